@@ -6,11 +6,25 @@
 #include "menu_manager.h"
 #include "text_strings.h"
 #include "modem_manager.h"
+#include "at_engine.h"
+#include "sms_handler.h"
+#include "settings.h"
+#include "alert_engine.h"
+#include "net_status.h"
 #include "time_manager.h"
 // debug_inject_key removed (no OpenWeather key support)
 // #include "debug_inject_key.h"   // declares debug_injectKeyNow(...)
 #include "weather_manager.h"    // declares weather_init(), weather_fetch(), etc.
 #include "key_server.h"
+#include "measurement.h"
+#include "sampling_scheduler.h"
+#include "power_manager.h"
+#include "telemetry.h"
+#include "net_transport.h"
+#include "ota_manager.h"
+#include "connectivity_manager.h"
+#include "http_async.h"
+#include "geocode_cache.h"
 #include <WiFi.h>
 #include <LiquidCrystal_I2C.h>
 #include <Preferences.h>
@@ -45,47 +59,38 @@ int test_batt_percent = 87;
 
 int test_rssi = -72;
 
-// -----------------------------------------------------------------------------
-// Helper: connect to WiFi using credentials stored in Preferences (optional).
-// Preferences keys: namespace "wifi_cfg", keys "ssid" and "pass".
-// This is non-blocking with timeout and only used for convenience during testing.
-static const char* PREF_WIFI_NS = "wifi_cfg";
-static const char* PREF_WIFI_SSID = "ssid";
-static const char* PREF_WIFI_PASS = "pass";
-
-void wifi_connectFromPrefs(unsigned long timeoutMs = 8000) {
-  Preferences p;
-  p.begin(PREF_WIFI_NS, true);
-  String ssid = p.getString(PREF_WIFI_SSID, "");
-  String pass = p.getString(PREF_WIFI_PASS, "");
-  p.end();
-
-  if (ssid.length() == 0) {
-    Serial.println("[WiFi] No SSID stored in prefs");
-    return;
-  }
-
-  Serial.print("[WiFi] Connecting to SSID: ");
-  Serial.println(ssid);
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid.c_str(), pass.c_str());
-
-  unsigned long start = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - start < timeoutMs) {
-    delay(250);
-    Serial.print(".");
-  }
-  Serial.println();
+// ============================================
+// Diagnostics
+// ============================================
+// Counters and latency histograms of every module (see STATS_DUMP_INTERVAL_MS)
+static void printAllStats() {
+  Serial.printf("[Stats] uptime %lu s, free heap %lu\n", millis() / 1000UL, (unsigned long)ESP.getFreeHeap());
+  Serial.printf("[Power] idle %.0f%% of uptime, ~%.1f mA saved\n",
+                power_getIdleFraction() * 100.0f, power_getIdleSavedMa());
+  modem_printPowerStats();
+  at_printStats();
+  netStatus_printStats();
+  sms_printStats();
+  connectivity_printStats();
+  netTransport_printStats();
+  httpAsync_printStats();
+  geocache_printStats();
+  telemetry_printStats();
+  alert_printStats();
+  keyServer_printStats();
+  ota_printStats();
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.print("[WiFi] Connected, IP: ");
-    Serial.println(WiFi.localIP());
-  } else {
-    Serial.println("[WiFi] Connect timed out");
+static void statsLoop() {
+  static unsigned long lastDump = 0;
+  bool requested = false;
+  while (Serial.available()) {
+    if (Serial.read() == 's') requested = true;
   }
-
-  // Debug: dump coords + request URL and attempt a weather fetch
-  weather_debug_dumpAndFetch();
+  if (STATS_DUMP_INTERVAL_MS > 0 && millis() - lastDump >= STATS_DUMP_INTERVAL_MS) requested = true;
+  if (!requested) return;
+  lastDump = millis();
+  printAllStats();
 }
 
 // ============================================
@@ -97,6 +102,9 @@ void setup() {
   Serial.begin(115200);
   delay(50);
 
+  // firmware trial bookkeeping first: a crashing new image must count its boots
+  ota_init();
+
   uiInit();
 
   // configure button pins early so menu/UI can read them
@@ -105,6 +113,9 @@ void setup() {
   pinMode(BTN_SELECT, INPUT_PULLUP);
   pinMode(BTN_BACK, INPUT_PULLUP);
 
+  // DFS + automatic light sleep; buttons wake the CPU
+  power_init();
+
   // ----------------------------
   // SD INIT (GLOBAL)
   // ----------------------------
@@ -112,10 +123,16 @@ void setup() {
   bool sd_ok = SD.begin(SD_CS);
 
   // initialize other modules
+  netTransport_init();   // connectivityMode (WiFi / LTE / offline) from NVS
   weather_init();
 
-  // Try to connect to WiFi using stored prefs (optional convenience)
-  wifi_connectFromPrefs(8000);
+  // WiFi: cached BSSID/channel first, async scan otherwise (waits up to 8 s here)
+  connectivity_init();
+  if (connectivity_wifiConnected() || connectivity_waitConnected(8000)) {
+    // Debug: dump coords + request URL and attempt a weather fetch
+    weather_debug_dumpAndFetch();
+  }
+  connectivity_printStats();
 
   // If WiFi is already connected start the key server (provisioning server)
   if (WiFi.status() == WL_CONNECTED) keyServer_init();
@@ -128,7 +145,12 @@ void setup() {
 
   menuInit();
   modemManager_init();   // modem manager stubs / init
+  sms_init();            // +CMTI driven SMS commands (needs the AT engine)
+  netStatus_init();      // cached WiFi/LTE status, registration URCs
   timeManager_init();
+  settings_init();       // NVS settings blob (sampling / uplink tunables)
+  sampler_init();
+  telemetry_init();      // after SD + modem: opens the store-and-forward queue
 
   // If WiFi connected we already started keyServer; keyServer_loop() will keep it alive.
 }
@@ -137,11 +159,38 @@ void setup() {
 void loop() {
 
   menuUpdate();
+  at_loop();             // modem UART: replies, URCs, queued AT commands
+  modem_powerLoop();     // modem leases: power-up / PSM idle / power-down
+  netStatus_loop();      // slow refresh of the cached link status (UI / HTTP read it)
+  sms_loop();            // lists stored SMS only after +CMTI (or a slow fallback poll)
+  connectivity_loop();   // WiFi reconnect / roaming, non-blocking
   timeManager_update();  // <-- REQUIRED for status screen timing
 
+  // Adaptive sampling: take a measurement when the scheduler says it is due
+  if (sampler_isDue()) {
+    Measurement m;
+    measurement_capture(m);
+    sampler_addReading(m);
+    telemetry_enqueue(m);
+    alert_evaluate(m);      // thresholds -> coalesced MQTT/SMS alerts
+    keyServer_publish(m);   // live /events subscribers
+  }
+
+  // MQTT uplink: batches the queue out when due, drains the backlog after reconnect
+  telemetry_loop();
+  alert_loop();
+
   // key server (provisioning) - auto-starts when WiFi connects (safe to call always)
   keyServer_loop();
 
+  // forecast cache: background refresh when stale
+  weather_loop();
+
+  // firmware update: pull downloads, trial health check, reboot after install
+  ota_loop();
+
+  statsLoop();
+
   delay(10);
 }
 
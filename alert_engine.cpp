@@ -0,0 +1,240 @@
+// alert_engine.cpp
+// - Rules are a static table; each measurement is reduced once to a small metric vector
+//   (weight drop over the window, internal temperature, battery %, tilt angle) and every
+//   rule compares one metric, so evaluation is O(metrics + rules) with fixed state.
+// - Per rule: NORMAL -> PENDING (condition seen, waiting for minDurMs) -> RAISED ->
+//   NORMAL once the value is back past the clear threshold. A raise inside the cooldown
+//   of the previous one is marked silent: neither it nor its clear is reported.
+// - Events collect in a fixed list for ALERT_COALESCE_S (or until it is full) and go out
+//   as one line of at most one SMS (160 chars).
+// - Timing uses millis(); state lives in RAM and starts over after a reboot.
+#include "alert_engine.h"
+#include "config.h"
+#include "telemetry.h"
+#include "sms_handler.h"
+#include <math.h>
+
+enum AlertMetric { AM_WEIGHT_DROP = 0, AM_TEMP_INT, AM_BATT_PCT, AM_TILT_DEG, AM_COUNT };
+enum AlertSeverity { SEV_INFO = 0, SEV_WARN, SEV_CRIT };
+
+struct AlertRule {
+  const char   *name;
+  uint8_t       metric;
+  bool          below;      // fires when the value drops below raise (else rises above)
+  float         raise;
+  float         clear;      // back to normal only past this value
+  uint32_t      minDurMs;   // condition must hold this long
+  uint32_t      cooldownMs; // minimum gap between two reported raises
+  uint8_t       severity;
+  const char   *unit;
+};
+
+static const uint32_t MIN_MS  = 60UL * 1000UL;
+static const uint32_t HOUR_MS = 60UL * MIN_MS;
+
+static const AlertRule RULES[] = {
+  // name           metric          below  raise                 clear                        minDur       cooldown      severity  unit
+  { "weight drop",  AM_WEIGHT_DROP, false, ALERT_WEIGHT_DROP_KG, ALERT_WEIGHT_DROP_KG * 0.5f, 0,           HOUR_MS,      SEV_CRIT, "kg" },
+  { "brood cold",   AM_TEMP_INT,    true,  ALERT_BROOD_MIN_C,    ALERT_BROOD_MIN_C + 1.0f,    30 * MIN_MS, 3 * HOUR_MS,  SEV_WARN, "C" },
+  { "brood hot",    AM_TEMP_INT,    false, ALERT_BROOD_MAX_C,    ALERT_BROOD_MAX_C - 1.0f,    15 * MIN_MS, 3 * HOUR_MS,  SEV_WARN, "C" },
+  { "battery low",  AM_BATT_PCT,    true,  ALERT_BATT_LOW_PCT,   ALERT_BATT_LOW_PCT + 5.0f,   0,           12 * HOUR_MS, SEV_WARN, "%" },
+  { "tilt",         AM_TILT_DEG,    false, ALERT_TILT_DEG,       ALERT_TILT_DEG - 5.0f,       0,           HOUR_MS,      SEV_CRIT, "deg" },
+};
+static const int RULE_COUNT = sizeof(RULES) / sizeof(RULES[0]);
+static_assert(RULE_COUNT <= 32, "alert_activeMask() has 32 bits");
+
+enum { RS_NORMAL = 0, RS_PENDING, RS_RAISED };
+
+struct RuleState {
+  uint8_t  phase;
+  bool     silent;      // raised inside the cooldown, not reported
+  bool     everRaised;
+  uint32_t sinceMs;     // condition first seen (PENDING)
+  uint32_t raisedMs;    // last reported raise
+};
+static RuleState s_state[RULE_COUNT];
+
+struct AlertEvent {
+  uint8_t rule;
+  bool    raised;       // false = cleared
+  float   value;
+};
+static AlertEvent    s_events[ALERT_MAX_EVENTS];
+static uint8_t       s_eventCount = 0;
+static unsigned long s_windowStartMs = 0;
+
+// Weight history for the drop metric (max over ALERT_WEIGHT_WINDOW_S minus current)
+static const int WEIGHT_HIST = 12;
+static float    s_wHist[WEIGHT_HIST];
+static uint32_t s_wHistMs[WEIGHT_HIST];
+static uint8_t  s_wCount = 0;
+static uint8_t  s_wHead = 0;
+
+static char s_msg[161];
+
+static uint32_t s_raised = 0;
+static uint32_t s_cleared = 0;
+static uint32_t s_suppressed = 0;
+static uint32_t s_sentMqtt = 0;
+static uint32_t s_sentSms = 0;
+static uint32_t s_undelivered = 0;
+
+// ---------------------------------------------------------------------------
+// Metrics
+// ---------------------------------------------------------------------------
+static float weightDrop(float w, uint32_t now) {
+  if (isnan(w)) return NAN;
+  s_wHist[s_wHead] = w;
+  s_wHistMs[s_wHead] = now;
+  s_wHead = (s_wHead + 1) % WEIGHT_HIST;
+  if (s_wCount < WEIGHT_HIST) s_wCount++;
+
+  float peak = w;
+  for (int i = 0; i < s_wCount; ++i) {
+    if (now - s_wHistMs[i] <= ALERT_WEIGHT_WINDOW_S * 1000UL && s_wHist[i] > peak) peak = s_wHist[i];
+  }
+  return peak - w;
+}
+
+static float tiltDeg(const Measurement &m) {
+  float g = sqrtf(m.acc_x * m.acc_x + m.acc_y * m.acc_y + m.acc_z * m.acc_z);
+  if (isnan(g) || g < 0.5f) return NAN;   // no sensor / free fall
+  float c = fabsf(m.acc_z) / g;
+  if (c > 1.0f) c = 1.0f;
+  return acosf(c) * 57.29578f;
+}
+
+// ---------------------------------------------------------------------------
+// Events
+// ---------------------------------------------------------------------------
+static void deliver();
+
+static void pushEvent(int rule, bool raised, float value) {
+  if (s_eventCount == 0) s_windowStartMs = millis();
+  s_events[s_eventCount++] = { (uint8_t)rule, raised, value };
+  Serial.printf("[Alert] %s %s (%.2f %s)\n", RULES[rule].name, raised ? "RAISED" : "cleared",
+                value, RULES[rule].unit);
+  if (s_eventCount >= ALERT_MAX_EVENTS) deliver();
+}
+
+static void raiseRule(int i, float v, uint32_t now) {
+  RuleState &st = s_state[i];
+  st.phase = RS_RAISED;
+  st.silent = st.everRaised && now - st.raisedMs < RULES[i].cooldownMs;
+  if (st.silent) {
+    s_suppressed++;
+    return;
+  }
+  st.everRaised = true;
+  st.raisedMs = now;
+  s_raised++;
+  pushEvent(i, true, v);
+}
+
+static void evaluateRule(int i, float v, uint32_t now) {
+  const AlertRule &r = RULES[i];
+  RuleState &st = s_state[i];
+  if (isnan(v)) return;   // sensor missing: keep the current state
+
+  bool tripped = r.below ? v < r.raise : v > r.raise;
+  bool cleared = r.below ? v >= r.clear : v <= r.clear;
+
+  switch (st.phase) {
+    case RS_NORMAL:
+      if (!tripped) break;
+      if (r.minDurMs == 0) { raiseRule(i, v, now); break; }
+      st.phase = RS_PENDING;
+      st.sinceMs = now;
+      break;
+    case RS_PENDING:
+      // The condition must hold for the whole window: any sample that is not past the
+      // raise threshold (cleared or in the hysteresis band) restarts it.
+      if (!tripped) st.phase = RS_NORMAL;
+      else if (now - st.sinceMs >= r.minDurMs) raiseRule(i, v, now);
+      break;
+    case RS_RAISED:
+      if (!cleared) break;
+      st.phase = RS_NORMAL;
+      if (!st.silent) {
+        s_cleared++;
+        pushEvent(i, false, v);
+      }
+      break;
+  }
+}
+
+// One line: "<dev> ALERT weight drop 2.1kg, tilt 34deg; OK battery low 26%"
+static uint8_t formatMessage() {
+  uint8_t sev = SEV_INFO;
+  int len = snprintf(s_msg, sizeof(s_msg), "%s", telemetry_deviceId());
+  bool any = false;
+  for (int pass = 0; pass < 2; ++pass) {
+    bool raised = pass == 0;
+    bool first = true;
+    for (uint8_t k = 0; k < s_eventCount; ++k) {
+      const AlertEvent &e = s_events[k];
+      if (e.raised != raised) continue;
+      const AlertRule &r = RULES[e.rule];
+      if (raised && r.severity > sev) sev = r.severity;
+      if (len >= (int)sizeof(s_msg)) break;
+      len += snprintf(s_msg + len, sizeof(s_msg) - len, "%s%s %.1f%s",
+                      first ? (raised ? " ALERT " : (any ? "; OK " : " OK ")) : ", ",
+                      r.name, e.value, r.unit);
+      first = false;
+      any = true;
+    }
+  }
+  return sev;
+}
+
+static void deliver() {
+  if (s_eventCount == 0) return;
+  uint8_t sev = formatMessage();
+  s_eventCount = 0;
+
+  bool mqtt = telemetry_publishAlert(s_msg);
+  if (mqtt) s_sentMqtt++;
+
+  // Escalation: critical always by SMS as well, warnings only if the uplink failed
+  bool sms = false;
+  if (ALERT_SMS_TO[0] && (sev == SEV_CRIT || (sev == SEV_WARN && !mqtt))) {
+    sms = sms_send(ALERT_SMS_TO, s_msg);
+    if (sms) s_sentSms++;
+  }
+  if (!mqtt && !sms) s_undelivered++;
+  Serial.printf("[Alert] sent '%s' (mqtt %s, sms %s)\n", s_msg, mqtt ? "ok" : "no", sms ? "ok" : "no");
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void alert_evaluate(const Measurement &m) {
+  uint32_t now = millis();
+  float v[AM_COUNT];
+  v[AM_WEIGHT_DROP] = weightDrop(m.weight, now);
+  v[AM_TEMP_INT]    = m.temp_int;
+  v[AM_BATT_PCT]    = m.batt_percent < 0 ? NAN : (float)m.batt_percent;
+  v[AM_TILT_DEG]    = tiltDeg(m);
+
+  for (int i = 0; i < RULE_COUNT; ++i) evaluateRule(i, v[RULES[i].metric], now);
+}
+
+void alert_loop() {
+  if (s_eventCount && millis() - s_windowStartMs >= ALERT_COALESCE_S * 1000UL) deliver();
+}
+
+uint32_t alert_activeMask() {
+  uint32_t mask = 0;
+  for (int i = 0; i < RULE_COUNT; ++i) {
+    if (s_state[i].phase == RS_RAISED) mask |= 1UL << i;
+  }
+  return mask;
+}
+
+void alert_printStats() {
+  Serial.printf("[Alert] raised=%lu cleared=%lu suppressed=%lu active=0x%02lx\n",
+                (unsigned long)s_raised, (unsigned long)s_cleared, (unsigned long)s_suppressed,
+                (unsigned long)alert_activeMask());
+  Serial.printf("[Alert] delivered mqtt=%lu sms=%lu, undelivered=%lu\n",
+                (unsigned long)s_sentMqtt, (unsigned long)s_sentSms, (unsigned long)s_undelivered);
+}
@@ -0,0 +1,26 @@
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include <Arduino.h>
+#include "measurement.h"
+
+// Threshold alerts on each new measurement: sharp weight drop (swarm/theft), internal
+// temperature outside the brood range, low battery and hive tilt.
+// Every rule has a raise and a clear threshold (hysteresis), a minimum duration the
+// condition must hold and a cooldown between two raises. Raise/clear events are
+// coalesced for ALERT_COALESCE_S and delivered as one message: MQTT alert topic first,
+// SMS to ALERT_SMS_TO for critical rules or when MQTT is unreachable.
+
+// Evaluate all rules against m (call once per new measurement). O(rules), no allocation.
+void alert_evaluate(const Measurement &m);
+
+// Deliver the coalesced message when its window is over (call from loop)
+void alert_loop();
+
+// Rules currently raised, bit i = rule i
+uint32_t alert_activeMask();
+
+// Raise / clear / suppressed / delivery counters since boot
+void alert_printStats();
+
+#endif // ALERT_ENGINE_H
@@ -0,0 +1,358 @@
+// at_engine.cpp
+// - One command in flight, AT_QUEUE_LEN waiting. Bytes are read in at_loop() and
+//   assembled into lines; each line is either echo (dropped), a final result code
+//   (completes the command), a URC (dispatched), or an info line (appended to s_resp).
+// - A line is treated as the command's own info line if it starts with the command name
+//   ("+CCLK" for "+CCLK?"), so a subscriber for the same prefix only sees true URCs.
+// - For commands in DATA_AFTER_HEADER (+CMGL, +CMGR) the line after each header is
+//   message text: it is appended as is, even when it reads "OK", "ERROR", "AT..." or
+//   looks like a URC, or is empty.
+// - The UART power lock is held only while a command is in flight.
+#include "at_engine.h"
+#include "power_manager.h"
+
+struct AtCmd {
+  char      cmd[AT_CMD_LEN];
+  char      payload[AT_PAYLOAD_LEN];
+  bool      prompt;
+  uint32_t  timeoutMs;
+  AtDoneFn  done;
+  void     *ctx;
+};
+
+struct AtSub {
+  char    prefix[12];
+  AtUrcFn fn;
+  void   *ctx;
+};
+
+static Stream *s_port = nullptr;
+
+static AtCmd   s_queue[AT_QUEUE_LEN];
+static uint8_t s_qHead = 0;
+static uint8_t s_qCount = 0;
+
+// Command in flight
+static AtCmd s_cur;
+static bool s_active = false;
+static bool s_payloadSent = false;
+static unsigned long s_sentAt = 0;
+static char s_name[16];            // "+CCLK" for "+CCLK?", empty for plain commands
+static bool s_hasData = false;     // header lines of this command own the following line
+static bool s_dataNext = false;    // next line is data, not a result code or URC
+
+static char s_line[AT_LINE_LEN];
+static uint16_t s_lineLen = 0;
+static char s_resp[AT_RESP_LEN];
+static uint16_t s_respLen = 0;
+static uint8_t s_respLines = 0;
+static bool s_respTruncated = false;
+
+static AtSub s_subs[AT_MAX_URC_SUBS];
+static uint8_t s_subCount = 0;
+
+static bool s_inCallback = false;
+static bool s_hold = false;        // at_waitIdle(): do not start queued commands
+
+// Stats
+static const uint16_t RTT_BUCKET_MS[] = { 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+static const int RTT_BUCKETS = sizeof(RTT_BUCKET_MS) / sizeof(RTT_BUCKET_MS[0]) + 1;
+static uint32_t s_rttHist[RTT_BUCKETS];
+static uint32_t s_results[AT_REJECTED + 1];
+static uint32_t s_urcs = 0;
+static uint32_t s_unclaimed = 0;
+
+// Commands whose header line is followed by one line of user data (SMS text)
+static const char *const DATA_AFTER_HEADER[] = { "+CMGL", "+CMGR" };
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static bool startsWith(const char *s, const char *prefix) {
+  return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+// Command name used to recognise its info lines: "+CMGL=..." -> "+CMGL"
+static void commandName(const char *cmd, char *out, size_t len) {
+  size_t n = 0;
+  if (cmd[0] == '+' || cmd[0] == '*' || cmd[0] == '^') {
+    while (cmd[n] && cmd[n] != '=' && cmd[n] != '?' && n + 1 < len) { out[n] = cmd[n]; n++; }
+  }
+  out[n] = 0;
+}
+
+static bool dispatchUrc(const char *line) {
+  for (uint8_t i = 0; i < s_subCount; ++i) {
+    if (startsWith(line, s_subs[i].prefix)) {
+      s_urcs++;
+      s_inCallback = true;
+      s_subs[i].fn(line, s_subs[i].ctx);
+      s_inCallback = false;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void appendResp(const char *line, uint16_t len) {
+  if (s_respTruncated) return;   // keep the kept prefix contiguous
+  if ((size_t)s_respLen + len + 1 >= sizeof(s_resp)) { s_respTruncated = true; return; }
+  if (s_respLen) s_resp[s_respLen++] = '\n';
+  memcpy(s_resp + s_respLen, line, len);
+  s_respLen += len;
+  s_resp[s_respLen] = 0;
+  s_respLines++;
+}
+
+static void finish(AtResult result, int errorCode) {
+  unsigned long ms = millis() - s_sentAt;
+  int b = 0;
+  while (b < RTT_BUCKETS - 1 && ms >= RTT_BUCKET_MS[b]) b++;
+  s_rttHist[b]++;
+  s_results[result]++;
+
+  s_active = false;
+  power_release(PWR_LOCK_UART);
+  if (result != AT_OK) {
+    Serial.printf("[AT] %s -> %s", s_cur.cmd, at_resultName(result));
+    if (errorCode >= 0) Serial.printf(" %d", errorCode);
+    Serial.println();
+  }
+
+  if (s_cur.done) {
+    AtReply r;
+    r.result = result;
+    r.errorCode = errorCode;
+    r.text = s_resp;
+    r.len = s_respLen;
+    r.lines = s_respLines;
+    r.truncated = s_respTruncated;
+    r.elapsedMs = ms;
+    s_inCallback = true;
+    s_cur.done(r, s_cur.ctx);
+    s_inCallback = false;
+  }
+}
+
+static void handleLine(char *line, uint16_t len) {
+  if (s_active && s_dataNext) {
+    // message text: keep it verbatim apart from the line ending
+    s_dataNext = false;
+    if (len && line[len - 1] == '\r') line[--len] = 0;
+    appendResp(line, len);
+    return;
+  }
+
+  // trim the '\r' and the blank left after a '>' prompt
+  while (len && (line[len - 1] == '\r' || line[len - 1] == ' ')) line[--len] = 0;
+  while (len && line[0] == ' ') { line++; len--; }
+  if (len == 0) return;
+
+  if (!s_active) {
+    if (!dispatchUrc(line)) s_unclaimed++;
+    return;
+  }
+
+  if (startsWith(line, "AT")) return;   // echo (ATE1)
+
+  if (strcmp(line, "OK") == 0) { finish(AT_OK, -1); return; }
+  if (strcmp(line, "ERROR") == 0 || strcmp(line, "NO CARRIER") == 0 ||
+      strcmp(line, "BUSY") == 0 || strcmp(line, "NO ANSWER") == 0) {
+    finish(AT_ERROR, -1);
+    return;
+  }
+  if (startsWith(line, "+CME ERROR:") || startsWith(line, "+CMS ERROR:")) {
+    finish(AT_CME_ERROR, atoi(line + 11));
+    return;
+  }
+
+  if (s_name[0] && startsWith(line, s_name)) {
+    appendResp(line, len);
+    s_dataNext = s_hasData;
+    return;
+  }
+  if (dispatchUrc(line)) return;
+  appendResp(line, len);
+}
+
+static void startNext() {
+  if (s_active || s_hold || s_qCount == 0) return;
+  s_cur = s_queue[s_qHead];
+  s_qHead = (s_qHead + 1) % AT_QUEUE_LEN;
+  s_qCount--;
+
+  commandName(s_cur.cmd, s_name, sizeof(s_name));
+  s_hasData = false;
+  for (const char *d : DATA_AFTER_HEADER) if (strcmp(s_name, d) == 0) s_hasData = true;
+  s_dataNext = false;
+  s_respLen = 0;
+  s_resp[0] = 0;
+  s_respLines = 0;
+  s_respTruncated = false;
+  s_payloadSent = false;
+  s_lineLen = 0;
+
+  power_acquire(PWR_LOCK_UART);
+  s_port->print("AT");
+  s_port->print(s_cur.cmd);
+  s_port->print("\r");
+  s_sentAt = millis();
+  s_active = true;
+}
+
+static bool enqueue(const char *cmd, const char *payload, uint32_t timeoutMs, AtDoneFn done, void *ctx) {
+  if (!s_port || s_qCount >= AT_QUEUE_LEN || strlen(cmd) >= AT_CMD_LEN ||
+      (payload && strlen(payload) >= AT_PAYLOAD_LEN)) {
+    Serial.printf("[AT] rejected %s\n", cmd);
+    s_results[AT_REJECTED]++;
+    return false;
+  }
+  AtCmd &c = s_queue[(s_qHead + s_qCount) % AT_QUEUE_LEN];
+  strcpy(c.cmd, cmd);
+  strcpy(c.payload, payload ? payload : "");
+  c.prompt = payload != nullptr;
+  c.timeoutMs = timeoutMs;
+  c.done = done;
+  c.ctx = ctx;
+  s_qCount++;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void at_init(Stream &port) {
+  s_port = &port;
+  while (s_port->available()) s_port->read();   // leftovers from the TinyGSM bring-up
+  Serial.println("[AT] engine started");
+}
+
+bool at_isStarted() { return s_port != nullptr; }
+
+void at_loop() {
+  if (!s_port) return;
+
+  for (int budget = 256; budget > 0 && s_port->available(); --budget) {
+    char c = (char)s_port->read();
+
+    // the prompt has no line ending: answer it as soon as it shows up
+    if (s_active && s_cur.prompt && !s_payloadSent && c == '>' && s_lineLen == 0) {
+      s_port->print(s_cur.payload);
+      s_port->write((uint8_t)0x1A);   // Ctrl-Z
+      s_payloadSent = true;
+      continue;
+    }
+
+    if (c == '\n') {
+      s_line[s_lineLen] = 0;
+      handleLine(s_line, s_lineLen);
+      s_lineLen = 0;
+    } else if (s_lineLen < sizeof(s_line) - 1) {
+      s_line[s_lineLen++] = c;
+    }
+  }
+
+  if (s_active && millis() - s_sentAt > s_cur.timeoutMs) {
+    bool noPrompt = s_cur.prompt && !s_payloadSent;
+    if (noPrompt) s_port->write((uint8_t)0x1B);   // ESC leaves a pending prompt
+    finish(noPrompt ? AT_NO_PROMPT : AT_TIMEOUT, -1);
+  }
+
+  startNext();
+}
+
+bool at_submit(const char *cmd, uint32_t timeoutMs, AtDoneFn done, void *ctx) {
+  return enqueue(cmd, nullptr, timeoutMs, done, ctx);
+}
+
+bool at_submitPrompt(const char *cmd, const char *payload, uint32_t timeoutMs, AtDoneFn done, void *ctx) {
+  return enqueue(cmd, payload, timeoutMs, done, ctx);
+}
+
+struct ExecWait {
+  AtResult result;
+  char    *resp;
+  size_t   respLen;
+};
+
+static void execDone(const AtReply &r, void *ctx) {
+  ExecWait *w = (ExecWait*)ctx;
+  w->result = r.result;
+  if (w->resp && w->respLen) {
+    size_t n = r.len < w->respLen - 1 ? r.len : w->respLen - 1;
+    memcpy(w->resp, r.text, n);
+    w->resp[n] = 0;
+  }
+}
+
+static AtResult execWait(const char *cmd, const char *payload, uint32_t timeoutMs, char *resp, size_t respLen) {
+  if (resp && respLen) resp[0] = 0;
+  if (s_inCallback) {
+    Serial.printf("[AT] %s: blocking call from a callback\n", cmd);
+    return AT_REJECTED;
+  }
+  ExecWait w = { AT_PENDING, resp, respLen };
+  if (!enqueue(cmd, payload, timeoutMs, execDone, &w)) return AT_REJECTED;
+  while (w.result == AT_PENDING) {
+    at_loop();
+    if (w.result == AT_PENDING) delay(1);
+  }
+  return w.result;
+}
+
+AtResult at_exec(const char *cmd, uint32_t timeoutMs, char *resp, size_t respLen) {
+  return execWait(cmd, nullptr, timeoutMs, resp, respLen);
+}
+
+AtResult at_execPrompt(const char *cmd, const char *payload, uint32_t timeoutMs) {
+  return execWait(cmd, payload, timeoutMs, nullptr, 0);
+}
+
+bool at_waitIdle(uint32_t timeoutMs) {
+  if (!s_port) return true;
+  unsigned long t0 = millis();
+  while (s_active) {
+    if (s_inCallback || millis() - t0 > timeoutMs) return false;
+    s_hold = true;
+    at_loop();
+    s_hold = false;
+    if (s_active) delay(1);
+  }
+  return true;
+}
+
+bool at_busy() { return s_active; }
+uint8_t at_queued() { return s_qCount; }
+
+bool at_subscribe(const char *prefix, AtUrcFn fn, void *ctx) {
+  if (s_subCount >= AT_MAX_URC_SUBS || strlen(prefix) >= sizeof(s_subs[0].prefix)) return false;
+  AtSub &s = s_subs[s_subCount++];
+  strcpy(s.prefix, prefix);
+  s.fn = fn;
+  s.ctx = ctx;
+  return true;
+}
+
+const char *at_resultName(AtResult r) {
+  switch (r) {
+    case AT_PENDING:   return "pending";
+    case AT_OK:        return "OK";
+    case AT_ERROR:     return "ERROR";
+    case AT_CME_ERROR: return "CME ERROR";
+    case AT_TIMEOUT:   return "timeout";
+    case AT_NO_PROMPT: return "no prompt";
+    case AT_REJECTED:  return "rejected";
+  }
+  return "?";
+}
+
+void at_printStats() {
+  Serial.printf("[AT] ok=%lu error=%lu cme=%lu timeout=%lu noprompt=%lu rejected=%lu urc=%lu unclaimed=%lu\n",
+                (unsigned long)s_results[AT_OK], (unsigned long)s_results[AT_ERROR],
+                (unsigned long)s_results[AT_CME_ERROR], (unsigned long)s_results[AT_TIMEOUT],
+                (unsigned long)s_results[AT_NO_PROMPT], (unsigned long)s_results[AT_REJECTED],
+                (unsigned long)s_urcs, (unsigned long)s_unclaimed);
+  Serial.print("[AT] round trip ms <");
+  for (int b = 0; b < RTT_BUCKETS - 1; ++b) Serial.printf(" %u:%lu", RTT_BUCKET_MS[b], (unsigned long)s_rttHist[b]);
+  Serial.printf(" >=%u:%lu\n", RTT_BUCKET_MS[RTT_BUCKETS - 2], (unsigned long)s_rttHist[RTT_BUCKETS - 1]);
+}
@@ -0,0 +1,82 @@
+#ifndef AT_ENGINE_H
+#define AT_ENGINE_H
+
+#include <Arduino.h>
+
+// Cooperative AT command engine for the A7670 UART.
+// Commands are queued and sent one at a time from at_loop(); the reply is parsed line
+// by line into fixed buffers and the command completes on the final result code
+// (OK / ERROR / +CME ERROR / +CMS ERROR), not after a fixed delay.
+// The line after a +CMGL/+CMGR header is message text and never ends the command.
+// Unsolicited result codes (+CMTI, +CREG, ...) are routed to subscribers by prefix,
+// both while idle and in the middle of another command's reply.
+//
+// TinyGSM still drives the socket layer (GPRS bearer, TCP/TLS clients) on the same
+// UART; call at_waitIdle() before any TinyGSM call so the two never interleave.
+
+#define AT_QUEUE_LEN     8
+#define AT_CMD_LEN       64     // command text after "AT"
+#define AT_PAYLOAD_LEN   164    // text sent after the '>' prompt (one SMS)
+#define AT_LINE_LEN      160
+#define AT_RESP_LEN      1024   // info lines of one reply, '\n' separated
+#define AT_MAX_URC_SUBS  8
+#define AT_FENCE_MS      5000   // at_waitIdle() budget before a TinyGSM call
+
+enum AtResult {
+  AT_PENDING = 0,
+  AT_OK,
+  AT_ERROR,
+  AT_CME_ERROR,     // +CME ERROR / +CMS ERROR, code in AtReply::errorCode
+  AT_TIMEOUT,
+  AT_NO_PROMPT,     // '>' never came for a prompt command
+  AT_REJECTED       // queue full, engine not started, or called from a callback
+};
+
+struct AtReply {
+  AtResult      result;
+  int           errorCode;
+  const char   *text;       // info lines without echo and final code, '\n' separated
+  uint16_t      len;
+  uint8_t       lines;
+  bool          truncated;  // reply exceeded AT_RESP_LEN
+  unsigned long elapsedMs;
+};
+
+typedef void (*AtDoneFn)(const AtReply &reply, void *ctx);
+typedef void (*AtUrcFn)(const char *line, void *ctx);
+
+// Take over the modem UART (after TinyGSM has brought the modem up)
+void at_init(Stream &port);
+bool at_isStarted();
+
+// Read and parse pending bytes, time out / start commands. Call from loop().
+void at_loop();
+
+// Queue "AT<cmd>". done (optional) runs from at_loop() with the reply. Returns false if
+// the queue is full.
+bool at_submit(const char *cmd, uint32_t timeoutMs, AtDoneFn done, void *ctx);
+
+// As at_submit(), then send payload + Ctrl-Z when the '>' prompt arrives (AT+CMGS)
+bool at_submitPrompt(const char *cmd, const char *payload, uint32_t timeoutMs, AtDoneFn done, void *ctx);
+
+// Blocking convenience: queue the command and run at_loop() until it completes.
+// Returns as soon as the final result code arrives. resp receives the info lines.
+// Must not be called from an AT or URC callback.
+AtResult at_exec(const char *cmd, uint32_t timeoutMs, char *resp = nullptr, size_t respLen = 0);
+AtResult at_execPrompt(const char *cmd, const char *payload, uint32_t timeoutMs);
+
+// Finish the command in flight (queued ones stay queued). For TinyGSM callers.
+bool at_waitIdle(uint32_t timeoutMs);
+
+bool    at_busy();          // a command is in flight
+uint8_t at_queued();        // waiting behind it
+
+// Route lines starting with prefix (e.g. "+CMTI:") to fn
+bool at_subscribe(const char *prefix, AtUrcFn fn, void *ctx);
+
+const char *at_resultName(AtResult r);
+
+// Round-trip histogram, results and URC counters since boot
+void at_printStats();
+
+#endif // AT_ENGINE_H
@@ -214,16 +214,22 @@ float calibration_getHumOffset() {
   return prefs.getFloat(K_HUM_OFF, 0.0f);
 }
 
-// Summary for UI
+// Summary for UI and the web API
+void calibration_readSummary(CalibrationSummary &out) {
+  out.zeroRaw = prefs.getLong(K_ZERO, 0);
+  out.scaleFactor = prefs.getFloat(K_SCALE, 0.0f);
+  out.battFactor = prefs.getFloat(K_BATT_FACTOR, 1.0f);
+  out.tempOffset = prefs.getFloat(K_TEMP_OFF, 0.0f);
+  out.humOffset = prefs.getFloat(K_HUM_OFF, 0.0f);
+  calibration_getAccelBias(out.accelBias[0], out.accelBias[1], out.accelBias[2]);
+}
+
 String calibration_getSummary() {
-  long zero = prefs.getLong(K_ZERO, 0);
-  float scale = prefs.getFloat(K_SCALE, 0.0f);
-  float battFac = prefs.getFloat(K_BATT_FACTOR, 1.0f);
-  float tb = prefs.getFloat(K_TEMP_OFF, 0.0f);
-  float hb = prefs.getFloat(K_HUM_OFF, 0.0f);
+  CalibrationSummary c;
+  calibration_readSummary(c);
   char buf[256];
   snprintf(buf, sizeof(buf),
            "Zero:%ld Scale:%.6f Bfac:%.4f Toff:%.2f Hoff:%.2f",
-           zero, scale, battFac, tb, hb);
+           c.zeroRaw, c.scaleFactor, c.battFactor, c.tempOffset, c.humOffset);
   return String(buf);
-}
\ No newline at end of file
+}
@@ -34,7 +34,18 @@ void calibration_setHumOffset(float deltaPct);
 float calibration_getTempOffset();
 float calibration_getHumOffset();
 
-// Persisted state introspection (for UI)
+// Persisted state introspection
+struct CalibrationSummary {
+  long  zeroRaw;        // HX711 raw reading at zero load
+  float scaleFactor;    // kg per raw count
+  float battFactor;     // battery ADC correction
+  float tempOffset;     // C
+  float humOffset;      // %
+  float accelBias[3];   // g (x, y, z)
+};
+void calibration_readSummary(CalibrationSummary &out);
+
+// Same data formatted as one line (for UI)
 String calibration_getSummary();
 
 #endif // CALIBRATION_H
\ No newline at end of file
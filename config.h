@@ -10,6 +10,26 @@
 // Timing
 #define MEASUREMENT_INTERVAL  (3600ULL * 1000000ULL)
 
+// -----------------------------------------------------------------------------
+// Adaptive sampling (sampling_scheduler.cpp)
+// Set ADAPTIVE_SAMPLING to 0 to always sample every MEASUREMENT_INTERVAL.
+#ifndef ADAPTIVE_SAMPLING
+#define ADAPTIVE_SAMPLING 1
+#endif
+#define SAMPLE_INTERVAL_MIN_S     300UL     // hard lower bound (5 min)
+#define SAMPLE_INTERVAL_MAX_S     14400UL   // hard upper bound (4 h)
+#define SAMPLE_INTERVAL_ACTIVE_S  300UL     // weight/temperature changing fast
+#define SAMPLE_INTERVAL_FORAGE_S  900UL     // daylight foraging hours
+#define SAMPLE_INTERVAL_FLAT_S    7200UL    // readings flat, outside foraging hours
+#define SAMPLE_FORAGE_START_HOUR  9         // local time, inclusive
+#define SAMPLE_FORAGE_END_HOUR    18        // local time, exclusive
+#define SAMPLE_WEIGHT_ACTIVE_KG   0.20f     // weight std-dev above this = active
+#define SAMPLE_TEMP_ACTIVE_C      0.50f     // internal temp std-dev above this = active
+#define SAMPLE_WEIGHT_FLAT_KG     0.05f     // both std-devs below these = flat
+#define SAMPLE_TEMP_FLAT_C        0.15f
+#define SAMPLE_BATT_LOW_PCT       30        // below: interval doubled
+#define SAMPLE_BATT_CRIT_PCT      15        // below: always SAMPLE_INTERVAL_MAX_S
+
 // =============================
 // Fixed hardware pinout
 // =============================
@@ -44,6 +64,42 @@
 #define BTN_SELECT     33
 #define BTN_BACK       32
 
+// Power management (power_manager.cpp)
+#ifndef POWER_AUTO_LIGHT_SLEEP
+#define POWER_AUTO_LIGHT_SLEEP 1
+#endif
+#define POWER_MAX_CPU_MHZ      240
+#define POWER_IDLE_CPU_MHZ     80
+// RX edges that wake the CPU from light sleep on the modem UART. A '\r' byte carries
+// three rising edges, so the CR that opens every URC is spent on the wakeup.
+#define POWER_UART_WAKE_EDGES  3
+// Rough board current figures used to estimate the idle saving on the status screen
+#define POWER_ACTIVE_MA        68.0f    // 240 MHz, busy-wait idle loop
+#define POWER_IDLE_MA          22.0f    // 80 MHz + automatic light sleep between polls
+
+// Diagnostics: every module's counters and latency histograms go to Serial every
+// STATS_DUMP_INTERVAL_MS (0 = never) and whenever 's' is typed into the serial monitor.
+#define STATS_DUMP_INTERVAL_MS (60UL * 60UL * 1000UL)
+
+// WiFi connectivity manager (connectivity_manager.cpp)
+#define CONN_MAX_CREDS         4
+#define CONN_FAST_TIMEOUT_MS   4000UL   // cached BSSID/channel join before falling back to a scan
+#define CONN_SCAN_TIMEOUT_MS   8000UL
+#define CONN_JOIN_TIMEOUT_MS   10000UL
+#define CONN_RETRY_S           60UL     // after no known network was found
+#define CONN_ROAM_CHECK_S      120UL    // link quality check period while connected
+#define CONN_WEAK_RSSI         -75      // below this, look for a better network
+#define CONN_MIN_RSSI          -90      // ignore networks weaker than this
+#define CONN_PRIORITY_DB       10       // score penalty per priority step
+#define CONN_HYSTERESIS_DB     8        // roam only if the new network scores this much better
+
+// Cached link status (net_status): refresh periods; registration also follows URCs
+#define NETSTAT_WIFI_MS        2000UL
+#define NETSTAT_REG_MS         60000UL
+#define NETSTAT_RSSI_MS        30000UL
+#define NETSTAT_OP_MS          600000UL
+#define NETSTAT_RETRY_MS       5000UL   // after a failed query
+
 // Connectivity modes
 #define CONNECTIVITY_LTE     0
 #define CONNECTIVITY_WIFI    1
@@ -54,15 +110,75 @@
 #define MODEM_GPRS_USER  ""
 #define MODEM_GPRS_PASS  ""
 
+// Modem power policy (modem_manager). Callers hold leases for radio time; with no lease
+// the modem is either left to the network's PSM/eDRX sleep or powered down.
+// Reachability for SMS commands (SET / STATUS? / GEO): a modem in PSM cannot be paged,
+// so the network holds incoming SMS until the next periodic TAU (MODEM_PSM_TAU) and
+// eDRX only applies during the short active time after it. With MODEM_PSM_ENABLED 0
+// the modem stays paged on the eDRX cycle (SMS within ~MODEM_EDRX_CYCLE, more current).
+// MODEM_POWER_OFF gets SMS only at the next power-up ("SMS DONE" listing).
+#define MODEM_POWER_ALWAYS_ON  0        // as before: on and awake
+#define MODEM_POWER_PSM        1        // on and registered, PSM/eDRX negotiated
+#define MODEM_POWER_OFF        2        // AT+CPOF after MODEM_LINGER_MS, PWRKEY to wake
+#define MODEM_POWER_POLICY     MODEM_POWER_PSM
+#define MODEM_LINGER_MS        30000UL  // idle time before power-down (POWER_OFF)
+#define MODEM_MIN_OFF_MS       5000UL   // let AT+CPOF finish before the next PWRKEY pulse
+#define MODEM_PWRKEY_MS        1000UL   // power-on pulse (< 2.5 s, which would power off)
+#define MODEM_BOOT_TIMEOUT_MS  20000UL
+#define MODEM_NET_HOLD_MS      60000UL  // LTE data lease, renewed by every use
+#define MODEM_PSM_ENABLED      1
+#define MODEM_PSM_TAU          "00000001"   // T3412 ext. periodic TAU: 10 min = worst SMS delay
+#define MODEM_PSM_ACTIVE       "00000101"   // T3324 active time: 10 s
+#define MODEM_EDRX_CYCLE       "0101"       // 81.92 s paging cycle (E-UTRAN)
+
+// MQTT telemetry uplink (telemetry.cpp)
+#ifndef TELEMETRY_ENABLED
+#define TELEMETRY_ENABLED 1
+#endif
+#define MQTT_HOST             "broker.example.com"
+#define MQTT_PORT             1883
+#define MQTT_USER             ""
+#define MQTT_PASS             ""
+#define MQTT_TOPIC_PREFIX     "beehive"
+#define MQTT_KEEPALIVE_S      60
+#define MQTT_CMD_TIMEOUT_MS   5000      // connect / PUBACK wait
+#define TELEMETRY_FORMAT_JSON   0
+#define TELEMETRY_FORMAT_BINARY 1       // telemetry_codec.h, ~25 B/record instead of ~100
+#define TELEMETRY_FORMAT      TELEMETRY_FORMAT_BINARY
+#define TELEMETRY_BATCH_MAX   8         // records per MQTT message
+#define TELEMETRY_KEYFRAME_EVERY 24     // full batch after this many delta batches
+#define TELEMETRY_SEQ_BLOCK   64        // batch seqs reserved per NVS write (seq survives reboots)
+#define TELEMETRY_FLUSH_S     900UL     // publish a partial batch once its oldest record is this old
+#define TELEMETRY_RETRY_MIN_S 15UL      // backoff after a failed connect/publish, doubling...
+#define TELEMETRY_RETRY_MAX_S 900UL     // ...up to this
+// Store-and-forward queue: ring file on SD, RAM ring when there is no card
+#define TELEMETRY_QUEUE_FILE  "/telemetry.q"
+#define TELEMETRY_QUEUE_CAP   4096UL    // records (~210 KB on SD)
+#define TELEMETRY_RAM_CAP     32
+
 // -----------------------------------------------------------------------------
 // Use Open-Meteo as the default weather provider (no API key required).
 // Set to 0 to keep previous OpenWeather code paths.
 #define USE_OPENMETEO 1
 
+// Forecast cache: served to the UI/key server until older than the TTL, then
+// refreshed in the background by weather_loop(). Failed refreshes retry after WEATHER_RETRY_S.
+#define WEATHER_CACHE_TTL_S   3600UL
+#define WEATHER_RETRY_S       300UL
+// A cache loaded from NVS has no age until the clock is set (NTP / LTE network time).
+// It is not judged stale for this long after boot, so a sync can arrive first.
+#define WEATHER_CLOCK_WAIT_S  300UL
+
+// HTTPS keep-alive pool (http_async): one connection per host, closed after
+// HTTP_KEEPALIVE_MS idle. Each open slot holds its TLS buffers (~40 KB heap).
+#define HTTP_POOL_SLOTS       2
+#define HTTP_KEEPALIVE_MS     30000UL
+
 // ---------------------------
 // Dual WiFi compile-time defaults
 // Primary network (SSID1) and Secondary network (SSID2)
 // These were provided by the user and are now hardcoded here.
+// The connectivity manager tries the network stored in NVS first, then these in order.
 #ifndef WIFI_SSID1
 #define WIFI_SSID1 "Redmi Note 13"
 #define WIFI_PASS1 "nen57asz5g44sh2"
@@ -126,4 +242,60 @@ extern int   test_rssi;
 // Set to 0 to require manual server start (menu action) instead.
 #ifndef AUTOSTART_KEYSERVER
 #define AUTOSTART_KEYSERVER 1
-#endif
\ No newline at end of file
+#endif
+
+// Key server connection slots. Each slot holds KS_REQ_BUF + KS_RESP_BUF bytes of static RAM.
+#define KS_MAX_CONN          4
+#define KS_REQ_BUF           1024     // request line + headers + form body
+#define KS_RESP_BUF          2048     // headers + response body
+#define KS_WRITE_CHUNK       536      // bytes handed to the socket per loop pass (one TCP MSS)
+#define KS_READ_TIMEOUT_MS   3000     // partial request / stalled write
+#define KS_KEEPALIVE_MS      5000     // idle keep-alive connection is closed after this
+#define KS_SSE_MAX_CLIENTS   2        // /events subscribers (each occupies a slot)
+#define KS_SSE_FRAME_MAX     384      // one "id/data" event with a measurement object
+#define KS_SSE_PING_MS       15000    // comment line to detect dead subscribers
+
+// -----------------------------------------------------------------------------
+// Firmware update (ota_manager). A new image must pass the health check (sampling,
+// heap, network) between OTA_HEALTH_MIN_MS and OTA_HEALTH_TIMEOUT_MS after boot and
+// may reboot at most OTA_MAX_TRIALS times, otherwise the previous image is restored.
+#define OTA_COMMIT_BYTES       (64UL * 1024UL)  // resume granularity (multiple of 4 KB)
+#define OTA_MAX_TRIALS         3
+#define OTA_HEALTH_MIN_MS      60000UL
+#define OTA_HEALTH_TIMEOUT_MS  600000UL
+#define OTA_HEALTH_MIN_HEAP    40000UL
+#define OTA_REBOOT_DELAY_MS    3000UL           // lets the HTTP reply go out first
+#define OTA_RETRY_MS           20000UL          // pull retry delay, times the attempt number
+#define OTA_PULL_MAX_RETRIES   10
+
+// Both OTA routes and POST /wifi need "Authorization: Bearer <token>". The token lives
+// in NVS "ota"; OTA_TOKEN (if set) replaces it at boot, otherwise a random one is
+// generated on first boot and printed to Serial. Pulls are only accepted from OTA_UPDATE_HOST (empty =
+// pull disabled), since the sha256 of a request only proves integrity, not origin.
+#define OTA_TOKEN              ""
+#define OTA_UPDATE_HOST        ""
+
+// -----------------------------------------------------------------------------
+// SMS commands (sms_handler): GEO:city,country / STATUS? / SET k=v;k=v.
+// Only senders in SMS_ALLOW_LIST (comma separated, compared on the trailing digits so
+// "+3069..." matches "069...") are obeyed. While it is empty only the read-only STATUS?
+// is answered; SET and GEO always need a listed sender. Replies are rate limited by a
+// token bucket: SMS_REPLY_BURST replies, one more every SMS_REPLY_REFILL_S.
+#define SMS_ALLOW_LIST        ""
+#define SMS_REPLY_BURST       3
+#define SMS_REPLY_REFILL_S    600UL
+
+// -----------------------------------------------------------------------------
+// Alerts (alert_engine). Thresholds below; hysteresis, minimum durations, cooldowns and
+// severities are in the rule table. Events within ALERT_COALESCE_S go out as one
+// message on the MQTT alert topic; critical ones (and warnings MQTT could not deliver)
+// also by SMS to ALERT_SMS_TO.
+#define ALERT_SMS_TO          ""        // international format, "" = no SMS alerts
+#define ALERT_COALESCE_S      120UL
+#define ALERT_MAX_EVENTS      8         // pending events; a full list is sent at once
+#define ALERT_WEIGHT_WINDOW_S 3600UL    // weight drop = max of this window - current
+#define ALERT_WEIGHT_DROP_KG  1.5f      // swarm / theft
+#define ALERT_BROOD_MIN_C     32.0f     // brood nest range, internal sensor
+#define ALERT_BROOD_MAX_C     37.0f
+#define ALERT_BATT_LOW_PCT    20.0f
+#define ALERT_TILT_DEG        20.0f     // from vertical (accelerometer z axis)
\ No newline at end of file
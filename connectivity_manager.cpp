@@ -0,0 +1,344 @@
+// connectivity_manager.cpp
+// - Single owner of WiFi station state and the A7670 data bearer (see header).
+// - Fast path: WiFi.begin(ssid, pass, channel, bssid) from the RTC cache, no scan.
+//   If that does not associate within CONN_FAST_TIMEOUT_MS the cache is dropped and an
+//   async scan picks the best known network.
+// - The NET power lock is held only while a scan or join is in progress.
+#include "connectivity_manager.h"
+#include "config.h"
+#include "modem_manager.h"
+#include "power_manager.h"
+#include "at_engine.h"
+#include "net_status.h"
+#include <WiFi.h>
+#include <Preferences.h>
+
+static const char *PREF_WIFI_NS   = "wifi_cfg";
+static const char *PREF_WIFI_SSID = "ssid";
+static const char *PREF_WIFI_PASS = "pass";
+
+struct WifiCred {
+  char    ssid[33];
+  char    pass[65];
+  uint8_t priority;   // 0 = most preferred
+};
+
+static WifiCred s_creds[CONN_MAX_CREDS];
+static int s_credCount = 0;
+
+// Last good AP, kept across deep sleep
+static const uint32_t FAST_MAGIC = 0xC0FFEE01;
+struct FastJoin {
+  uint32_t magic;
+  uint8_t  cred;
+  uint8_t  bssid[6];
+  int32_t  channel;
+};
+RTC_DATA_ATTR static FastJoin s_fast;
+
+static ConnState s_state = CONN_IDLE;
+static unsigned long s_stateSince = 0;
+static unsigned long s_attemptStart = 0;   // start of the current (re)connect
+static unsigned long s_lastRoamCheck = 0;
+static bool s_lockHeld = false;
+static int s_joinCred = -1;                // credential being joined / in use
+
+// Stats
+struct LatencyStat { uint32_t count, totalMs, maxMs; };
+static LatencyStat s_fastStat, s_scanStat;
+static uint32_t s_fastMisses = 0;
+static uint32_t s_roams = 0;
+static uint32_t s_drops = 0;
+
+static const char *STATE_NAMES[] = {
+  "IDLE", "FAST_JOIN", "SCANNING", "JOINING", "CONNECTED", "ROAM_SCAN", "BACKOFF"
+};
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static void setState(ConnState s) {
+  s_state = s;
+  s_stateSince = millis();
+  bool busy = (s == CONN_FAST_JOIN || s == CONN_SCANNING || s == CONN_JOINING || s == CONN_ROAM_SCAN);
+  if (busy && !s_lockHeld) { power_acquire(PWR_LOCK_NET); s_lockHeld = true; }
+  if (!busy && s_lockHeld) { power_release(PWR_LOCK_NET); s_lockHeld = false; }
+}
+
+static void addCred(const char *ssid, const char *pass, uint8_t priority) {
+  if (!ssid || !ssid[0] || s_credCount >= CONN_MAX_CREDS) return;
+  for (int i = 0; i < s_credCount; ++i) if (strcmp(s_creds[i].ssid, ssid) == 0) return;
+  WifiCred &c = s_creds[s_credCount++];
+  strncpy(c.ssid, ssid, sizeof(c.ssid) - 1);
+  c.ssid[sizeof(c.ssid) - 1] = 0;
+  strncpy(c.pass, pass ? pass : "", sizeof(c.pass) - 1);
+  c.pass[sizeof(c.pass) - 1] = 0;
+  c.priority = priority;
+}
+
+static void loadCreds() {
+  s_credCount = 0;
+  Preferences p;
+  p.begin(PREF_WIFI_NS, true);
+  String ssid = p.getString(PREF_WIFI_SSID, "");
+  String pass = p.getString(PREF_WIFI_PASS, "");
+  p.end();
+  addCred(ssid.c_str(), pass.c_str(), 0);
+  addCred(WIFI_SSID1, WIFI_PASS1, 1);
+  addCred(WIFI_SSID2, WIFI_PASS2, 2);
+}
+
+static int findCred(const String &ssid) {
+  for (int i = 0; i < s_credCount; ++i) if (ssid == s_creds[i].ssid) return i;
+  return -1;
+}
+
+static int score(int cred, int32_t rssi) {
+  return rssi - s_creds[cred].priority * CONN_PRIORITY_DB;
+}
+
+static bool wifiAllowed() {
+  return connectivityMode != CONNECTIVITY_OFFLINE;
+}
+
+// Async scan; roam = stay connected meanwhile and only switch for a clearly better AP
+static void startScan(bool roam) {
+  WiFi.scanDelete();
+  if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) {
+    Serial.println("[Conn] scan start failed");
+    setState(roam ? CONN_CONNECTED : CONN_BACKOFF);
+    return;
+  }
+  setState(roam ? CONN_ROAM_SCAN : CONN_SCANNING);
+}
+
+static void join(int cred, int32_t channel, const uint8_t *bssid) {
+  s_joinCred = cred;
+  Serial.printf("[Conn] joining %s (ch %ld)\n", s_creds[cred].ssid, (long)channel);
+  WiFi.begin(s_creds[cred].ssid, s_creds[cred].pass, channel, bssid, true);
+}
+
+// Start a (re)connect: cached AP first, scan otherwise
+static void beginAttempt() {
+  if (!wifiAllowed() || s_credCount == 0) { setState(CONN_IDLE); return; }
+  s_attemptStart = millis();
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false);   // reconnects are ours, with the cached BSSID
+  if (s_fast.magic == FAST_MAGIC && s_fast.cred < s_credCount) {
+    join(s_fast.cred, s_fast.channel, s_fast.bssid);
+    setState(CONN_FAST_JOIN);
+  } else {
+    WiFi.disconnect(false);
+    startScan(false);
+  }
+}
+
+static void recordLatency(LatencyStat &st, const char *path) {
+  uint32_t ms = millis() - s_attemptStart;
+  st.count++;
+  st.totalMs += ms;
+  if (ms > st.maxMs) st.maxMs = ms;
+  Serial.printf("[Conn] connected to %s via %s in %lu ms, IP ", s_creds[s_joinCred].ssid, path,
+                (unsigned long)ms);
+  Serial.println(WiFi.localIP());
+}
+
+static void onConnected(bool fast) {
+  recordLatency(fast ? s_fastStat : s_scanStat, fast ? "cache" : "scan");
+  s_fast.magic = FAST_MAGIC;
+  s_fast.cred = (uint8_t)s_joinCred;
+  s_fast.channel = WiFi.channel();
+  const uint8_t *b = WiFi.BSSID();
+  if (b) memcpy(s_fast.bssid, b, 6);
+  s_lastRoamCheck = millis();
+  setState(CONN_CONNECTED);
+}
+
+// Best known network in the scan results (index into the results, -1 if none)
+static int pickFromScan(int n, int *credOut) {
+  int best = -1, bestScore = -1000;
+  for (int i = 0; i < n; ++i) {
+    int c = findCred(WiFi.SSID(i));
+    if (c < 0 || WiFi.RSSI(i) < CONN_MIN_RSSI) continue;
+    int sc = score(c, WiFi.RSSI(i));
+    if (sc > bestScore) { best = i; bestScore = sc; *credOut = c; }
+  }
+  return best;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void connectivity_init() {
+  loadCreds();
+  Serial.printf("[Conn] %d WiFi credentials, fast-join cache %s\n", s_credCount,
+                s_fast.magic == FAST_MAGIC ? "valid" : "empty");
+  beginAttempt();
+}
+
+void connectivity_connect() {
+  if (s_state == CONN_CONNECTED || s_state == CONN_ROAM_SCAN) return;
+  beginAttempt();
+}
+
+void connectivity_setCredentials(const char *ssid, const char *pass) {
+  Preferences p;
+  p.begin(PREF_WIFI_NS, false);
+  p.putString(PREF_WIFI_SSID, ssid ? ssid : "");
+  p.putString(PREF_WIFI_PASS, pass ? pass : "");
+  p.end();
+  loadCreds();
+  s_fast.magic = 0;
+  WiFi.disconnect(false);
+  beginAttempt();
+}
+
+void connectivity_loop() {
+  unsigned long now = millis();
+  unsigned long inState = now - s_stateSince;
+
+  if (!wifiAllowed() && s_state != CONN_IDLE) {
+    WiFi.disconnect(false);
+    setState(CONN_IDLE);
+    return;
+  }
+
+  switch (s_state) {
+    case CONN_FAST_JOIN:
+      if (WiFi.status() == WL_CONNECTED) { onConnected(true); break; }
+      if (inState > CONN_FAST_TIMEOUT_MS) {
+        Serial.println("[Conn] cached AP did not answer, scanning");
+        s_fastMisses++;
+        s_fast.magic = 0;
+        WiFi.disconnect(false);
+        startScan(false);
+      }
+      break;
+
+    case CONN_SCANNING:
+    case CONN_ROAM_SCAN: {
+      int n = WiFi.scanComplete();
+      if (n == WIFI_SCAN_RUNNING) {
+        if (inState > CONN_SCAN_TIMEOUT_MS) { WiFi.scanDelete(); setState(s_state == CONN_ROAM_SCAN ? CONN_CONNECTED : CONN_BACKOFF); }
+        break;
+      }
+      int cred = -1;
+      int i = n > 0 ? pickFromScan(n, &cred) : -1;
+
+      if (s_state == CONN_ROAM_SCAN) {
+        // switch only if clearly better than the current link (hysteresis)
+        int cur = score(s_joinCred, WiFi.RSSI());
+        const uint8_t *b = i >= 0 ? WiFi.BSSID(i) : nullptr;
+        bool sameAp = b && WiFi.BSSID() && memcmp(b, WiFi.BSSID(), 6) == 0;
+        if (i >= 0 && !sameAp && score(cred, WiFi.RSSI(i)) >= cur + CONN_HYSTERESIS_DB) {
+          Serial.printf("[Conn] roaming to %s (%ld dBm)\n", s_creds[cred].ssid, (long)WiFi.RSSI(i));
+          s_roams++;
+          s_attemptStart = now;
+          join(cred, WiFi.channel(i), b);
+          WiFi.scanDelete();
+          setState(CONN_JOINING);
+        } else {
+          WiFi.scanDelete();
+          setState(CONN_CONNECTED);
+        }
+        break;
+      }
+
+      if (i < 0) {
+        Serial.println("[Conn] no known network in range");
+        WiFi.scanDelete();
+        setState(CONN_BACKOFF);
+        break;
+      }
+      join(cred, WiFi.channel(i), WiFi.BSSID(i));
+      WiFi.scanDelete();
+      setState(CONN_JOINING);
+      break;
+    }
+
+    case CONN_JOINING:
+      if (WiFi.status() == WL_CONNECTED) { onConnected(false); break; }
+      if (inState > CONN_JOIN_TIMEOUT_MS) {
+        Serial.println("[Conn] join timed out");
+        WiFi.disconnect(false);
+        setState(CONN_BACKOFF);
+      }
+      break;
+
+    case CONN_CONNECTED:
+      if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("[Conn] link lost, reconnecting");
+        s_drops++;
+        beginAttempt();
+        break;
+      }
+      if (now - s_lastRoamCheck > CONN_ROAM_CHECK_S * 1000UL) {
+        s_lastRoamCheck = now;
+        if (WiFi.RSSI() < CONN_WEAK_RSSI && s_credCount > 1) startScan(true);
+      }
+      break;
+
+    case CONN_BACKOFF:
+      if (inState > CONN_RETRY_S * 1000UL) beginAttempt();
+      break;
+
+    default:
+      break;
+  }
+}
+
+bool connectivity_wifiConnected() { return WiFi.status() == WL_CONNECTED; }
+ConnState connectivity_state() { return s_state; }
+const char *connectivity_stateName() { return STATE_NAMES[s_state]; }
+
+bool connectivity_waitConnected(unsigned long timeoutMs) {
+  unsigned long start = millis();
+  while (!connectivity_wifiConnected() && millis() - start < timeoutMs) {
+    connectivity_loop();
+    if (s_state == CONN_IDLE || s_state == CONN_BACKOFF) break;
+    delay(50);
+  }
+  connectivity_loop();
+  return connectivity_wifiConnected();
+}
+
+// ---------------------------------------------------------------------------
+// LTE
+// ---------------------------------------------------------------------------
+bool connectivity_lteRegistered() {
+  if (!modem_isReady()) return false;
+  // While the modem is powered down by the power policy this is the last known state,
+  // so LTE still counts as an option; connectivity_lteDataUp(true) wakes the modem
+  return netStatus_lteRegistered();
+}
+
+bool connectivity_lteDataUp(bool attach) {
+  // Radio time for the bearer; a powered-down modem starts booting and the caller retries
+  if (attach && !modem_acquire(MODEM_LEASE_NET, MODEM_NET_HOLD_MS)) return false;
+  if (!modem_isOn() || !connectivity_lteRegistered()) return false;
+  power_acquire(PWR_LOCK_UART);
+  if (!at_waitIdle(AT_FENCE_MS)) {   // AT command still running: do not talk over it
+    power_release(PWR_LOCK_UART);
+    return false;
+  }
+  bool up = modem_get().isGprsConnected();
+  if (!up && attach) {
+    Serial.println("[Conn] attaching LTE data bearer");
+    unsigned long t0 = millis();
+    up = modem_get().gprsConnect(MODEM_APN, MODEM_GPRS_USER, MODEM_GPRS_PASS);
+    Serial.printf("[Conn] bearer %s after %lu ms\n", up ? "up" : "failed", millis() - t0);
+  }
+  power_release(PWR_LOCK_UART);
+  return up;
+}
+
+void connectivity_printStats() {
+  Serial.printf("[Conn] state %s, drops=%lu roams=%lu cache misses=%lu\n", STATE_NAMES[s_state],
+                (unsigned long)s_drops, (unsigned long)s_roams, (unsigned long)s_fastMisses);
+  Serial.printf("[Conn] reconnect via cache: n=%lu avg=%lums max=%lums\n", (unsigned long)s_fastStat.count,
+                (unsigned long)(s_fastStat.count ? s_fastStat.totalMs / s_fastStat.count : 0),
+                (unsigned long)s_fastStat.maxMs);
+  Serial.printf("[Conn] reconnect via scan:  n=%lu avg=%lums max=%lums\n", (unsigned long)s_scanStat.count,
+                (unsigned long)(s_scanStat.count ? s_scanStat.totalMs / s_scanStat.count : 0),
+                (unsigned long)s_scanStat.maxMs);
+}
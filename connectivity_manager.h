@@ -0,0 +1,52 @@
+#ifndef CONNECTIVITY_MANAGER_H
+#define CONNECTIVITY_MANAGER_H
+
+#include <Arduino.h>
+
+// Owns the WiFi station and the LTE data bearer.
+// - Credential list with priority: the network stored in NVS ("wifi_cfg": ssid/pass) first,
+//   then WIFI_SSID1 and WIFI_SSID2 from config.h.
+// - The last good SSID/BSSID/channel is kept in RTC memory, so a reconnect (also after
+//   deep sleep) joins the AP directly without a scan. Scans, when needed, are asynchronous.
+// - While connected, a weak link triggers a background scan; another network is joined
+//   only if it scores CONN_HYSTERESIS_DB better (score = RSSI - priority * CONN_PRIORITY_DB).
+// - All calls are non-blocking; connectivity_loop() drives the state machine.
+
+enum ConnState {
+  CONN_IDLE = 0,      // not started, or connectivityMode has no WiFi
+  CONN_FAST_JOIN,     // joining the cached BSSID/channel
+  CONN_SCANNING,      // async scan for a known network
+  CONN_JOINING,       // joining the network picked from the scan
+  CONN_CONNECTED,
+  CONN_ROAM_SCAN,     // connected, scanning for a better network
+  CONN_BACKOFF        // nothing found, retry after CONN_RETRY_S
+};
+
+// Load credentials and start connecting (call from setup)
+void connectivity_init();
+
+// Drive scans/joins/roaming (call from loop)
+void connectivity_loop();
+
+// (Re)start a connection attempt now, e.g. after new credentials were stored
+void connectivity_connect();
+
+// Store the provisioned network (highest priority) and reconnect
+void connectivity_setCredentials(const char *ssid, const char *pass);
+
+bool connectivity_wifiConnected();
+ConnState connectivity_state();
+const char *connectivity_stateName();
+
+// Block up to timeoutMs for WiFi, running the state machine (setup-time convenience)
+bool connectivity_waitConnected(unsigned long timeoutMs);
+
+// LTE: registered on the network (net_status cache, no AT round trip)
+bool connectivity_lteRegistered();
+// LTE packet data bearer up; attach = bring it up if needed (blocks a few seconds)
+bool connectivity_lteDataUp(bool attach);
+
+// Reconnect latency (fast path vs. scan path) and roaming counters
+void connectivity_printStats();
+
+#endif // CONNECTIVITY_MANAGER_H
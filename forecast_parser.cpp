@@ -0,0 +1,109 @@
+// forecast_parser.cpp
+// - Open-Meteo hourly forecast -> WeatherDay slots, fed chunk by chunk from the HTTP body.
+// - Every scalar the tokenizer reports is matched on its path (hourly.<field>[idx]);
+//   anything outside the sampled indices is dropped without being stored.
+#include "forecast_parser.h"
+#include "json_stream.h"
+#include <math.h>
+
+static_assert(FORECAST_SAMPLES <= WEATHER_MAX_DAYS, "forecast samples exceed WeatherDay storage");
+
+enum { HAVE_TIME = 1, HAVE_TEMP = 2, HAVE_CODE = 4, HAVE_HUM = 8, HAVE_PRESS = 16 };
+
+static WeatherDay s_slots[FORECAST_SAMPLES];
+static uint8_t s_slotHave[FORECAST_SAMPLES];   // HAVE_* bits per slot
+static int32_t s_slotOffset = 0;               // utc_offset_seconds of the response
+static JsonStream s_json;
+
+// Map Open-Meteo weathercode to our condensed WeatherCode
+static WeatherCode mapWeatherCodeOpenMeteo(int code) {
+  switch(code) {
+    case 0: return WX_CLEAR;
+    case 1: case 2: case 3: return WX_PARTLY_CLOUDY;
+    case 45: case 48: return WX_FOG;
+    case 51: case 53: case 55: return WX_DRIZZLE;
+    case 61: case 63: case 65: return WX_RAIN;
+    case 71: case 73: case 75: return WX_SNOW;
+    case 80: case 81: case 82: return WX_SHOWERS;
+    case 95: case 96: case 99: return WX_THUNDER;
+    default: return WX_UNKNOWN;
+  }
+}
+
+static void onForecastValue(const JsonStream &js, const char *value, uint8_t len, bool quoted, void *ctx) {
+  (void)ctx; (void)len;
+  if (!quoted && strcmp(value, "null") == 0) return;
+
+  // top-level utc_offset_seconds
+  if (js.depth == 1) {
+    if (strcmp(js.key[0], "utc_offset_seconds") == 0) s_slotOffset = atol(value);
+    return;
+  }
+
+  // hourly.<field>[idx]
+  if (js.depth != 3 || js.isArray[0] || js.isArray[1] || !js.isArray[2]) return;
+  if (strcmp(js.key[0], "hourly") != 0) return;
+  uint16_t idx = js.index[2];
+  if (idx % FORECAST_STEP != 0 || idx >= FORECAST_HOURS) return;
+
+  WeatherDay &d = s_slots[idx / FORECAST_STEP];
+  uint8_t &have = s_slotHave[idx / FORECAST_STEP];
+  const char *field = js.key[1];
+  if (strcmp(field, "time") == 0) {
+    d.time = (uint32_t)strtoul(value, nullptr, 10);
+    have |= HAVE_TIME;
+  } else if (strcmp(field, "temperature_2m") == 0) {
+    d.temp_c10 = (int16_t)lroundf(atof(value) * 10.0f);
+    have |= HAVE_TEMP;
+  } else if (strcmp(field, "weathercode") == 0) {
+    d.code = mapWeatherCodeOpenMeteo(atoi(value));
+    have |= HAVE_CODE;
+  } else if (strcmp(field, "relativehumidity_2m") == 0) {
+    float h = atof(value);
+    d.humidity = (uint8_t)constrain(lroundf(h), 0L, 100L);
+    have |= HAVE_HUM;
+  } else if (strcmp(field, "surface_pressure") == 0) {
+    // Open-Meteo surface_pressure is hPa; a value that looks like Pa (>2000) is converted
+    float pr = atof(value);
+    if (pr > 2000.0f) pr /= 100.0f;
+    d.press_10 = (uint16_t)lroundf(pr * 10.0f);
+    have |= HAVE_PRESS;
+  }
+}
+
+void forecastParser_begin() {
+  memset(s_slots, 0, sizeof(s_slots));
+  memset(s_slotHave, 0, sizeof(s_slotHave));
+  s_slotOffset = 0;
+  jsonStream_begin(s_json, onForecastValue, nullptr);
+}
+
+bool forecastParser_feed(const uint8_t *data, size_t len) {
+  return jsonStream_feed(s_json, data, len);
+}
+
+int forecastParser_finish(WeatherDay *out, int max, int32_t &utcOffset, const char *&err) {
+  if (!jsonStream_done(s_json)) {
+    err = "JSON truncated";
+    return 0;
+  }
+
+  int samples = 0;
+  while (samples < FORECAST_SAMPLES && samples < max &&
+         (s_slotHave[samples] & (HAVE_TIME | HAVE_TEMP)) == (HAVE_TIME | HAVE_TEMP))
+    samples++;
+
+  if (samples == 0) {
+    err = (s_slotHave[0] & HAVE_TIME) ? "Incomplete hourly data" : "No hourly data";
+    return 0;
+  }
+
+  // missing optional fields stay 0 (from the memset), an unknown code is WX_UNKNOWN
+  for (int i = 0; i < samples; ++i) {
+    if (!(s_slotHave[i] & HAVE_CODE)) s_slots[i].code = WX_UNKNOWN;
+  }
+  memcpy(out, s_slots, sizeof(WeatherDay) * samples);
+  utcOffset = s_slotOffset;
+  err = "";
+  return samples;
+}
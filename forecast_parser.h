@@ -0,0 +1,28 @@
+#ifndef FORECAST_PARSER_H
+#define FORECAST_PARSER_H
+
+#include <Arduino.h>
+#include "weather_manager.h"
+
+// Streaming extraction of the Open-Meteo hourly forecast.
+// The body is tokenized (json_stream) as it downloads and only every FORECAST_STEP-th
+// element of the hourly arrays for the next FORECAST_HOURS is written into a WeatherDay
+// slot. No response buffer and no JSON document: the whole state is one JsonStream plus
+// the slots, in static memory. Pure C++, so it also builds on a host.
+
+#define FORECAST_HOURS   72
+#define FORECAST_STEP    6
+#define FORECAST_SAMPLES (FORECAST_HOURS / FORECAST_STEP)
+
+// Start a new response
+void forecastParser_begin();
+
+// Feed the next chunk of the body. Returns false on a JSON syntax error.
+bool forecastParser_feed(const uint8_t *data, size_t len);
+
+// After the last chunk: copy the leading samples that have a time and a temperature into
+// out (up to max) and the response's utc_offset_seconds into utcOffset. Returns the
+// sample count; 0 with err set if the body was truncated or has no usable hourly data.
+int forecastParser_finish(WeatherDay *out, int max, int32_t &utcOffset, const char *&err);
+
+#endif // FORECAST_PARSER_H
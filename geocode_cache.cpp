@@ -0,0 +1,169 @@
+// geocode_cache.cpp
+// - Persistent LRU of (city, country) -> (lat, lon, name, country) geocoding results.
+// - Keys are normalized: trimmed, inner whitespace collapsed, city lower-case,
+//   country code upper-case. Coordinates are stored as micro-degrees.
+// - The whole table is one fixed-size NVS blob ("geo_cache"), rewritten on every change;
+//   geocodes are rare (setup form, SMS GEO:, provisioning UI) so wear is negligible.
+#include "geocode_cache.h"
+#include <Preferences.h>
+
+static const char *PREF_NS = "beehive";
+static const char *PREF_KEY_GEO = "geo_cache";
+static const uint8_t GEO_VERSION = 1;
+
+struct GeoEntry {
+  char     city[32];     // normalized key
+  char     cc[4];        // normalized ISO-3166 alpha-2, "" = any
+  int32_t  lat_e6;
+  int32_t  lon_e6;
+  uint32_t lastUse;      // LRU stamp, 0 = empty slot
+  char     name[32];
+  char     country[24];
+};
+
+struct GeoBlob {
+  uint8_t  version;
+  uint8_t  reserved[3];
+  uint32_t clock;        // last LRU stamp handed out
+  GeoEntry e[GEOCACHE_ENTRIES];
+};
+
+static GeoBlob  s_blob;
+static bool     s_loaded = false;
+static uint32_t s_hits = 0;
+static uint32_t s_misses = 0;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static void normalize(const char *in, char *out, size_t len, bool upper) {
+  size_t n = 0;
+  bool space = false;
+  if (in) {
+    for (; *in && n < len - 1; ++in) {
+      char c = *in;
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n') { space = n > 0; continue; }
+      if (space && n < len - 2) out[n++] = ' ';
+      space = false;
+      out[n++] = upper ? toupper((unsigned char)c) : tolower((unsigned char)c);
+    }
+  }
+  out[n] = 0;
+}
+
+static void copyStr(char *dst, size_t len, const char *src) {
+  strncpy(dst, src ? src : "", len - 1);
+  dst[len - 1] = 0;
+}
+
+static void save() {
+  Preferences p;
+  p.begin(PREF_NS, false);
+  p.putBytes(PREF_KEY_GEO, &s_blob, sizeof(s_blob));
+  p.end();
+}
+
+static GeoEntry *find(const char *city, const char *cc) {
+  for (int i = 0; i < GEOCACHE_ENTRIES; ++i) {
+    GeoEntry &e = s_blob.e[i];
+    if (e.lastUse && strcmp(e.city, city) == 0 && strcmp(e.cc, cc) == 0) return &e;
+  }
+  return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void geocache_init() {
+  if (s_loaded) return;
+  s_loaded = true;
+  Preferences p;
+  p.begin(PREF_NS, true);
+  size_t n = p.getBytes(PREF_KEY_GEO, &s_blob, sizeof(s_blob));
+  p.end();
+  if (n != sizeof(s_blob) || s_blob.version != GEO_VERSION) {
+    memset(&s_blob, 0, sizeof(s_blob));
+    s_blob.version = GEO_VERSION;
+  }
+}
+
+bool geocache_lookup(const char *city, const char *countryCode, GeoResult &out) {
+  geocache_init();
+  char key[sizeof(GeoEntry::city)], cc[sizeof(GeoEntry::cc)];
+  normalize(city, key, sizeof(key), false);
+  normalize(countryCode, cc, sizeof(cc), true);
+
+  GeoEntry *e = key[0] ? find(key, cc) : nullptr;
+  if (!e) {
+    s_misses++;
+    Serial.printf("[GeoCache] miss '%s' [%s] (hits=%lu misses=%lu)\n", key, cc,
+                  (unsigned long)s_hits, (unsigned long)s_misses);
+    return false;
+  }
+
+  s_hits++;
+  e->lastUse = ++s_blob.clock;
+  save();   // keep the LRU order across reboots
+
+  out.lat = e->lat_e6 / 1e6;
+  out.lon = e->lon_e6 / 1e6;
+  copyStr(out.name, sizeof(out.name), e->name);
+  copyStr(out.country, sizeof(out.country), e->country);
+  Serial.printf("[GeoCache] hit '%s' [%s] -> %.6f,%.6f (hits=%lu misses=%lu)\n", key, cc,
+                out.lat, out.lon, (unsigned long)s_hits, (unsigned long)s_misses);
+  return true;
+}
+
+void geocache_store(const char *city, const char *countryCode, const GeoResult &res) {
+  geocache_init();
+  char key[sizeof(GeoEntry::city)], cc[sizeof(GeoEntry::cc)];
+  normalize(city, key, sizeof(key), false);
+  normalize(countryCode, cc, sizeof(cc), true);
+  if (!key[0]) return;
+
+  GeoEntry *e = find(key, cc);
+  if (!e) {
+    // free slot, else the least recently used one
+    e = &s_blob.e[0];
+    for (int i = 0; i < GEOCACHE_ENTRIES; ++i) {
+      GeoEntry &c = s_blob.e[i];
+      if (c.lastUse == 0) { e = &c; break; }
+      if (c.lastUse < e->lastUse) e = &c;
+    }
+    if (e->lastUse) Serial.printf("[GeoCache] evict '%s' [%s]\n", e->city, e->cc);
+  }
+
+  memset(e, 0, sizeof(*e));
+  copyStr(e->city, sizeof(e->city), key);
+  copyStr(e->cc, sizeof(e->cc), cc);
+  e->lat_e6 = (int32_t)lround(res.lat * 1e6);
+  e->lon_e6 = (int32_t)lround(res.lon * 1e6);
+  copyStr(e->name, sizeof(e->name), res.name);
+  copyStr(e->country, sizeof(e->country), res.country);
+  e->lastUse = ++s_blob.clock;
+  save();
+}
+
+void geocache_clear() {
+  memset(&s_blob, 0, sizeof(s_blob));
+  s_blob.version = GEO_VERSION;
+  s_loaded = true;
+  save();
+}
+
+uint32_t geocache_hits()   { return s_hits; }
+uint32_t geocache_misses() { return s_misses; }
+
+int geocache_count() {
+  geocache_init();
+  int n = 0;
+  for (int i = 0; i < GEOCACHE_ENTRIES; ++i) if (s_blob.e[i].lastUse) n++;
+  return n;
+}
+
+void geocache_printStats() {
+  uint32_t total = s_hits + s_misses;
+  Serial.printf("[GeoCache] %d/%d entries, hits=%lu misses=%lu (%lu%% hit rate)\n",
+                geocache_count(), GEOCACHE_ENTRIES, (unsigned long)s_hits, (unsigned long)s_misses,
+                total ? (unsigned long)(s_hits * 100UL / total) : 0UL);
+}
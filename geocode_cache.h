@@ -0,0 +1,36 @@
+#ifndef GEOCODE_CACHE_H
+#define GEOCODE_CACHE_H
+
+#include <Arduino.h>
+
+// Small persistent LRU of geocoding results, keyed by normalized (city, country).
+// Lookups are case/whitespace-insensitive ("  new   York" == "New York").
+// Stored as one NVS blob; hit/miss counters are kept since boot.
+
+#define GEOCACHE_ENTRIES 8
+
+struct GeoResult {
+  double lat;
+  double lon;
+  char   name[32];     // place name as returned by the geocoder
+  char   country[24];  // country name as returned by the geocoder
+};
+
+// Load the cache from NVS (called lazily by lookup/store as well)
+void geocache_init();
+
+// Return true and fill out if (city, countryCode) is cached. countryCode may be null/empty.
+bool geocache_lookup(const char *city, const char *countryCode, GeoResult &out);
+
+// Insert or refresh an entry; the least recently used one is evicted when full
+void geocache_store(const char *city, const char *countryCode, const GeoResult &res);
+
+// Drop all entries (NVS included)
+void geocache_clear();
+
+uint32_t geocache_hits();
+uint32_t geocache_misses();
+int      geocache_count();
+void     geocache_printStats();
+
+#endif // GEOCODE_CACHE_H
@@ -0,0 +1,461 @@
+// http_async.cpp
+// - Non-blocking HTTPS GET engine used by the weather and geocoding code.
+// - Runs over WiFi or the A7670 LTE link, whichever net_transport selects; over LTE the
+//   modem resolves the host and terminates TLS itself, so CONNECT is a no-op.
+// - Explicit phases: CONNECT (DNS) -> TLS (TCP + handshake) -> SEND -> RECEIVE -> PARSE.
+// - Each phase has its own timeout; RECEIVE times out on inactivity, not total time.
+// - Headers are parsed byte by byte into a fixed line buffer; chunked bodies are decoded
+//   on the fly and handed to the caller's sink as they arrive.
+// - DNS and the TLS handshake are single blocking calls inside the WiFi stack or one modem
+//   AT exchange (bounded by the resolver timeout and TLS_TIMEOUT_MS); cancel takes effect
+//   on the next poll.
+// - Phase latencies go into fixed log-scale histograms (httpAsync_printStats()).
+// - Connections are pooled per host and transport (HTTP_POOL_SLOTS) and kept alive for HTTP_KEEPALIVE_MS
+//   after a cleanly framed response, so requests made close together skip DNS and the TLS
+//   handshake. A reused socket the server already closed is retried once with a fresh one.
+#include "http_async.h"
+#include "config.h"
+#include "power_manager.h"
+#include "net_transport.h"
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+
+static const unsigned long TLS_TIMEOUT_MS     = 10000;
+static const unsigned long SEND_TIMEOUT_MS    = 5000;
+static const unsigned long RECEIVE_IDLE_MS    = 8000;
+static const size_t        POLL_BUDGET_BYTES  = 2048;   // max bytes consumed per poll
+
+// Keep-alive pool: one TLS client per slot, bound to the host and transport it is connected to
+struct PoolSlot {
+  Client *client;
+  NetTransport transport;
+  char host[64];
+  unsigned long idleSince;   // millis() when the last response completed
+  bool idle;                 // connected, no request in flight, reusable
+};
+static PoolSlot s_pool[HTTP_POOL_SLOTS];
+static PoolSlot *s_slot = nullptr;
+static Client *s_client = nullptr;
+static NetTransport s_transport = NET_NONE;
+static unsigned long s_connectStart = 0;
+static bool s_reused = false;        // current request runs on a kept-alive socket
+static bool s_serverClose = false;   // response carried "Connection: close"
+static uint32_t s_handshakes = 0;
+static uint32_t s_reuses = 0;
+
+static HttpPhase s_phase = HTTP_IDLE;
+static unsigned long s_phaseStart = 0;
+static unsigned long s_lastRx = 0;
+
+static char s_host[64];
+static char s_path[320];
+static IPAddress s_ip;
+static HttpBodySink s_onBody = nullptr;
+static HttpParseFn  s_onParse = nullptr;
+static void *s_ctx = nullptr;
+
+static char s_err[64] = "";
+static int  s_status = 0;
+static uint32_t s_nextRange = 0;     // set by httpAsync_setRangeStart() for the next start
+static uint32_t s_range = 0;         // range of the current request, 0 = whole body
+
+// Response parsing state
+static char     s_line[192];
+static size_t   s_lineLen = 0;
+static bool     s_inHeaders = true;
+static int32_t  s_contentLength = -1;
+static uint32_t s_bodyBytes = 0;
+static bool     s_chunked = false;
+
+enum ChunkState { CH_SIZE, CH_DATA, CH_DATA_END, CH_TRAILER, CH_DONE };
+static ChunkState s_chunkState = CH_SIZE;
+static uint32_t   s_chunkLeft = 0;
+
+// Latency histograms: bucket upper bounds in ms, last bucket is open-ended
+static const uint16_t BUCKET_MS[] = { 50, 100, 200, 500, 1000, 2000, 5000 };
+static const int BUCKETS = sizeof(BUCKET_MS) / sizeof(BUCKET_MS[0]) + 1;
+static uint16_t s_hist[HTTP_PHASE_COUNT][BUCKETS];
+static uint32_t s_phaseTotalMs[HTTP_PHASE_COUNT];
+
+static const char *PHASE_NAMES[HTTP_PHASE_COUNT] = {
+  "IDLE", "CONNECT", "TLS", "SEND", "RECEIVE", "PARSE", "DONE", "FAILED", "CANCELLED"
+};
+
+static void recordLatency(HttpPhase p, unsigned long ms) {
+  int b = 0;
+  while (b < BUCKETS - 1 && ms >= BUCKET_MS[b]) b++;
+  if (s_hist[p][b] < 0xFFFF) s_hist[p][b]++;
+  s_phaseTotalMs[p] += ms;
+}
+
+static void enterPhase(HttpPhase next) {
+  unsigned long now = millis();
+  if (s_phase >= HTTP_CONNECT && s_phase <= HTTP_PARSE) recordLatency(s_phase, now - s_phaseStart);
+  s_phase = next;
+  s_phaseStart = now;
+  if (next == HTTP_RECEIVE) s_lastRx = now;
+}
+
+static void finish(HttpPhase endPhase, const char *err) {
+  if (err) {
+    strncpy(s_err, err, sizeof(s_err) - 1);
+    s_err[sizeof(s_err) - 1] = 0;
+    Serial.printf("[HTTP] %s %s: %s\n", PHASE_NAMES[s_phase], s_host, s_err);
+  }
+  s_client->stop();
+  s_slot->idle = false;
+  enterPhase(endPhase);
+  power_release(PWR_LOCK_NET);
+}
+
+static bool slotExpired(PoolSlot &sl, unsigned long now) {
+  return now - sl.idleSince > HTTP_KEEPALIVE_MS || !sl.client->connected();
+}
+
+static void closeSlot(PoolSlot &sl) {
+  if (sl.client) sl.client->stop();
+  sl.idle = false;
+}
+
+// Idle connection to host over transport t if one is still usable, else a free slot or
+// the oldest idle one (rebound to t). Returns null if t has no client.
+static PoolSlot *pickSlot(const char *host, NetTransport t) {
+  unsigned long now = millis();
+  PoolSlot *pick = nullptr;
+  for (int i = 0; i < HTTP_POOL_SLOTS; ++i) {
+    PoolSlot &sl = s_pool[i];
+    if (sl.idle && slotExpired(sl, now)) closeSlot(sl);
+    if (sl.idle && sl.transport == t && strcmp(sl.host, host) == 0) return &sl;
+  }
+  for (int i = 0; i < HTTP_POOL_SLOTS; ++i) {
+    PoolSlot &sl = s_pool[i];
+    if (!sl.idle) { pick = &sl; break; }
+    if (!pick || sl.idleSince < pick->idleSince) pick = &sl;
+  }
+  closeSlot(*pick);
+  pick->client = netTransport_tlsClient(t, pick - s_pool);
+  if (!pick->client) return nullptr;
+  pick->transport = t;
+  strcpy(pick->host, host);
+  return pick;
+}
+
+// The kept-alive socket turned out to be dead: start over with a fresh connection
+static void retryFresh(const char *why) {
+  Serial.printf("[HTTP] reused connection to %s %s, reconnecting\n", s_host, why);
+  s_client->stop();
+  s_reused = false;
+  s_status = 0;
+  s_lineLen = 0;
+  s_inHeaders = true;
+  enterPhase(HTTP_CONNECT);
+}
+
+bool httpAsync_start(const char *host, const char *path,
+                     HttpBodySink onBody, HttpParseFn onParse, void *ctx) {
+  if (httpAsync_busy()) return false;
+  if (strlen(host) >= sizeof(s_host) || strlen(path) >= sizeof(s_path)) {
+    strcpy(s_err, "URL too long");
+    s_phase = HTTP_FAILED;
+    return false;
+  }
+  strcpy(s_host, host);
+  strcpy(s_path, path);
+  s_onBody = onBody;
+  s_onParse = onParse;
+  s_ctx = ctx;
+
+  s_err[0] = 0;
+  s_status = 0;
+  s_lineLen = 0;
+  s_inHeaders = true;
+  s_contentLength = -1;
+  s_bodyBytes = 0;
+  s_chunked = false;
+  s_chunkState = CH_SIZE;
+  s_chunkLeft = 0;
+  s_serverClose = false;
+  s_range = s_nextRange;
+  s_nextRange = 0;
+
+  s_transport = netTransport_select();
+  s_slot = s_transport != NET_NONE ? pickSlot(host, s_transport) : nullptr;
+  if (!s_slot) {
+    strcpy(s_err, s_transport == NET_NONE ? "No network" : "No client");
+    s_phase = HTTP_FAILED;
+    return false;
+  }
+
+  power_acquire(PWR_LOCK_NET);
+  s_phaseStart = millis();
+  s_connectStart = s_phaseStart;
+  s_client = s_slot->client;
+  s_reused = s_slot->idle;
+  s_slot->idle = false;
+  if (s_reused) {
+    s_reuses++;
+    s_phase = HTTP_SEND;
+  } else {
+    s_phase = HTTP_CONNECT;
+  }
+  return true;
+}
+
+void httpAsync_cancel() {
+  if (!httpAsync_busy()) return;
+  strcpy(s_err, "Cancelled");
+  finish(HTTP_CANCELLED, nullptr);
+  Serial.println("[HTTP] cancelled");
+}
+
+// 200, or 206 when a range was requested
+static bool statusOk() {
+  return s_status == 200 || (s_status == 206 && s_range);
+}
+
+// Status line and headers, one byte at a time. Returns false on a malformed response.
+static bool headerByte(char c) {
+  if (c != '\n') {
+    if (c != '\r' && s_lineLen < sizeof(s_line) - 1) s_line[s_lineLen++] = c;
+    return true;
+  }
+  s_line[s_lineLen] = 0;
+
+  if (s_status == 0) {
+    // a stray CRLF left on a kept-alive socket is not a status line
+    if (s_lineLen == 0) return true;
+    // "HTTP/1.1 200 OK"
+    const char *sp = strchr(s_line, ' ');
+    if (strncmp(s_line, "HTTP/", 5) != 0 || !sp) return false;
+    s_status = atoi(sp + 1);
+  } else if (s_lineLen == 0) {
+    s_inHeaders = false;
+  } else if (strncasecmp(s_line, "Content-Length:", 15) == 0) {
+    s_contentLength = atol(s_line + 15);
+  } else if (strncasecmp(s_line, "Transfer-Encoding:", 18) == 0) {
+    s_chunked = strstr(s_line + 18, "chunked") != nullptr;
+  } else if (strncasecmp(s_line, "Connection:", 11) == 0) {
+    s_serverClose = strcasestr(s_line + 11, "close") != nullptr;
+  }
+  s_lineLen = 0;
+  return true;
+}
+
+static bool deliver(const uint8_t *data, size_t len) {
+  s_bodyBytes += len;
+  // Error bodies are drained but not handed to the sink
+  if (!statusOk()) return true;
+  return s_onBody ? s_onBody(data, len, s_ctx) : true;
+}
+
+// Body bytes (chunked decoding). Returns number of bytes consumed, or -1 to abort.
+static int bodyBytes(const uint8_t *data, size_t len) {
+  if (!s_chunked) {
+    size_t n = len;
+    if (s_contentLength >= 0 && s_bodyBytes + n > (uint32_t)s_contentLength)
+      n = s_contentLength - s_bodyBytes;
+    if (n && !deliver(data, n)) return -1;
+    return (int)len;
+  }
+
+  size_t i = 0;
+  while (i < len && s_chunkState != CH_DONE) {
+    if (s_chunkState == CH_SIZE) {
+      char c = (char)data[i++];
+      if (c == '\n') {
+        s_line[s_lineLen] = 0;
+        s_chunkLeft = strtoul(s_line, nullptr, 16);
+        s_lineLen = 0;
+        s_chunkState = s_chunkLeft ? CH_DATA : CH_TRAILER;
+      } else if (c != '\r' && s_lineLen < sizeof(s_line) - 1) {
+        s_line[s_lineLen++] = c;
+      }
+    } else if (s_chunkState == CH_DATA) {
+      size_t n = len - i;
+      if (n > s_chunkLeft) n = s_chunkLeft;
+      if (!deliver(data + i, n)) return -1;
+      i += n;
+      s_chunkLeft -= n;
+      if (s_chunkLeft == 0) s_chunkState = CH_DATA_END;
+    } else if (s_chunkState == CH_DATA_END) {  // skip CRLF after the chunk
+      if ((char)data[i++] == '\n') s_chunkState = CH_SIZE;
+    } else {  // CH_TRAILER: trailer fields after the last chunk, up to the empty line
+      char c = (char)data[i++];
+      if (c == '\n') {
+        if (s_lineLen == 0) s_chunkState = CH_DONE;
+        s_lineLen = 0;
+      } else if (c != '\r') {
+        s_lineLen = 1;   // only "line is not empty" matters
+      }
+    }
+  }
+  return (int)i;
+}
+
+static bool bodyComplete() {
+  if (s_inHeaders) return false;
+  if (s_chunked) return s_chunkState == CH_DONE;
+  if (s_contentLength >= 0) return s_bodyBytes >= (uint32_t)s_contentLength;
+  return false;   // read until close
+}
+
+static void pollReceive() {
+  unsigned long now = millis();
+  uint8_t buf[256];
+  size_t budget = POLL_BUDGET_BYTES;
+
+  while (budget > 0 && s_client->available() > 0) {
+    int n = s_client->read(buf, min(sizeof(buf), budget));
+    if (n <= 0) break;
+    budget -= n;
+    netTransport_addBytes(s_transport, 0, n);
+    s_lastRx = now;
+
+    int i = 0;
+    while (i < n && s_inHeaders) {
+      if (!headerByte((char)buf[i++])) { finish(HTTP_FAILED, "Bad status line"); return; }
+    }
+    if (i < n) {
+      if (bodyBytes(buf + i, n - i) < 0) { finish(HTTP_FAILED, "Aborted by sink"); return; }
+    }
+    if (bodyComplete()) break;
+  }
+
+  bool closed = !s_client->connected() && s_client->available() == 0;
+  if (closed && s_reused && s_status == 0 && s_lineLen == 0) { retryFresh("was closed"); return; }
+  if (bodyComplete() || (closed && !s_inHeaders && !s_chunked && s_contentLength < 0)) {
+    // keep the socket only if the response was framed and the server did not ask to close
+    if (bodyComplete() && !s_serverClose && s_client->connected()) {
+      s_slot->idle = true;
+      s_slot->idleSince = now;
+    } else {
+      s_client->stop();
+    }
+    if (!statusOk()) {
+      char msg[32];
+      snprintf(msg, sizeof(msg), "HTTP_%d", s_status);
+      finish(HTTP_FAILED, msg);
+      return;
+    }
+    enterPhase(HTTP_PARSE);
+    return;
+  }
+  if (closed) { finish(HTTP_FAILED, "Connection closed early"); return; }
+  if (now - s_lastRx > RECEIVE_IDLE_MS) finish(HTTP_FAILED, "Receive timeout");
+}
+
+HttpPhase httpAsync_poll() {
+  switch (s_phase) {
+    case HTTP_CONNECT:
+      s_connectStart = millis();
+      if (!netTransport_isUp(s_transport)) { finish(HTTP_FAILED, "Network down"); break; }
+      // over LTE the modem resolves the name as part of its TLS connect
+      if (s_transport == NET_WIFI && !WiFi.hostByName(s_host, s_ip)) {
+        netTransport_recordConnect(s_transport, 0, false);
+        finish(HTTP_FAILED, "DNS lookup failed");
+        break;
+      }
+      enterPhase(HTTP_TLS);
+      break;
+
+    case HTTP_TLS: {
+      bool ok;
+      s_client->setTimeout(TLS_TIMEOUT_MS);
+      if (s_transport == NET_WIFI) {
+        WiFiClientSecure *tls = static_cast<WiFiClientSecure*>(s_client);
+        tls->setHandshakeTimeout(TLS_TIMEOUT_MS / 1000);
+        ok = tls->connect(s_ip, 443, s_host, nullptr, nullptr, nullptr);
+      } else {
+        ok = s_client->connect(s_host, 443);
+      }
+      netTransport_recordConnect(s_transport, millis() - s_connectStart, ok);
+      if (!ok) {
+        finish(HTTP_FAILED, "TLS connect failed");
+        break;
+      }
+      s_handshakes++;
+      enterPhase(HTTP_SEND);
+      break;
+    }
+
+    case HTTP_SEND: {
+      char req[512];
+      char range[40] = "";
+      if (s_range) snprintf(range, sizeof(range), "Range: bytes=%lu-\r\n", (unsigned long)s_range);
+      int n = snprintf(req, sizeof(req),
+                       "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: BeehiveMonitor\r\n"
+                       "Accept-Encoding: identity\r\n%sConnection: keep-alive\r\n\r\n",
+                       s_path, s_host, range);
+      if (n <= 0 || n >= (int)sizeof(req)) { finish(HTTP_FAILED, "Request too long"); break; }
+      s_client->setTimeout(SEND_TIMEOUT_MS);
+      if (s_client->write((const uint8_t*)req, n) != (size_t)n) {
+        if (s_reused) { retryFresh("refused the request"); break; }
+        finish(HTTP_FAILED, "Send failed");
+        break;
+      }
+      netTransport_addBytes(s_transport, n, 0);
+      enterPhase(HTTP_RECEIVE);
+      break;
+    }
+
+    case HTTP_RECEIVE:
+      pollReceive();
+      break;
+
+    case HTTP_PARSE: {
+      bool ok = s_onParse ? s_onParse(s_ctx) : true;
+      if (ok) {
+        enterPhase(HTTP_DONE);
+        power_release(PWR_LOCK_NET);
+      } else {
+        finish(HTTP_FAILED, "Parse failed");
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+  return s_phase;
+}
+
+bool httpAsync_busy() { return s_phase >= HTTP_CONNECT && s_phase <= HTTP_PARSE; }
+HttpPhase httpAsync_phase() { return s_phase; }
+int httpAsync_statusCode() { return s_status; }
+
+void httpAsync_setRangeStart(uint32_t offset) { s_nextRange = offset; }
+uint32_t httpAsync_bytesReceived() { return s_bodyBytes; }
+const char *httpAsync_lastError() { return s_err; }
+uint32_t httpAsync_handshakes() { return s_handshakes; }
+uint32_t httpAsync_reuses() { return s_reuses; }
+
+void httpAsync_closeIdle(bool all) {
+  if (httpAsync_busy()) return;
+  unsigned long now = millis();
+  for (int i = 0; i < HTTP_POOL_SLOTS; ++i) {
+    PoolSlot &sl = s_pool[i];
+    if (sl.idle && (all || slotExpired(sl, now))) closeSlot(sl);
+  }
+}
+
+const char *httpAsync_phaseName(HttpPhase p) {
+  return (p < HTTP_PHASE_COUNT) ? PHASE_NAMES[p] : "?";
+}
+
+int httpAsync_progress() {
+  if (s_phase == HTTP_DONE) return 100;
+  if (s_contentLength <= 0) return -1;
+  uint32_t pct = (s_bodyBytes * 100UL) / (uint32_t)s_contentLength;
+  return pct > 100 ? 100 : (int)pct;
+}
+
+void httpAsync_printStats() {
+  Serial.print("[HTTP] latency ms  <50 <100 <200 <500 <1k <2k <5k >=5k  total\n");
+  for (int p = HTTP_CONNECT; p <= HTTP_PARSE; ++p) {
+    Serial.printf("[HTTP] %-8s", PHASE_NAMES[p]);
+    for (int b = 0; b < BUCKETS; ++b) Serial.printf(" %4u", s_hist[p][b]);
+    Serial.printf("  %lu\n", (unsigned long)s_phaseTotalMs[p]);
+  }
+  Serial.printf("[HTTP] connections: %lu TLS handshakes, %lu keep-alive reuses\n",
+                (unsigned long)s_handshakes, (unsigned long)s_reuses);
+}
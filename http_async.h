@@ -0,0 +1,61 @@
+#ifndef HTTP_ASYNC_H
+#define HTTP_ASYNC_H
+
+#include <Arduino.h>
+
+// Phases of one HTTPS GET. CONNECT = DNS lookup, TLS = TCP connect + handshake,
+// RECEIVE = status line, headers and body, PARSE = caller's completion hook.
+enum HttpPhase {
+  HTTP_IDLE = 0,
+  HTTP_CONNECT,
+  HTTP_TLS,
+  HTTP_SEND,
+  HTTP_RECEIVE,
+  HTTP_PARSE,
+  HTTP_DONE,
+  HTTP_FAILED,
+  HTTP_CANCELLED,
+  HTTP_PHASE_COUNT
+};
+
+// Body bytes as they arrive (chunked encoding already removed). Return false to abort.
+typedef bool (*HttpBodySink)(const uint8_t *data, size_t len, void *ctx);
+// Called once in PARSE after a 200 response was fully received. Return false on failure.
+typedef bool (*HttpParseFn)(void *ctx);
+
+// Start a GET of https://host/path. Only one request runs at a time; returns false if busy.
+// host/path are copied, callbacks and ctx must stay valid until the request ends.
+bool httpAsync_start(const char *host, const char *path,
+                     HttpBodySink onBody, HttpParseFn onParse, void *ctx);
+
+// Ask the next httpAsync_start() for the body from byte offset on ("Range: bytes=N-").
+// A 206 reply is then treated like 200; the sink can check httpAsync_statusCode() to see
+// whether the server honoured the range (206) or sent the whole body (200).
+void httpAsync_setRangeStart(uint32_t offset);
+
+// Advance the state machine (call from loop or a UI wait loop). Returns the current phase.
+HttpPhase httpAsync_poll();
+
+// Abort the running request; the phase becomes HTTP_CANCELLED.
+void httpAsync_cancel();
+
+bool httpAsync_busy();                 // CONNECT..PARSE
+HttpPhase httpAsync_phase();
+int  httpAsync_statusCode();           // HTTP status, 0 if none yet
+int  httpAsync_progress();             // body percent 0..100, -1 if length unknown
+uint32_t httpAsync_bytesReceived();
+const char *httpAsync_lastError();
+const char *httpAsync_phaseName(HttpPhase p);
+
+// Per-phase latency histograms (ms buckets) and connection counters accumulated since boot
+void httpAsync_printStats();
+
+// Keep-alive pool: full TLS handshakes vs. requests served on a kept-alive connection
+uint32_t httpAsync_handshakes();
+uint32_t httpAsync_reuses();
+
+// Close idle pooled connections past HTTP_KEEPALIVE_MS (or all of them) to free the
+// TLS buffers. Call periodically; no-op while a request runs.
+void httpAsync_closeIdle(bool all);
+
+#endif // HTTP_ASYNC_H
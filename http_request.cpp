@@ -0,0 +1,224 @@
+// http_request.cpp
+// - Incremental, allocation-free HTTP/1.1 request parser (see http_request.h).
+// - Lines are located by scanning for '\n' from the last position, so each byte is looked
+//   at once no matter how the request is split across reads.
+// - HttpBody: printf-style writer for responses built in a fixed buffer.
+#include "http_request.h"
+#include <stdarg.h>
+#include <math.h>
+
+enum { RS_REQUEST_LINE = 0, RS_HEADERS, RS_BODY, RS_DONE };
+
+void httpRequest_reset(HttpRequest &r) {
+  memset(&r, 0, sizeof(r));
+  r.contentLength = -1;
+  r.keepAlive = true;
+  r.state = RS_REQUEST_LINE;
+}
+
+static bool spanIEquals(const char *p, uint16_t n, const char *lit) {
+  size_t l = strlen(lit);
+  return n == l && strncasecmp(p, lit, l) == 0;
+}
+
+static HttpSpan trimSpan(const char *buf, uint16_t off, uint16_t end) {
+  while (off < end && (buf[off] == ' ' || buf[off] == '\t')) off++;
+  while (end > off && (buf[end - 1] == ' ' || buf[end - 1] == '\t' || buf[end - 1] == '\r')) end--;
+  HttpSpan s = { off, (uint16_t)(end - off) };
+  return s;
+}
+
+// "GET /path?query HTTP/1.1"
+static bool parseRequestLine(HttpRequest &r, const char *buf, uint16_t start, uint16_t end) {
+  const char *line = buf + start;
+  uint16_t n = end - start;
+  const char *sp1 = (const char*)memchr(line, ' ', n);
+  if (!sp1) return false;
+  const char *target = sp1 + 1;
+  const char *sp2 = (const char*)memchr(target, ' ', line + n - target);
+  if (!sp2 || sp2 == target) return false;
+  const char *version = sp2 + 1;
+  if (line + n - version < 8 || strncmp(version, "HTTP/1.", 7) != 0) return false;
+  if (version[7] == '0') r.keepAlive = false;
+
+  r.method.off = start;
+  r.method.len = sp1 - line;
+  const char *q = (const char*)memchr(target, '?', sp2 - target);
+  r.path.off = target - buf;
+  r.path.len = (q ? q : sp2) - target;
+  if (q) {
+    r.query.off = q + 1 - buf;
+    r.query.len = sp2 - (q + 1);
+  }
+  return true;
+}
+
+static void parseHeader(HttpRequest &r, const char *buf, uint16_t start, uint16_t end) {
+  const char *line = buf + start;
+  const char *colon = (const char*)memchr(line, ':', end - start);
+  if (!colon) return;
+  uint16_t nameLen = colon - line;
+  HttpSpan v = trimSpan(buf, colon + 1 - buf, end);
+
+  if (spanIEquals(line, nameLen, "Content-Length")) {
+    r.contentLength = atol(buf + v.off);
+  } else if (spanIEquals(line, nameLen, "Connection")) {
+    if (spanIEquals(buf + v.off, v.len, "close")) r.keepAlive = false;
+    else if (spanIEquals(buf + v.off, v.len, "keep-alive")) r.keepAlive = true;
+  } else if (spanIEquals(line, nameLen, "If-None-Match")) {
+    r.ifNoneMatch = v;
+  } else if (spanIEquals(line, nameLen, "Accept-Encoding")) {
+    r.acceptEncoding = v;
+  } else if (spanIEquals(line, nameLen, "Authorization")) {
+    r.authorization = v;
+  }
+}
+
+HttpParseResult httpRequest_parse(HttpRequest &r, const char *buf, uint16_t len, uint16_t cap) {
+  while (r.state == RS_REQUEST_LINE || r.state == RS_HEADERS) {
+    const char *nl = (const char*)memchr(buf + r.scan, '\n', len - r.scan);
+    if (!nl) {
+      r.scan = len;
+      return len >= cap ? HTTP_REQ_TOO_LARGE : HTTP_REQ_MORE;
+    }
+    uint16_t end = nl - buf;              // '\n'
+    uint16_t lineEnd = (end > r.lineStart && buf[end - 1] == '\r') ? end - 1 : end;
+    uint16_t start = r.lineStart;
+    r.scan = r.lineStart = end + 1;
+
+    if (r.state == RS_REQUEST_LINE) {
+      if (lineEnd == start) continue;     // tolerate leading blank lines
+      if (!parseRequestLine(r, buf, start, lineEnd)) return HTTP_REQ_BAD;
+      r.state = RS_HEADERS;
+    } else if (lineEnd == start) {
+      // end of headers
+      r.body.off = r.scan;
+      if (r.contentLength < 0) r.contentLength = 0;
+      r.state = RS_BODY;
+      if ((uint32_t)r.body.off + (uint32_t)r.contentLength > cap) return HTTP_REQ_BODY_LARGE;
+    } else {
+      parseHeader(r, buf, start, lineEnd);
+    }
+  }
+
+  if (r.state == RS_BODY) {
+    if (len - r.body.off < r.contentLength) return HTTP_REQ_MORE;
+    r.body.len = r.contentLength;
+    r.total = r.body.off + r.body.len;
+    r.state = RS_DONE;
+  }
+  return HTTP_REQ_DONE;
+}
+
+bool httpSpan_equals(const char *buf, HttpSpan s, const char *lit) {
+  size_t l = strlen(lit);
+  return s.len == l && memcmp(buf + s.off, lit, l) == 0;
+}
+
+bool httpSpan_startsWith(const char *buf, HttpSpan s, const char *lit) {
+  size_t l = strlen(lit);
+  return s.len >= l && memcmp(buf + s.off, lit, l) == 0;
+}
+
+bool httpSpan_contains(const char *buf, HttpSpan s, const char *lit) {
+  size_t l = strlen(lit);
+  if (l == 0) return true;
+  for (size_t i = 0; i + l <= s.len; ++i) {
+    if (memcmp(buf + s.off + i, lit, l) == 0) return true;
+  }
+  return false;
+}
+
+int httpPath_compare(const char *p, size_t len, const char *entry) {
+  size_t el = strlen(entry);
+  int d = memcmp(p, entry, len < el ? len : el);
+  if (d != 0) return d;
+  return len < el ? -1 : (len > el ? 1 : 0);
+}
+
+static int hexVal(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool httpRequest_formValue(const char *buf, HttpSpan form, const char *name, char *out, size_t outLen) {
+  const char *p = buf + form.off;
+  const char *end = p + form.len;
+  size_t nameLen = strlen(name);
+
+  while (p < end) {
+    const char *amp = (const char*)memchr(p, '&', end - p);
+    if (!amp) amp = end;
+    const char *eq = (const char*)memchr(p, '=', amp - p);
+    if (eq && (size_t)(eq - p) == nameLen && memcmp(p, name, nameLen) == 0) {
+      size_t n = 0;
+      for (const char *v = eq + 1; v < amp && n + 1 < outLen; ++v) {
+        char c = *v;
+        if (c == '+') c = ' ';
+        else if (c == '%' && v + 2 < amp && hexVal(v[1]) >= 0 && hexVal(v[2]) >= 0) {
+          c = (char)(hexVal(v[1]) * 16 + hexVal(v[2]));
+          v += 2;
+        }
+        if (n == 0 && (c == ' ' || c == '\t')) continue;
+        out[n++] = c;
+      }
+      while (n > 0 && (out[n - 1] == ' ' || out[n - 1] == '\t')) n--;
+      out[n] = 0;
+      return true;
+    }
+    p = amp + 1;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Response body writer
+void httpBody_init(HttpBody &b, char *buf, size_t cap) {
+  b.p = buf;
+  b.cap = cap;
+  b.len = 0;
+  b.overflow = false;
+}
+
+void httpBody_puts(HttpBody &b, const char *s) {
+  size_t n = strlen(s);
+  if (b.len + n > b.cap) { b.overflow = true; n = b.cap - b.len; }
+  memcpy(b.p + b.len, s, n);
+  b.len += n;
+}
+
+void httpBody_printf(HttpBody &b, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(b.p + b.len, b.cap - b.len, fmt, ap);
+  va_end(ap);
+  if (n < 0) return;
+  if ((size_t)n >= b.cap - b.len) { b.overflow = true; b.len = b.cap; return; }
+  b.len += n;
+}
+
+void httpBody_jsonString(HttpBody &b, const char *s) {
+  httpBody_puts(b, "\"");
+  char esc[8];
+  for (; *s; ++s) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      esc[0] = '\\'; esc[1] = c; esc[2] = 0;
+      httpBody_puts(b, esc);
+    } else if (c < 0x20) {
+      snprintf(esc, sizeof(esc), "\\u%04x", c);
+      httpBody_puts(b, esc);
+    } else {
+      if (b.len >= b.cap) { b.overflow = true; return; }
+      b.p[b.len++] = c;
+    }
+  }
+  httpBody_puts(b, "\"");
+}
+
+void httpBody_jsonFloat(HttpBody &b, float v, uint8_t decimals) {
+  if (isnan(v) || isinf(v)) httpBody_puts(b, "null");
+  else httpBody_printf(b, "%.*f", decimals, v);
+}
@@ -0,0 +1,93 @@
+#ifndef HTTP_REQUEST_H
+#define HTTP_REQUEST_H
+
+#include <Arduino.h>
+
+// Incremental HTTP/1.1 request parser over a caller-owned fixed buffer.
+// Bytes are appended to the buffer as they arrive and httpRequest_parse() resumes where
+// it stopped; nothing is copied. Parsed parts are spans (offset + length) into the buffer,
+// so the buffer can be compacted between pipelined requests.
+
+struct HttpSpan {
+  uint16_t off;
+  uint16_t len;
+};
+
+enum HttpParseResult {
+  HTTP_REQ_MORE = 0,    // need more bytes
+  HTTP_REQ_DONE,        // request line, headers and body complete
+  HTTP_REQ_BAD,         // malformed
+  HTTP_REQ_TOO_LARGE,   // request line + headers do not fit the buffer
+  HTTP_REQ_BODY_LARGE   // headers parsed, body (contentLength) does not fit: the caller
+                        // either streams it from body.off on or rejects the request
+};
+
+struct HttpRequest {
+  // results
+  HttpSpan method;
+  HttpSpan path;          // target without the query
+  HttpSpan query;         // after '?', empty if none
+  HttpSpan body;
+  HttpSpan ifNoneMatch;   // If-None-Match header value
+  HttpSpan acceptEncoding;
+  HttpSpan authorization; // Authorization header value
+  int32_t  contentLength; // -1 if absent
+  bool     keepAlive;     // HTTP/1.1 default unless "Connection: close"
+  uint16_t total;         // bytes of this request (headers + body)
+
+  // parser state (private)
+  uint8_t  state;
+  uint16_t scan;          // next byte to examine
+  uint16_t lineStart;
+};
+
+void httpRequest_reset(HttpRequest &r);
+
+// Parse buf[0..len). cap is the buffer capacity (for the TOO_LARGE decision).
+HttpParseResult httpRequest_parse(HttpRequest &r, const char *buf, uint16_t len, uint16_t cap);
+
+// Span helpers
+bool httpSpan_equals(const char *buf, HttpSpan s, const char *lit);
+bool httpSpan_startsWith(const char *buf, HttpSpan s, const char *lit);
+bool httpSpan_contains(const char *buf, HttpSpan s, const char *lit);
+
+// Byte order compare of a length-delimited path against a table entry (same order as strcmp)
+int httpPath_compare(const char *p, size_t len, const char *entry);
+
+// Bisection over a table sorted by its .path member (routes, web assets); nullptr if absent
+template <typename T>
+const T *httpTable_find(const T *table, int count, const char *p, size_t len) {
+  int lo = 0, hi = count - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    int d = httpPath_compare(p, len, table[mid].path);
+    if (d == 0) return &table[mid];
+    if (d < 0) hi = mid - 1;
+    else lo = mid + 1;
+  }
+  return nullptr;
+}
+
+// Find name=value in an application/x-www-form-urlencoded span and URL-decode the value
+// into out, trimming surrounding blanks. Returns false if the name is absent.
+bool httpRequest_formValue(const char *buf, HttpSpan form, const char *name, char *out, size_t outLen);
+
+// -----------------------------------------------------------------------------
+// Response body writer over a caller-owned fixed buffer. Appends past the capacity set
+// overflow instead of writing, so a caller can check once at the end.
+struct HttpBody {
+  char  *p;
+  size_t cap;
+  size_t len;
+  bool   overflow;
+};
+
+void httpBody_init(HttpBody &b, char *buf, size_t cap);
+void httpBody_puts(HttpBody &b, const char *s);
+void httpBody_printf(HttpBody &b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// JSON helpers: quoted + escaped string, and a number that becomes null when NaN/inf
+void httpBody_jsonString(HttpBody &b, const char *s);
+void httpBody_jsonFloat(HttpBody &b, float v, uint8_t decimals);
+
+#endif // HTTP_REQUEST_H
@@ -0,0 +1,121 @@
+// json_stream.cpp
+// - Byte-at-a-time JSON tokenizer used to parse HTTP bodies while they download.
+// - Keeps only the container stack, the current key per level and one scalar buffer.
+#include "json_stream.h"
+
+enum { ST_VALUE = 0, ST_STRING, ST_SCALAR, ST_DONE, ST_ERROR };
+
+void jsonStream_begin(JsonStream &js, JsonValueFn onValue, void *ctx) {
+  memset(&js, 0, sizeof(js));
+  js.state = ST_VALUE;
+  js.onValue = onValue;
+  js.ctx = ctx;
+}
+
+bool jsonStream_done(const JsonStream &js) { return js.state == ST_DONE; }
+
+static bool inObject(const JsonStream &js) {
+  return js.depth > 0 && !js.isArray[js.depth - 1];
+}
+
+static void emit(JsonStream &js, bool quoted) {
+  js.val[js.valLen] = 0;
+  if (js.depth > 0 && js.onValue) js.onValue(js, js.val, js.valLen, quoted, js.ctx);
+  js.valLen = 0;
+}
+
+static bool push(JsonStream &js, bool isArray) {
+  if (js.depth >= JSON_STREAM_MAX_DEPTH) return false;
+  js.isArray[js.depth] = isArray;
+  js.key[js.depth][0] = 0;
+  js.index[js.depth] = 0;
+  js.depth++;
+  js.expectKey = !isArray;
+  return true;
+}
+
+static bool pop(JsonStream &js) {
+  if (js.depth == 0) return false;
+  js.depth--;
+  js.expectKey = false;
+  if (js.depth == 0) js.state = ST_DONE;
+  return true;
+}
+
+bool jsonStream_feed(JsonStream &js, const uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    char c = (char)data[i];
+
+    switch (js.state) {
+      case ST_STRING: {
+        bool isKey = inObject(js) && js.expectKey;
+        if (js.escape) {
+          js.escape = false;
+        } else if (c == '\\') {
+          js.escape = true;
+          continue;
+        } else if (c == '"') {
+          if (isKey) {
+            js.key[js.depth - 1][js.keyLen] = 0;
+            js.expectKey = false;
+          } else {
+            emit(js, true);
+          }
+          js.state = ST_VALUE;
+          continue;
+        }
+        if (isKey) {
+          if (js.keyLen < JSON_STREAM_KEY_LEN - 1) js.key[js.depth - 1][js.keyLen++] = c;
+        } else if (js.valLen < JSON_STREAM_VAL_LEN - 1) {
+          js.val[js.valLen++] = c;
+        }
+        continue;
+      }
+
+      case ST_SCALAR:
+        if (c == ',' || c == ']' || c == '}' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+          emit(js, false);
+          js.state = ST_VALUE;
+          break;   // fall through to ST_VALUE handling of the delimiter
+        }
+        if (js.valLen < JSON_STREAM_VAL_LEN - 1) js.val[js.valLen++] = c;
+        continue;
+
+      case ST_VALUE:
+        break;
+
+      default:   // ST_DONE / ST_ERROR: ignore trailing bytes
+        continue;
+    }
+
+    // ST_VALUE: structural characters
+    switch (c) {
+      case ' ': case '\t': case '\r': case '\n': case ':':
+        break;
+      case ',':
+        if (js.depth > 0 && js.isArray[js.depth - 1]) js.index[js.depth - 1]++;
+        else js.expectKey = true;
+        break;
+      case '{':
+        if (!push(js, false)) { js.state = ST_ERROR; return false; }
+        break;
+      case '[':
+        if (!push(js, true)) { js.state = ST_ERROR; return false; }
+        break;
+      case '}': case ']':
+        if (!pop(js)) { js.state = ST_ERROR; return false; }
+        break;
+      case '"':
+        js.state = ST_STRING;
+        js.keyLen = 0;
+        js.valLen = 0;
+        break;
+      default:
+        js.state = ST_SCALAR;
+        js.val[0] = c;
+        js.valLen = 1;
+        break;
+    }
+  }
+  return js.state != ST_ERROR;
+}
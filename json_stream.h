@@ -0,0 +1,48 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <Arduino.h>
+
+// Minimal incremental JSON tokenizer.
+// Bytes can be fed in arbitrary chunks; every scalar (string, number, true/false/null)
+// is reported through a callback together with the path of open containers:
+//   level 0..depth-1 are the enclosing objects/arrays, key[level] is the current key
+//   inside an object and index[level] the current element inside an array.
+// Example: {"hourly":{"time":["a","b"]}} reports "b" with depth 3,
+//   key[0]="hourly", key[1]="time", index[2]=1.
+// Keys longer than JSON_STREAM_KEY_LEN-1 and values longer than JSON_STREAM_VAL_LEN-1
+// are truncated. Total state is a few hundred bytes, no heap.
+
+#define JSON_STREAM_MAX_DEPTH 6
+#define JSON_STREAM_KEY_LEN   24
+#define JSON_STREAM_VAL_LEN   32
+
+struct JsonStream;
+typedef void (*JsonValueFn)(const JsonStream &js, const char *value, uint8_t len, bool quoted, void *ctx);
+
+struct JsonStream {
+  uint8_t  depth;
+  bool     isArray[JSON_STREAM_MAX_DEPTH];
+  char     key[JSON_STREAM_MAX_DEPTH][JSON_STREAM_KEY_LEN];
+  uint16_t index[JSON_STREAM_MAX_DEPTH];
+
+  // tokenizer state (private)
+  uint8_t  state;
+  bool     expectKey;
+  bool     escape;
+  char     val[JSON_STREAM_VAL_LEN];
+  uint8_t  valLen;
+  uint8_t  keyLen;
+  JsonValueFn onValue;
+  void    *ctx;
+};
+
+void jsonStream_begin(JsonStream &js, JsonValueFn onValue, void *ctx);
+
+// Feed the next chunk. Returns false on a syntax error (the stream must be restarted).
+bool jsonStream_feed(JsonStream &js, const uint8_t *data, size_t len);
+
+// True once the top-level value was closed
+bool jsonStream_done(const JsonStream &js);
+
+#endif // JSON_STREAM_H
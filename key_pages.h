@@ -0,0 +1,24 @@
+#ifndef KEY_PAGES_H
+#define KEY_PAGES_H
+
+#include "http_request.h"
+
+// The key server's dynamic form page (GET / for clients without gzip, and the reply to
+// /set), shared with tools/http_bench.cpp so the benchmark renders the page the firmware
+// sends. status is shown above the form when not empty.
+inline void keyPages_form(HttpBody &b, const char *status) {
+  httpBody_puts(b, "<!doctype html><html><head><meta charset='utf-8'><title>Beehive: Provision</title></head><body>");
+  httpBody_puts(b, "<h3>Beehive Provisioning</h3>");
+  if (status && status[0]) httpBody_printf(b, "<p><b>Status:</b> %s</p>", status);
+
+  httpBody_puts(b, "<p><i>Enter City and (optional) 2-letter Country code. Location will be used with Open‑Meteo (no API key required).</i></p>");
+
+  httpBody_puts(b, "<form method='POST' action='/set'>");
+  httpBody_puts(b, "City: <input name='city' style='width:200px' placeholder='e.g. Elefsina'> Country (2-letter ISO): <input name='country' style='width:60px' placeholder='GR'><br><br>");
+  httpBody_puts(b, "<input type='submit' value='Save'>");
+  httpBody_puts(b, "</form>");
+  httpBody_puts(b, "<p>Or use GET: /set?city=Athens&country=GR</p>");
+  httpBody_puts(b, "</body></html>");
+}
+
+#endif // KEY_PAGES_H
@@ -0,0 +1,28 @@
+#ifndef KEY_ROUTES_H
+#define KEY_ROUTES_H
+
+// Key server route table, shared by key_server.cpp and tools/http_bench.cpp so the
+// benchmark always dispatches over the routes the firmware serves.
+// KS_ROUTES(X) expands X(path, methods, handler) once per route, sorted by path
+// (key_server.cpp checks the order at compile time).
+
+enum {
+  M_GET    = 0x01,
+  M_POST   = 0x02,
+  M_STREAM = 0x80     // handler consumes a POST body larger than KS_REQ_BUF itself
+};
+
+#define KS_ROUTES(X)                                           \
+  X("/",                 M_GET | M_POST,    handleRoot)        \
+  X("/api/calibration",  M_GET,             apiCalibration)    \
+  X("/api/forecast",     M_GET,             apiForecast)       \
+  X("/api/measurements", M_GET,             apiMeasurements)   \
+  X("/api/ota",          M_GET,             apiOta)            \
+  X("/api/status",       M_GET,             apiStatus)         \
+  X("/events",           M_GET,             handleEvents)      \
+  X("/ota",              M_POST | M_STREAM, handleOta)         \
+  X("/ota/pull",         M_POST,            handleOtaPull)     \
+  X("/set",              M_GET | M_POST,    handleSet)         \
+  X("/wifi",             M_POST,            handleWifi)
+
+#endif // KEY_ROUTES_H
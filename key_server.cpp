@@ -1,70 +1,706 @@
 // key_server.cpp
-// - Simple HTTP provisioning server that accepts city + country for geocoding.
+// - Non-blocking HTTP provisioning server that accepts city + country for geocoding.
+// - Up to KS_MAX_CONN clients are served concurrently from fixed slots; each slot owns a
+//   request buffer (parsed in place by http_request) and a response buffer that is
+//   written out in KS_WRITE_CHUNK pieces, so keyServer_loop() never waits on a socket.
+// - /set only queues the geocode lookup; the job runs from keyServer_loop() via the
+//   async weather API and its outcome is shown on the next page load.
+// - /api/* routes return JSON documents from web_api for dashboards polling the hive.
+// - /events is a Server-Sent Events stream of measurements for up to KS_SSE_MAX_CLIENTS
+//   subscribers. keyServer_publish() formats the frame once into s_frame; a subscriber
+//   that is still sending an older frame skips the ones in between (counted as dropped).
+// - "/" and the other files from web/ are served from web_assets.h: gzip bodies sent
+//   straight from flash with an ETag, so a revisit costs a 304 with no body.
+// - POST /ota streams a firmware image from the socket into ota_manager without
+//   buffering it (the slot's request buffer is reused as the chunk buffer). /ota and
+//   /ota/pull are POST only and need the OTA bearer token; /api/ota reports progress.
+// - POST /wifi (ssid=&pass=, same token) stores the provisioned network through
+//   connectivity_setCredentials(). It is applied a moment after the 202 went out, since
+//   the reconnect drops this very connection.
+// - Only GET responses carry "Access-Control-Allow-Origin: *".
 // - When started it prints the IP to Serial and shows it briefly on the LCD (row 3).
 #include "key_server.h"
+#include "http_request.h"
+#include "key_routes.h"
+#include "key_pages.h"
+#include "web_api.h"
+#include "web_assets.h"
+#include "ota_manager.h"
+#include "connectivity_manager.h"
 #include "weather_manager.h"
 #include "ui.h"
 #include "menu_manager.h"
+#include "power_manager.h"
+#include "config.h"
 #include <WiFi.h>
 
 static WiFiServer *s_server = nullptr;
 static unsigned long s_lastActivity = 0;
 static const unsigned long IDLE_TIMEOUT_MS = 5 * 60 * 1000UL; // stop server after idle
 static bool s_running = false;
+static bool s_lockHeld = false;
 
-static String urlDecode(const String &src) {
-  String ret;
-  char tmp[3] = {0,0,0};
-  for (size_t i=0; i < src.length(); ++i) {
-    char c = src[i];
-    if (c == '+') ret += ' ';
-    else if (c == '%' && i + 2 < src.length()) {
-      tmp[0] = src[i+1];
-      tmp[1] = src[i+2];
-      int v = (int)strtol(tmp, nullptr, 16);
-      ret += (char)v;
-      i += 2;
-    } else ret += c;
-  }
-  return ret;
-}
-
-static void sendHttpResponse(WiFiClient &client, const String &body) {
-  client.print("HTTP/1.1 200 OK\r\n");
-  client.print("Content-Type: text/html; charset=UTF-8\r\n");
-  client.print("Connection: close\r\n");
-  client.printf("Content-Length: %u\r\n\r\n", (unsigned)body.length());
-  client.print(body);
-}
-
-static String makeFormPage(const String &status) {
-  String page;
-  page.reserve(1024);
-  page += "<!doctype html><html><head><meta charset='utf-8'><title>Beehive: Provision</title></head><body>";
-  page += "<h3>Beehive Provisioning</h3>";
-  if (status.length()) {
-    page += "<p><b>Status:</b> ";
-    page += status;
-    page += "</p>";
-  }
-
-  page += "<p><i>Enter City and (optional) 2-letter Country code. Location will be used with Open‑Meteo (no API key required).</i></p>";
-
-  page += "<form method='POST' action='/set'>";
-  page += "City: <input name='city' style='width:200px' placeholder='e.g. Elefsina'> Country (2-letter ISO): <input name='country' style='width:60px' placeholder='GR'><br><br>";
-  page += "<input type='submit' value='Save'>";
-  page += "</form>";
-  page += "<p>Or use GET: /set?city=Athens&country=GR</p>";
-  page += "</body></html>";
-  return page;
+// -----------------------------------------------------------------------------
+// Connection slots
+enum KsPhase { KS_FREE = 0, KS_READ, KS_WRITE, KS_STREAM, KS_UPLOAD };
+
+// Space kept in front of the body for the status line and headers, which are formatted
+// after the body length is known and placed directly before it.
+#define KS_HDR_RESERVE 256
+
+struct KsConn {
+  WiFiClient    client;
+  uint8_t       phase;
+  HttpRequest   req;
+  char          in[KS_REQ_BUF];
+  uint16_t      inLen;
+  char          out[KS_RESP_BUF];
+  uint16_t      outPos;
+  uint16_t      outEnd;
+  const uint8_t *ext;           // body sent after out[] without copying (flash asset)
+  uint32_t      extLen;
+  uint32_t      extPos;
+  bool          closeAfter;
+  bool          stream;         // /events subscriber
+  uint32_t      sentSeq;        // last SSE frame handed to this subscriber
+  uint32_t      uploadLeft;     // /ota body bytes still to receive
+  unsigned long lastIo;
+  unsigned long reqStart;
+};
+
+static KsConn s_conn[KS_MAX_CONN];
+
+// Latest SSE frame, shared by all subscribers
+static char s_frame[KS_SSE_FRAME_MAX];
+static uint16_t s_frameLen = 0;
+static uint32_t s_frameSeq = 0;
+static uint32_t s_sseDropped = 0;
+
+// -----------------------------------------------------------------------------
+// Deferred /set job
+enum { JOB_IDLE = 0, JOB_QUEUED, JOB_RUNNING };
+
+static uint8_t s_jobState = JOB_IDLE;
+static char s_jobCity[48];
+static char s_jobCountry[4];
+static char s_jobMsg[96] = "";
+
+// Deferred /wifi credentials (applied WIFI_APPLY_DELAY_MS after the reply)
+static const unsigned long WIFI_APPLY_DELAY_MS = 1000;
+static bool s_wifiPending = false;
+static unsigned long s_wifiQueuedMs = 0;
+static char s_wifiSsid[33];
+static char s_wifiPass[65];
+
+// -----------------------------------------------------------------------------
+// Stats: requests served and request latency (first byte read -> last byte written)
+static const uint16_t LAT_BUCKET_MS[] = { 5, 10, 20, 50, 100, 200, 500, 1000 };
+static const int LAT_BUCKETS = sizeof(LAT_BUCKET_MS) / sizeof(LAT_BUCKET_MS[0]) + 1;
+static uint32_t s_latHist[LAT_BUCKETS];
+static uint32_t s_requests = 0;
+static uint32_t s_rejected = 0;
+static uint32_t s_errors = 0;
+static uint32_t s_notModified = 0;
+static unsigned long s_statsSince = 0;
+
+static void recordLatency(unsigned long ms) {
+  int b = 0;
+  while (b < LAT_BUCKETS - 1 && ms >= LAT_BUCKET_MS[b]) b++;
+  s_latHist[b]++;
+}
+
+// -----------------------------------------------------------------------------
+// Response helpers
+static HttpBody beginBody(KsConn &c) {
+  HttpBody b;
+  httpBody_init(b, c.out + KS_HDR_RESERVE, sizeof(c.out) - KS_HDR_RESERVE);
+  return b;
+}
+
+static const char *statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 422: return "Unprocessable Entity";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default:  return "Error";
+  }
+}
+
+// Place status line + headers in front of the bodyLen bytes already at out+KS_HDR_RESERVE
+// and switch the slot to KS_WRITE. contentLength also covers an external body in c.ext.
+static void writeHead(KsConn &c, int code, const char *contentType, size_t bodyLen,
+                      uint32_t contentLength, const char *extraHeaders) {
+  char hdr[KS_HDR_RESERVE];
+  int n = snprintf(hdr, sizeof(hdr),
+                   "HTTP/1.1 %d %s\r\n"
+                   "Content-Type: %s\r\n"
+                   "Content-Length: %lu\r\n"
+                   "Connection: %s\r\n%s\r\n",
+                   code, statusText(code), contentType, (unsigned long)contentLength,
+                   c.closeAfter ? "close" : "keep-alive", extraHeaders);
+  if (n <= 0 || n >= (int)sizeof(hdr)) {
+    Serial.println("[KeyServer] headers exceed KS_HDR_RESERVE");
+    n = 0;
+  }
+
+  c.outPos = KS_HDR_RESERVE - n;
+  memcpy(c.out + c.outPos, hdr, n);
+  c.outEnd = KS_HDR_RESERVE + bodyLen;
+  c.phase = KS_WRITE;
+}
+
+static void sendResponse(KsConn &c, int code, const char *contentType, HttpBody &b,
+                         const char *extraHeaders = "") {
+  if (b.overflow) {
+    Serial.println("[KeyServer] response truncated, sending 500");
+    s_errors++;
+    b.len = 0;
+    httpBody_puts(b, "response too large");
+    code = 500;
+    contentType = "text/plain";
+  }
+  writeHead(c, code, contentType, b.len, b.len, extraHeaders);
+}
+
+static void sendText(KsConn &c, int code, const char *text) {
+  HttpBody b = beginBody(c);
+  httpBody_puts(b, text);
+  sendResponse(c, code, "text/plain", b);
+}
+
+// -----------------------------------------------------------------------------
+// Pages
+static void sendFormPage(KsConn &c, const char *status) {
+  HttpBody b = beginBody(c);
+  keyPages_form(b, status);
+  sendResponse(c, 200, "text/html; charset=UTF-8", b);
+}
+
+// Escape the few characters that matter before echoing user input into HTML
+static void htmlSafeCopy(char *dst, size_t len, const char *src) {
+  size_t n = 0;
+  for (; *src && n + 1 < len; ++src) {
+    char ch = *src;
+    dst[n++] = (ch == '<' || ch == '>' || ch == '&' || ch == '"' || ch == '\'') ? '_' : ch;
+  }
+  dst[n] = 0;
+}
+
+static void handleSet(KsConn &c) {
+  const HttpRequest &r = c.req;
+  HttpSpan form = httpSpan_equals(c.in, r.method, "POST") ? r.body : r.query;
+
+  char city[48] = "";
+  char country[8] = "";
+  httpRequest_formValue(c.in, form, "city", city, sizeof(city));
+  httpRequest_formValue(c.in, form, "country", country, sizeof(country));
+
+  char safe[48];
+  char status[128];
+  if (city[0] == 0) {
+    sendFormPage(c, "No city provided.");
+  } else if (s_jobState == JOB_RUNNING) {
+    sendFormPage(c, "Previous lookup still running, try again shortly.");
+  } else {
+    // a queued job that has not started yet is simply replaced
+    strncpy(s_jobCity, city, sizeof(s_jobCity) - 1);
+    s_jobCity[sizeof(s_jobCity) - 1] = 0;
+    strncpy(s_jobCountry, country, sizeof(s_jobCountry) - 1);
+    s_jobCountry[sizeof(s_jobCountry) - 1] = 0;
+    s_jobState = JOB_QUEUED;
+    htmlSafeCopy(safe, sizeof(safe), s_jobCity);
+    snprintf(s_jobMsg, sizeof(s_jobMsg), "Geocode queued for %s.", safe);
+    snprintf(status, sizeof(status), "%s Reload this page for the result.", s_jobMsg);
+    Serial.printf("[KeyServer] geocode queued: %s %s\n", s_jobCity, s_jobCountry);
+    sendFormPage(c, status);
+  }
+}
+
+// WEB_ASSETS is emitted sorted by path
+static const WebAsset *findAsset(const char *path, size_t len) {
+  return httpTable_find(WEB_ASSETS, WEB_ASSET_COUNT, path, len);
+}
+
+// Static file from web_assets.h. Every response is revalidated (no-cache) but a matching
+// If-None-Match is answered with 304 and no body, so revisits cost a few hundred bytes.
+static void sendAsset(KsConn &c, const WebAsset &a) {
+  char extra[112];
+  snprintf(extra, sizeof(extra), "ETag: %s\r\nCache-Control: no-cache\r\n%s",
+           a.etag, "Vary: Accept-Encoding\r\n");
+
+  if (c.req.ifNoneMatch.len && httpSpan_contains(c.in, c.req.ifNoneMatch, a.etag)) {
+    s_notModified++;
+    writeHead(c, 304, a.contentType, 0, 0, extra);
+    return;
+  }
+
+  size_t n = strlen(extra);
+  snprintf(extra + n, sizeof(extra) - n, "Content-Encoding: gzip\r\n");
+  c.ext = a.gz;
+  c.extLen = a.gzLen;
+  c.extPos = 0;
+  writeHead(c, 200, a.contentType, 0, a.gzLen, extra);
+}
+
+typedef int (*ApiFn)(HttpBody &body);
+
+static void sendJson(KsConn &c, ApiFn fn) {
+  HttpBody b = beginBody(c);
+  int code = fn(b);
+  bool get = httpSpan_equals(c.in, c.req.method, "GET");
+  sendResponse(c, code, "application/json", b,
+               get ? "Cache-Control: no-store\r\nAccess-Control-Allow-Origin: *\r\n"
+                   : "Cache-Control: no-store\r\n");
+}
+
+// Copy the latest frame (or a keep-alive comment) into the slot and start writing it
+static void queueFrame(KsConn &c, const char *data, uint16_t len, unsigned long now) {
+  memcpy(c.out, data, len);
+  c.outPos = 0;
+  c.outEnd = len;
+  c.lastIo = now;     // stall timeout counts from here
+  c.phase = KS_WRITE;
+}
+
+static void handleEvents(KsConn &c) {
+  int streams = 0;
+  for (int i = 0; i < KS_MAX_CONN; ++i) if (s_conn[i].stream) streams++;
+  if (streams >= KS_SSE_MAX_CLIENTS) {
+    c.closeAfter = true;
+    sendText(c, 503, "too many event subscribers");
+    return;
+  }
+
+  HttpBody b;
+  httpBody_init(b, c.out, sizeof(c.out));
+  httpBody_puts(b, "HTTP/1.1 200 OK\r\n"
+                   "Content-Type: text/event-stream\r\n"
+                   "Cache-Control: no-store\r\n"
+                   "Access-Control-Allow-Origin: *\r\n"
+                   "Connection: keep-alive\r\n\r\n"
+                   "retry: 5000\n\n");
+  // start with the current snapshot so the page is not empty until the next sample
+  if (s_frameLen && b.len + s_frameLen <= b.cap) {
+    memcpy(b.p + b.len, s_frame, s_frameLen);
+    b.len += s_frameLen;
+  }
+  c.stream = true;
+  c.sentSeq = s_frameSeq;
+  c.outPos = 0;
+  c.outEnd = b.len;
+  c.phase = KS_WRITE;
+  s_requests++;
+  Serial.println("[KeyServer] event subscriber added");
+}
+
+static void sendJsonCode(KsConn &c, ApiFn fn, int code) {
+  HttpBody b = beginBody(c);
+  fn(b);
+  sendResponse(c, code, "application/json", b, "Cache-Control: no-store\r\n");
+}
+
+static uint32_t formUInt(KsConn &c, HttpSpan form, const char *name) {
+  char v[12];
+  return httpRequest_formValue(c.in, form, name, v, sizeof(v)) ? strtoul(v, nullptr, 10) : 0;
+}
+
+// "Authorization: Bearer <token>" matching the OTA token, which also guards the other
+// routes that change the device. Answers 401 itself.
+static bool tokenAuthorized(KsConn &c) {
+  HttpSpan a = c.req.authorization;
+  char token[40] = "";
+  if (httpSpan_startsWith(c.in, a, "Bearer ") && a.len < 7 + sizeof(token)) {
+    memcpy(token, c.in + a.off + 7, a.len - 7);
+    token[a.len - 7] = 0;
+  }
+  if (ota_authorized(token)) return true;
+  Serial.println("[KeyServer] request without a valid token");
+  c.closeAfter = true;
+  sendText(c, 401, "token required");
+  return false;
+}
+
+// ?size=N&sha256=HEX[&offset=K] with the image (from offset K) as body
+static void handleOta(KsConn &c) {
+  const HttpRequest &r = c.req;
+  c.closeAfter = true;
+  if (!tokenAuthorized(c)) return;
+
+  char sha[72] = "";
+  uint32_t size = formUInt(c, r.query, "size");
+  uint32_t offset = formUInt(c, r.query, "offset");
+  httpRequest_formValue(c.in, r.query, "sha256", sha, sizeof(sha));
+  if (size == 0 || offset >= size || (uint32_t)r.contentLength != size - offset) {
+    sendText(c, 400, "need ?size=&sha256=[&offset=] and Content-Length = size - offset");
+    return;
+  }
+  if (!ota_begin(size, sha, offset)) { sendJsonCode(c, webApi_ota, 409); return; }
+
+  // body bytes that arrived together with the headers
+  uint32_t have = c.inLen - r.body.off;
+  if (have > (uint32_t)r.contentLength) have = r.contentLength;
+  c.uploadLeft = r.contentLength - have;
+  c.inLen = 0;
+  if (have && !ota_write((const uint8_t*)c.in + r.body.off, have)) {
+    sendJsonCode(c, webApi_ota, 500);
+    return;
+  }
+  c.phase = KS_UPLOAD;
+}
+
+// Form body path=P&size=N&sha256=HEX[&host=H]: download https://H/P over WiFi or LTE.
+// host defaults to OTA_UPDATE_HOST and may not name any other server.
+static void handleOtaPull(KsConn &c) {
+  const HttpRequest &r = c.req;
+  if (!tokenAuthorized(c)) return;
+  char host[64] = OTA_UPDATE_HOST, path[192] = "", sha[72] = "";
+  httpRequest_formValue(c.in, r.body, "host", host, sizeof(host));
+  httpRequest_formValue(c.in, r.body, "path", path, sizeof(path));
+  httpRequest_formValue(c.in, r.body, "sha256", sha, sizeof(sha));
+  uint32_t size = formUInt(c, r.body, "size");
+  if (!host[0] || path[0] != '/' || size == 0) {
+    sendText(c, 400, "need path (starting with /), size and sha256");
+    return;
+  }
+  sendJsonCode(c, webApi_ota, ota_pullStart(host, path, size, sha) ? 202 : 409);
+}
+
+// Form body ssid=S&pass=P: provisioned network, joined ahead of the compiled-in ones
+static void handleWifi(KsConn &c) {
+  const HttpRequest &r = c.req;
+  if (!tokenAuthorized(c)) return;
+  char ssid[sizeof(s_wifiSsid)] = "", pass[sizeof(s_wifiPass)] = "";
+  httpRequest_formValue(c.in, r.body, "ssid", ssid, sizeof(ssid));
+  httpRequest_formValue(c.in, r.body, "pass", pass, sizeof(pass));
+  size_t passLen = strlen(pass);
+  if (!ssid[0] || (passLen && passLen < 8)) {
+    sendText(c, 400, "need ssid (1..32 chars) and pass (empty or 8..63 chars)");
+    return;
+  }
+  memcpy(s_wifiSsid, ssid, sizeof(ssid));
+  memcpy(s_wifiPass, pass, sizeof(pass));
+  s_wifiPending = true;
+  s_wifiQueuedMs = millis();
+  Serial.printf("[KeyServer] WiFi credentials for %s queued\n", ssid);
+  c.closeAfter = true;
+  sendText(c, 202, "credentials stored, reconnecting (the IP address may change)");
+}
+
+static void handleRoot(KsConn &c) {
+  // the gzip dashboard, or the plain form for clients that cannot take gzip
+  const WebAsset *index = findAsset("/index.html", 11);
+  bool isGet = httpSpan_equals(c.in, c.req.method, "GET");
+  if (index && isGet && httpSpan_contains(c.in, c.req.acceptEncoding, "gzip")) sendAsset(c, *index);
+  else sendFormPage(c, s_jobMsg);
+}
+
+static void apiCalibration(KsConn &c)  { sendJson(c, webApi_calibration); }
+static void apiForecast(KsConn &c)     { sendJson(c, webApi_forecast); }
+static void apiMeasurements(KsConn &c) { sendJson(c, webApi_measurements); }
+static void apiOta(KsConn &c)          { sendJson(c, webApi_ota); }
+static void apiStatus(KsConn &c)       { sendJson(c, webApi_status); }
+
+// -----------------------------------------------------------------------------
+// Route table (key_routes.h): sorted by path (checked at compile time) and searched by
+// bisection over the path span, so dispatch costs log2(ROUTE_COUNT) memcmp calls and no
+// allocation. Paths not in the table fall through to the web assets, which the build
+// script also emits sorted.
+typedef void (*RouteFn)(KsConn &c);
+
+struct Route {
+  const char *path;
+  uint8_t     methods;
+  RouteFn     handler;
+};
+
+#define KS_ROUTE_ENTRY(path, methods, handler) { path, methods, handler },
+static constexpr Route ROUTES[] = { KS_ROUTES(KS_ROUTE_ENTRY) };
+#undef KS_ROUTE_ENTRY
+static constexpr int ROUTE_COUNT = sizeof(ROUTES) / sizeof(ROUTES[0]);
+
+constexpr int constStrCmp(const char *a, const char *b) {
+  return (*a != *b || *a == 0) ? (int)(unsigned char)*a - (int)(unsigned char)*b
+                               : constStrCmp(a + 1, b + 1);
+}
+constexpr bool routesSorted(int i) {
+  return i + 1 >= ROUTE_COUNT ||
+         (constStrCmp(ROUTES[i].path, ROUTES[i + 1].path) < 0 && routesSorted(i + 1));
+}
+static_assert(routesSorted(0), "ROUTES must be sorted by path, without duplicates");
+
+static const Route *findRoute(const char *p, size_t len) {
+  return httpTable_find(ROUTES, ROUTE_COUNT, p, len);
+}
+
+// Route a complete request; every branch ends in a response
+static void dispatch(KsConn &c) {
+  const HttpRequest &r = c.req;
+  const char *path = c.in + r.path.off;
+  uint8_t method = httpSpan_equals(c.in, r.method, "GET") ? M_GET
+                 : httpSpan_equals(c.in, r.method, "POST") ? M_POST : 0;
+
+  Serial.printf("[KeyServer] %.*s %.*s\n", r.method.len, c.in + r.method.off, r.path.len, path);
+
+  const Route *route = findRoute(path, r.path.len);
+  if (route) {
+    if (route->methods & method) {
+      route->handler(c);
+    } else {
+      c.closeAfter = true;
+      sendText(c, 405, "method not allowed");
+    }
+    return;
+  }
+
+  const WebAsset *a = findAsset(path, r.path.len);
+  if (a && method == M_GET) {
+    sendAsset(c, *a);
+  } else if (a) {
+    c.closeAfter = true;
+    sendText(c, 405, "method not allowed");
+  } else {
+    HttpBody b = beginBody(c);
+    httpBody_puts(b, "<html><body><h3>404</h3></body></html>");
+    sendResponse(c, 404, "text/html; charset=UTF-8", b);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Slot state machine
+static void closeConn(KsConn &c) {
+  if (c.phase == KS_UPLOAD) ota_pause("upload connection closed");
+  c.client.stop();
+  c.phase = KS_FREE;
+  c.inLen = 0;
+  c.stream = false;
+  c.ext = nullptr;
+}
+
+static void startRequest(KsConn &c) {
+  httpRequest_reset(c.req);
+  c.reqStart = 0;
+}
+
+static void failRequest(KsConn &c, int code, const char *text) {
+  s_errors++;
+  c.closeAfter = true;
+  sendText(c, code, text);
+}
+
+static void serviceRead(KsConn &c, unsigned long now) {
+  int avail = c.client.available();
+  if (avail > 0 && c.inLen < sizeof(c.in)) {
+    size_t room = sizeof(c.in) - c.inLen;
+    int n = c.client.read((uint8_t*)c.in + c.inLen, (size_t)avail < room ? (size_t)avail : room);
+    if (n > 0) {
+      if (c.inLen == 0 && c.reqStart == 0) c.reqStart = now;
+      c.inLen += n;
+      c.lastIo = now;
+      s_lastActivity = now;
+    }
+  }
+
+  if (c.inLen > 0) {
+    switch (httpRequest_parse(c.req, c.in, c.inLen, sizeof(c.in))) {
+      case HTTP_REQ_DONE:
+        c.closeAfter = !c.req.keepAlive;
+        dispatch(c);
+        return;
+      case HTTP_REQ_BAD:
+        failRequest(c, 400, "bad request");
+        return;
+      case HTTP_REQ_TOO_LARGE:
+        failRequest(c, 413, "request too large");
+        return;
+      case HTTP_REQ_BODY_LARGE: {
+        const Route *route = findRoute(c.in + c.req.path.off, c.req.path.len);
+        if (route && (route->methods & M_STREAM) && httpSpan_equals(c.in, c.req.method, "POST")) {
+          c.closeAfter = true;
+          dispatch(c);
+        } else {
+          failRequest(c, 413, "request too large");
+        }
+        return;
+      }
+      case HTTP_REQ_MORE:
+        break;
+    }
+  }
+
+  if (!c.client.connected() && c.client.available() == 0) {
+    closeConn(c);
+  } else if (c.inLen > 0 && now - c.lastIo > KS_READ_TIMEOUT_MS) {
+    failRequest(c, 408, "request timeout");
+  } else if (c.inLen == 0 && now - c.lastIo > KS_KEEPALIVE_MS) {
+    closeConn(c);   // idle keep-alive connection
+  }
+}
+
+static void serviceWrite(KsConn &c, unsigned long now) {
+  if (!c.client.connected()) { closeConn(c); return; }
+
+  // headers (and in-buffer body) first, then the external body straight from flash
+  bool fromOut = c.outPos < c.outEnd;
+  const uint8_t *src = fromOut ? (const uint8_t*)c.out + c.outPos : c.ext + c.extPos;
+  size_t left = fromOut ? c.outEnd - c.outPos : (c.ext ? c.extLen - c.extPos : 0);
+  size_t n = left ? c.client.write(src, left < KS_WRITE_CHUNK ? left : KS_WRITE_CHUNK) : 0;
+  if (n > 0) {
+    if (fromOut) c.outPos += n;
+    else c.extPos += n;
+    c.lastIo = now;
+  } else if (left && now - c.lastIo > KS_READ_TIMEOUT_MS) {
+    Serial.println("[KeyServer] write stalled, dropping client");
+    closeConn(c);
+    return;
+  }
+  if (c.outPos < c.outEnd || (c.ext && c.extPos < c.extLen)) return;
+  c.ext = nullptr;
+
+  if (c.stream) {
+    c.phase = KS_STREAM;
+    s_lastActivity = now;   // an open stream keeps the server from idling out
+    return;
+  }
+
+  s_requests++;
+  if (c.reqStart) recordLatency(now - c.reqStart);
+
+  if (c.closeAfter) { closeConn(c); return; }
+
+  // keep-alive: move any pipelined bytes to the front and parse the next request
+  uint16_t used = c.req.total;
+  if (used < c.inLen) memmove(c.in, c.in + used, c.inLen - used);
+  c.inLen = used < c.inLen ? c.inLen - used : 0;
+  startRequest(c);
+  if (c.inLen > 0) c.reqStart = now;
+  c.phase = KS_READ;
+}
+
+// Firmware upload: socket -> request buffer -> flash, then one JSON reply
+static void serviceUpload(KsConn &c, unsigned long now) {
+  int avail = c.client.available();
+  if (avail > 0) {
+    size_t want = c.uploadLeft < sizeof(c.in) ? c.uploadLeft : sizeof(c.in);
+    int n = c.client.read((uint8_t*)c.in, (size_t)avail < want ? (size_t)avail : want);
+    if (n > 0) {
+      c.lastIo = now;
+      s_lastActivity = now;
+      c.uploadLeft -= n;
+      if (!ota_write((const uint8_t*)c.in, n)) { sendJsonCode(c, webApi_ota, 500); return; }
+    }
+  }
+
+  if (c.uploadLeft == 0) {
+    sendJsonCode(c, webApi_ota, ota_end() ? 200 : 422);
+  } else if (!c.client.connected() && c.client.available() == 0) {
+    ota_pause("upload interrupted");
+    closeConn(c);
+  } else if (now - c.lastIo > KS_READ_TIMEOUT_MS) {
+    ota_pause("upload timeout");
+    failRequest(c, 408, "upload timeout");
+  }
+}
+
+// Subscriber waiting for the next frame. Anything the client sends is discarded.
+static void serviceStream(KsConn &c, unsigned long now) {
+  uint8_t scratch[32];
+  while (c.client.available() > 0) c.client.read(scratch, sizeof(scratch));
+  if (!c.client.connected()) {
+    Serial.println("[KeyServer] event subscriber gone");
+    closeConn(c);
+    return;
+  }
+
+  if (c.sentSeq != s_frameSeq) {
+    s_sseDropped += s_frameSeq - c.sentSeq - 1;
+    c.sentSeq = s_frameSeq;
+    queueFrame(c, s_frame, s_frameLen, now);
+  } else if (now - c.lastIo > KS_SSE_PING_MS) {
+    static const char PING[] = ": ping\n\n";
+    queueFrame(c, PING, sizeof(PING) - 1, now);
+  }
+}
+
+static void acceptClients(unsigned long now) {
+  while (s_server->hasClient()) {
+    WiFiClient client = s_server->accept();
+    if (!client) return;
+
+    KsConn *slot = nullptr;
+    for (int i = 0; i < KS_MAX_CONN; ++i) {
+      if (s_conn[i].phase == KS_FREE) { slot = &s_conn[i]; break; }
+    }
+    if (!slot) {
+      // all slots busy: short fixed reply, no buffering
+      s_rejected++;
+      client.print("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+      client.stop();
+      continue;
+    }
+
+    slot->client = client;
+    slot->client.setNoDelay(true);
+    slot->phase = KS_READ;
+    slot->inLen = 0;
+    slot->stream = false;
+    slot->lastIo = now;
+    startRequest(*slot);
+    s_lastActivity = now;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Deferred job runner
+static void finishJob(bool ok) {
+  char safe[48];
+  htmlSafeCopy(safe, sizeof(safe), s_jobCity);
+  if (ok) {
+    snprintf(s_jobMsg, sizeof(s_jobMsg), "Geocode OK: %s. %s", safe,
+             weather_isStale() ? "Forecast refresh scheduled." : "Forecast cached.");
+    Serial.println("[KeyServer] Geocode OK");
+  } else {
+    String err = weather_getLastError();
+    snprintf(s_jobMsg, sizeof(s_jobMsg), "Geocode failed for %s.", safe);
+    Serial.print("[KeyServer] Geocode failed: ");
+    Serial.println(err);
+  }
+  s_jobState = JOB_IDLE;
 }
 
+static void runJob() {
+  if (s_jobState == JOB_QUEUED) {
+    if (weather_busy()) return;   // forecast transfer in flight, try on a later pass
+    if (!weather_geocodeStart(s_jobCity, s_jobCountry[0] ? s_jobCountry : nullptr)) {
+      finishJob(false);
+      return;
+    }
+    s_jobState = JOB_RUNNING;
+  }
+  if (s_jobState == JOB_RUNNING) {
+    if (weather_poll()) return;
+    finishJob(weather_getLastError().length() == 0);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
 void keyServer_init() {
   if (s_server) return;
   s_server = new WiFiServer(80);
   s_server->begin();
+  s_server->setNoDelay(true);
   s_running = true;
   s_lastActivity = millis();
+  if (s_statsSince == 0) s_statsSince = s_lastActivity;
   Serial.println("[KeyServer] started on port 80");
   if (WiFi.status() == WL_CONNECTED) {
     IPAddress ip = WiFi.localIP();
@@ -84,6 +720,10 @@ void keyServer_init() {
 // Stop server
 void keyServer_stop() {
   if (!s_server) return;
+  for (int i = 0; i < KS_MAX_CONN; ++i) {
+    if (s_conn[i].phase != KS_FREE) closeConn(s_conn[i]);
+  }
+  if (s_lockHeld) { power_release(PWR_LOCK_NET); s_lockHeld = false; }
   s_server->stop();
   delete s_server;
   s_server = nullptr;
@@ -93,6 +733,15 @@ void keyServer_stop() {
 
 // Call this periodically from loop(); it will auto-start server when WiFi connects.
 void keyServer_loop() {
+  // a queued lookup still completes if the server goes idle in the meantime
+  runJob();
+
+  if (s_wifiPending && millis() - s_wifiQueuedMs >= WIFI_APPLY_DELAY_MS) {
+    s_wifiPending = false;
+    connectivity_setCredentials(s_wifiSsid, s_wifiPass);
+    memset(s_wifiPass, 0, sizeof(s_wifiPass));
+  }
+
   // Stop server on idle
   if (s_running && (millis() - s_lastActivity > IDLE_TIMEOUT_MS)) {
     Serial.println("[KeyServer] idle timeout, stopping");
@@ -108,134 +757,67 @@ void keyServer_loop() {
 
   if (!s_server) return;
 
-  WiFiClient client = s_server->available();
-  if (!client) return;
+  unsigned long now = millis();
+  acceptClients(now);
 
-  s_lastActivity = millis();
-  Serial.println("[KeyServer] client connected");
-
-  // Read request headers (simple)
-  String req;
-  unsigned long start = millis();
-  while (client.connected() && (millis() - start < 2000)) {
-    if (client.available()) {
-      String line = client.readStringUntil('\n');
-      req += line + '\n';
-      if (line.length() == 1 && line[0] == '\r') break;
-    } else delay(1);
-  }
-
-  int idx = req.indexOf('\n');
-  String reqLine = idx >= 0 ? req.substring(0, idx) : String();
-  reqLine.trim();
-  Serial.print("[KeyServer] Request: ");
-  Serial.println(reqLine);
-
-  // Parse method and path
-  String method, path;
-  {
-    int sp1 = reqLine.indexOf(' ');
-    int sp2 = (sp1 >= 0) ? reqLine.indexOf(' ', sp1 + 1) : -1;
-    if (sp1 >= 0 && sp2 > sp1) {
-      method = reqLine.substring(0, sp1);
-      path = reqLine.substring(sp1 + 1, sp2);
-    }
+  bool active = false;
+  for (int i = 0; i < KS_MAX_CONN; ++i) {
+    KsConn &c = s_conn[i];
+    if (c.phase == KS_READ) serviceRead(c, now);
+    if (c.phase == KS_STREAM) serviceStream(c, now);
+    if (c.phase == KS_UPLOAD) serviceUpload(c, now);
+    if (c.phase == KS_WRITE) serviceWrite(c, now);
+    if (c.phase != KS_FREE) active = true;
   }
 
-  String body;
-  if (method == "POST") {
-    int clIdx = req.indexOf("\nContent-Length:");
-    int contentLength = 0;
-    if (clIdx < 0) clIdx = req.indexOf("\ncontent-length:");
-    if (clIdx >= 0) {
-      int lineEnd = req.indexOf('\n', clIdx + 1);
-      String clLine = req.substring(clIdx + 1, lineEnd);
-      clLine.replace("Content-Length:", "");
-      clLine.replace("content-length:", "");
-      clLine.trim();
-      contentLength = clLine.toInt();
-    }
-    unsigned long tstart = millis();
-    while (client.connected() && (int)body.length() < contentLength && (millis() - tstart < 2000)) {
-      if (client.available()) {
-        char c = client.read();
-        body += c;
-      } else delay(1);
-    }
-  }
+  // keep full clock and no light sleep while any client is connected
+  if (active && !s_lockHeld) { power_acquire(PWR_LOCK_NET); s_lockHeld = true; }
+  if (!active && s_lockHeld) { power_release(PWR_LOCK_NET); s_lockHeld = false; }
+}
 
-  // Extract query string
-  String query;
-  int qIdx = path.indexOf('?');
-  if (qIdx >= 0) {
-    query = path.substring(qIdx + 1);
-    path = path.substring(0, qIdx);
-  } else if (method == "POST") {
-    query = body;
-  }
+const char *keyServer_jobMessage() { return s_jobMsg; }
 
-  // Root page
-  if (path == "/" || path.length() == 0) {
-    String page = makeFormPage("");
-    sendHttpResponse(client, page);
-    client.stop();
+void keyServer_publish(const Measurement &m) {
+  HttpBody b;
+  httpBody_init(b, s_frame, sizeof(s_frame));
+  httpBody_printf(b, "id: %lu\ndata: ", (unsigned long)(s_frameSeq + 1));
+  webApi_writeMeasurement(b, m);
+  httpBody_puts(b, "\n\n");
+  if (b.overflow) {
+    Serial.println("[KeyServer] SSE frame too large, not published");
     return;
   }
+  s_frameLen = b.len;
+  s_frameSeq++;
+  // subscribers pick the frame up in keyServer_loop()
+}
 
-  if (path == "/set") {
-    // parse query k=v&...
-    String valCity = "", valCountry = "";
-    int pos = 0;
-    while (pos < (int)query.length()) {
-      int amp = query.indexOf('&', pos);
-      String part;
-      if (amp >= 0) { part = query.substring(pos, amp); pos = amp + 1; }
-      else { part = query.substring(pos); pos = query.length(); }
-      int eq = part.indexOf('=');
-      if (eq < 0) continue;
-      String name = part.substring(0, eq);
-      String val = urlDecode(part.substring(eq+1));
-      name.trim();
-      val.trim();
-      if (name == "city") valCity = val;
-      else if (name == "country") valCountry = val;
-    }
-
-    String statusMsg;
-
-    if (valCity.length() > 0) {
-      bool geoOk = false;
-      if (valCountry.length() > 0) geoOk = weather_geocodeLocation(valCity.c_str(), valCountry.c_str());
-      else geoOk = weather_geocodeLocation(valCity.c_str(), nullptr);
-      if (geoOk) { statusMsg += "Geocode OK. "; Serial.println("[KeyServer] Geocode OK"); }
-      else { statusMsg += "Geocode failed. "; Serial.print("[KeyServer] Geocode failed: "); Serial.println(weather_getLastError()); }
-    } else {
-      statusMsg += "No city provided. ";
-    }
-
-    // Verify fetch if WiFi connected
-    if (WiFi.status() == WL_CONNECTED) {
-      if (weather_fetch()) {
-        statusMsg += "Weather fetch OK.";
-      } else {
-        statusMsg += "Weather fetch failed.";
-      }
-    } else {
-      statusMsg += "WiFi not connected for verify.";
-    }
-
-    String page = makeFormPage(statusMsg);
-    sendHttpResponse(client, page);
-    client.stop();
-    s_lastActivity = millis();
-    return;
+void keyServer_printStats() {
+  unsigned long elapsed = millis() - s_statsSince;
+  int open = 0, streams = 0;
+  for (int i = 0; i < KS_MAX_CONN; ++i) {
+    if (s_conn[i].phase != KS_FREE) open++;
+    if (s_conn[i].stream) streams++;
   }
 
-  // other paths -> 404
-  {
-    String page = "<html><body><h3>404</h3></body></html>";
-    sendHttpResponse(client, page);
-    client.stop();
-    return;
+  Serial.printf("[KeyServer] requests=%lu rejected=%lu errors=%lu open=%d/%d",
+                (unsigned long)s_requests, (unsigned long)s_rejected,
+                (unsigned long)s_errors, open, KS_MAX_CONN);
+  if (elapsed > 0) Serial.printf(" rate=%.2f/s", s_requests * 1000.0f / elapsed);
+  Serial.printf(" 304=%lu", (unsigned long)s_notModified);
+  Serial.printf(" events=%d/%d seq=%lu dropped=%lu\n", streams, KS_SSE_MAX_CLIENTS,
+                (unsigned long)s_frameSeq, (unsigned long)s_sseDropped);
+
+  // p50/p99 from the histogram: upper bound of the bucket that crosses the rank
+  uint32_t p50 = 0, p99 = 0, seen = 0;
+  for (int b = 0; b < LAT_BUCKETS; ++b) {
+    seen += s_latHist[b];
+    uint32_t bound = b < LAT_BUCKETS - 1 ? LAT_BUCKET_MS[b] : 0xFFFF;
+    if (!p50 && seen * 2 >= s_requests && s_requests) p50 = bound;
+    if (!p99 && seen * 100 >= s_requests * 99 && s_requests) p99 = bound;
   }
-}
\ No newline at end of file
+  Serial.print("[KeyServer] latency ms <");
+  for (int b = 0; b < LAT_BUCKETS - 1; ++b) Serial.printf(" %u:%lu", LAT_BUCKET_MS[b], (unsigned long)s_latHist[b]);
+  Serial.printf(" >=%u:%lu", LAT_BUCKET_MS[LAT_BUCKETS - 2], (unsigned long)s_latHist[LAT_BUCKETS - 1]);
+  Serial.printf("  p50<%lu p99<%lu\n", (unsigned long)p50, (unsigned long)p99);
+}
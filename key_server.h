@@ -2,6 +2,7 @@
 #define KEY_SERVER_H
 
 #include <Arduino.h>
+#include "measurement.h"
 
 // Initialize server (no-op until WiFi connected). Call once in setup or leave out and call keyServer_loop() from loop().
 // You must call keyServer_loop() regularly (from your main loop).
@@ -9,4 +10,14 @@ void keyServer_init();   // starts the server if WiFi connected (safe to call re
 void keyServer_loop();   // handle incoming HTTP requests; also auto-starts server when WiFi connects
 void keyServer_stop();   // stop server
 
+// Outcome of the last /set geocode job (empty before the first one)
+const char *keyServer_jobMessage();
+
+// Push a measurement to all /events (Server-Sent Events) subscribers. Never blocks: each
+// subscriber has one frame in flight and skips to the newest when it falls behind.
+void keyServer_publish(const Measurement &m);
+
+// Requests served, rejected (all slots busy), error replies, request rate and latency histogram
+void keyServer_printStats();
+
 #endif // KEY_SERVER_H
\ No newline at end of file
@@ -0,0 +1,35 @@
+// measurement.cpp
+// - Collects one snapshot of all sensors into a Measurement record.
+// - Sensor drivers are still placeholders, so values come from the test_* globals in config.h.
+#include "measurement.h"
+#include "config.h"
+#include "time_manager.h"
+#include <time.h>
+
+static Measurement s_latest;
+static bool s_hasLatest = false;
+
+void measurement_capture(Measurement &out) {
+  out.timestamp    = timeManager_isTimeValid() ? (uint32_t)time(nullptr) : 0;
+  out.weight       = test_weight;
+  out.temp_int     = test_temp_int;
+  out.hum_int      = test_hum_int;
+  out.temp_ext     = test_temp_ext;
+  out.hum_ext      = test_hum_ext;
+  out.pressure     = test_pressure;
+  out.acc_x        = test_acc_x;
+  out.acc_y        = test_acc_y;
+  out.acc_z        = test_acc_z;
+  out.batt_voltage = test_batt_voltage;
+  out.batt_percent = test_batt_percent;
+  out.rssi         = test_rssi;
+
+  s_latest = out;
+  s_hasLatest = true;
+}
+
+bool measurement_getLatest(Measurement &out) {
+  if (!s_hasLatest) return false;
+  out = s_latest;
+  return true;
+}
@@ -0,0 +1,29 @@
+#ifndef MEASUREMENT_H
+#define MEASUREMENT_H
+
+#include <Arduino.h>
+
+// One snapshot of all hive sensors, taken by the sampling scheduler.
+struct Measurement {
+  uint32_t timestamp;     // epoch seconds (0 while the clock is not valid yet)
+  float weight;           // kg
+  float temp_int;         // internal temperature (C)
+  float hum_int;          // internal humidity (%)
+  float temp_ext;         // external temperature (C)
+  float hum_ext;          // external humidity (%)
+  float pressure;         // hPa
+  float acc_x;            // g
+  float acc_y;
+  float acc_z;
+  float batt_voltage;     // V
+  int   batt_percent;     // %
+  int   rssi;             // dBm
+};
+
+// Read all sensors into out and remember it as the latest measurement.
+void measurement_capture(Measurement &out);
+
+// Latest captured measurement. Returns false if nothing was captured yet.
+bool measurement_getLatest(Measurement &out);
+
+#endif // MEASUREMENT_H
@@ -4,9 +4,12 @@
 #include "config.h"
 #include "time_manager.h"
 #include "modem_manager.h"
+#include "net_status.h"
+#include "at_engine.h"
 #include "weather_manager.h"
 #include "provisioning_ui.h"
 #include "sms_handler.h"
+#include "power_manager.h"
 #include <SD.h>
 #include <LiquidCrystal_I2C.h>
 #include <WiFi.h>
@@ -268,6 +271,10 @@ static void menuShowStatus() {
         uiPrint(0, 3, getTextEN(TXT_BACK_SMALL));
       else
         lcdPrintGreek(getTextGR(TXT_BACK_SMALL), 0, 3);
+
+      // estimated idle current saved by DFS + light sleep
+      snprintf(line, 21, "PM:-%3dmA", (int)(power_getIdleSavedMa() + 0.5f));
+      uiPrint(11, 3, line);
     }
 
     Button b = getButton();
@@ -558,31 +565,45 @@ static void menuCalSave() {
 // =====================================================================
 // CONNECTIVITY
 // =====================================================================
+// "12s" / "5m" / "--" for a net_status stamp
+static void formatAge(char *out, size_t len, uint32_t stampMs) {
+  uint32_t age = netStatus_age(stampMs);
+  if (age == NETSTAT_AGE_NEVER) snprintf(out, len, "--");
+  else if (age < 100000UL) snprintf(out, len, "%lus", (unsigned long)(age / 1000UL));
+  else snprintf(out, len, "%lum", (unsigned long)(age / 60000UL));
+}
+
 static void menuShowConnectivity() {
   uiClear();
+  netStatus_refresh();   // fresh values while the screen is open
 
   while (true) {
-    bool wifiOK = (WiFi.status() == WL_CONNECTED);
-    bool lteOK  = modem_isNetworkRegistered();
+    // This screen owns the loop: keep the AT engine and the status cache moving.
+    // Everything drawn below is read from the cache (no AT round trip per frame).
+    at_loop();
+    netStatus_loop();
+    const NetStatus &ns = netStatus_get();
 
     char line[21];
+    char age[6];
 
-    if (wifiOK) {
-      int32_t rssi = WiFi.RSSI();
+    if (ns.wifiConnected) {
       uiPrint(0, 0, getTextEN(TXT_WIFI_CONNECTED));
 
       snprintf(line, 21, "%s %s", getTextEN(TXT_SSID), WiFi.SSID().c_str());
       uiPrint(0, 1, line);
 
-      snprintf(line, 21, "%s %ddBm", getTextEN(TXT_RSSI), rssi);
+      formatAge(age, sizeof(age), ns.wifiMs);
+      snprintf(line, 21, "%s %4ddBm %4s   ", getTextEN(TXT_RSSI), ns.wifiRssi, age);
       uiPrint(0, 2, line);
-    } else if (lteOK) {
-      int16_t rssi = modem_getRSSI();
-
+    } else if (netStatus_lteRegistered()) {
       uiPrint(0, 0, getTextEN(TXT_LTE_REGISTERED));
-      snprintf(line, 21, "%s %ddBm", getTextEN(TXT_RSSI), rssi);
+      formatAge(age, sizeof(age), ns.rssiMs);
+      if (ns.lteRssi) snprintf(line, 21, "%s %4ddBm %4s   ", getTextEN(TXT_RSSI), ns.lteRssi, age);
+      else snprintf(line, 21, "%-20s", "RSSI: --");
       uiPrint(0, 1, line);
-      uiPrint(0, 2, "MODE: LTE");
+      snprintf(line, 21, "LTE %-16s", ns.op);
+      uiPrint(0, 2, line);
     } else {
       uiPrint(0, 0, getTextEN(TXT_NO_CONNECTIVITY));
       uiPrint(0, 1, "                   ");
@@ -680,17 +701,49 @@ static void menuShowWeather() {
   int lastPage = -1;
   WeatherDay wd;
 
-  // Show fetching indicator briefly
-  uiClear();
-  if (currentLanguage == LANG_EN)
-    uiPrint(0,0,getTextEN(TXT_FETCHING_WEATHER));
-  else
-    lcdPrintGreek(getTextGR(TXT_FETCHING_WEATHER),0,0);
+  // Serve from the cache; only wait in the foreground when there is nothing to show.
+  // A stale cache is refreshed in the background while the pages are displayed.
+  if (!weather_hasData() && (weather_busy() || weather_fetchStart())) {
+    // Show fetching indicator
+    uiClear();
+    if (currentLanguage == LANG_EN)
+      uiPrint(0,0,getTextEN(TXT_FETCHING_WEATHER));
+    else
+      lcdPrintGreek(getTextGR(TXT_FETCHING_WEATHER),0,0);
 
-  // Blocking fetch (brief)
-  weather_fetch();
+    // Non-blocking fetch: show phase/progress, BACK cancels
+    char line[21];
+    const char *lastPhase = nullptr;
+    int lastPct = -2;
+    uiPrint(0, 3, getTextEN(TXT_BACK_SMALL));
+    while (weather_poll()) {
+      const char *phase = weather_phaseName();
+      int pct = weather_progress();
+      if (phase != lastPhase || pct != lastPct) {
+        if (pct >= 0) snprintf(line, 21, "%-10s %3d%%     ", phase, pct);
+        else          snprintf(line, 21, "%-20s", phase);
+        uiPrint(0, 1, line);
+        lastPhase = phase;
+        lastPct = pct;
+      }
+      Button b = getButton();
+      if (b == BTN_BACK_PRESSED) {
+        weather_cancel();
+        menuDraw();
+        return;
+      }
+      delay(5);
+    }
+  }
 
+  bool wasBusy = weather_busy();
   while (true) {
+    // background refresh; redraw when it completes
+    weather_loop();
+    bool busy = weather_busy();
+    if (wasBusy && !busy) lastPage = -1;
+    wasBusy = busy;
+
     int total = weather_daysCount();
     int maxPage = (total > 0) ? (total - 1) : 0;
 
@@ -706,28 +759,30 @@ static void menuShowWeather() {
 
         weather_getDay(page, wd);
         char line[21];
+        char when[16];
+        weather_formatTime(wd, when, sizeof(when));
 
         // Line 0: date/time
         if (currentLanguage == LANG_EN) {
-          snprintf(line,21,"%s                ", wd.date.c_str());
+          snprintf(line,21,"%s                ", when);
           uiPrint(0,0,line);
           // Line 1: description (trim/pad)
-          snprintf(line,21,"%-20s", wd.desc.c_str());
+          snprintf(line,21,"%-20s", weather_codeDesc(wd.code));
           uiPrint(0,1,line);
           // Line 2: temperature and humidity
-          snprintf(line,21,"T:%5.1fC H:%3.0f%%", wd.temp_min, wd.humidity);
+          snprintf(line,21,"T:%5.1fC H:%3d%%", weatherDay_tempC(wd), (int)wd.humidity);
           uiPrint(0,2,line);
           // Line 3: pressure and back label
-          snprintf(line,21,"P:%5.0fhPa %s", wd.pressure, getTextEN(TXT_BACK_SMALL));
+          snprintf(line,21,"P:%5.0fhPa %s", weatherDay_pressureHpa(wd), getTextEN(TXT_BACK_SMALL));
           uiPrint(0,3,line);
         } else {
           // Greek: show same patterns using lcdPrintGreek for strings
-          snprintf(line,21,"%s                ", wd.date.c_str());
+          snprintf(line,21,"%s                ", when);
           lcdPrintGreek(line,0,0);
-          lcdPrintGreek(wd.desc.c_str(),0,1);
-          snprintf(line,21,"T:%5.1fC H:%3.0f%%", wd.temp_min, wd.humidity);
+          lcdPrintGreek(weather_codeDesc(wd.code),0,1);
+          snprintf(line,21,"T:%5.1fC H:%3d%%", weatherDay_tempC(wd), (int)wd.humidity);
           lcdPrintGreek(line,0,2);
-          snprintf(line,21,"P:%5.0fhPa %s", wd.pressure, getTextEN(TXT_BACK_SMALL));
+          snprintf(line,21,"P:%5.0fhPa %s", weatherDay_pressureHpa(wd), getTextEN(TXT_BACK_SMALL));
           lcdPrintGreek(line,0,3);
         }
       }
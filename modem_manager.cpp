@@ -1,4 +1,7 @@
 #include "modem_manager.h"
+#include "power_manager.h"
+#include "at_engine.h"
+#include "config.h"
 #include <HardwareSerial.h>
 
 // ---------------------------------------------------------
@@ -6,13 +9,117 @@
 // ---------------------------------------------------------
 HardwareSerial SerialAT(2);  // UART2 on ESP32
 
+// Constructing TinyGsm only stores the stream, so the instance can live at file scope:
+// modem_get() always returns a valid object, even before (or without) modemManager_init().
+// _modem is set once the modem has been initialized.
+static TinyGsm  s_modemInstance(SerialAT);
 static TinyGsm* _modem = nullptr;
 
+// ---------------------------------------------------------
+// Power state / leases
+// ---------------------------------------------------------
+static const char *POWER_STATE_NAMES[MPS_COUNT] = { "off", "booting", "active", "idle" };
+
+static ModemPowerState s_pstate      = MPS_OFF;
+static unsigned long   s_pstateSince = 0;
+static unsigned long   s_pstateMs[MPS_COUNT];
+static uint32_t        s_leaseMask = 0;
+static unsigned long   s_leaseUntil[MODEM_LEASE_COUNT];   // 0 = until released
+static unsigned long   s_idleSince = 0;
+static unsigned long   s_offSince  = 0;
+static unsigned long   s_bootStart = 0;
+static unsigned long   s_nextProbe = 0;
+static bool            s_pulsing = false;       // PWRKEY held high
+static bool            s_probePending = false;
+
+static uint32_t s_powerUps = 0;
+static uint32_t s_powerDowns = 0;
+static uint32_t s_bootFails = 0;
+static uint32_t s_bootMsTotal = 0;
+static uint32_t s_bootMsMax = 0;
+
 // ---------------------------------------------------------
 // Accessor for global modem instance
 // ---------------------------------------------------------
 TinyGsm& modem_get() {
-    return *_modem;
+    return s_modemInstance;
+}
+
+bool modem_isReady() {
+    return _modem != nullptr;
+}
+
+// ---------------------------------------------------------
+// Power state machine
+// ---------------------------------------------------------
+static void setPowerState(ModemPowerState st)
+{
+    unsigned long now = millis();
+    s_pstateMs[s_pstate] += now - s_pstateSince;
+    s_pstateSince = now;
+    if (st == s_pstate) return;
+    Serial.printf("[Modem] power %s -> %s\n", POWER_STATE_NAMES[s_pstate], POWER_STATE_NAMES[st]);
+    s_pstate = st;
+    if (st == MPS_IDLE) s_idleSince = now;
+    if (st == MPS_OFF) s_offSince = now;
+}
+
+static void startBoot()
+{
+    setPowerState(MPS_BOOTING);
+    s_bootStart = millis();
+    s_pulsing = true;
+    s_probePending = false;
+    s_nextProbe = s_bootStart + MODEM_PWRKEY_MS + 1000;
+    digitalWrite(MODEM_PWR, HIGH);     // PWRKEY pulse (board transistor inverts it)
+}
+
+// Plain "AT" while booting; the first OK ends the boot
+static void onProbe(const AtReply &reply, void *ctx)
+{
+    (void)ctx;
+    s_probePending = false;
+    if (s_pstate != MPS_BOOTING || reply.result != AT_OK) return;
+
+    uint32_t ms = millis() - s_bootStart;
+    s_powerUps++;
+    s_bootMsTotal += ms;
+    if (ms > s_bootMsMax) s_bootMsMax = ms;
+    Serial.printf("[Modem] answering %lu ms after power-up\n", (unsigned long)ms);
+
+    // Fast re-attach: no TinyGSM restart() (full CFUN reset + SIM init); the module
+    // re-registers on its stored PLMN/cell and the bearer is raised on demand.
+    at_submit("E0", 1000, nullptr, nullptr);
+    at_submit("+CREG=1", 1000, nullptr, nullptr);
+    at_submit("+CEREG=1", 1000, nullptr, nullptr);
+    setPowerState(s_leaseMask ? MPS_ACTIVE : MPS_IDLE);
+}
+
+static void powerDown()
+{
+    Serial.println("[Modem] no lease, powering down (AT+CPOF)");
+    at_submit("+CPOF", 9000, nullptr, nullptr);
+    s_powerDowns++;
+    setPowerState(MPS_OFF);
+}
+
+// PSM / eDRX timers (3GPP TS 27.007 +CPSMS / +CEDRXS), or both off for the other policies
+static void negotiateSleep()
+{
+#if MODEM_POWER_POLICY == MODEM_POWER_PSM
+    // PSM: unreachable between TAUs, so SMS commands wait up to MODEM_PSM_TAU.
+    // Without it eDRX alone keeps the modem pageable every MODEM_EDRX_CYCLE.
+#if MODEM_PSM_ENABLED
+    AtResult psm  = at_exec("+CPSMS=1,,,\"" MODEM_PSM_TAU "\",\"" MODEM_PSM_ACTIVE "\"", 2000);
+#else
+    AtResult psm  = at_exec("+CPSMS=0", 2000);
+#endif
+    AtResult edrx = at_exec("+CEDRXS=1,4,\"" MODEM_EDRX_CYCLE "\"", 2000);
+    Serial.printf("[Modem] PSM request %s, eDRX request %s\n", at_resultName(psm), at_resultName(edrx));
+#else
+    at_exec("+CPSMS=0", 2000);
+    at_exec("+CEDRXS=0", 2000);
+#endif
 }
 
 // ---------------------------------------------------------
@@ -20,17 +127,168 @@ TinyGsm& modem_get() {
 // ---------------------------------------------------------
 void modemManager_init()
 {
+    power_acquire(PWR_LOCK_UART);
+    pinMode(MODEM_PWR, OUTPUT);
+    digitalWrite(MODEM_PWR, LOW);
     SerialAT.begin(115200, SERIAL_8N1, 26, 27);   // your pins in v20
+    power_enableUartWake(2);                      // URCs must wake the CPU from light sleep
     delay(300);
 
-    static TinyGsm modemInstance(SerialAT);
+    TinyGsm &modemInstance = s_modemInstance;
     _modem = &modemInstance;
 
+    // Left powered down by MODEM_POWER_OFF before a reset: pulse PWRKEY first
+    if (!modemInstance.testAT(1000)) {
+        Serial.println("[Modem] not answering, pulsing PWRKEY");
+        digitalWrite(MODEM_PWR, HIGH);
+        delay(MODEM_PWRKEY_MS);
+        digitalWrite(MODEM_PWR, LOW);
+    }
+
     modemInstance.restart();
     delay(500);
 
-    modemInstance.sendAT("+CFUN=1");
-    modemInstance.waitResponse(1000);
+    at_init(SerialAT);
+
+    AtResult r = at_exec("+CFUN=1", 1000);
+    if (r != AT_OK) Serial.printf("[Modem] CFUN=1: %s\n", at_resultName(r));
+    at_exec("+CREG=1", 1000);
+    at_exec("+CEREG=1", 1000);
+    negotiateSleep();
+    power_release(PWR_LOCK_UART);
+
+    s_pstateSince = millis();
+    s_pstate = MPS_OFF;
+    setPowerState(at_exec("", 1000) == AT_OK ? MPS_IDLE : MPS_OFF);
+}
+
+// ---------------------------------------------------------
+// Leases
+// ---------------------------------------------------------
+bool modem_acquire(ModemLease who, uint32_t holdMs)
+{
+    if (!_modem || who >= MODEM_LEASE_COUNT) return false;
+    uint32_t bit = 1UL << who;
+    unsigned long until = holdMs ? millis() + holdMs : 0;
+    if (!(s_leaseMask & bit)) s_leaseUntil[who] = until;
+    else if (s_leaseUntil[who] && (!until || (long)(until - s_leaseUntil[who]) > 0)) s_leaseUntil[who] = until;
+    s_leaseMask |= bit;
+
+    switch (s_pstate) {
+        case MPS_ACTIVE:
+            return true;
+        case MPS_IDLE:
+            setPowerState(MPS_ACTIVE);
+            return true;
+        case MPS_OFF:
+            if (millis() - s_offSince >= MODEM_MIN_OFF_MS) startBoot();
+            return false;
+        default:
+            return false;   // booting
+    }
+}
+
+void modem_release(ModemLease who)
+{
+    if (who >= MODEM_LEASE_COUNT) return;
+    s_leaseMask &= ~(1UL << who);
+}
+
+bool modem_waitOn(uint32_t timeoutMs)
+{
+    unsigned long t0 = millis();
+    while (!modem_isOn()) {
+        if (millis() - t0 >= timeoutMs || (s_pstate == MPS_OFF && !s_leaseMask)) return false;
+        modem_powerLoop();
+        at_loop();
+        delay(10);
+    }
+    return true;
+}
+
+void modem_powerLoop()
+{
+    if (!_modem) return;
+    unsigned long now = millis();
+
+    for (int i = 0; i < MODEM_LEASE_COUNT; ++i) {
+        uint32_t bit = 1UL << i;
+        if ((s_leaseMask & bit) && s_leaseUntil[i] && (long)(now - s_leaseUntil[i]) >= 0) s_leaseMask &= ~bit;
+    }
+
+    switch (s_pstate) {
+        case MPS_OFF:
+            if (s_leaseMask && now - s_offSince >= MODEM_MIN_OFF_MS) startBoot();
+            break;
+
+        case MPS_BOOTING:
+            if (s_pulsing && now - s_bootStart >= MODEM_PWRKEY_MS) {
+                digitalWrite(MODEM_PWR, LOW);
+                s_pulsing = false;
+            }
+            if (!s_pulsing && !s_probePending && (long)(now - s_nextProbe) >= 0) {
+                s_probePending = at_submit("", 500, onProbe, nullptr);
+                s_nextProbe = now + 1000;
+            }
+            if (now - s_bootStart >= MODEM_BOOT_TIMEOUT_MS) {
+                Serial.println("[Modem] power-up timed out");
+                digitalWrite(MODEM_PWR, LOW);
+                s_pulsing = false;
+                s_bootFails++;
+                setPowerState(MPS_OFF);
+            }
+            break;
+
+        case MPS_ACTIVE:
+            if (!s_leaseMask) setPowerState(MPS_IDLE);
+            break;
+
+        case MPS_IDLE:
+#if MODEM_POWER_POLICY == MODEM_POWER_OFF
+            if (now - s_idleSince >= MODEM_LINGER_MS && !at_busy() && !at_queued()) powerDown();
+#endif
+            break;
+
+        default:
+            break;
+    }
+}
+
+ModemPowerState modem_powerState() { return s_pstate; }
+bool modem_isOn() { return s_pstate == MPS_ACTIVE || s_pstate == MPS_IDLE; }
+uint32_t modem_powerUps() { return s_powerUps; }
+
+static unsigned long powerStateMs(int st)
+{
+    return s_pstateMs[st] + (st == s_pstate ? millis() - s_pstateSince : 0);
+}
+
+uint32_t modem_powerStateSec(ModemPowerState st)
+{
+    return st < MPS_COUNT ? powerStateMs(st) / 1000UL : 0;
+}
+
+const char *modem_powerStateName(ModemPowerState st)
+{
+    return st < MPS_COUNT ? POWER_STATE_NAMES[st] : "?";
+}
+
+void modem_printPowerStats()
+{
+    unsigned long total = 0;
+    unsigned long ms[MPS_COUNT];
+    for (int i = 0; i < MPS_COUNT; ++i) {
+        ms[i] = powerStateMs(i);
+        total += ms[i];
+    }
+    for (int i = 0; i < MPS_COUNT; ++i) {
+        Serial.printf("[Modem] %-7s %8lu s  %3lu%%\n", POWER_STATE_NAMES[i], ms[i] / 1000UL,
+                      total ? (unsigned long)((uint64_t)ms[i] * 100ULL / total) : 0UL);
+    }
+    Serial.printf("[Modem] power-ups=%lu downs=%lu failed=%lu boot avg=%lums max=%lums leases=0x%02lx\n",
+                  (unsigned long)s_powerUps, (unsigned long)s_powerDowns, (unsigned long)s_bootFails,
+                  (unsigned long)(s_powerUps ? s_bootMsTotal / s_powerUps : 0),
+                  (unsigned long)s_bootMsMax, (unsigned long)s_leaseMask);
 }
 
 // ---------------------------------------------------------
@@ -38,7 +296,14 @@ void modemManager_init()
 // ---------------------------------------------------------
 bool modem_isNetworkRegistered()
 {
+    if (!modem_isOn()) return false;
+    power_acquire(PWR_LOCK_UART);
+    if (!at_waitIdle(AT_FENCE_MS)) {   // AT command still running: do not talk over it
+        power_release(PWR_LOCK_UART);
+        return false;
+    }
     int stat = modem_get().getRegistrationStatus();
+    power_release(PWR_LOCK_UART);
 
     // 1 = registered (home)
     // 5 = registered (roaming)
@@ -50,7 +315,15 @@ bool modem_isNetworkRegistered()
 // ---------------------------------------------------------
 int16_t modem_getRSSI()
 {
-    return modem_get().getSignalQuality();
+    if (!modem_isOn()) return 99;   // 99 = unknown, as +CSQ reports it
+    power_acquire(PWR_LOCK_UART);
+    if (!at_waitIdle(AT_FENCE_MS)) {
+        power_release(PWR_LOCK_UART);
+        return 99;
+    }
+    int16_t q = modem_get().getSignalQuality();
+    power_release(PWR_LOCK_UART);
+    return q;
 }
 
 // ---------------------------------------------------------
@@ -58,5 +331,13 @@ int16_t modem_getRSSI()
 // ---------------------------------------------------------
 String modem_getOperator()
 {
-    return modem_get().getOperator();
+    if (!modem_isOn()) return String();
+    power_acquire(PWR_LOCK_UART);
+    if (!at_waitIdle(AT_FENCE_MS)) {
+        power_release(PWR_LOCK_UART);
+        return String();
+    }
+    String op = modem_get().getOperator();
+    power_release(PWR_LOCK_UART);
+    return op;
 }
@@ -10,14 +10,62 @@
 
 #include <TinyGsmClient.h>
 
-// Expose the global modem instance
+// Expose the global modem instance (always valid; check modem_isReady() before use)
 TinyGsm& modem_get();
 
+// True once modemManager_init() has created the modem instance
+bool modem_isReady();
+
 // ---------------------------------------------------------------------
 // Public API
+// Live AT queries (block for a round trip). UI and HTTP readers use the cached
+// values from net_status.h instead.
 // ---------------------------------------------------------------------
 bool modem_isNetworkRegistered();
 int16_t modem_getRSSI();
 String modem_getOperator();
 
 void modemManager_init();
+
+// ---------------------------------------------------------------------
+// Power policy (MODEM_POWER_POLICY in config.h) and radio-time leases
+// ---------------------------------------------------------------------
+enum ModemPowerState {
+    MPS_OFF = 0,    // powered down (AT+CPOF), or not answering
+    MPS_BOOTING,    // PWRKEY pulsed, waiting for "AT" -> OK
+    MPS_ACTIVE,     // on, at least one lease held
+    MPS_IDLE,       // on, no lease: PSM/eDRX sleep, or lingering before power-down
+    MPS_COUNT
+};
+
+// Lease owners; each holds at most one lease
+enum ModemLease {
+    MODEM_LEASE_NET = 0,    // LTE data bearer (telemetry, HTTP)
+    MODEM_LEASE_SMS,        // stored-message listing
+    MODEM_LEASE_SMS_TX,     // outgoing SMS (replies, alerts)
+    MODEM_LEASE_TIME,       // +CCLK? time sync
+    MODEM_LEASE_COUNT
+};
+
+// Ask for radio time. holdMs = 0 keeps the lease until modem_release(); otherwise it
+// lapses holdMs after the last call. Returns true if the modem is on right now; when it
+// is off, the call starts the power-up and returns false (try again later).
+bool modem_acquire(ModemLease who, uint32_t holdMs = 0);
+void modem_release(ModemLease who);
+
+// Block (running the AT engine) until the modem is on. Not from AT callbacks.
+bool modem_waitOn(uint32_t timeoutMs);
+
+// Boot progress, lease expiry, power-down after MODEM_LINGER_MS. Call from loop().
+void modem_powerLoop();
+
+ModemPowerState modem_powerState();
+bool     modem_isOn();          // MPS_ACTIVE or MPS_IDLE
+uint32_t modem_powerUps();      // completed power-ups since boot (registration caches reset)
+
+// Time spent in a power state since boot, including the current stretch
+uint32_t modem_powerStateSec(ModemPowerState st);
+const char *modem_powerStateName(ModemPowerState st);
+
+// Time per power state, power-up count and boot latency since boot
+void modem_printPowerStats();
@@ -0,0 +1,180 @@
+// net_status.cpp
+// - One cache for WiFi and LTE link status, so screens and /api/status stop issuing
+//   AT+CREG / AT+CSQ per frame (each a blocking UART round trip).
+// - WiFi values come from the driver every NETSTAT_WIFI_MS. LTE registration, signal
+//   and operator are queried asynchronously on the AT engine (+CEREG?, +CSQ, +COPS?),
+//   one at a time and only while the modem is on; +CEREG URCs update the registration
+//   in between. +CREG (circuit switched) is tracked separately and never decides
+//   whether LTE is up: on a data-only SIM it stays 0 while EPS is registered.
+// - After a modem power-up every LTE value is refreshed at once.
+#include "net_status.h"
+#include "config.h"
+#include "at_engine.h"
+#include "modem_manager.h"
+#include <WiFi.h>
+
+enum { Q_REG = 0, Q_RSSI, Q_OP, Q_COUNT };
+
+static NetStatus s_status;
+static bool      s_queryPending = false;
+static uint32_t  s_powerEpoch = 0;
+static uint32_t  s_triedMs[Q_COUNT];   // last attempt, so a failing query is not retried every pass
+
+static uint32_t s_queries = 0;
+static uint32_t s_urcUpdates = 0;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static uint32_t stampNow() {
+  uint32_t now = millis();
+  return now ? now : 1;   // 0 means "never"
+}
+
+static bool due(uint32_t stampMs, uint32_t periodMs) {
+  return stampMs == 0 || millis() - stampMs >= periodMs;
+}
+
+// "+CEREG: <stat>" (URC) or "+CEREG: <n>,<stat>[,...]" (query reply)
+static int parseRegStat(const char *line, bool urc) {
+  const char *p = strchr(line, ':');
+  if (!p) return -1;
+  if (!urc) {
+    p = strchr(p, ',');
+    if (!p) return -1;
+  }
+  return atoi(p + 1);
+}
+
+static void setRegStat(int stat) {
+  if (stat != s_status.regStat) Serial.printf("[NetStatus] LTE registration %d -> %d\n", s_status.regStat, stat);
+  s_status.regStat = (int8_t)stat;
+  s_status.regMs = stampNow();
+}
+
+static void onCeregUrc(const char *line, void *ctx) {
+  (void)ctx;
+  int stat = parseRegStat(line, true);
+  if (stat < 0) return;
+  s_urcUpdates++;
+  setRegStat(stat);
+}
+
+static void onCregUrc(const char *line, void *ctx) {
+  (void)ctx;
+  int stat = parseRegStat(line, true);
+  if (stat < 0) return;
+  s_urcUpdates++;
+  s_status.csRegStat = (int8_t)stat;
+  s_status.csRegMs = stampNow();
+}
+
+static void onCereg(const AtReply &reply, void *ctx) {
+  (void)ctx;
+  s_queryPending = false;
+  if (reply.result != AT_OK) return;
+  const char *line = strstr(reply.text, "+CEREG:");
+  int stat = line ? parseRegStat(line, false) : -1;
+  if (stat >= 0) setRegStat(stat);
+}
+
+static void onCsq(const AtReply &reply, void *ctx) {
+  (void)ctx;
+  s_queryPending = false;
+  if (reply.result != AT_OK) return;
+  const char *line = strstr(reply.text, "+CSQ:");
+  if (!line) return;
+  int csq = atoi(line + 5);
+  s_status.csq = (uint8_t)csq;
+  s_status.lteRssi = (csq >= 0 && csq <= 31) ? (int16_t)(-113 + 2 * csq) : 0;
+  s_status.rssiMs = stampNow();
+}
+
+// +COPS: <mode>[,<format>,"<oper>"[,<AcT>]]
+static void onCops(const AtReply &reply, void *ctx) {
+  (void)ctx;
+  s_queryPending = false;
+  if (reply.result != AT_OK) return;
+  const char *line = strstr(reply.text, "+COPS:");
+  if (!line) return;
+  const char *q1 = strchr(line, '"');
+  const char *q2 = q1 ? strchr(q1 + 1, '"') : nullptr;
+  size_t n = (q1 && q2) ? (size_t)(q2 - q1 - 1) : 0;
+  if (n >= sizeof(s_status.op)) n = sizeof(s_status.op) - 1;
+  if (n) memcpy(s_status.op, q1 + 1, n);
+  s_status.op[n] = 0;
+  s_status.opMs = stampNow();
+}
+
+// Value q is stale and its last attempt is NETSTAT_RETRY_MS old
+static bool wanted(int q, uint32_t stampMs, uint32_t periodMs) {
+  return due(stampMs, periodMs) && due(s_triedMs[q], NETSTAT_RETRY_MS);
+}
+
+static bool query(int q, const char *cmd, AtDoneFn done) {
+  s_triedMs[q] = stampNow();
+  if (!at_submit(cmd, 2000, done, nullptr)) return false;
+  s_queryPending = true;
+  s_queries++;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void netStatus_init() {
+  memset(&s_status, 0, sizeof(s_status));
+  s_status.regStat = -1;
+  s_status.csRegStat = -1;
+  s_status.csq = 99;
+  at_subscribe("+CREG:", onCregUrc, nullptr);
+  at_subscribe("+CEREG:", onCeregUrc, nullptr);
+}
+
+void netStatus_loop() {
+  if (due(s_status.wifiMs, NETSTAT_WIFI_MS)) {
+    s_status.wifiConnected = WiFi.status() == WL_CONNECTED;
+    s_status.wifiRssi = s_status.wifiConnected ? (int16_t)WiFi.RSSI() : 0;
+    s_status.wifiMs = stampNow();
+  }
+
+  if (!modem_isReady() || !modem_isOn() || !at_isStarted()) return;
+
+  // Fresh power-up: what we knew before is stale
+  if (s_powerEpoch != modem_powerUps()) {
+    s_powerEpoch = modem_powerUps();
+    s_status.regMs = s_status.rssiMs = s_status.opMs = 0;
+    memset(s_triedMs, 0, sizeof(s_triedMs));
+  }
+
+  if (s_queryPending || at_busy() || at_queued()) return;   // never compete with real work
+  if (wanted(Q_REG, s_status.regMs, NETSTAT_REG_MS)) query(Q_REG, "+CEREG?", onCereg);
+  else if (wanted(Q_RSSI, s_status.rssiMs, NETSTAT_RSSI_MS)) query(Q_RSSI, "+CSQ", onCsq);
+  else if (wanted(Q_OP, s_status.opMs, NETSTAT_OP_MS)) query(Q_OP, "+COPS?", onCops);
+}
+
+const NetStatus &netStatus_get() { return s_status; }
+
+bool netStatus_lteRegistered() {
+  return s_status.regStat == 1 || s_status.regStat == 5;
+}
+
+uint32_t netStatus_age(uint32_t stampMs) {
+  return stampMs ? (uint32_t)(millis() - stampMs) : NETSTAT_AGE_NEVER;
+}
+
+void netStatus_refresh() {
+  s_status.wifiMs = s_status.regMs = s_status.rssiMs = s_status.opMs = 0;
+  memset(s_triedMs, 0, sizeof(s_triedMs));
+}
+
+void netStatus_printStats() {
+  const NetStatus &s = s_status;
+  Serial.printf("[NetStatus] wifi %s %ddBm (%lus), lte reg=%d (%lus) cs=%d %ddBm (%lus) '%s' (%lus)\n",
+                s.wifiConnected ? "up" : "down", s.wifiRssi, (unsigned long)(netStatus_age(s.wifiMs) / 1000UL),
+                s.regStat, (unsigned long)(netStatus_age(s.regMs) / 1000UL), s.csRegStat,
+                s.lteRssi, (unsigned long)(netStatus_age(s.rssiMs) / 1000UL),
+                s.op, (unsigned long)(netStatus_age(s.opMs) / 1000UL));
+  Serial.printf("[NetStatus] %lu AT queries, %lu URC updates\n",
+                (unsigned long)s_queries, (unsigned long)s_urcUpdates);
+}
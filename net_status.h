@@ -0,0 +1,54 @@
+#ifndef NET_STATUS_H
+#define NET_STATUS_H
+
+#include <Arduino.h>
+
+// Cached connectivity status for the UI and the HTTP API.
+// netStatus_loop() refreshes each value on its own slow schedule (NETSTAT_*_MS) through
+// queued AT commands, never waking a powered-down modem; registration changes also
+// arrive from +CEREG (EPS) and +CREG (CS) URCs, kept apart because a data-only SIM is
+// EPS-registered while CS says "not registered". Readers get the cached values in
+// constant time, each with the millis() stamp of its last refresh (0 = never).
+
+#define NETSTAT_AGE_NEVER 0xFFFFFFFFUL
+
+struct NetStatus {
+  // WiFi (driver state, no UART traffic)
+  bool     wifiConnected;
+  int16_t  wifiRssi;       // dBm, 0 when not connected
+  uint32_t wifiMs;
+
+  // LTE
+  int8_t   regStat;        // EPS (+CEREG) <stat>: 1 home, 5 roaming, 2 searching, -1 unknown
+  uint32_t regMs;
+  int8_t   csRegStat;      // CS domain (+CREG) <stat>, informational only
+  uint32_t csRegMs;
+  uint8_t  csq;            // raw +CSQ 0..31, 99 = unknown
+  int16_t  lteRssi;        // dBm from csq, 0 when unknown
+  uint32_t rssiMs;
+  char     op[24];         // operator name from +COPS?, "" when unknown
+  uint32_t opMs;
+};
+
+// Subscribe to the registration URCs (call after modemManager_init)
+void netStatus_init();
+
+// Refresh whatever is due, at most one AT query in flight. Call from loop().
+void netStatus_loop();
+
+const NetStatus &netStatus_get();
+
+// EPS registered (home or roaming), which is what the LTE data link needs. While the
+// modem is powered down by the power policy this is the last known state.
+bool netStatus_lteRegistered();
+
+// ms since a stamp from NetStatus, NETSTAT_AGE_NEVER if it was never refreshed
+uint32_t netStatus_age(uint32_t stampMs);
+
+// Make every value due on the next loop passes (e.g. when a status screen opens)
+void netStatus_refresh();
+
+// Current values with ages, query / URC counters since boot
+void netStatus_printStats();
+
+#endif // NET_STATUS_H
@@ -0,0 +1,188 @@
+// net_transport.cpp
+// - Chooses between WiFi and the A7670 packet data link according to connectivityMode;
+//   link state itself (WiFi join, LTE registration and bearer) lives in connectivity_manager.
+// - Owns the network clients: WiFiClientSecure / TinyGsmClientSecure per HTTP pool slot,
+//   and one plain client per transport for MQTT. Modem clients are bound to fixed mux
+//   channels (0 = plain, 1.. = TLS slots) on first use, and handed out behind a guard
+//   that waits for the AT engine to go idle before each socket call.
+// - Keeps per-transport connect latency and byte counters (netTransport_printStats()).
+#include "net_transport.h"
+#include "config.h"
+#include "modem_manager.h"
+#include "connectivity_manager.h"
+#include "at_engine.h"
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <Preferences.h>
+
+// Declared extern in config.h
+int connectivityMode = CONNECTIVITY_WIFI;
+
+static const char *PREF_NS = "beehive";
+static const char *PREF_KEY_MODE = "conn_mode";
+
+static const uint8_t LTE_MUX_PLAIN = 0;
+static const uint8_t LTE_MUX_TLS0  = 1;
+
+static WiFiClientSecure    s_wifiTls[HTTP_POOL_SLOTS];
+static WiFiClient          s_wifiPlain;
+static TinyGsmClientSecure s_lteTls[HTTP_POOL_SLOTS];
+static TinyGsmClient       s_ltePlain;
+static bool s_lteTlsBound[HTTP_POOL_SLOTS];
+static bool s_ltePlainBound = false;
+static uint32_t s_fenceTimeouts = 0;   // socket calls refused: AT command still running
+
+// TinyGSM clients share the UART with the AT engine; every call first lets the
+// command in flight finish so the two never interleave on the wire. With the modem
+// powered down (modem power policy), or a command still running after AT_FENCE_MS,
+// the call fails as if the socket were closed rather than writing into that command.
+class AtGuardClient : public Client {
+ public:
+  void bind(Client *inner) { _c = inner; }
+
+  int connect(IPAddress ip, uint16_t port) override { return fence() ? _c->connect(ip, port) : 0; }
+  int connect(const char *host, uint16_t port) override { return fence() ? _c->connect(host, port) : 0; }
+  size_t write(uint8_t b) override { return fence() ? _c->write(b) : 0; }
+  size_t write(const uint8_t *buf, size_t len) override { return fence() ? _c->write(buf, len) : 0; }
+  int available() override { return fence() ? _c->available() : 0; }
+  int read() override { return fence() ? _c->read() : -1; }
+  int read(uint8_t *buf, size_t len) override { return fence() ? _c->read(buf, len) : -1; }
+  int peek() override { return fence() ? _c->peek() : -1; }
+  void flush() override { if (fence()) _c->flush(); }
+  void stop() override { if (fence()) _c->stop(); }
+  uint8_t connected() override { return fence() ? _c->connected() : 0; }
+  operator bool() override { return _c && (bool)*_c; }
+  using Print::write;
+
+ private:
+  Client *_c = nullptr;
+  static bool fence() {
+    if (!modem_isOn()) return false;
+    if (at_busy() && !at_waitIdle(AT_FENCE_MS)) {
+      s_fenceTimeouts++;
+      return false;
+    }
+    return true;
+  }
+};
+
+static AtGuardClient s_lteTlsGuard[HTTP_POOL_SLOTS];
+static AtGuardClient s_ltePlainGuard;
+
+struct TransportStats {
+  uint32_t connects;
+  uint32_t failures;
+  uint32_t connectMsTotal;
+  uint32_t connectMsMax;
+  uint32_t bytesTx;
+  uint32_t bytesRx;
+};
+static TransportStats s_stats[NET_TRANSPORT_COUNT];
+
+static const char *NAMES[NET_TRANSPORT_COUNT] = { "none", "WiFi", "LTE" };
+
+void netTransport_init() {
+  Preferences p;
+  p.begin(PREF_NS, true);
+  connectivityMode = p.getInt(PREF_KEY_MODE, CONNECTIVITY_WIFI);
+  p.end();
+  if (connectivityMode < CONNECTIVITY_LTE || connectivityMode > CONNECTIVITY_OFFLINE)
+    connectivityMode = CONNECTIVITY_WIFI;
+  Serial.printf("[Net] connectivity mode %d\n", connectivityMode);
+}
+
+void netTransport_setMode(int mode) {
+  if (mode < CONNECTIVITY_LTE || mode > CONNECTIVITY_OFFLINE) return;
+  connectivityMode = mode;
+  Preferences p;
+  p.begin(PREF_NS, false);
+  p.putInt(PREF_KEY_MODE, mode);
+  p.end();
+}
+
+static bool wifiUp() { return WiFi.status() == WL_CONNECTED; }
+
+NetTransport netTransport_select() {
+  switch (connectivityMode) {
+    case CONNECTIVITY_OFFLINE:
+      return NET_NONE;
+    case CONNECTIVITY_LTE:
+      if (connectivity_lteDataUp(true)) return NET_LTE;
+      return wifiUp() ? NET_WIFI : NET_NONE;
+    default:
+      if (wifiUp()) return NET_WIFI;
+      return connectivity_lteDataUp(true) ? NET_LTE : NET_NONE;
+  }
+}
+
+bool netTransport_isUp(NetTransport t) {
+  if (connectivityMode == CONNECTIVITY_OFFLINE) return false;
+  if (t == NET_WIFI) return wifiUp();
+  if (t == NET_LTE) return connectivity_lteDataUp(false);
+  return false;
+}
+
+bool netTransport_available() {
+  if (connectivityMode == CONNECTIVITY_OFFLINE) return false;
+  return wifiUp() || connectivity_lteRegistered();
+}
+
+Client *netTransport_tlsClient(NetTransport t, uint8_t slot) {
+  if (slot >= HTTP_POOL_SLOTS) return nullptr;
+  if (t == NET_WIFI) {
+    s_wifiTls[slot].setInsecure();   // no CA pinning, as before
+    return &s_wifiTls[slot];
+  }
+  if (t == NET_LTE && modem_isReady()) {
+    if (!s_lteTlsBound[slot]) {
+      s_lteTls[slot].init(&modem_get(), LTE_MUX_TLS0 + slot);
+      s_lteTlsGuard[slot].bind(&s_lteTls[slot]);
+      s_lteTlsBound[slot] = true;
+    }
+    return &s_lteTlsGuard[slot];
+  }
+  return nullptr;
+}
+
+Client *netTransport_plainClient(NetTransport t) {
+  if (t == NET_WIFI) return &s_wifiPlain;
+  if (t == NET_LTE && modem_isReady()) {
+    if (!s_ltePlainBound) {
+      s_ltePlain.init(&modem_get(), LTE_MUX_PLAIN);
+      s_ltePlainGuard.bind(&s_ltePlain);
+      s_ltePlainBound = true;
+    }
+    return &s_ltePlainGuard;
+  }
+  return nullptr;
+}
+
+const char *netTransport_name(NetTransport t) {
+  return t < NET_TRANSPORT_COUNT ? NAMES[t] : "?";
+}
+
+void netTransport_recordConnect(NetTransport t, uint32_t ms, bool ok) {
+  if (t >= NET_TRANSPORT_COUNT) return;
+  TransportStats &s = s_stats[t];
+  if (!ok) { s.failures++; return; }
+  s.connects++;
+  s.connectMsTotal += ms;
+  if (ms > s.connectMsMax) s.connectMsMax = ms;
+}
+
+void netTransport_addBytes(NetTransport t, uint32_t tx, uint32_t rx) {
+  if (t >= NET_TRANSPORT_COUNT) return;
+  s_stats[t].bytesTx += tx;
+  s_stats[t].bytesRx += rx;
+}
+
+void netTransport_printStats() {
+  for (int t = NET_WIFI; t < NET_TRANSPORT_COUNT; ++t) {
+    const TransportStats &s = s_stats[t];
+    Serial.printf("[Net] %-4s connects=%lu failed=%lu connect avg=%lums max=%lums tx=%lu rx=%lu\n",
+                  NAMES[t], (unsigned long)s.connects, (unsigned long)s.failures,
+                  (unsigned long)(s.connects ? s.connectMsTotal / s.connects : 0),
+                  (unsigned long)s.connectMsMax, (unsigned long)s.bytesTx, (unsigned long)s.bytesRx);
+  }
+  Serial.printf("[Net] LTE socket calls refused by the AT fence: %lu\n", (unsigned long)s_fenceTimeouts);
+}
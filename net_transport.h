@@ -0,0 +1,51 @@
+#ifndef NET_TRANSPORT_H
+#define NET_TRANSPORT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Network transport selection for the HTTP engine and the telemetry uplink.
+// connectivityMode (config.h, persisted in NVS) sets the preference:
+//   CONNECTIVITY_WIFI    WiFi, falling back to the A7670 data link when WiFi is down
+//   CONNECTIVITY_LTE     A7670 data link, falling back to WiFi when not registered
+//   CONNECTIVITY_OFFLINE no network traffic at all
+// Clients are owned here: TLS clients per HTTP pool slot, one plain client per transport.
+
+enum NetTransport {
+  NET_NONE = 0,
+  NET_WIFI,
+  NET_LTE,
+  NET_TRANSPORT_COUNT
+};
+
+// Load connectivityMode from NVS (call from setup, before any network use)
+void netTransport_init();
+
+// Change and persist connectivityMode (CONNECTIVITY_*)
+void netTransport_setMode(int mode);
+
+// Pick the transport for a new connection. May bring up the GPRS/LTE bearer, which
+// blocks for a few seconds the first time. Returns NET_NONE if nothing is usable.
+NetTransport netTransport_select();
+
+// True if the transport is still up (cheap check for pooled connections)
+bool netTransport_isUp(NetTransport t);
+
+// True if netTransport_select() can be expected to find a transport (WiFi connected or
+// modem registered, mode not OFFLINE). Does not attach the LTE bearer.
+bool netTransport_available();
+
+// TLS client for HTTP pool slot (0..HTTP_POOL_SLOTS-1); certificate checks disabled
+Client *netTransport_tlsClient(NetTransport t, uint8_t slot);
+
+// Plain TCP client (MQTT)
+Client *netTransport_plainClient(NetTransport t);
+
+const char *netTransport_name(NetTransport t);
+
+// Counters: connection setup latency and payload bytes per transport
+void netTransport_recordConnect(NetTransport t, uint32_t ms, bool ok);
+void netTransport_addBytes(NetTransport t, uint32_t tx, uint32_t rx);
+void netTransport_printStats();
+
+#endif // NET_TRANSPORT_H
@@ -0,0 +1,537 @@
+// ota_manager.cpp
+// - Writes firmware images into the inactive OTA partition with esp_partition_* calls,
+//   erasing one sector ahead of the write position, and hashes them with SHA-256.
+// - Session (size, expected hash, partition, committed offset) lives in NVS "ota";
+//   the committed offset only advances in OTA_COMMIT_BYTES steps, so everything below
+//   it is known to be on flash. Resuming re-reads that prefix to rebuild the hash.
+// - After switching partitions the new image is on trial: every boot increments a
+//   counter, the health check in ota_loop() clears it. Too many boots or a failed check
+//   boots the previous partition (through the IDF rollback API when the bootloader has
+//   rollback enabled, otherwise by selecting it directly).
+// - Pull downloads go through http_async, so they work over WiFi and LTE alike.
+// - Network callers authenticate with a token kept in NVS (OTA_TOKEN or generated on
+//   first boot); pulls only go to OTA_UPDATE_HOST.
+#include "ota_manager.h"
+#include "http_async.h"
+#include "net_transport.h"
+#include "measurement.h"
+#include "config.h"
+#include <Preferences.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+
+static const char *PREF_NS = "ota";
+static const uint32_t SECTOR = 4096;
+
+// Session
+static OtaState s_state = OTA_IDLE;
+static const esp_partition_t *s_part = nullptr;
+static uint32_t s_size = 0;
+static uint32_t s_written = 0;
+static uint32_t s_committed = 0;
+static uint32_t s_erasedTo = 0;
+static char s_sha[65] = "";
+static char s_err[48] = "";
+static mbedtls_sha256_context s_hash;
+static bool s_hashActive = false;
+
+// Throughput of the running transfer
+static unsigned long s_startMs = 0;
+static uint32_t s_startOffset = 0;
+static uint32_t s_bps = 0;
+
+static unsigned long s_rebootAt = 0;
+
+// Shared secret for the key server routes, empty = OTA over the network disabled
+static char s_token[33] = "";
+
+// Trial of a freshly installed image
+static bool s_trial = false;
+static bool s_idfPending = false;
+
+// Pull download
+static struct {
+  bool active;
+  bool running;
+  bool firstChunk;
+  uint8_t attempts;
+  unsigned long nextTry;
+  uint32_t size;
+  char sha[65];
+  char host[64];
+  char path[192];
+} s_pull;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static void setError(const char *msg) {
+  strncpy(s_err, msg, sizeof(s_err) - 1);
+  s_err[sizeof(s_err) - 1] = 0;
+  Serial.print("[OTA] ");
+  Serial.println(msg);
+}
+
+static const esp_partition_t *findPartition(uint32_t address) {
+  const esp_partition_t *found = nullptr;
+  esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, nullptr);
+  while (it) {
+    const esp_partition_t *p = esp_partition_get(it);
+    if (p->address == address) { found = p; break; }
+    it = esp_partition_next(it);
+  }
+  if (it) esp_partition_iterator_release(it);
+  return found;
+}
+
+static void saveSession() {
+  Preferences p;
+  p.begin(PREF_NS, false);
+  p.putUInt("s_size", s_size);
+  p.putString("s_sha", s_sha);
+  p.putUInt("s_part", s_part ? s_part->address : 0);
+  p.putUInt("s_commit", s_committed);
+  p.end();
+}
+
+static void saveCommit() {
+  Preferences p;
+  p.begin(PREF_NS, false);
+  p.putUInt("s_commit", s_committed);
+  p.end();
+}
+
+static void clearSession() {
+  Preferences p;
+  p.begin(PREF_NS, false);
+  p.remove("s_size");
+  p.remove("s_sha");
+  p.remove("s_part");
+  p.remove("s_commit");
+  p.end();
+  s_size = s_committed = s_written = 0;
+  s_sha[0] = 0;
+}
+
+static void hashStop() {
+  if (s_hashActive) mbedtls_sha256_free(&s_hash);
+  s_hashActive = false;
+}
+
+// Restart the hash and feed it the first len bytes already on flash
+static bool rehash(uint32_t len) {
+  hashStop();
+  mbedtls_sha256_init(&s_hash);
+  mbedtls_sha256_starts(&s_hash, 0);
+  s_hashActive = true;
+
+  uint8_t buf[512];
+  for (uint32_t off = 0; off < len; off += sizeof(buf)) {
+    uint32_t n = len - off < sizeof(buf) ? len - off : sizeof(buf);
+    if (esp_partition_read(s_part, off, buf, n) != ESP_OK) return false;
+    mbedtls_sha256_update(&s_hash, buf, n);
+  }
+  return true;
+}
+
+static void updateRate() {
+  unsigned long ms = millis() - s_startMs;
+  if (ms > 0) s_bps = (uint32_t)((uint64_t)(s_written - s_startOffset) * 1000ULL / ms);
+}
+
+static void fail(const char *msg) {
+  setError(msg);
+  hashStop();
+  updateRate();
+  s_state = OTA_FAILED;
+}
+
+// OTA_TOKEN overrides the stored token; without either a random one is generated once
+static void loadToken() {
+  Preferences p;
+  p.begin(PREF_NS, false);
+  String stored = p.getString("token", "");
+  if (OTA_TOKEN[0]) {
+    if (stored != OTA_TOKEN) p.putString("token", OTA_TOKEN);
+    stored = OTA_TOKEN;
+  } else if (stored.length() == 0) {
+    char gen[33];
+    for (int i = 0; i < 4; ++i) snprintf(gen + i * 8, 9, "%08lx", (unsigned long)esp_random());
+    p.putString("token", gen);
+    stored = gen;
+    Serial.printf("[OTA] generated update token: %s\n", gen);
+  }
+  p.end();
+  strncpy(s_token, stored.c_str(), sizeof(s_token) - 1);
+  s_token[sizeof(s_token) - 1] = 0;
+}
+
+static bool isHex64(const char *s) {
+  if (!s || strlen(s) != 64) return false;
+  for (int i = 0; i < 64; ++i) if (!isxdigit((unsigned char)s[i])) return false;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Trial / rollback
+// ---------------------------------------------------------------------------
+static void rollback(const char *why) {
+  Serial.printf("[OTA] rolling back: %s\n", why);
+  Preferences p;
+  p.begin(PREF_NS, false);
+  uint32_t prevAddr = p.getUInt("t_prev", 0);
+  p.remove("t_pending");
+  p.remove("t_trials");
+  p.end();
+
+  if (s_idfPending) esp_ota_mark_app_invalid_rollback_and_reboot();   // does not return on success
+
+  const esp_partition_t *prev = findPartition(prevAddr);
+  if (prev && esp_ota_set_boot_partition(prev) == ESP_OK) {
+    Serial.printf("[OTA] booting %s again\n", prev->label);
+  } else {
+    Serial.println("[OTA] previous partition not bootable, keeping current image");
+    s_trial = false;
+    return;
+  }
+  delay(100);
+  ESP.restart();
+}
+
+static void markHealthy() {
+  Preferences p;
+  p.begin(PREF_NS, false);
+  p.remove("t_pending");
+  p.remove("t_trials");
+  p.end();
+  if (s_idfPending) esp_ota_mark_app_valid_cancel_rollback();
+  s_trial = false;
+  s_idfPending = false;
+  Serial.println("[OTA] new image passed the health check");
+}
+
+// The image can sample sensors, has heap to spare and can reach the network
+static bool healthy() {
+  Measurement m;
+  return measurement_getLatest(m) &&
+         ESP.getFreeHeap() >= OTA_HEALTH_MIN_HEAP &&
+         netTransport_available();
+}
+
+// ---------------------------------------------------------------------------
+// Pull download
+// ---------------------------------------------------------------------------
+static bool pullSink(const uint8_t *data, size_t len, void *) {
+  if (s_pull.firstChunk) {
+    s_pull.firstChunk = false;
+    if (s_written > 0 && httpAsync_statusCode() == 200) {
+      // server ignored the Range header and sends the whole image
+      Serial.println("[OTA] server has no range support, restarting at 0");
+      hashStop();
+      s_state = OTA_PAUSED;
+      if (!ota_begin(s_pull.size, s_pull.sha, 0)) return false;
+    }
+  }
+  return ota_write(data, len);
+}
+
+static bool pullParse(void *) {
+  return ota_end();
+}
+
+static void pullLoop() {
+  if (!s_pull.active) return;
+  unsigned long now = millis();
+
+  if (s_pull.running) {
+    HttpPhase phase = httpAsync_poll();
+    if (httpAsync_busy()) return;
+    s_pull.running = false;
+    if (phase == HTTP_DONE && s_state == OTA_READY) {
+      s_pull.active = false;
+      return;
+    }
+    if (s_state == OTA_RECEIVING) ota_pause(httpAsync_lastError());
+    if (s_state == OTA_FAILED || ++s_pull.attempts >= OTA_PULL_MAX_RETRIES) {
+      s_pull.active = false;
+      if (s_state != OTA_FAILED) fail("pull gave up");
+      return;
+    }
+    s_pull.nextTry = now + OTA_RETRY_MS * s_pull.attempts;
+    Serial.printf("[OTA] pull attempt %u failed, retry from %lu in %lus\n", s_pull.attempts,
+                  (unsigned long)s_committed, (OTA_RETRY_MS * s_pull.attempts) / 1000UL);
+    return;
+  }
+
+  if ((long)(now - s_pull.nextTry) < 0 || httpAsync_busy() || !netTransport_available()) return;
+
+  uint32_t offset = (s_state == OTA_PAUSED && s_size == s_pull.size && strcmp(s_sha, s_pull.sha) == 0)
+                    ? s_committed : 0;
+  if (!ota_begin(s_pull.size, s_pull.sha, offset) && (offset == 0 || !ota_begin(s_pull.size, s_pull.sha, 0))) {
+    s_pull.active = false;
+    return;
+  }
+  httpAsync_setRangeStart(s_written);
+  if (!httpAsync_start(s_pull.host, s_pull.path, pullSink, pullParse, nullptr)) {
+    ota_pause(httpAsync_lastError());
+    s_pull.nextTry = now + OTA_RETRY_MS;
+    return;
+  }
+  s_pull.running = true;
+  s_pull.firstChunk = true;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void ota_init() {
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  esp_ota_img_states_t st;
+  s_idfPending = running && esp_ota_get_state_partition(running, &st) == ESP_OK &&
+                 st == ESP_OTA_IMG_PENDING_VERIFY;
+
+  Preferences p;
+  p.begin(PREF_NS, false);
+  bool pending = p.getBool("t_pending", false);
+  uint32_t prevAddr = p.getUInt("t_prev", 0);
+  uint8_t trials = p.getUChar("t_trials", 0);
+  if (pending && running && running->address == prevAddr) {
+    // the bootloader already went back to the old image
+    p.remove("t_pending");
+    p.remove("t_trials");
+    pending = false;
+    Serial.println("[OTA] previous image is running, update was rolled back");
+  } else if (pending) {
+    p.putUChar("t_trials", ++trials);
+  }
+
+  s_size = p.getUInt("s_size", 0);
+  s_committed = p.getUInt("s_commit", 0);
+  uint32_t partAddr = p.getUInt("s_part", 0);
+  String sha = p.getString("s_sha", "");
+  p.end();
+
+  loadToken();
+
+  s_trial = pending || s_idfPending;
+  if (s_trial) {
+    Serial.printf("[OTA] running %s on trial, boot %u of %u\n", running ? running->label : "?",
+                  trials, OTA_MAX_TRIALS);
+    if (trials > OTA_MAX_TRIALS) rollback("too many reboots");
+  }
+
+  // resumable session: only valid if it still targets the inactive partition
+  const esp_partition_t *next = esp_ota_get_next_update_partition(nullptr);
+  strncpy(s_sha, sha.c_str(), sizeof(s_sha) - 1);
+  s_sha[sizeof(s_sha) - 1] = 0;
+  if (s_size && next && next->address == partAddr && s_committed <= s_size) {
+    s_part = next;
+    s_written = s_committed;
+    s_state = OTA_PAUSED;
+    Serial.printf("[OTA] resumable session: %lu of %lu bytes\n",
+                  (unsigned long)s_committed, (unsigned long)s_size);
+  } else if (s_size) {
+    clearSession();
+  }
+}
+
+void ota_loop() {
+  if (s_rebootAt && (long)(millis() - s_rebootAt) >= 0) {
+    Serial.println("[OTA] rebooting into the new image");
+    delay(100);
+    ESP.restart();
+  }
+
+  if (s_trial) {
+    unsigned long up = millis();
+    if (up >= OTA_HEALTH_MIN_MS && healthy()) markHealthy();
+    else if (up >= OTA_HEALTH_TIMEOUT_MS) rollback("health check failed");
+  }
+
+  pullLoop();
+}
+
+bool ota_begin(uint32_t size, const char *sha256Hex, uint32_t offset) {
+  if (s_state == OTA_RECEIVING) { setError("transfer already running"); return false; }
+  if (s_state == OTA_READY) { setError("update pending reboot"); return false; }
+  if (!isHex64(sha256Hex)) { setError("sha256 must be 64 hex digits"); return false; }
+
+  const esp_partition_t *part = esp_ota_get_next_update_partition(nullptr);
+  if (!part) { setError("no OTA partition"); return false; }
+  if (size == 0 || size > part->size) { setError("bad image size"); return false; }
+
+  char sha[65];
+  for (int i = 0; i < 65; ++i) sha[i] = tolower((unsigned char)sha256Hex[i]);
+
+  if (offset > 0) {
+    if (s_state != OTA_PAUSED || s_part != part || s_size != size || strcmp(s_sha, sha) != 0 ||
+        offset != s_committed) {
+      char msg[48];
+      snprintf(msg, sizeof(msg), "cannot resume at %lu (committed %lu)",
+               (unsigned long)offset, (unsigned long)s_committed);
+      setError(msg);
+      return false;
+    }
+  } else {
+    s_part = part;
+    s_size = size;
+    s_committed = 0;
+    strcpy(s_sha, sha);
+    saveSession();
+  }
+
+  // offset is a multiple of OTA_COMMIT_BYTES, so sector aligned
+  s_erasedTo = offset;
+  if (!rehash(offset)) { fail("flash read failed"); return false; }
+  s_written = offset;
+  s_startOffset = offset;
+  s_startMs = millis();
+  s_bps = 0;
+  s_err[0] = 0;
+  s_state = OTA_RECEIVING;
+  Serial.printf("[OTA] %s %s at %lu of %lu bytes\n", offset ? "resuming" : "writing",
+                s_part->label, (unsigned long)offset, (unsigned long)size);
+  return true;
+}
+
+bool ota_write(const uint8_t *data, size_t len) {
+  if (s_state != OTA_RECEIVING) return false;
+  if (s_written + len > s_size) { fail("image larger than announced"); return false; }
+
+  while (s_written + len > s_erasedTo) {
+    if (esp_partition_erase_range(s_part, s_erasedTo, SECTOR) != ESP_OK) { fail("flash erase failed"); return false; }
+    s_erasedTo += SECTOR;
+  }
+  if (esp_partition_write(s_part, s_written, data, len) != ESP_OK) { fail("flash write failed"); return false; }
+  mbedtls_sha256_update(&s_hash, data, len);
+  s_written += len;
+
+  if (s_written - s_committed >= OTA_COMMIT_BYTES) {
+    s_committed = s_written - (s_written % OTA_COMMIT_BYTES);
+    saveCommit();
+    updateRate();
+    Serial.printf("[OTA] %lu / %lu KB, %lu B/s\n", (unsigned long)(s_written / 1024),
+                  (unsigned long)(s_size / 1024), (unsigned long)s_bps);
+  }
+  return true;
+}
+
+bool ota_end() {
+  if (s_state != OTA_RECEIVING) return false;
+  if (s_written != s_size) { ota_pause("image incomplete"); return false; }
+
+  uint8_t digest[32];
+  mbedtls_sha256_finish(&s_hash, digest);
+  hashStop();
+  updateRate();
+
+  char hex[65];
+  for (int i = 0; i < 32; ++i) sprintf(hex + i * 2, "%02x", digest[i]);
+  if (strcmp(hex, s_sha) != 0) {
+    clearSession();
+    fail("sha256 mismatch");
+    return false;
+  }
+
+  esp_err_t err = esp_ota_set_boot_partition(s_part);
+  if (err != ESP_OK) {
+    clearSession();
+    fail("image rejected by bootloader check");
+    return false;
+  }
+
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  Preferences p;
+  p.begin(PREF_NS, false);
+  p.putBool("t_pending", true);
+  p.putUChar("t_trials", 0);
+  p.putUInt("t_prev", running ? running->address : 0);
+  p.end();
+  clearSession();
+
+  s_state = OTA_READY;
+  s_rebootAt = millis() + OTA_REBOOT_DELAY_MS;
+  Serial.printf("[OTA] image verified, %lu B/s, booting %s in %lus\n", (unsigned long)s_bps,
+                s_part->label, OTA_REBOOT_DELAY_MS / 1000UL);
+  return true;
+}
+
+void ota_pause(const char *why) {
+  if (s_state != OTA_RECEIVING) return;
+  hashStop();
+  updateRate();
+  s_written = s_committed;
+  s_state = OTA_PAUSED;
+  setError(why && why[0] ? why : "interrupted");
+  Serial.printf("[OTA] paused, resumable from %lu\n", (unsigned long)s_committed);
+}
+
+void ota_cancel() {
+  hashStop();
+  clearSession();
+  s_pull.active = false;
+  if (s_state != OTA_READY) s_state = OTA_IDLE;
+}
+
+bool ota_authorized(const char *token) {
+  size_t n = strlen(s_token);
+  if (n == 0 || !token || strlen(token) != n) return false;
+  uint8_t diff = 0;
+  for (size_t i = 0; i < n; ++i) diff |= (uint8_t)(token[i] ^ s_token[i]);
+  return diff == 0;
+}
+
+bool ota_pullStart(const char *host, const char *path, uint32_t size, const char *sha256Hex) {
+  if (!OTA_UPDATE_HOST[0]) { setError("pull disabled (no OTA_UPDATE_HOST)"); return false; }
+  if (strcasecmp(host, OTA_UPDATE_HOST) != 0) { setError("host is not the update server"); return false; }
+  if (s_state == OTA_RECEIVING || s_state == OTA_READY) { setError("transfer already running"); return false; }
+  if (!isHex64(sha256Hex)) { setError("sha256 must be 64 hex digits"); return false; }
+  if (strlen(host) >= sizeof(s_pull.host) || strlen(path) >= sizeof(s_pull.path)) { setError("URL too long"); return false; }
+
+  strcpy(s_pull.host, host);
+  strcpy(s_pull.path, path);
+  for (int i = 0; i < 65; ++i) s_pull.sha[i] = tolower((unsigned char)sha256Hex[i]);
+  s_pull.size = size;
+  s_pull.attempts = 0;
+  s_pull.running = false;
+  s_pull.nextTry = millis();
+  s_pull.active = true;
+  Serial.printf("[OTA] pull scheduled: https://%s%s\n", host, path);
+  return true;
+}
+
+void ota_getStatus(OtaStatus &out) {
+  if (s_state == OTA_RECEIVING) updateRate();
+  out.state = s_state;
+  out.size = s_size;
+  out.written = s_written;
+  out.committed = s_committed;
+  out.bytesPerSec = s_bps;
+  out.pull = s_pull.active;
+  out.trial = s_trial;
+  strcpy(out.sha256, s_sha);
+  strcpy(out.error, s_err);
+}
+
+const char *ota_stateName(OtaState s) {
+  switch (s) {
+    case OTA_IDLE:      return "idle";
+    case OTA_RECEIVING: return "receiving";
+    case OTA_PAUSED:    return "paused";
+    case OTA_READY:     return "ready";
+    case OTA_FAILED:    return "failed";
+  }
+  return "?";
+}
+
+void ota_printStats() {
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  Serial.printf("[OTA] running=%s trial=%d state=%s", running ? running->label : "?",
+                s_trial, ota_stateName(s_state));
+  if (s_size) Serial.printf(" %lu/%lu committed=%lu", (unsigned long)s_written,
+                            (unsigned long)s_size, (unsigned long)s_committed);
+  Serial.printf(" rate=%lu B/s pull=%d", (unsigned long)s_bps, s_pull.active);
+  if (s_err[0]) Serial.printf(" err=%s", s_err);
+  Serial.println();
+}
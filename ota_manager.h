@@ -0,0 +1,69 @@
+#ifndef OTA_MANAGER_H
+#define OTA_MANAGER_H
+
+#include <Arduino.h>
+
+// Firmware update into the inactive OTA partition.
+// The image is written to flash as it arrives (no RAM copy) and hashed on the fly.
+// Progress is committed to NVS every OTA_COMMIT_BYTES, so an interrupted transfer
+// resumes from the last committed offset (the hash is rebuilt from the flash contents).
+// After the switch the new image runs on trial: it must pass the health check within
+// OTA_HEALTH_TIMEOUT_MS and may reboot at most OTA_MAX_TRIALS times, otherwise the
+// previous partition is booted again.
+//
+// Two sources feed the same writer:
+//   - upload:  POST /ota?size=N&sha256=HEX[&offset=K] to the key server
+//   - pull:    ota_pullStart() downloads over the current transport (WiFi or LTE),
+//              retrying with a Range request from the committed offset
+// Callers on the network side must check ota_authorized() first; pulls are further
+// limited to OTA_UPDATE_HOST.
+
+enum OtaState {
+  OTA_IDLE = 0,
+  OTA_RECEIVING,      // image bytes are being written
+  OTA_PAUSED,         // transfer interrupted, resumable from the committed offset
+  OTA_READY,          // verified and selected for boot, rebooting shortly
+  OTA_FAILED
+};
+
+struct OtaStatus {
+  OtaState state;
+  uint32_t size;          // image size of the current session, 0 if none
+  uint32_t written;       // bytes written in the current session
+  uint32_t committed;     // resume offset persisted in NVS
+  uint32_t bytesPerSec;   // throughput of the running (or last) transfer
+  bool     pull;          // a pull download is active or scheduled
+  bool     trial;         // running image has not passed the health check yet
+  char     sha256[65];    // expected hash (hex) of the current session
+  char     error[48];
+};
+
+// Boot-time: trial/rollback bookkeeping and loading a resumable session. Call early in setup.
+void ota_init();
+
+// Health check of a trial image, pull retries, reboot after a successful update.
+void ota_loop();
+
+// Start (offset 0) or resume (offset == committed, same size and hash) a session.
+bool ota_begin(uint32_t size, const char *sha256Hex, uint32_t offset);
+// Append image bytes at the current offset
+bool ota_write(const uint8_t *data, size_t len);
+// All bytes written: verify the hash and select the new partition for the next boot.
+bool ota_end();
+// Transfer interrupted: keep the committed offset for a later resume.
+void ota_pause(const char *why);
+// Drop the session (next begin starts at 0)
+void ota_cancel();
+
+// Constant-time check of a client token against the one stored in NVS
+bool ota_authorized(const char *token);
+
+// Download https://host/path over the current transport; resumes automatically.
+// host must be OTA_UPDATE_HOST.
+bool ota_pullStart(const char *host, const char *path, uint32_t size, const char *sha256Hex);
+
+void ota_getStatus(OtaStatus &out);
+const char *ota_stateName(OtaState s);
+void ota_printStats();
+
+#endif // OTA_MANAGER_H
@@ -0,0 +1,135 @@
+// power_manager.cpp
+// - Enables ESP-IDF dynamic frequency scaling (80..240 MHz) and automatic light sleep.
+// - The four buttons are configured as light-sleep GPIO wake sources (active LOW).
+// - The modem UART is a light-sleep wake source, so unsolicited +CMTI/+CEREG lines
+//   are not lost while idle; only the bytes that trigger the wakeup are dropped.
+// - WiFi/HTTP and modem UART code take a lock while busy; with no lock held the
+//   idle task may drop the clock and light-sleep between menu/loop polls.
+// - If the core was built without CONFIG_PM_ENABLE we fall back to setCpuFrequencyMhz().
+// - Time spent with and without locks is accumulated to estimate the current saved.
+#include "power_manager.h"
+#include "config.h"
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <driver/uart.h>
+
+static uint8_t s_lockCount[PWR_LOCK_COUNT] = {0};
+static uint8_t s_heldTotal = 0;
+static bool    s_pmActive = false;
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_cpuLock[PWR_LOCK_COUNT];
+static esp_pm_lock_handle_t s_sleepLock[PWR_LOCK_COUNT];
+#endif
+
+// Time accounting (ms)
+static unsigned long s_bootMs = 0;
+static unsigned long s_busySinceMs = 0;
+static unsigned long s_busyTotalMs = 0;
+
+static void enableButtonWake() {
+  const int pins[] = { BTN_UP, BTN_DOWN, BTN_SELECT, BTN_BACK };
+  for (int pin : pins) gpio_wakeup_enable((gpio_num_t)pin, GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+}
+
+void power_init() {
+  s_bootMs = millis();
+  s_busyTotalMs = 0;
+
+#if CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t cfg;
+#else
+  esp_pm_config_esp32_t cfg;
+#endif
+  cfg.max_freq_mhz = POWER_MAX_CPU_MHZ;
+  cfg.min_freq_mhz = POWER_IDLE_CPU_MHZ;
+  cfg.light_sleep_enable = POWER_AUTO_LIGHT_SLEEP ? true : false;
+
+  const char *names[PWR_LOCK_COUNT] = { "net", "uart" };
+  for (int i = 0; i < PWR_LOCK_COUNT; ++i) {
+    // NET needs full CPU for TLS; UART only needs a stable APB clock for the baud rate
+    esp_pm_lock_type_t type = (i == PWR_LOCK_NET) ? ESP_PM_CPU_FREQ_MAX : ESP_PM_APB_FREQ_MAX;
+    esp_pm_lock_create(type, 0, names[i], &s_cpuLock[i]);
+    esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, names[i], &s_sleepLock[i]);
+  }
+
+  if (esp_pm_configure(&cfg) == ESP_OK) {
+    s_pmActive = true;
+    if (POWER_AUTO_LIGHT_SLEEP) enableButtonWake();
+    Serial.printf("[Power] DFS %d..%d MHz, light sleep %s\n",
+                  POWER_IDLE_CPU_MHZ, POWER_MAX_CPU_MHZ, POWER_AUTO_LIGHT_SLEEP ? "on" : "off");
+  } else {
+    Serial.println("[Power] esp_pm_configure failed, using manual frequency scaling");
+  }
+#endif
+
+  if (!s_pmActive) {
+    setCpuFrequencyMhz(POWER_IDLE_CPU_MHZ);
+    Serial.printf("[Power] manual scaling, idle at %d MHz\n", POWER_IDLE_CPU_MHZ);
+  }
+}
+
+void power_enableUartWake(int uartNum) {
+#if CONFIG_PM_ENABLE
+  if (!s_pmActive || !POWER_AUTO_LIGHT_SLEEP) return;
+  // The wakeup edges are consumed, not received: with POWER_UART_WAKE_EDGES = 3 that is
+  // the leading CR of "\r\n+CMTI: ..." and the line itself still reaches the engine.
+  if (uart_set_wakeup_threshold((uart_port_t)uartNum, POWER_UART_WAKE_EDGES) != ESP_OK ||
+      esp_sleep_enable_uart_wakeup(uartNum) != ESP_OK) {
+    Serial.printf("[Power] UART%d wakeup not available\n", uartNum);
+    return;
+  }
+  Serial.printf("[Power] UART%d wakes from light sleep\n", uartNum);
+#else
+  (void)uartNum;
+#endif
+}
+
+void power_acquire(PowerLock lock) {
+  if (lock >= PWR_LOCK_COUNT) return;
+  if (s_lockCount[lock]++ == 0) {
+#if CONFIG_PM_ENABLE
+    if (s_pmActive) {
+      esp_pm_lock_acquire(s_cpuLock[lock]);
+      esp_pm_lock_acquire(s_sleepLock[lock]);
+    }
+#endif
+    if (s_heldTotal++ == 0) {
+      s_busySinceMs = millis();
+      if (!s_pmActive) setCpuFrequencyMhz(POWER_MAX_CPU_MHZ);
+    }
+  }
+}
+
+void power_release(PowerLock lock) {
+  if (lock >= PWR_LOCK_COUNT || s_lockCount[lock] == 0) return;
+  if (--s_lockCount[lock] == 0) {
+#if CONFIG_PM_ENABLE
+    if (s_pmActive) {
+      esp_pm_lock_release(s_sleepLock[lock]);
+      esp_pm_lock_release(s_cpuLock[lock]);
+    }
+#endif
+    if (--s_heldTotal == 0) {
+      s_busyTotalMs += millis() - s_busySinceMs;
+      if (!s_pmActive) setCpuFrequencyMhz(POWER_IDLE_CPU_MHZ);
+    }
+  }
+}
+
+float power_getIdleFraction() {
+  unsigned long now = millis();
+  unsigned long up = now - s_bootMs;
+  if (up == 0) return 0.0f;
+  unsigned long busy = s_busyTotalMs;
+  if (s_heldTotal > 0) busy += now - s_busySinceMs;
+  if (busy > up) busy = up;
+  return (float)(up - busy) / (float)up;
+}
+
+float power_getIdleSavedMa() {
+  return power_getIdleFraction() * (POWER_ACTIVE_MA - POWER_IDLE_MA);
+}
@@ -0,0 +1,31 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+
+// Power-management lock owners. Hold a lock only while the peripheral is busy;
+// with no lock held the CPU drops to POWER_IDLE_CPU_MHZ and may enter light sleep.
+enum PowerLock {
+  PWR_LOCK_NET = 0,   // WiFi / HTTP transfer in flight: full clock, no light sleep
+  PWR_LOCK_UART,      // modem UART traffic: APB at full speed, no light sleep
+  PWR_LOCK_COUNT
+};
+
+// Enable automatic light sleep + DFS and GPIO wake on the four buttons (call from setup).
+void power_init();
+
+// Let RX activity on a UART wake the CPU from light sleep (call after the port is begun).
+// Without it, URCs that arrive while no lock is held are lost.
+void power_enableUartWake(int uartNum);
+
+// Nestable acquire/release (counted per lock).
+void power_acquire(PowerLock lock);
+void power_release(PowerLock lock);
+
+// Estimated average current saved versus running at full clock all the time (mA).
+float power_getIdleSavedMa();
+
+// Share of uptime spent with no lock held (0..1)
+float power_getIdleFraction();
+
+#endif // POWER_MANAGER_H
@@ -6,6 +6,7 @@
 #include "provisioning_ui.h"
 #include "ui.h"
 #include "weather_manager.h"
+#include "net_transport.h"
 #include "text_strings.h"
 #include "menu_manager.h"
 #include <LiquidCrystal_I2C.h>
@@ -207,7 +208,7 @@ void provisioning_ui_enterCityCountry() {
           if (currentLanguage==LANG_EN) enPrintFixed(0,0,getTextEN(TXT_GEOCODE_SAVED));
           else grPrintFixed(0,0,getTextGR(TXT_GEOCODE_SAVED));
           // attempt immediate weather fetch to populate forecast and verify
-          if (WiFi.status() == WL_CONNECTED) {
+          if (netTransport_available()) {
             if (weather_fetch()) {
               if (currentLanguage==LANG_EN) enPrintFixed(0,1,"WEATHER FETCH OK");
               else grPrintFixed(0,1,"WEATHER FETCH OK");
@@ -238,7 +239,7 @@ void provisioning_ui_enterCityCountry() {
           if (currentLanguage==LANG_EN) enPrintFixed(0,0,getTextEN(TXT_GEOCODE_SAVED));
           else grPrintFixed(0,0,getTextGR(TXT_GEOCODE_SAVED));
           // attempt immediate weather fetch to populate forecast and verify
-          if (WiFi.status() == WL_CONNECTED) {
+          if (netTransport_available()) {
             if (weather_fetch()) {
               if (currentLanguage==LANG_EN) enPrintFixed(0,1,"WEATHER FETCH OK");
               else grPrintFixed(0,1,"WEATHER FETCH OK");
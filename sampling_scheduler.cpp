@@ -0,0 +1,138 @@
+// sampling_scheduler.cpp
+// - Chooses the measurement interval from recent hive activity and battery level.
+// - Short interval when weight or internal temperature move (honey flow, swarming),
+//   medium during daylight foraging hours, long when readings are flat.
+// - Low battery stretches the interval; critical battery pins it to the maximum.
+// - The interval is applied by sampler_isDue() in the awake main loop; between readings
+//   the CPU light-sleeps (power_manager.cpp). No deep-sleep timer is armed: deep sleep
+//   would stop the key server, SMS reception and MQTT.
+// - The reading history lives in RTC memory so the policy keeps working across deep sleep.
+// - Activity/battery thresholds and an optional fixed interval come from settings.h
+//   (remote SET), with the config.h values as defaults.
+#include "sampling_scheduler.h"
+#include "config.h"
+#include "time_manager.h"
+#include "settings.h"
+#include <esp_sleep.h>
+#include <time.h>
+
+static const int HISTORY = 8;   // readings used for the variance estimate
+
+RTC_DATA_ATTR static float    s_weights[HISTORY];
+RTC_DATA_ATTR static float    s_temps[HISTORY];
+RTC_DATA_ATTR static uint8_t  s_count = 0;
+RTC_DATA_ATTR static uint8_t  s_head = 0;
+RTC_DATA_ATTR static uint32_t s_intervalSec = (uint32_t)(MEASUREMENT_INTERVAL / 1000000ULL);
+RTC_DATA_ATTR static uint8_t  s_reason = SAMPLE_NORMAL;
+RTC_DATA_ATTR static int8_t   s_lastBatt = 100;
+
+static unsigned long s_lastSampleMs = 0;
+static bool s_sampledSinceBoot = false;
+
+// Standard deviation of the last s_count values in a ring buffer
+static float stdDev(const float *v) {
+  if (s_count < 2) return 0.0f;
+  float mean = 0.0f;
+  for (int i = 0; i < s_count; ++i) mean += v[i];
+  mean /= s_count;
+  float acc = 0.0f;
+  for (int i = 0; i < s_count; ++i) acc += (v[i] - mean) * (v[i] - mean);
+  return sqrtf(acc / (s_count - 1));
+}
+
+static bool isForagingHour() {
+  if (!timeManager_isTimeValid()) return false;
+  time_t now = time(nullptr);
+  struct tm t;
+  localtime_r(&now, &t);
+  return t.tm_hour >= SAMPLE_FORAGE_START_HOUR && t.tm_hour < SAMPLE_FORAGE_END_HOUR;
+}
+
+static void recompute(int battPercent) {
+#if ADAPTIVE_SAMPLING
+  const Settings &st = settings_get();
+  float wSd = stdDev(s_weights);
+  float tSd = stdDev(s_temps);
+  uint32_t iv = (uint32_t)(MEASUREMENT_INTERVAL / 1000000ULL);
+  SampleReason reason = SAMPLE_NORMAL;
+
+  if (st.sampleFixedS) {
+    iv = st.sampleFixedS;
+    reason = SAMPLE_FIXED;
+  } else if (wSd > st.activeWeightKg || tSd > st.activeTempC) {
+    iv = SAMPLE_INTERVAL_ACTIVE_S;
+    reason = SAMPLE_ACTIVE;
+  } else if (isForagingHour()) {
+    iv = SAMPLE_INTERVAL_FORAGE_S;
+    reason = SAMPLE_FORAGE;
+  } else if (s_count >= 2 && wSd < SAMPLE_WEIGHT_FLAT_KG && tSd < SAMPLE_TEMP_FLAT_C) {
+    iv = SAMPLE_INTERVAL_FLAT_S;
+    reason = SAMPLE_FLAT;
+  }
+
+  if (battPercent < st.battCritPct) {
+    iv = SAMPLE_INTERVAL_MAX_S;
+    reason = SAMPLE_BATT_CRIT;
+  } else if (battPercent < st.battLowPct) {
+    iv *= 2;
+    reason = SAMPLE_BATT_LOW;
+  }
+
+  if (iv < SAMPLE_INTERVAL_MIN_S) iv = SAMPLE_INTERVAL_MIN_S;
+  if (iv > SAMPLE_INTERVAL_MAX_S) iv = SAMPLE_INTERVAL_MAX_S;
+  s_intervalSec = iv;
+  s_reason = reason;
+#else
+  (void)battPercent;
+  uint32_t iv = settings_get().sampleFixedS;
+  if (iv == 0) iv = (uint32_t)(MEASUREMENT_INTERVAL / 1000000ULL);
+  // same hard bounds as the adaptive policy: "SET iv=1" must not sample every second
+  if (iv < SAMPLE_INTERVAL_MIN_S) iv = SAMPLE_INTERVAL_MIN_S;
+  if (iv > SAMPLE_INTERVAL_MAX_S) iv = SAMPLE_INTERVAL_MAX_S;
+  s_intervalSec = iv;
+  s_reason = SAMPLE_FIXED;
+#endif
+}
+
+void sampler_init() {
+  // History is only meaningful after a timer wakeup from deep sleep, not a cold boot
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) {
+    s_count = 0;
+    s_head = 0;
+    s_intervalSec = (uint32_t)(MEASUREMENT_INTERVAL / 1000000ULL);
+    s_reason = ADAPTIVE_SAMPLING ? SAMPLE_NORMAL : SAMPLE_FIXED;
+  }
+  s_lastSampleMs = millis();
+  s_sampledSinceBoot = false;
+}
+
+bool sampler_isDue() {
+  // Always take one reading right after boot / wake-up
+  if (!s_sampledSinceBoot) return true;
+  return (millis() - s_lastSampleMs) >= s_intervalSec * 1000UL;
+}
+
+void sampler_addReading(const Measurement &m) {
+  s_weights[s_head] = m.weight;
+  s_temps[s_head]   = m.temp_int;
+  s_head = (s_head + 1) % HISTORY;
+  if (s_count < HISTORY) s_count++;
+
+  s_lastBatt = (int8_t)constrain(m.batt_percent, 0, 100);
+  recompute(m.batt_percent);
+
+  s_lastSampleMs = millis();
+  s_sampledSinceBoot = true;
+
+  Serial.printf("[Sampler] w=%.2f t=%.1f batt=%d%% -> next in %lus (reason %d)\n",
+                m.weight, m.temp_int, m.batt_percent, (unsigned long)s_intervalSec, (int)s_reason);
+}
+
+void sampler_settingsChanged() {
+  recompute(s_lastBatt);
+  Serial.printf("[Sampler] settings changed -> interval %lus (reason %d)\n",
+                (unsigned long)s_intervalSec, (int)s_reason);
+}
+
+uint32_t sampler_getIntervalSec() { return s_intervalSec; }
+SampleReason sampler_getReason() { return (SampleReason)s_reason; }
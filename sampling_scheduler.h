@@ -0,0 +1,34 @@
+#ifndef SAMPLING_SCHEDULER_H
+#define SAMPLING_SCHEDULER_H
+
+#include <Arduino.h>
+#include "measurement.h"
+
+// Activity class behind the current interval (for UI/debug)
+enum SampleReason {
+  SAMPLE_FIXED = 0,   // ADAPTIVE_SAMPLING disabled
+  SAMPLE_ACTIVE,      // high weight or temperature variance
+  SAMPLE_FORAGE,      // daylight foraging hours
+  SAMPLE_NORMAL,
+  SAMPLE_FLAT,        // readings flat
+  SAMPLE_BATT_LOW,    // stretched because battery is low
+  SAMPLE_BATT_CRIT    // battery critical: maximum interval
+};
+
+// Init the scheduler (call from setup). History survives deep sleep (RTC memory).
+void sampler_init();
+
+// True when the next measurement is due (millis based, for the awake main loop).
+bool sampler_isDue();
+
+// Feed a new measurement; recomputes the interval.
+void sampler_addReading(const Measurement &m);
+
+// Re-evaluate the interval after settings.h changed (uses the last battery reading)
+void sampler_settingsChanged();
+
+// Interval chosen after the last reading, clamped to SAMPLE_INTERVAL_MIN_S..MAX_S.
+uint32_t sampler_getIntervalSec();
+SampleReason sampler_getReason();
+
+#endif // SAMPLING_SCHEDULER_H
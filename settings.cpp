@@ -0,0 +1,186 @@
+// settings.cpp
+// - One fixed-size NVS blob ("settings") with a layout version; a mismatch falls back
+//   to the config.h defaults instead of reading garbage after a firmware update.
+// - settings_apply() parses into a copy through a key table (name, type, offset, range)
+//   and only writes when every pair is valid, so a multi-key update is one NVS commit.
+// - "net" is not part of the blob: net_transport owns connectivityMode, so the key is
+//   validated with the rest and handed to netTransport_setMode() once they are committed.
+#include "settings.h"
+#include "config.h"
+#include "net_transport.h"
+#include <Preferences.h>
+#include <stddef.h>
+#include <math.h>
+
+static const char *PREF_NS = "beehive";
+static const char *PREF_KEY_SETTINGS = "settings";
+static const uint8_t SETTINGS_VERSION = 1;
+
+static Settings s_settings;
+static bool     s_loaded = false;
+
+enum KeyType { KT_U8, KT_U32, KT_F32 };
+
+struct SettingKey {
+  const char *name;
+  KeyType     type;
+  size_t      offset;
+  float       min;
+  float       max;
+};
+
+static const SettingKey KEYS[] = {
+  { "iv",    KT_U32, offsetof(Settings, sampleFixedS),   0.0f,  (float)SAMPLE_INTERVAL_MAX_S },
+  { "wact",  KT_F32, offsetof(Settings, activeWeightKg), 0.01f, 5.0f },
+  { "tact",  KT_F32, offsetof(Settings, activeTempC),    0.05f, 5.0f },
+  { "blow",  KT_U8,  offsetof(Settings, battLowPct),     0.0f,  90.0f },
+  { "bcrit", KT_U8,  offsetof(Settings, battCritPct),    0.0f,  90.0f },
+  { "batch", KT_U8,  offsetof(Settings, batchMax),       1.0f,  (float)TELEMETRY_BATCH_MAX },
+  { "flush", KT_U32, offsetof(Settings, flushS),         60.0f, 86400.0f },
+};
+static const int KEY_COUNT = sizeof(KEYS) / sizeof(KEYS[0]);
+
+// "net" values, indexed by CONNECTIVITY_* (LTE, WIFI, OFFLINE)
+static const char *NET_MODES[] = { "lte", "wifi", "off" };
+static const int NET_MODE_COUNT = sizeof(NET_MODES) / sizeof(NET_MODES[0]);
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static void setDefaults(Settings &s) {
+  memset(&s, 0, sizeof(s));
+  s.version        = SETTINGS_VERSION;
+  s.sampleFixedS   = ADAPTIVE_SAMPLING ? 0 : (uint32_t)(MEASUREMENT_INTERVAL / 1000000ULL);
+  s.activeWeightKg = SAMPLE_WEIGHT_ACTIVE_KG;
+  s.activeTempC    = SAMPLE_TEMP_ACTIVE_C;
+  s.battLowPct     = SAMPLE_BATT_LOW_PCT;
+  s.battCritPct    = SAMPLE_BATT_CRIT_PCT;
+  s.batchMax       = TELEMETRY_BATCH_MAX;
+  s.flushS         = TELEMETRY_FLUSH_S;
+}
+
+static const SettingKey *findKey(const char *name, size_t len) {
+  for (int i = 0; i < KEY_COUNT; ++i) {
+    if (strlen(KEYS[i].name) == len && strncasecmp(KEYS[i].name, name, len) == 0) return &KEYS[i];
+  }
+  return nullptr;
+}
+
+static int parseNetMode(const char *val) {
+  for (int i = 0; i < NET_MODE_COUNT; ++i) {
+    if (strcasecmp(val, NET_MODES[i]) == 0) return i;
+  }
+  return -1;
+}
+
+static bool setValue(Settings &s, const SettingKey &k, const char *val) {
+  char *end;
+  float v = strtof(val, &end);
+  while (*end == ' ') end++;
+  // strtof takes "nan"/"inf", which slip past a range check; NaN -> uint32_t is UB
+  if (end == val || *end || !isfinite(v) || v < k.min || v > k.max) return false;
+  uint8_t *p = (uint8_t *)&s + k.offset;
+  switch (k.type) {
+    case KT_U8:  { uint8_t u = (uint8_t)v;  memcpy(p, &u, sizeof(u)); break; }
+    case KT_U32: { uint32_t u = (uint32_t)v; memcpy(p, &u, sizeof(u)); break; }
+    case KT_F32: memcpy(p, &v, sizeof(v)); break;
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void settings_init() {
+  if (s_loaded) return;
+  s_loaded = true;
+  Preferences p;
+  p.begin(PREF_NS, true);
+  size_t n = p.getBytes(PREF_KEY_SETTINGS, &s_settings, sizeof(s_settings));
+  p.end();
+  if (n != sizeof(s_settings) || s_settings.version != SETTINGS_VERSION) setDefaults(s_settings);
+
+  char buf[128];
+  settings_format(buf, sizeof(buf));
+  Serial.printf("[Settings] %s\n", buf);
+}
+
+const Settings &settings_get() {
+  settings_init();
+  return s_settings;
+}
+
+bool settings_apply(const char *kv, char *err, size_t errLen) {
+  settings_init();
+  Settings next = s_settings;
+  if (err && errLen) err[0] = 0;
+
+  char pair[32];
+  int changed = 0;
+  int netMode = -1;
+  const char *p = kv;
+  while (*p) {
+    while (*p == ' ' || *p == ';' || *p == ',') p++;
+    if (!*p) break;
+    size_t n = strcspn(p, ";,");
+    size_t copy = n < sizeof(pair) - 1 ? n : sizeof(pair) - 1;
+    memcpy(pair, p, copy);
+    pair[copy] = 0;
+    p += n;
+
+    char *eq = strchr(pair, '=');
+    bool known = false;
+    if (eq) {
+      char *name = pair;
+      size_t nameLen = (size_t)(eq - pair);
+      while (nameLen && name[nameLen - 1] == ' ') nameLen--;
+      char *val = eq + 1;
+      while (*val == ' ') val++;
+      size_t valLen = strlen(val);
+      while (valLen && val[valLen - 1] == ' ') val[--valLen] = 0;
+      if (nameLen == 3 && strncasecmp(name, "net", 3) == 0) {
+        known = true;
+        netMode = parseNetMode(val);
+        if (netMode >= 0) { changed++; continue; }
+      } else {
+        const SettingKey *k = findKey(name, nameLen);
+        known = k != nullptr;
+        if (k && setValue(next, *k, val)) { changed++; continue; }
+      }
+    }
+    if (err && errLen) snprintf(err, errLen, "%s %s", known ? "bad value" : "unknown", pair);
+    return false;
+  }
+
+  if (changed == 0) {
+    if (err && errLen) snprintf(err, errLen, "nothing to set");
+    return false;
+  }
+  if (next.battCritPct > next.battLowPct) {
+    if (err && errLen) snprintf(err, errLen, "bcrit > blow");
+    return false;
+  }
+
+  s_settings = next;
+  Preferences pr;
+  pr.begin(PREF_NS, false);
+  pr.putBytes(PREF_KEY_SETTINGS, &s_settings, sizeof(s_settings));
+  pr.end();
+  if (netMode >= 0) netTransport_setMode(netMode);
+
+  char buf[128];
+  settings_format(buf, sizeof(buf));
+  Serial.printf("[Settings] %d updated: %s\n", changed, buf);
+  return true;
+}
+
+int settings_format(char *out, size_t len) {
+  const Settings &s = settings_get();
+  const char *net = connectivityMode >= 0 && connectivityMode < NET_MODE_COUNT
+                    ? NET_MODES[connectivityMode] : "?";
+  int n = snprintf(out, len, "iv=%lu wact=%.2f tact=%.2f blow=%u bcrit=%u batch=%u flush=%lu net=%s",
+                   (unsigned long)s.sampleFixedS, s.activeWeightKg, s.activeTempC,
+                   (unsigned)s.battLowPct, (unsigned)s.battCritPct, (unsigned)s.batchMax,
+                   (unsigned long)s.flushS, net);
+  return n < 0 ? 0 : (n >= (int)len ? (int)len - 1 : n);
+}
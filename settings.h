@@ -0,0 +1,44 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+
+// Runtime-tunable settings, persisted as one NVS blob ("settings").
+// Defaults come from config.h; remote updates ("k=v;k=v", e.g. from an SMS SET command)
+// are validated as a whole and written with a single NVS commit.
+//
+// Keys:
+//   iv     fixed sampling interval in s, 0 = adaptive (sampling_scheduler)
+//   wact   weight std-dev (kg) above which the hive counts as active
+//   tact   internal temperature std-dev (C) above which the hive counts as active
+//   blow   battery % below which the interval is doubled
+//   bcrit  battery % below which the interval is pinned to the maximum
+//   batch  telemetry records per MQTT message (1..TELEMETRY_BATCH_MAX)
+//   flush  publish a partial batch once its oldest record is this old (s)
+//   net    connectivityMode: wifi (LTE fallback), lte (WiFi fallback) or off. Kept in its
+//          own NVS key by net_transport, applied after the blob commit
+
+struct Settings {
+  uint8_t  version;
+  uint8_t  battLowPct;
+  uint8_t  battCritPct;
+  uint8_t  batchMax;
+  uint32_t sampleFixedS;
+  float    activeWeightKg;
+  float    activeTempC;
+  uint32_t flushS;
+};
+
+// Load from NVS (defaults when missing or from an older layout). Call early in setup.
+void settings_init();
+
+const Settings &settings_get();
+
+// Parse "k=v;k=v" (',' or ';' separated, case-insensitive keys), validate every pair and
+// commit once. On failure nothing changes and err names the offending pair.
+bool settings_apply(const char *kv, char *err, size_t errLen);
+
+// "iv=0 wact=0.20 ..." for replies and logs; returns the length written
+int settings_format(char *out, size_t len);
+
+#endif // SETTINGS_H
@@ -2,181 +2,409 @@
 #include "modem_manager.h"
 #include "weather_manager.h"
 #include "text_strings.h"
-#include <TinyGsmClient.h>
+#include "power_manager.h"
+#include "at_engine.h"
+#include "settings.h"
+#include "measurement.h"
+#include "sampling_scheduler.h"
+#include "telemetry.h"
+#include "config.h"
+#include <time.h>
 #include <Arduino.h>
 
-// This SMS handler uses AT commands sent through the TinyGsm modem instance.
-// It attempts to:
-// - set text mode (AT+CMGF=1)
-// - list unread messages (AT+CMGL="REC UNREAD")
-// - parse messages for commands (GEO:city,country)
-// - on success call weather_geocodeLocation()
-// - delete processed messages (AT+CMGD=index)
-// - attempt to send a basic SMS reply confirming the action (AT+CMGS)
+// This SMS handler uses AT commands queued on the AT engine (at_engine.h).
+// - +CMTI (new message) URCs are enabled (AT+CNMI=2,1) and trigger one listing;
+//   otherwise the modem is left alone apart from a slow fallback poll, because a
+//   URC that arrives while TinyGSM owns the UART is swallowed by TinyGSM
+// - listing never wakes a powered-down modem (MODEM_POWER_OFF); it runs whenever the
+//   modem is on anyway, and after every power-up ("SMS DONE"). Sending takes a lease
+//   and powers the modem up if needed.
+// - one AT+CMGL="ALL" pass into the engine's fixed reply buffer, sliced in place
+//   into header/body without copies. The engine keeps the line after each header as
+//   text, so a body reading "OK" or "ERROR" cannot end the listing
+// - messages are matched against a command table (STATUS?, SET k=v;k=v, GEO:city,country)
+//   and answered with one AT+CMGS, only for senders on SMS_ALLOW_LIST and only while
+//   the reply token bucket has tokens (SMS_REPLY_BURST / SMS_REPLY_REFILL_S). With an
+//   empty list, commands that change the device (SET, GEO) are refused to everyone
+// - only the received messages actually handled are deleted, one AT+CMGD=<idx> each,
+//   fed to the engine as queue room allows. A bulk "delete all read" would also take
+//   messages the listing never showed (a multi-line body with an "OK" line still ends
+//   it early), so anything not parsed stays on the SIM for the next listing
+// - a listing cut short (timeout, full reply buffer) that handled nothing is retried
+//   with a doubling delay, SMS_LIST_RETRIES times; the last retry deletes a cut-off
+//   message unhandled, so one oversized body cannot hold the UART and the lease forever
 
-static unsigned long s_lastCheck = 0;
-static const unsigned long SMS_CHECK_INTERVAL = 30UL * 1000UL; // check every 30s
+static const unsigned long SMS_FALLBACK_INTERVAL = 10UL * 60UL * 1000UL; // poll every 10 min
+static const uint8_t SMS_MAX_BATCH = 16;   // messages handled (and deleted) per listing
+static const unsigned long SMS_LIST_RETRY_MS = 5000UL;   // 5, 10, 20, 40 s after cut-off listings
+static const uint8_t SMS_LIST_RETRIES = 4;
+
+static unsigned long s_lastList = 0;
+static volatile bool s_newMsg      = false;   // +CMTI seen since the last listing
+static volatile bool s_listPending = false;   // CMGL queued, reply not in yet
+static volatile bool s_listReady   = false;
+static bool s_listTruncated = false;       // last body may be cut short
+static uint8_t       s_listRetries = 0;    // cut-off listings in a row that handled nothing
+static unsigned long s_listDelay   = 0;    // wait after s_lastList before the retry
+
+// Indices handled in the last listing, deleted from sms_loop()
+static int     s_del[SMS_MAX_BATCH];
+static uint8_t s_delCount = 0;
+static uint8_t s_delNext  = 0;
+
+// CMGL reply copied out of the AT engine callback, parsed on the next sms_loop()
+static char s_list[AT_RESP_LEN];
+
+static uint32_t s_cmtiCount = 0;
+static uint32_t s_listCount = 0;
+static uint32_t s_msgCount  = 0;
+static uint32_t s_denied    = 0;   // sender not on the allow-list
+static uint32_t s_throttled = 0;   // reply dropped by the rate limit
+static uint32_t s_cutDropped = 0;  // deleted unhandled after SMS_LIST_RETRIES cut-off listings
+
+// Reply token bucket
+static uint8_t       s_tokens = SMS_REPLY_BURST;
+static unsigned long s_tokenMs = 0;
+
+// Command handlers fill reply (160 chars max, one SMS) and return true to send it
+typedef bool (*SmsCmdFn)(char *args, char *reply, size_t replyLen);
+
+struct SmsCommand {
+  const char *prefix;   // matched case-insensitively at the start of the body
+  SmsCmdFn    fn;
+  bool        writes;   // changes the device: needs a sender on SMS_ALLOW_LIST
+};
+
+// +CMTI: "SM",<index>
+static void onCmti(const char *line, void *ctx) {
+  (void)line; (void)ctx;
+  s_cmtiCount++;
+  s_newMsg = true;
+}
+
+// "SMS DONE": SMS subsystem ready after a modem power-up; text mode and URC routing
+// are volatile, so restore them and list what the network delivered meanwhile
+static void onSmsReady(const char *line, void *ctx) {
+  (void)line; (void)ctx;
+  at_submit("+CMGF=1", 1000, nullptr, nullptr);
+  at_submit("+CNMI=2,1,0,0,0", 1000, nullptr, nullptr);
+  s_newMsg = true;
+}
 
 void sms_init() {
   // Ensure modem is initialized externally (modemManager_init)
-  TinyGsm &modem = modem_get();
-  Serial.println("[SMS] Setting text mode (AT+CMGF=1)...");
-  modem.sendAT("+CMGF=1");
-  modem.waitResponse(2000);
-  s_lastCheck = millis();
-}
-
-// Helper: send AT and read stream for a short time, return aggregated response
-static String modemReadResponse(unsigned long timeout = 3000) {
-  TinyGsm &modem = modem_get();
-  Stream &s = modem.stream;
-  unsigned long t0 = millis();
-  String resp;
-  while (millis() - t0 < timeout) {
-    while (s.available()) {
-      char c = s.read();
-      resp += c;
-    }
-    delay(10);
+  if (!at_isStarted()) return;
+  Serial.println("[SMS] Text mode, new-message URCs (AT+CMGF=1, AT+CNMI=2,1)...");
+  at_subscribe("+CMTI:", onCmti, nullptr);
+  at_subscribe("SMS DONE", onSmsReady, nullptr);
+  power_acquire(PWR_LOCK_UART);
+  AtResult r = at_exec("+CMGF=1", 2000);
+  if (r == AT_OK) r = at_exec("+CNMI=2,1,0,0,0", 2000);
+  power_release(PWR_LOCK_UART);
+  if (r != AT_OK) Serial.printf("[SMS] setup: %s\n", at_resultName(r));
+  s_newMsg = true;   // pick up anything that arrived while we were off
+}
+
+// Attempt to send a text SMS (best-effort). number must be in international format.
+bool sms_send(const char *number, const char *message) {
+  // Text mode is already set; AT+CMGS="num", then the body after the '>' prompt
+  if (!modem_acquire(MODEM_LEASE_SMS_TX) && !modem_waitOn(MODEM_BOOT_TIMEOUT_MS)) {
+    modem_release(MODEM_LEASE_SMS_TX);
+    Serial.println("[SMS] send: modem not available");
+    return false;
   }
-  return resp;
+  char cmd[48];
+  snprintf(cmd, sizeof(cmd), "+CMGS=\"%s\"", number);
+  power_acquire(PWR_LOCK_UART);
+  AtResult r = at_execPrompt(cmd, message, 10000);
+  power_release(PWR_LOCK_UART);
+  modem_release(MODEM_LEASE_SMS_TX);
+  Serial.printf("[SMS] send result: %s\n", at_resultName(r));
+  return r == AT_OK;
 }
 
-// Helper: send AT and get response quickly
-static String atSendAndRead(const char *cmd, unsigned long timeout = 3000) {
-  TinyGsm &modem = modem_get();
-  modem.sendAT(cmd);
-  return modemReadResponse(timeout);
+// Whatever was listed is handled even when the command did not end in OK, so a message
+// that upsets the listing gets deleted instead of blocking every later pass
+static void onCmgl(const AtReply &reply, void *ctx) {
+  (void)ctx;
+  power_release(PWR_LOCK_UART);
+  s_listPending = false;
+  if (reply.result != AT_OK) Serial.printf("[SMS] CMGL ended with %s\n", at_resultName(reply.result));
+  if (reply.len == 0 && reply.result != AT_OK) {
+    modem_release(MODEM_LEASE_SMS);
+    return;
+  }
+  memcpy(s_list, reply.text, reply.len);
+  s_list[reply.len] = 0;
+  s_listTruncated = reply.truncated || reply.result == AT_TIMEOUT;
+  s_listReady = true;
 }
 
-// Attempt to send a text SMS (best-effort). number must be in international format.
-static bool sms_send(const String &number, const String &message) {
-  TinyGsm &modem = modem_get();
-  // Set text mode first (already done), then send AT+CMGS="num"
-  String at = String("+CMGS=\"") + number + "\"";
-  modem.sendAT(at.c_str());
-  // wait for '>' prompt
-  unsigned long t0 = millis();
-  bool prompt = false;
-  while (millis() - t0 < 3000) {
-    while (modem.stream.available()) {
-      char c = modem.stream.read();
-      if (c == '>') { prompt = true; break; }
+// Copy the n-th quoted field of a CMGL header ("REC UNREAD", "+30...") into out
+static bool quotedField(const char *hdr, int n, char *out, size_t outLen) {
+  const char *p = hdr;
+  for (int i = 0; i <= n; ++i) {
+    p = strchr(p, '"');
+    if (!p) return false;
+    const char *e = strchr(p + 1, '"');
+    if (!e) return false;
+    if (i == n) {
+      size_t len = (size_t)(e - p - 1);
+      if (len >= outLen) len = outLen - 1;
+      memcpy(out, p + 1, len);
+      out[len] = 0;
+      return true;
     }
-    if (prompt) break;
-    delay(10);
+    p = e + 1;
   }
-  if (!prompt) {
-    Serial.println("[SMS] No prompt for CMGS");
-    return false;
+  return false;
+}
+
+static void trimInPlace(char *&s) {
+  while (*s == ' ' || *s == '\r' || *s == '\t') s++;
+  size_t n = strlen(s);
+  while (n && (s[n - 1] == ' ' || s[n - 1] == '\r' || s[n - 1] == '\t')) s[--n] = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Commands
+// ---------------------------------------------------------------------------
+// GEO:city[,country]
+static bool cmdGeo(char *args, char *reply, size_t replyLen) {
+  char *city = args;
+  char *country = strchr(city, ',');
+  if (country) *country++ = 0;
+  trimInPlace(city);
+  if (country) trimInPlace(country);
+  if (!*city) return false;
+  if (weather_geocodeLocation(city, (country && *country) ? country : nullptr)) {
+    Serial.println("[SMS] Geocode stored from SMS");
+    snprintf(reply, replyLen, "OK: Geocode stored");
+  } else {
+    Serial.print("[SMS] Geocode failed: ");
+    Serial.println(weather_getLastError());
+    snprintf(reply, replyLen, "ERR: geocode failed");
+  }
+  return true;
+}
+
+// STATUS? -> latest measurement, interval and uplink backlog in one SMS
+static bool cmdStatus(char *args, char *reply, size_t replyLen) {
+  (void)args;
+  Measurement m;
+  if (!measurement_getLatest(m)) {
+    snprintf(reply, replyLen, "STATUS: no measurement yet");
+    return true;
+  }
+  char at[8] = "--:--";
+  if (m.timestamp) {
+    time_t ts = (time_t)m.timestamp;
+    struct tm t;
+    localtime_r(&ts, &t);
+    strftime(at, sizeof(at), "%H:%M", &t);
+  }
+  snprintf(reply, replyLen,
+           "%s W%.2fkg Ti%.1fC Hi%.0f%% Te%.1fC He%.0f%% P%.0f B%.2fV %d%% RSSI%d iv%lus q%lu",
+           at, m.weight, m.temp_int, m.hum_int, m.temp_ext, m.hum_ext, m.pressure,
+           m.batt_voltage, m.batt_percent, m.rssi,
+           (unsigned long)sampler_getIntervalSec(), (unsigned long)telemetry_pending());
+  return true;
+}
+
+// SET k=v;k=v -> all or nothing, one NVS commit
+static bool cmdSet(char *args, char *reply, size_t replyLen) {
+  char err[48];
+  if (!settings_apply(args, err, sizeof(err))) {
+    snprintf(reply, replyLen, "ERR: %s", err);
+    return true;
+  }
+  sampler_settingsChanged();
+  int n = snprintf(reply, replyLen, "OK ");
+  settings_format(reply + n, replyLen - n);
+  return true;
+}
+
+static const SmsCommand COMMANDS[] = {
+  { "STATUS?", cmdStatus, false },
+  { "SET ",    cmdSet,    true },
+  { "GEO:",    cmdGeo,    true },
+};
+
+// Compare the trailing digits of two numbers ("+30 69..." vs "069...")
+static bool sameNumber(const char *a, const char *b) {
+  char da[20], db[20];
+  size_t na = 0, nb = 0;
+  for (; *a && na < sizeof(da); ++a) if (isdigit((unsigned char)*a)) da[na++] = *a;
+  for (; *b && nb < sizeof(db); ++b) if (isdigit((unsigned char)*b)) db[nb++] = *b;
+  size_t n = na < nb ? na : nb;
+  if (n < 8) return false;
+  return memcmp(da + na - n, db + nb - n, n) == 0;
+}
+
+// Empty list: read-only commands for anyone, nothing that writes
+static bool senderAllowed(const char *from, bool writes) {
+  const char *list = SMS_ALLOW_LIST;
+  if (!*list) return !writes;
+  while (*list) {
+    size_t n = strcspn(list, ",");
+    char entry[24];
+    size_t copy = n < sizeof(entry) - 1 ? n : sizeof(entry) - 1;
+    memcpy(entry, list, copy);
+    entry[copy] = 0;
+    if (sameNumber(entry, from)) return true;
+    list += n;
+    if (*list == ',') list++;
   }
-  // send message then Ctrl+Z
-  modem.stream.print(message);
-  modem.stream.write(26); // Ctrl+Z
-  // read response
-  String r = modemReadResponse(5000);
-  Serial.print("[SMS] send response: "); Serial.println(r);
-  if (r.indexOf("OK") >= 0) return true;
   return false;
 }
 
-// Parse and handle messages returned by AT+CMGL
-static void processSmsListResponse(const String &resp) {
-  int idx = 0;
-  while (true) {
-    int pos = resp.indexOf("\n+CMGL:", idx);
-    if (pos < 0) {
-      if (idx == 0) pos = resp.indexOf("+CMGL:");
-      if (pos < 0) break;
-    }
-    int eol = resp.indexOf('\n', pos+1);
-    if (eol < 0) break;
-    String header = resp.substring(pos, eol);
-    int cidx = -1;
-    {
-      int p1 = header.indexOf(':');
-      int p2 = header.indexOf(',');
-      if (p1 >= 0 && p2 > p1) {
-        String sidx = header.substring(p1+1, p2);
-        sidx.trim();
-        cidx = sidx.toInt();
-      }
-    }
-    int bodyStart = eol + 1;
-    int nextHeader = resp.indexOf("\n+CMGL:", bodyStart);
-    if (nextHeader < 0) nextHeader = resp.length();
-    String body = resp.substring(bodyStart, nextHeader);
-    body.trim();
-    if (body.length() == 0) {
-      idx = nextHeader;
-      continue;
-    }
-    Serial.print("[SMS] Msg idx="); Serial.print(cidx); Serial.print(" body='"); Serial.print(body); Serial.println("'");
-    String u = body;
-    u.toUpperCase();
-    bool handled = false;
-
-    // Support GEO:city,country messages only; ignore API key commands
-    if (u.startsWith("GEO:")) {
-      int colon = body.indexOf(':');
-      String payload = (colon>=0) ? body.substring(colon+1) : "";
-      payload.trim();
-      int comma = payload.indexOf(',');
-      String city = payload;
-      String country = "";
-      if (comma >= 0) {
-        city = payload.substring(0, comma);
-        country = payload.substring(comma+1);
-      }
-      city.trim();
-      country.trim();
-      if (city.length() > 0) {
-        if (weather_geocodeLocation(city.c_str(), country.length() ? country.c_str() : nullptr)) {
-          Serial.println("[SMS] Geocode stored from SMS");
-          int q1 = header.indexOf('"', header.indexOf(',')+1);
-          int q2 = -1;
-          if (q1 >= 0) q2 = header.indexOf('"', q1+1);
-          String from = "";
-          if (q1 >= 0 && q2 > q1) from = header.substring(q1+1, q2);
-          if (from.length()) sms_send(from, "OK: Geocode stored");
-          handled = true;
-        } else {
-          Serial.print("[SMS] Geocode failed: ");
-          Serial.println(weather_getLastError());
-        }
-      }
-    } else {
-      Serial.println("[SMS] Unknown or unsupported command in SMS");
-    }
+static bool takeReplyToken() {
+  unsigned long now = millis();
+  unsigned long refill = SMS_REPLY_REFILL_S * 1000UL;
+  while (s_tokens < SMS_REPLY_BURST && now - s_tokenMs >= refill) {
+    s_tokens++;
+    s_tokenMs += refill;
+  }
+  if (s_tokens >= SMS_REPLY_BURST) s_tokenMs = now;
+  if (s_tokens == 0) return false;
+  s_tokens--;
+  return true;
+}
+
+// One message: from = sender number, body = NUL-terminated text (may be modified)
+static void handleMessage(const char *from, char *body) {
+  Serial.printf("[SMS] from=%s body='%s'\n", from, body);
+
+  const SmsCommand *cmd = nullptr;
+  for (const SmsCommand &c : COMMANDS) {
+    if (strncasecmp(body, c.prefix, strlen(c.prefix)) == 0) { cmd = &c; break; }
+  }
+  if (!cmd) {
+    Serial.println("[SMS] Unknown or unsupported command in SMS");
+    return;
+  }
+
+  if (!*from || !senderAllowed(from, cmd->writes)) {
+    s_denied++;
+    Serial.println("[SMS] Sender not on the allow-list, ignored");
+    return;
+  }
 
-    if (cidx >= 0) {
-      char cmd[32];
-      snprintf(cmd, sizeof(cmd), "+CMGD=%d", cidx);
-      TinyGsm &modem = modem_get();
-      modem.sendAT(cmd);
-      modem.waitResponse(2000);
+  char reply[161];
+  reply[0] = 0;
+  if (!cmd->fn(body + strlen(cmd->prefix), reply, sizeof(reply)) || !reply[0]) return;
+  if (!takeReplyToken()) {
+    s_throttled++;
+    Serial.printf("[SMS] Reply rate limited: %s\n", reply);
+    return;
+  }
+  sms_send(from, reply);
+}
+
+// Walk the CMGL reply in place: "+CMGL: <idx>,"<stat>","<from>",...\n<body lines>..."
+// Received messages handled go to s_del[]. Returns false if some were left for the
+// next listing (batch full). A cut-off last body is left on the SIM, or deleted
+// unhandled once the retries are used up.
+static bool processSmsList(char *list) {
+  s_delCount = s_delNext = 0;
+  char *p = strstr(list, "+CMGL:");
+  while (p) {
+    if (s_delCount >= SMS_MAX_BATCH) return false;
+    char *hdrEnd = strchr(p, '\n');
+    if (!hdrEnd) break;   // header without body: cut off by truncation
+    *hdrEnd = 0;
+    char *body = hdrEnd + 1;
+
+    // Body runs to the next header line (bodies may contain newlines)
+    char *next = strstr(body, "\n+CMGL:");
+    if (next) *next++ = 0;
+    bool cut = !next && s_listTruncated;
+    if (cut && s_listRetries < SMS_LIST_RETRIES) break;   // leave it for the next pass
+
+    int idx = atoi(p + 6);
+    char stat[16], from[24];
+    if (!quotedField(p, 0, stat, sizeof(stat))) stat[0] = 0;
+    if (!quotedField(p, 1, from, sizeof(from))) from[0] = 0;
+
+    s_msgCount++;
+    trimInPlace(body);
+    if (strncmp(stat, "REC", 3) == 0) {
+      s_del[s_delCount++] = idx;
+      if (cut) {
+        s_cutDropped++;
+        Serial.printf("[SMS] Deleting message %d unhandled: body always cut off\n", idx);
+      } else if (*body) {
+        handleMessage(from, body);
+      }
     }
 
-    idx = nextHeader;
-  } // while
+    p = next;
+  }
+  return true;
 }
 
 void sms_loop() {
-  if (millis() - s_lastCheck < SMS_CHECK_INTERVAL) return;
-  s_lastCheck = millis();
+  if (s_listReady) {
+    s_listReady = false;
+    s_listCount++;
+    bool more = !processSmsList(s_list) || s_listTruncated;
+    if (!more || s_delCount > 0) {
+      // done, or progress made: list the rest straight away
+      s_listRetries = 0;
+      s_listDelay = 0;
+      if (more) s_newMsg = true;
+    } else if (s_listRetries < SMS_LIST_RETRIES) {
+      s_listDelay = SMS_LIST_RETRY_MS << s_listRetries++;
+      s_newMsg = true;
+      Serial.printf("[SMS] Listing cut off, retry in %lus\n", s_listDelay / 1000UL);
+    } else {
+      // nothing listable at all (the modem keeps timing out): back to the slow poll
+      s_listRetries = 0;
+      s_listDelay = 0;
+      Serial.println("[SMS] Listing keeps failing, waiting for the fallback poll");
+    }
+    if (s_delCount == 0) {
+      if (!s_newMsg) Serial.println("[SMS] No stored messages");
+      modem_release(MODEM_LEASE_SMS);
+    }
+  }
 
-  TinyGsm &modem = modem_get();
-  Serial.println("[SMS] Checking unread messages...");
-  modem.sendAT("+CMGF=1");
-  modem.waitResponse(1000);
+  // Delete what was handled, leaving queue room for other users of the engine. The
+  // lease is kept until the last delete is queued; power-down waits for the queue.
+  if (s_delNext < s_delCount) {
+    while (s_delNext < s_delCount && at_queued() < AT_QUEUE_LEN - 2) {
+      char cmd[20];
+      snprintf(cmd, sizeof(cmd), "+CMGD=%d", s_del[s_delNext]);
+      if (!at_submit(cmd, 2000, nullptr, nullptr)) break;
+      s_delNext++;
+    }
+    if (s_delNext < s_delCount) return;
+    s_delCount = s_delNext = 0;
+    modem_release(MODEM_LEASE_SMS);
+  }
 
-  modem.sendAT("+CMGL=\"REC UNREAD\"");
-  String resp = modemReadResponse(3000);
-  Serial.print("[SMS] CMGL response: "); Serial.println(resp);
+  if (s_listPending || !at_isStarted() || !modem_isOn()) return;
+  if (s_listDelay && millis() - s_lastList < s_listDelay) return;
+  if (!s_newMsg && millis() - s_lastList < SMS_FALLBACK_INTERVAL) return;
+  if (at_queued() > AT_QUEUE_LEN - 3) return;   // deletes still draining
 
-  if (resp.indexOf("+CMGL:") >= 0) {
-    processSmsListResponse(resp);
-  } else {
-    Serial.println("[SMS] No unread messages");
+  s_newMsg = false;
+  s_lastList = millis();
+  modem_acquire(MODEM_LEASE_SMS);
+  power_acquire(PWR_LOCK_UART);
+  // CMGF is volatile across modem resets; queue it ahead of the listing
+  at_submit("+CMGF=1", 1000, nullptr, nullptr);
+  if (!at_submit("+CMGL=\"ALL\"", 5000, onCmgl, nullptr)) {
+    power_release(PWR_LOCK_UART);
+    modem_release(MODEM_LEASE_SMS);
+    s_newMsg = true;
+    return;
   }
-}
\ No newline at end of file
+  s_listPending = true;
+}
+
+void sms_printStats() {
+  Serial.printf("[SMS] cmti=%lu listings=%lu messages=%lu denied=%lu throttled=%lu cut=%lu\n",
+                (unsigned long)s_cmtiCount, (unsigned long)s_listCount, (unsigned long)s_msgCount,
+                (unsigned long)s_denied, (unsigned long)s_throttled, (unsigned long)s_cutDropped);
+}
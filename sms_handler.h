@@ -6,7 +6,15 @@
 // Initialize SMS handler (call during setup after modemManager_init).
 void sms_init();
 
-// Call periodically from loop() to check for unread messages and process them.
+// Call periodically from loop(). Lists and processes stored messages after a +CMTI
+// new-message URC, or on a slow fallback poll.
 void sms_loop();
 
+// Send one text SMS (AT+CMGS, blocks until the modem confirms). number in
+// international format. Returns false when the modem is not up or refused it.
+bool sms_send(const char *number, const char *message);
+
+// URC / listing / message counters since boot
+void sms_printStats();
+
 #endif // SMS_HANDLER_H
\ No newline at end of file
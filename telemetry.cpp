@@ -0,0 +1,364 @@
+// telemetry.cpp
+// - Batched MQTT uplink with an offline store-and-forward queue.
+// - Backpressure: at most one batch is in flight; QoS1 publish blocks until PUBACK
+//   (MQTT_CMD_TIMEOUT_MS) and the records are popped only after it. A failed publish or
+//   connect backs off exponentially (TELEMETRY_RETRY_MIN_S..TELEMETRY_RETRY_MAX_S).
+// - Publishing starts when a full batch is waiting, when the oldest record has waited
+//   the flush age, or on telemetry_flush(); it then continues until the queue is empty.
+//   Batch size and flush age come from settings.h (TELEMETRY_BATCH_MAX / _FLUSH_S default).
+// - Payload: compact binary batch (telemetry_codec, TELEMETRY_FORMAT_BINARY) or JSON
+//   {"v":1,"id":"<dev>","r":[[ts,w,ti,hi,te,he,p,ax,ay,az,bv,bp,rssi],...]}. The first byte
+//   tells them apart ('{' vs. the codec version).
+// - Binary batches are deltas against the last record the broker acknowledged (PUBACK).
+//   A keyframe is sent first after boot, every TELEMETRY_KEYFRAME_EVERY batches, and when
+//   "keyframe" is published to "<prefix>/<dev>/cmd" (e.g. after the server lost its state).
+// - Batch seqs keep increasing across reboots, so a receiver can drop QoS1 redeliveries
+//   by seq: NVS holds the end of a reserved block of TELEMETRY_SEQ_BLOCK seqs and a boot
+//   continues after it (a few numbers are skipped, the flash sees one write per block).
+// - A batch is encoded once and its bytes are resent unchanged until PUBACK, so a seq
+//   never names two different payloads: a retry after a lost PUBACK is an exact duplicate
+//   the receiver can drop. If the queue head changed meanwhile (fallback to RAM dropped
+//   records) the batch is re-encoded as a keyframe under a new seq.
+#include "telemetry.h"
+#include "telemetry_queue.h"
+#include "telemetry_codec.h"
+#include "config.h"
+#include "net_transport.h"
+#include "power_manager.h"
+#include "settings.h"
+#include <MQTT.h>
+#include <Preferences.h>
+
+static const int PAYLOAD_MAX = 1024;
+
+static MQTTClient   s_mqtt(PAYLOAD_MAX + 128);
+static NetTransport s_net = NET_NONE;
+
+static char s_devId[13];
+static char s_topic[64];
+static char s_cmdTopic[64];
+static char s_alertTopic[64];
+static char s_payload[PAYLOAD_MAX];
+
+static bool s_draining = false;
+static bool s_flushRequested = false;
+static unsigned long s_oldestQueuedMs = 0;     // when the queue last went non-empty
+static unsigned long s_nextTryMs = 0;
+static unsigned long s_backoffMs = 0;
+
+// Delta reference: last record of the last acknowledged batch
+static TelemetrySnapshot s_acked;
+static uint32_t s_seq = 1;                 // seq of the batch in flight, else of the next one
+static uint32_t s_seqLimit = 0;            // end of the block reserved in NVS
+static uint32_t s_batchesSinceKey = 0;
+static bool s_keyRequested = false;
+static bool s_lastWasKey = false;
+
+// Batch in flight: s_payload holds its encoding until the PUBACK (n == 0: none)
+static struct {
+  int         n;
+  int         len;
+  bool        key;
+  Measurement first, last;
+} s_pin;
+
+// Stats
+static uint32_t s_batches = 0;
+static uint32_t s_records = 0;
+static uint32_t s_bytes = 0;
+static uint32_t s_failures = 0;
+static uint32_t s_connects = 0;
+static uint32_t s_publishMsTotal = 0;
+static uint32_t s_publishMsMax = 0;
+static unsigned long s_drainStartMs = 0;
+static uint32_t s_drainStartCount = 0;
+// Encoding cost: binary vs. the JSON the same batches would have needed
+static uint32_t s_binBytes = 0;
+static uint32_t s_jsonBytes = 0;
+static uint32_t s_binEncodeUs = 0;
+static uint32_t s_jsonEncodeUs = 0;
+static uint32_t s_keyframes = 0;
+static uint32_t s_keyBytes = 0;
+static uint32_t s_deltas = 0;
+static uint32_t s_deltaBytes = 0;
+
+// ---------------------------------------------------------------------------
+// Connection (transport chosen by net_transport: WiFi or the LTE data link)
+// ---------------------------------------------------------------------------
+static bool ensureConnected() {
+  NetTransport t = netTransport_select();
+  if (t == NET_NONE) return false;
+  if (s_mqtt.connected() && t == s_net) return true;
+
+  Client *c = netTransport_plainClient(t);
+  if (!c) return false;
+  if (s_mqtt.connected()) s_mqtt.disconnect();
+  s_net = t;
+  s_mqtt.begin(MQTT_HOST, MQTT_PORT, *c);
+  s_mqtt.setOptions(MQTT_KEEPALIVE_S, true, MQTT_CMD_TIMEOUT_MS);
+
+  unsigned long t0 = millis();
+  bool ok = s_mqtt.connect(s_devId, MQTT_USER[0] ? MQTT_USER : nullptr, MQTT_PASS[0] ? MQTT_PASS : nullptr);
+  netTransport_recordConnect(t, millis() - t0, ok);
+  if (!ok) {
+    Serial.printf("[Telemetry] MQTT connect failed (%s): err=%d rc=%d\n",
+                  netTransport_name(t), (int)s_mqtt.lastError(), (int)s_mqtt.returnCode());
+    return false;
+  }
+  s_connects++;
+  s_mqtt.subscribe(s_cmdTopic, 1);
+  Serial.printf("[Telemetry] MQTT connected over %s\n", netTransport_name(t));
+  return true;
+}
+
+static void backoff() {
+  s_failures++;
+  s_backoffMs = s_backoffMs ? s_backoffMs * 2 : TELEMETRY_RETRY_MIN_S * 1000UL;
+  if (s_backoffMs > TELEMETRY_RETRY_MAX_S * 1000UL) s_backoffMs = TELEMETRY_RETRY_MAX_S * 1000UL;
+  s_nextTryMs = millis() + s_backoffMs;
+}
+
+// ---------------------------------------------------------------------------
+// Payload
+// ---------------------------------------------------------------------------
+static int encodeBatchJson(const Measurement *r, int n) {
+  size_t len = telemetryCodec_encodeJson(r, n, s_devId, s_payload, sizeof(s_payload));
+  return len ? (int)len : -1;
+}
+
+// Sizes and encode times of the last encodeBatch(), added to the totals once it is sent
+static struct {
+  int      bin, json;
+  uint32_t binUs, jsonUs;
+} s_enc;
+
+// Encode in the configured format; the other one is measured for the size/time comparison
+static int encodeBatch(const Measurement *r, int n) {
+  unsigned long t0 = micros();
+  int json = encodeBatchJson(r, n);
+  unsigned long t1 = micros();
+  s_enc.json = json;
+  s_enc.jsonUs = t1 - t0;
+  s_enc.bin = 0;
+#if TELEMETRY_FORMAT == TELEMETRY_FORMAT_BINARY
+  s_lastWasKey = !s_acked.valid || s_keyRequested || s_batchesSinceKey >= TELEMETRY_KEYFRAME_EVERY;
+  int bin = (int)telemetryCodec_encode(r, n, s_seq, s_lastWasKey ? nullptr : &s_acked,
+                                       (uint8_t*)s_payload, sizeof(s_payload));
+  s_enc.binUs = micros() - t1;
+  if (bin == 0) return -1;
+  s_enc.bin = bin;
+  return bin;
+#else
+  return json;
+#endif
+}
+
+// Persist the end of the next block before any seq from it goes out
+static void reserveSeqBlock() {
+  Preferences p;
+  p.begin("telemetry", false);
+  if (s_seqLimit == 0) s_seq = p.getUInt("seq", 0) + 1;
+  s_seqLimit = s_seq + TELEMETRY_SEQ_BLOCK;
+  p.putUInt("seq", s_seqLimit - 1);
+  p.end();
+}
+
+static void nextSeq() {
+  if (++s_seq >= s_seqLimit) reserveSeqBlock();
+}
+
+// A pinned batch may only be resent while the queue still starts with its records
+static bool pinStillQueued() {
+  Measurement head[TELEMETRY_BATCH_MAX];
+  int n = telemetryQueue_peek(head, s_pin.n);
+  return n == s_pin.n && memcmp(&head[0], &s_pin.first, sizeof(Measurement)) == 0 &&
+         memcmp(&head[n - 1], &s_pin.last, sizeof(Measurement)) == 0;
+}
+
+// Publish the oldest batch; records leave the queue only after PUBACK
+static bool publishBatch() {
+  if (s_pin.n && !pinStillQueued()) {
+    Serial.printf("[Telemetry] queue changed under batch seq %lu, re-encoding as a keyframe\n",
+                  (unsigned long)s_seq);
+    s_pin.n = 0;
+    nextSeq();
+    s_keyRequested = true;
+  }
+
+  if (s_pin.n == 0) {
+    Measurement batch[TELEMETRY_BATCH_MAX];
+    int n = telemetryQueue_peek(batch, settings_get().batchMax);
+    if (n == 0) return true;
+
+    int len = encodeBatch(batch, n);
+    while (len < 0 && n > 1) len = encodeBatch(batch, --n);   // shrink until it fits
+    if (len < 0) return false;
+    s_pin.n = n;
+    s_pin.len = len;
+    s_pin.key = s_lastWasKey;
+    s_pin.first = batch[0];
+    s_pin.last = batch[n - 1];
+  }
+  int n = s_pin.n;
+  int len = s_pin.len;
+
+  unsigned long t0 = millis();
+  bool ok = s_mqtt.publish(s_topic, s_payload, len, false, 1);
+  uint32_t ms = millis() - t0;
+  if (!ok) {
+    Serial.printf("[Telemetry] publish of %d records (seq %lu) failed: err=%d\n", n,
+                  (unsigned long)s_seq, (int)s_mqtt.lastError());
+    return false;
+  }
+  s_pin.n = 0;
+
+  telemetryQueue_pop(n);
+  netTransport_addBytes(s_net, len, 0);
+  // only the encoding that went out counts, not the attempts the shrink loop discarded
+  if (s_enc.bin > 0) { s_binBytes += s_enc.bin; s_binEncodeUs += s_enc.binUs; }
+  if (s_enc.json > 0) { s_jsonBytes += s_enc.json; s_jsonEncodeUs += s_enc.jsonUs; }
+#if TELEMETRY_FORMAT == TELEMETRY_FORMAT_BINARY
+  // acknowledged: this batch's last record is the reference for the next delta
+  telemetryCodec_snapshot(s_pin.last, s_seq, s_acked);
+  if (s_pin.key) {
+    s_keyframes++;
+    s_keyBytes += len;
+    s_batchesSinceKey = 0;
+    s_keyRequested = false;
+  } else {
+    s_deltas++;
+    s_deltaBytes += len;
+    s_batchesSinceKey++;
+  }
+#endif
+  nextSeq();
+  s_batches++;
+  s_records += n;
+  s_bytes += len;
+  s_publishMsTotal += ms;
+  if (ms > s_publishMsMax) s_publishMsMax = ms;
+  return true;
+}
+
+// Commands from the server on the cmd topic
+static void onCommand(String &topic, String &payload) {
+  (void)topic;
+  payload.trim();
+  if (payload.equalsIgnoreCase("keyframe")) {
+    Serial.println("[Telemetry] keyframe requested by server");
+    telemetry_requestKeyframe();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void telemetry_init() {
+  uint64_t mac = ESP.getEfuseMac();
+  snprintf(s_devId, sizeof(s_devId), "%04X%08lX", (unsigned)(mac >> 32) & 0xFFFF, (unsigned long)mac);
+  snprintf(s_topic, sizeof(s_topic), "%s/%s/telemetry", MQTT_TOPIC_PREFIX, s_devId);
+  snprintf(s_cmdTopic, sizeof(s_cmdTopic), "%s/%s/cmd", MQTT_TOPIC_PREFIX, s_devId);
+  snprintf(s_alertTopic, sizeof(s_alertTopic), "%s/%s/alert", MQTT_TOPIC_PREFIX, s_devId);
+  s_mqtt.onMessage(onCommand);
+  telemetryQueue_init();
+  reserveSeqBlock();
+  if (telemetryQueue_count()) s_oldestQueuedMs = millis();
+  Serial.printf("[Telemetry] topic %s, %lu queued, seq %lu\n", s_topic,
+                (unsigned long)telemetryQueue_count(), (unsigned long)s_seq);
+}
+
+void telemetry_enqueue(const Measurement &m) {
+  if (telemetryQueue_count() == 0) s_oldestQueuedMs = millis();
+  telemetryQueue_push(m);
+}
+
+void telemetry_flush() { s_flushRequested = true; }
+
+void telemetry_requestKeyframe() { s_keyRequested = true; }
+
+void telemetry_loop() {
+#if TELEMETRY_ENABLED
+  unsigned long now = millis();
+  if (s_mqtt.connected()) s_mqtt.loop();
+
+  uint32_t pending = telemetryQueue_count();
+  if (pending == 0) {
+    if (s_draining && s_records > s_drainStartCount) {
+      unsigned long ms = now - s_drainStartMs;
+      Serial.printf("[Telemetry] queue drained: %lu records in %lu ms\n",
+                    (unsigned long)(s_records - s_drainStartCount), ms);
+    }
+    s_draining = false;
+    s_flushRequested = false;
+    return;
+  }
+
+  if (!s_draining) {
+    const Settings &st = settings_get();
+    bool due = pending >= st.batchMax || s_flushRequested ||
+               now - s_oldestQueuedMs >= st.flushS * 1000UL;
+    if (!due) return;
+    s_draining = true;
+    s_drainStartMs = now;
+    s_drainStartCount = s_records;
+  }
+  if ((long)(now - s_nextTryMs) < 0) return;
+
+  power_acquire(PWR_LOCK_NET);
+  bool ok = ensureConnected() && publishBatch();
+  power_release(PWR_LOCK_NET);
+
+  if (ok) {
+    s_backoffMs = 0;
+  } else {
+    if (s_mqtt.connected()) s_mqtt.disconnect();
+    backoff();
+  }
+#endif
+}
+
+bool telemetry_publishAlert(const char *text) {
+#if TELEMETRY_ENABLED
+  // Respect the reconnect backoff; the caller escalates to SMS instead of waiting
+  if (!s_mqtt.connected() && (long)(millis() - s_nextTryMs) < 0) return false;
+  int len = (int)strlen(text);
+  power_acquire(PWR_LOCK_NET);
+  bool ok = ensureConnected() && s_mqtt.publish(s_alertTopic, text, len, false, 1);
+  power_release(PWR_LOCK_NET);
+  if (ok) netTransport_addBytes(s_net, len, 0);
+  else Serial.printf("[Telemetry] alert publish failed: err=%d\n", (int)s_mqtt.lastError());
+  return ok;
+#else
+  (void)text;
+  return false;
+#endif
+}
+
+bool telemetry_isConnected() { return s_mqtt.connected(); }
+uint32_t telemetry_pending() { return telemetryQueue_count(); }
+const char *telemetry_deviceId() { return s_devId; }
+
+void telemetry_printStats() {
+  Serial.printf("[Telemetry] %lu records in %lu batches, %lu bytes, %lu connects, %lu failures\n",
+                (unsigned long)s_records, (unsigned long)s_batches, (unsigned long)s_bytes,
+                (unsigned long)s_connects, (unsigned long)s_failures);
+  if (s_batches) {
+    Serial.printf("[Telemetry] publish+PUBACK avg %lu ms, max %lu ms, %lu bytes/record\n",
+                  (unsigned long)(s_publishMsTotal / s_batches), (unsigned long)s_publishMsMax,
+                  (unsigned long)(s_bytes / s_records));
+  }
+  if (s_keyframes || s_deltas) {
+    Serial.printf("[Telemetry] %lu keyframes (avg %lu B), %lu deltas (avg %lu B)\n",
+                  (unsigned long)s_keyframes, (unsigned long)(s_keyframes ? s_keyBytes / s_keyframes : 0),
+                  (unsigned long)s_deltas, (unsigned long)(s_deltas ? s_deltaBytes / s_deltas : 0));
+  }
+  if (s_binBytes && s_jsonBytes) {
+    Serial.printf("[Telemetry] binary %lu B (%lu us) vs JSON %lu B (%lu us): %lu%% of JSON size\n",
+                  (unsigned long)s_binBytes, (unsigned long)s_binEncodeUs,
+                  (unsigned long)s_jsonBytes, (unsigned long)s_jsonEncodeUs,
+                  (unsigned long)(s_binBytes * 100UL / s_jsonBytes));
+  }
+  Serial.printf("[Telemetry] queue: %lu pending, %lu dropped, %s\n",
+                (unsigned long)telemetryQueue_count(), (unsigned long)telemetryQueue_dropped(),
+                telemetryQueue_isPersistent() ? "SD" : "RAM");
+}
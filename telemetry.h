@@ -0,0 +1,42 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "measurement.h"
+
+// MQTT telemetry uplink.
+// Measurements are queued (telemetry_queue) and published in batches of up to
+// TELEMETRY_BATCH_MAX records with QoS1 to "<MQTT_TOPIC_PREFIX>/<device id>/telemetry".
+// A batch is removed from the queue only after the broker's PUBACK, so records captured
+// while offline are drained on reconnect, one batch per telemetry_loop() call.
+// Transport: chosen by net_transport (connectivityMode: WiFi and/or the A7670 LTE link).
+// Payload format: TELEMETRY_FORMAT (binary telemetry_codec batches by default, JSON optional).
+// Binary batches are deltas against the last acknowledged record, with periodic keyframes.
+
+// Open the queue and configure the MQTT client (call from setup, after SD and modem init)
+void telemetry_init();
+
+// Queue a measurement for upload
+void telemetry_enqueue(const Measurement &m);
+
+// Connect / publish / back off as needed (call from loop; returns quickly when idle)
+void telemetry_loop();
+
+// Publish everything pending on the next telemetry_loop() calls, ignoring TELEMETRY_FLUSH_S
+void telemetry_flush();
+
+// Send the next batch as a full keyframe instead of a delta
+void telemetry_requestKeyframe();
+
+// Publish one alert message (QoS1) to "<MQTT_TOPIC_PREFIX>/<device id>/alert" right away.
+// Returns false when the broker is unreachable or still in reconnect backoff.
+bool telemetry_publishAlert(const char *text);
+
+bool     telemetry_isConnected();
+uint32_t telemetry_pending();
+const char *telemetry_deviceId();
+
+// Throughput / drain counters since boot
+void telemetry_printStats();
+
+#endif // TELEMETRY_H
@@ -0,0 +1,235 @@
+// telemetry_codec.cpp
+// - Versioned fixed-point + varint encoding of Measurement batches (see telemetry_codec.h).
+// - Keyframes carry every field; delta batches carry only fields that moved since the
+//   acknowledged snapshot, so flat readings cost ~3 bytes per record.
+// - Pure C++ (no Arduino calls) so it also compiles on a host.
+#include "telemetry_codec.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// NaN and values past int32 would make lroundf undefined: map them before rounding
+static int32_t q(float v, float scale) {
+  if (isnan(v)) return TC_Q_NAN;
+  float s = v * scale;
+  if (s >= 2147483520.0f) return INT32_MAX;          // largest float below 2^31
+  if (s <= -2147483520.0f) return INT32_MIN + 1;     // INT32_MIN is the NaN sentinel
+  return (int32_t)lroundf(s);
+}
+
+// Delta arithmetic modulo 2^32 (no signed overflow with the sentinel)
+static int32_t qSub(int32_t a, int32_t b) { return (int32_t)((uint32_t)a - (uint32_t)b); }
+static int32_t qAdd(int32_t a, int32_t b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+
+int32_t telemetryCodec_quantize(const Measurement &m, int field) {
+  switch (field) {
+    case TF_WEIGHT:   return q(m.weight, 100.0f);
+    case TF_TEMP_INT: return q(m.temp_int, 100.0f);
+    case TF_HUM_INT:  return q(m.hum_int, 10.0f);
+    case TF_TEMP_EXT: return q(m.temp_ext, 100.0f);
+    case TF_HUM_EXT:  return q(m.hum_ext, 10.0f);
+    case TF_PRESSURE: return q(m.pressure, 10.0f);
+    case TF_ACC_X:    return q(m.acc_x, 1000.0f);
+    case TF_ACC_Y:    return q(m.acc_y, 1000.0f);
+    case TF_ACC_Z:    return q(m.acc_z, 1000.0f);
+    case TF_BATT_V:   return q(m.batt_voltage, 1000.0f);
+    case TF_BATT_PCT: return m.batt_percent;
+    case TF_RSSI:     return m.rssi;
+    default:          return 0;
+  }
+}
+
+void telemetryCodec_dequantize(Measurement &m, int field, int32_t v) {
+  float x = v == TC_Q_NAN ? NAN : (float)v;   // NaN / scale stays NaN
+  switch (field) {
+    case TF_WEIGHT:   m.weight = x / 100.0f; break;
+    case TF_TEMP_INT: m.temp_int = x / 100.0f; break;
+    case TF_HUM_INT:  m.hum_int = x / 10.0f; break;
+    case TF_TEMP_EXT: m.temp_ext = x / 100.0f; break;
+    case TF_HUM_EXT:  m.hum_ext = x / 10.0f; break;
+    case TF_PRESSURE: m.pressure = x / 10.0f; break;
+    case TF_ACC_X:    m.acc_x = x / 1000.0f; break;
+    case TF_ACC_Y:    m.acc_y = x / 1000.0f; break;
+    case TF_ACC_Z:    m.acc_z = x / 1000.0f; break;
+    case TF_BATT_V:   m.batt_voltage = x / 1000.0f; break;
+    case TF_BATT_PCT: m.batt_percent = v; break;
+    case TF_RSSI:     m.rssi = v; break;
+    default: break;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Varints
+// ---------------------------------------------------------------------------
+size_t telemetryCodec_putVarint(uint8_t *buf, size_t cap, uint32_t v) {
+  size_t n = 0;
+  do {
+    if (n >= cap) return 0;
+    uint8_t b = v & 0x7F;
+    v >>= 7;
+    buf[n++] = v ? (b | 0x80) : b;
+  } while (v);
+  return n;
+}
+
+size_t telemetryCodec_putSVarint(uint8_t *buf, size_t cap, int32_t v) {
+  uint32_t zz = ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+  return telemetryCodec_putVarint(buf, cap, zz);
+}
+
+size_t telemetryCodec_getVarint(const uint8_t *buf, size_t len, uint32_t &v) {
+  v = 0;
+  for (size_t n = 0; n < len && n < 5; ++n) {
+    v |= (uint32_t)(buf[n] & 0x7F) << (7 * n);
+    if (!(buf[n] & 0x80)) return n + 1;
+  }
+  return 0;
+}
+
+size_t telemetryCodec_getSVarint(const uint8_t *buf, size_t len, int32_t &v) {
+  uint32_t zz;
+  size_t n = telemetryCodec_getVarint(buf, len, zz);
+  v = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+  return n;
+}
+
+// ---------------------------------------------------------------------------
+// Batches
+// ---------------------------------------------------------------------------
+#define PUT(fn, v) do { size_t w_ = fn(buf + pos, cap - pos, v); if (!w_) return 0; pos += w_; } while (0)
+#define GET(fn, v) do { size_t r_ = fn(buf + pos, len - pos, v); if (!r_) return -1; pos += r_; } while (0)
+
+void telemetryCodec_snapshot(const Measurement &m, uint32_t seq, TelemetrySnapshot &out) {
+  out.valid = true;
+  out.seq = seq;
+  out.timestamp = m.timestamp;
+  for (int f = 0; f < TF_COUNT; ++f) out.q[f] = telemetryCodec_quantize(m, f);
+}
+
+size_t telemetryCodec_encode(const Measurement *recs, int n, uint32_t seq,
+                             const TelemetrySnapshot *base, uint8_t *buf, size_t cap) {
+  if (n <= 0 || cap < 2) return 0;
+  bool key = !base || !base->valid;
+  size_t pos = 0;
+  buf[pos++] = TELEMETRY_CODEC_VERSION;
+  buf[pos++] = key ? TC_FLAG_KEYFRAME : 0;
+  PUT(telemetryCodec_putVarint, seq);
+  if (!key) PUT(telemetryCodec_putVarint, base->seq);
+  PUT(telemetryCodec_putVarint, (uint32_t)n);
+
+  if (key) {
+    PUT(telemetryCodec_putVarint, recs[0].timestamp);
+    uint32_t prevTs = recs[0].timestamp;
+    for (int i = 0; i < n; ++i) {
+      PUT(telemetryCodec_putSVarint, (int32_t)(recs[i].timestamp - prevTs));
+      prevTs = recs[i].timestamp;
+      for (int f = 0; f < TF_COUNT; ++f) PUT(telemetryCodec_putSVarint, telemetryCodec_quantize(recs[i], f));
+    }
+    return pos;
+  }
+
+  for (int i = 0; i < n; ++i) {
+    int32_t d[TF_COUNT];
+    uint32_t mask = 0;
+    for (int f = 0; f < TF_COUNT; ++f) {
+      d[f] = qSub(telemetryCodec_quantize(recs[i], f), base->q[f]);
+      if (d[f]) mask |= 1UL << f;
+    }
+    PUT(telemetryCodec_putSVarint, (int32_t)(recs[i].timestamp - base->timestamp));
+    PUT(telemetryCodec_putVarint, mask);
+    for (int f = 0; f < TF_COUNT; ++f) if (mask & (1UL << f)) PUT(telemetryCodec_putSVarint, d[f]);
+  }
+  return pos;
+}
+
+size_t telemetryCodec_encodeJson(const Measurement *recs, int n, const char *devId,
+                                 char *buf, size_t cap) {
+  int len = snprintf(buf, cap, "{\"v\":1,\"id\":\"%s\",\"r\":[", devId);
+  for (int i = 0; i < n && len < (int)cap; ++i) {
+    const Measurement &m = recs[i];
+    len += snprintf(buf + len, cap - len,
+                    "%s[%lu,%.3f,%.2f,%.1f,%.2f,%.1f,%.1f,%.3f,%.3f,%.3f,%.3f,%d,%d]",
+                    i ? "," : "", (unsigned long)m.timestamp, m.weight, m.temp_int, m.hum_int,
+                    m.temp_ext, m.hum_ext, m.pressure, m.acc_x, m.acc_y, m.acc_z,
+                    m.batt_voltage, m.batt_percent, m.rssi);
+  }
+  len += snprintf(buf + len, len < (int)cap ? cap - len : 0, "]}");
+  return len > 0 && len < (int)cap ? (size_t)len : 0;
+}
+
+// Version 1 batches: keyframe layout without sequence numbers
+static int decodeV1(const uint8_t *buf, size_t len, Measurement *out, int max) {
+  size_t pos = 2;
+  uint32_t count, ts;
+  GET(telemetryCodec_getVarint, count);
+  GET(telemetryCodec_getVarint, ts);
+  int n = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    Measurement m;
+    memset(&m, 0, sizeof(m));
+    int32_t v;
+    GET(telemetryCodec_getSVarint, v);
+    ts += (uint32_t)v;
+    m.timestamp = ts;
+    for (int f = 0; f < TF_COUNT; ++f) {
+      GET(telemetryCodec_getSVarint, v);
+      telemetryCodec_dequantize(m, f, v);
+    }
+    if (n < max) out[n++] = m;
+  }
+  return n;
+}
+
+int telemetryCodec_decode(const uint8_t *buf, size_t len, Measurement *out, int max,
+                          TelemetrySnapshot *base) {
+  if (len < 2) return -1;
+  if (buf[0] == 1) return decodeV1(buf, len, out, max);
+  if (buf[0] != TELEMETRY_CODEC_VERSION) return -1;
+
+  bool key = buf[1] & TC_FLAG_KEYFRAME;
+  size_t pos = 2;
+  uint32_t seq, baseSeq = 0, count;
+  GET(telemetryCodec_getVarint, seq);
+  if (base && base->valid && seq <= base->seq) return 0;   // already decoded
+  if (!key) {
+    GET(telemetryCodec_getVarint, baseSeq);
+    if (!base || !base->valid || base->seq != baseSeq) return -1;
+  }
+  GET(telemetryCodec_getVarint, count);
+
+  int n = 0;
+  int32_t q[TF_COUNT];
+  uint32_t ts = 0;
+  if (key) GET(telemetryCodec_getVarint, ts);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    int32_t v;
+    GET(telemetryCodec_getSVarint, v);
+    if (key) {
+      ts += (uint32_t)v;
+      for (int f = 0; f < TF_COUNT; ++f) GET(telemetryCodec_getSVarint, q[f]);
+    } else {
+      ts = base->timestamp + (uint32_t)v;
+      uint32_t mask;
+      GET(telemetryCodec_getVarint, mask);
+      for (int f = 0; f < TF_COUNT; ++f) {
+        q[f] = base->q[f];
+        if (mask & (1UL << f)) { GET(telemetryCodec_getSVarint, v); q[f] = qAdd(q[f], v); }
+      }
+    }
+    Measurement m;
+    memset(&m, 0, sizeof(m));
+    m.timestamp = ts;
+    for (int f = 0; f < TF_COUNT; ++f) telemetryCodec_dequantize(m, f, q[f]);
+    if (n < max) out[n++] = m;
+  }
+
+  // the batch's last record is the reference for the next delta batch
+  if (base && count) {
+    base->valid = true;
+    base->seq = seq;
+    base->timestamp = ts;
+    memcpy(base->q, q, sizeof(q));
+  }
+  return n;
+}
@@ -0,0 +1,95 @@
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "measurement.h"
+
+// Compact binary encoding of measurement batches for the telemetry uplink.
+// Every field is quantized to a fixed-point integer and written as a zigzag varint,
+// so a typical record takes ~25 bytes instead of ~100 as JSON. Delta batches send
+// only the fields that differ from the last snapshot the server acknowledged.
+//
+// Batch, version 2 (version 1 = keyframe layout without seq, still decoded):
+//   u8      version (TELEMETRY_CODEC_VERSION)
+//   u8      flags (TC_FLAG_KEYFRAME)
+//   varint  seq: batch sequence number (a retransmission reuses it)
+//   varint  base seq: batch whose last record is the reference (delta batches only)
+//   varint  record count
+//   keyframe:
+//     varint  timestamp of the first record (epoch s)
+//     per record: svarint timestamp delta to the previous record (0 for the first),
+//                 svarint each TelemetryField in enum order, quantized with its scale
+//   delta (every record against the same reference snapshot):
+//     per record: svarint timestamp - reference timestamp,
+//                 varint  bitmask of fields that differ (bit = TelemetryField),
+//                 svarint quantized value - reference value, for each set bit
+//
+// The code has no Arduino dependencies beyond measurement.h, so the same file builds
+// on a host for a decoder (see also tools/telemetry_decode.py).
+
+#define TELEMETRY_CODEC_VERSION 2
+#define TC_FLAG_KEYFRAME        0x01
+// Quantized value of a field that is NaN (sensor missing). Deltas are taken modulo 2^32,
+// so the sentinel survives delta coding exactly; decoders turn it back into NaN.
+#define TC_Q_NAN                INT32_MIN
+
+// Quantized fields in wire order. Scales: value * scale, rounded.
+enum TelemetryField {
+  TF_WEIGHT = 0,    // kg   x100  (10 g)
+  TF_TEMP_INT,      // C    x100
+  TF_HUM_INT,       // %    x10
+  TF_TEMP_EXT,      // C    x100
+  TF_HUM_EXT,       // %    x10
+  TF_PRESSURE,      // hPa  x10
+  TF_ACC_X,         // g    x1000 (mg)
+  TF_ACC_Y,
+  TF_ACC_Z,
+  TF_BATT_V,        // V    x1000 (mV)
+  TF_BATT_PCT,      // %    x1
+  TF_RSSI,          // dBm  x1
+  TF_COUNT
+};
+
+// Fixed-point value of one field (TC_Q_NAN for NaN, out of range values saturate), and
+// the inverse
+int32_t telemetryCodec_quantize(const Measurement &m, int field);
+void    telemetryCodec_dequantize(Measurement &m, int field, int32_t q);
+
+// Varint primitives (LEB128, zigzag for signed). Return bytes written/read, 0 on overflow.
+size_t telemetryCodec_putVarint(uint8_t *buf, size_t cap, uint32_t v);
+size_t telemetryCodec_putSVarint(uint8_t *buf, size_t cap, int32_t v);
+size_t telemetryCodec_getVarint(const uint8_t *buf, size_t len, uint32_t &v);
+size_t telemetryCodec_getSVarint(const uint8_t *buf, size_t len, int32_t &v);
+
+// Quantized record used as the delta reference: the last record of batch seq
+struct TelemetrySnapshot {
+  bool     valid;
+  uint32_t seq;
+  uint32_t timestamp;
+  int32_t  q[TF_COUNT];
+};
+
+void telemetryCodec_snapshot(const Measurement &m, uint32_t seq, TelemetrySnapshot &out);
+
+// Encode n records as batch seq into buf: a delta against base, or a keyframe when base
+// is null/invalid. Returns the batch length, 0 if it does not fit.
+size_t telemetryCodec_encode(const Measurement *recs, int n, uint32_t seq,
+                             const TelemetrySnapshot *base, uint8_t *buf, size_t cap);
+
+// The same records as JSON, {"v":1,"id":"<dev>","r":[[ts,w,ti,hi,te,he,p,ax,ay,az,bv,bp,rssi],...]}
+// (TELEMETRY_FORMAT_JSON, and the baseline the binary size is compared against).
+// Returns the length without the NUL, 0 if it does not fit.
+size_t telemetryCodec_encodeJson(const Measurement *recs, int n, const char *devId,
+                                 char *buf, size_t cap);
+
+// Decode a batch into out (up to max records). Delta batches need the reference snapshot
+// (base->seq must match); on success base is advanced to the batch's last record.
+// Batches with seq <= base->seq are QoS1 redeliveries (seqs never repeat, not even across
+// reboots) and are skipped without touching base.
+// Returns the record count, 0 for a skipped duplicate, -1 if malformed, of an unknown
+// version or missing its base.
+int telemetryCodec_decode(const uint8_t *buf, size_t len, Measurement *out, int max,
+                          TelemetrySnapshot *base);
+
+#endif // TELEMETRY_CODEC_H
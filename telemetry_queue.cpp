@@ -0,0 +1,151 @@
+// telemetry_queue.cpp
+// - Fixed-record ring buffer for the telemetry uplink, persisted on SD.
+// - File layout: QueueHeader, then TELEMETRY_QUEUE_CAP slots of sizeof(Measurement).
+// - A push writes the record slot first and the header last, so a reset in between
+//   loses at most that record, never the queue.
+// - Falls back to a RAM ring when the card is missing or the file cannot be opened. On
+//   an SD error later on, the newest pending records that still read back move to RAM
+//   and the others are added to the drop counter.
+#include "telemetry_queue.h"
+#include "config.h"
+#include <SD.h>
+
+static const uint32_t QUEUE_MAGIC = 0x31515442;   // "BTQ1"
+
+struct QueueHeader {
+  uint32_t magic;
+  uint16_t recSize;
+  uint16_t reserved;
+  uint32_t capacity;
+  uint32_t head;      // slot of the oldest record
+  uint32_t count;
+  uint32_t dropped;
+};
+
+static File        s_file;
+static bool        s_onSd = false;
+static QueueHeader s_hdr;
+
+static Measurement s_ram[TELEMETRY_RAM_CAP];
+
+static uint32_t capacity() { return s_onSd ? TELEMETRY_QUEUE_CAP : TELEMETRY_RAM_CAP; }
+
+static uint32_t slotOffset(uint32_t slot) {
+  return sizeof(QueueHeader) + slot * sizeof(Measurement);
+}
+
+static bool writeHeader() {
+  if (!s_onSd) return true;
+  if (!s_file.seek(0) || s_file.write((const uint8_t*)&s_hdr, sizeof(s_hdr)) != sizeof(s_hdr)) return false;
+  s_file.flush();
+  return true;
+}
+
+// Any SD error: keep going from RAM rather than losing new records. The newest pending
+// records that still read back are moved into the RAM ring; the rest count as dropped.
+static void fallBackToRam(const char *why) {
+  uint32_t pending = s_hdr.count;
+  uint32_t keep = pending < TELEMETRY_RAM_CAP ? pending : TELEMETRY_RAM_CAP;
+  uint32_t saved = 0;
+  for (uint32_t i = pending - keep; i < pending && s_file; ++i) {
+    uint32_t slot = (s_hdr.head + i) % TELEMETRY_QUEUE_CAP;
+    if (!s_file.seek(slotOffset(slot)) ||
+        s_file.read((uint8_t*)&s_ram[saved], sizeof(Measurement)) != sizeof(Measurement)) break;
+    saved++;
+  }
+  if (s_file) s_file.close();
+  s_onSd = false;
+  s_hdr.head = 0;
+  s_hdr.count = saved;
+  s_hdr.dropped += pending - saved;
+  Serial.printf("[TQueue] SD %s, using RAM queue: %lu of %lu pending records kept, %lu dropped\n",
+                why, (unsigned long)saved, (unsigned long)pending, (unsigned long)(pending - saved));
+}
+
+bool telemetryQueue_init() {
+  memset(&s_hdr, 0, sizeof(s_hdr));
+  s_onSd = false;
+  if (s_file) s_file.close();   // re-init: never read the header through a stale handle
+
+  if (SD.exists(TELEMETRY_QUEUE_FILE)) s_file = SD.open(TELEMETRY_QUEUE_FILE, "r+");
+  if (s_file && s_file.read((uint8_t*)&s_hdr, sizeof(s_hdr)) == sizeof(s_hdr) &&
+      s_hdr.magic == QUEUE_MAGIC && s_hdr.recSize == sizeof(Measurement) &&
+      s_hdr.capacity == TELEMETRY_QUEUE_CAP && s_hdr.count <= TELEMETRY_QUEUE_CAP &&
+      s_hdr.head < TELEMETRY_QUEUE_CAP) {
+    s_onSd = true;
+    Serial.printf("[TQueue] SD ring: %lu pending, %lu dropped\n",
+                  (unsigned long)s_hdr.count, (unsigned long)s_hdr.dropped);
+    return true;
+  }
+
+  // missing or incompatible: start a new ring
+  if (s_file) s_file.close();
+  s_file = SD.open(TELEMETRY_QUEUE_FILE, FILE_WRITE);
+  if (!s_file) {
+    Serial.println("[TQueue] no SD, using RAM queue");
+    return false;
+  }
+  s_file.close();
+  s_file = SD.open(TELEMETRY_QUEUE_FILE, "r+");
+  memset(&s_hdr, 0, sizeof(s_hdr));
+  s_hdr.magic = QUEUE_MAGIC;
+  s_hdr.recSize = sizeof(Measurement);
+  s_hdr.capacity = TELEMETRY_QUEUE_CAP;
+  s_onSd = (bool)s_file;
+  if (!s_onSd || !writeHeader()) { fallBackToRam("create failed"); return false; }
+  Serial.println("[TQueue] SD ring created");
+  return true;
+}
+
+void telemetryQueue_push(const Measurement &m) {
+  uint32_t cap = capacity();
+  if (s_hdr.count == cap) {
+    // full: drop the oldest record
+    s_hdr.head = (s_hdr.head + 1) % cap;
+    s_hdr.count--;
+    s_hdr.dropped++;
+  }
+  uint32_t slot = (s_hdr.head + s_hdr.count) % cap;
+
+  if (s_onSd) {
+    if (!s_file.seek(slotOffset(slot)) ||
+        s_file.write((const uint8_t*)&m, sizeof(m)) != sizeof(m)) {
+      fallBackToRam("write failed");
+      telemetryQueue_push(m);
+      return;
+    }
+  } else {
+    s_ram[slot] = m;
+  }
+  s_hdr.count++;
+  if (!writeHeader()) fallBackToRam("header write failed");
+}
+
+int telemetryQueue_peek(Measurement *out, int max) {
+  uint32_t cap = capacity();
+  int n = 0;
+  while (n < max && (uint32_t)n < s_hdr.count) {
+    uint32_t slot = (s_hdr.head + n) % cap;
+    if (s_onSd) {
+      if (!s_file.seek(slotOffset(slot)) ||
+          s_file.read((uint8_t*)&out[n], sizeof(Measurement)) != sizeof(Measurement)) break;
+    } else {
+      out[n] = s_ram[slot];
+    }
+    n++;
+  }
+  return n;
+}
+
+void telemetryQueue_pop(int n) {
+  if (n <= 0) return;
+  if ((uint32_t)n > s_hdr.count) n = s_hdr.count;
+  s_hdr.head = (s_hdr.head + n) % capacity();
+  s_hdr.count -= n;
+  if (s_hdr.count == 0) s_hdr.head = 0;
+  if (!writeHeader()) fallBackToRam("header write failed");
+}
+
+uint32_t telemetryQueue_count()   { return s_hdr.count; }
+uint32_t telemetryQueue_dropped() { return s_hdr.dropped; }
+bool telemetryQueue_isPersistent() { return s_onSd; }
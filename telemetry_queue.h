@@ -0,0 +1,28 @@
+#ifndef TELEMETRY_QUEUE_H
+#define TELEMETRY_QUEUE_H
+
+#include <Arduino.h>
+#include "measurement.h"
+
+// Store-and-forward queue of measurement records waiting for the uplink.
+// Backed by a fixed-size ring file on the SD card (TELEMETRY_QUEUE_FILE, TELEMETRY_QUEUE_CAP
+// records) so records survive reboots and long offline periods. Without an SD card a
+// small RAM ring (TELEMETRY_RAM_CAP) is used instead. When full, the oldest record is dropped.
+
+// Open or create the ring (call after SD.begin()). Returns true if the SD ring is in use.
+bool telemetryQueue_init();
+
+// Append a record
+void telemetryQueue_push(const Measurement &m);
+
+// Copy up to max of the oldest records into out without removing them. Returns the count.
+int telemetryQueue_peek(Measurement *out, int max);
+
+// Remove the n oldest records (after they were acknowledged)
+void telemetryQueue_pop(int n);
+
+uint32_t telemetryQueue_count();
+uint32_t telemetryQueue_dropped();     // records lost to overflow (persisted with the ring)
+bool     telemetryQueue_isPersistent();
+
+#endif // TELEMETRY_QUEUE_H
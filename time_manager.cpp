@@ -1,5 +1,8 @@
 #include "time_manager.h"
 #include "modem_manager.h"
+#include "power_manager.h"
+#include "connectivity_manager.h"
+#include "at_engine.h"
 #include "config.h"
 #include <WiFi.h>
 #include <time.h>
@@ -10,7 +13,8 @@
 enum TimeState {
   TS_IDLE,
   TS_LTE_CHECK,
-  TS_WIFI_SCAN,
+  TS_LTE_WAIT,
+  TS_WIFI_START,
   TS_WIFI_CONNECTING,
   TS_NTP_REQUEST,
   TS_DONE,
@@ -24,20 +28,37 @@ static int          attempt     = 0;
 static bool        time_valid   = false;
 static TimeSource  time_source  = TSRC_NONE;
 
-// ---------------------------------------------------------
-// WIFI HOTSPOTS (from your previous working setup)
-// ---------------------------------------------------------
-static const char* hotspot_ssids[] = {
-  "COSMOTE-32bssa",
-  "Redmi Note 13",
-  nullptr
-};
+// +CCLK? result handed over from the AT engine callback
+static volatile int8_t cclk_done = 0;    // 0 = pending, 1 = time set, -1 = failed
 
-static const char* hotspot_pass[] = {
-  "vudvvc5x97s4afpk",
-  "nen57asz5g44sh2",
-  nullptr
-};
+// +CCLK: "yy/MM/dd,hh:mm:ss+tz"   (tz in quarter hours, local time per configTime)
+static void onCclk(const AtReply &reply, void *ctx) {
+  (void)ctx;
+  power_release(PWR_LOCK_UART);
+  modem_release(MODEM_LEASE_TIME);
+  cclk_done = -1;
+  if (reply.result != AT_OK) return;
+
+  const char *p = strstr(reply.text, "+CCLK:");
+  int y, M, d, h, m, s;
+  if (!p || sscanf(p, "+CCLK: \"%d/%d/%d,%d:%d:%d", &y, &M, &d, &h, &m, &s) != 6) return;
+  if (y < 24) return;   // modem clock not yet set from the network (70/01/01)
+
+  struct tm t;
+  memset(&t, 0, sizeof(t));
+  t.tm_year  = 2000 + y - 1900;
+  t.tm_mon   = M - 1;
+  t.tm_mday  = d;
+  t.tm_hour  = h;
+  t.tm_min   = m;
+  t.tm_sec   = s;
+  t.tm_isdst = -1;
+
+  time_t tt = mktime(&t);
+  struct timeval tv = { tt, 0 };
+  settimeofday(&tv, nullptr);
+  cclk_done = 1;
+}
 
 // ---------------------------------------------------------
 // INIT
@@ -53,25 +74,6 @@ void timeManager_init() {
   time_source = TSRC_NONE;
 }
 
-// ---------------------------------------------------------
-// WIFI HELPER
-// ---------------------------------------------------------
-static bool tryConnectToWifi() {
-  int n = WiFi.scanNetworks();
-  if (n <= 0) return false;
-
-  for (int i = 0; hotspot_ssids[i] != nullptr; i++) {
-    const char* target = hotspot_ssids[i];
-    for (int j = 0; j < n; j++) {
-      if (WiFi.SSID(j) == target) {
-        WiFi.begin(target, hotspot_pass[i]);
-        return true;
-      }
-    }
-  }
-  return false;
-}
-
 // ---------------------------------------------------------
 // UPDATE
 // ---------------------------------------------------------
@@ -86,59 +88,57 @@ void timeManager_update() {
       if (now - last_query < 3000) return;
       last_query = now;
 
-      TinyGsm& modem = modem_get();
-
-      modem.sendAT("+CCLK?");
-      String resp = modem.stream.readString();
-
-      if (resp.indexOf("+CCLK:") >= 0) {
-        int y, M, d, h, m, s, tz;
-        if (sscanf(resp.c_str(),
-                   "*+CCLK: \"%d/%d/%d,%d:%d:%d+%d",
-                   &y, &M, &d, &h, &m, &s, &tz) == 7) {
-          struct tm t;
-          t.tm_year = 2000 + y - 1900;
-          t.tm_mon  = M - 1;
-          t.tm_mday = d;
-          t.tm_hour = h;
-          t.tm_min  = m;
-          t.tm_sec  = s;
-
-          time_t tt = mktime(&t);
-          struct timeval tv = { tt, 0 };
-          settimeofday(&tv, nullptr);
-
-          time_valid  = true;
-          time_source = TSRC_LTE;
-          state       = TS_DONE;
-          break;
-        }
+      if (!at_isStarted()) {
+        state = TS_WIFI_START;
+        break;
       }
 
-      // If LTE time failed → fallback to WiFi NTP
-      state = TS_WIFI_SCAN;
+      // Radio time for the query; a powered-down modem is woken and asked on a later pass
+      if (!modem_acquire(MODEM_LEASE_TIME, 60000UL)) {
+        if (modem_powerState() == MPS_BOOTING) return;
+        state = TS_WIFI_START;
+        break;
+      }
+
+      // Answered from at_loop(); OK arrives within a few ms instead of a Stream timeout
+      power_acquire(PWR_LOCK_UART);
+      cclk_done = 0;
+      if (!at_submit("+CCLK?", 1000, onCclk, nullptr)) {
+        power_release(PWR_LOCK_UART);
+        modem_release(MODEM_LEASE_TIME);
+        state = TS_WIFI_START;
+        break;
+      }
+      state = TS_LTE_WAIT;
       break;
     }
 
-    case TS_WIFI_SCAN:
+    case TS_LTE_WAIT:
+      if (cclk_done == 0) return;
+      if (cclk_done > 0) {
+        time_valid  = true;
+        time_source = TSRC_LTE;
+        state       = TS_DONE;
+        break;
+      }
+      // If LTE time failed → fallback to WiFi NTP
+      state = TS_WIFI_START;
+      break;
+
+    case TS_WIFI_START:
+      // WiFi is owned by the connectivity manager; just make sure it is trying
       if (now - last_query < 5000) return;
       last_query = now;
-
-      WiFi.mode(WIFI_STA);
-      WiFi.disconnect(false);
-
-      if (tryConnectToWifi())
-        state = TS_WIFI_CONNECTING;
-      else
-        state = TS_FAIL;
+      connectivity_connect();
+      state = TS_WIFI_CONNECTING;
       break;
 
     case TS_WIFI_CONNECTING:
-      if (WiFi.status() == WL_CONNECTED) {
+      if (connectivity_wifiConnected()) {
         time_source = TSRC_WIFI;
         state       = TS_NTP_REQUEST;
         last_query  = now;
-      } else if (now - last_query > 8000) {
+      } else if (now - last_query > 15000) {
         state = TS_FAIL;
       }
       break;
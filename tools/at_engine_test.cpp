@@ -0,0 +1,284 @@
+// tools/at_engine_test.cpp
+// - Host test for the AT command engine (at_engine.cpp) against a scripted fake A7670.
+// - FakeModem is the Stream the engine owns. Each command it receives must match the next
+//   step of the script; the step's reply is then released at the UART rate
+//   (FAKE_BYTES_PER_MS after the step's delay) on the simulated clock, so lines arrive
+//   split across at_loop() calls the way they do on the device. URCs can be injected at
+//   any time, between or in the middle of replies.
+// - Cases: completion on the final result code well before the timeout, echo, URCs while
+//   idle and inside a reply, +CMGL text lines that read like result codes or URCs,
+//   +CME/+CMS errors, timeouts, the '>' prompt (and a prompt that never comes), queued
+//   commands with callbacks, and blocking calls from a callback.
+// - Reports per case the result, the simulated round trip and the info lines; the exit
+//   status is 1 if any check fails.
+// - Build and run from the repository root:
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/at_engine_test.cpp at_engine.cpp -o at_engine_test
+//     ./at_engine_test
+#include "at_engine.h"
+#include "power_manager.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+#define FAKE_BYTES_PER_MS  11     // 115200 baud, 8N1
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (ok) return;
+  if (s_failures++ < 10) printf("FAILED: %s\n", what);
+}
+
+// -----------------------------------------------------------------------------
+// Scripted modem
+struct Step {
+  std::string expect;     // bytes the engine sends, ending in '\r', Ctrl-Z or ESC
+  std::string reply;      // empty: the modem stays silent
+  uint32_t    delayMs;    // before the first reply byte
+};
+
+class FakeModem : public Stream {
+public:
+  std::deque<Step>         script;
+  std::vector<std::string> received;
+  bool                     echo = false;   // ATE1
+
+  // bytes become readable FAKE_BYTES_PER_MS per ms from `at` on
+  void send(const std::string &bytes, uint32_t delayMs = 0) {
+    unsigned long at = std::max(millis() + delayMs, lastAt_);
+    for (size_t i = 0; i < bytes.size(); ++i) rx_.push_back({ bytes[i], at + i / FAKE_BYTES_PER_MS });
+    lastAt_ = at + bytes.size() / FAKE_BYTES_PER_MS;
+  }
+
+  size_t write(uint8_t c) override {
+    tx_ += (char)c;
+    if (c == '\r' || c == 0x1A || c == 0x1B) command();
+    return 1;
+  }
+  int available() override {
+    int n = 0;
+    for (const Byte &b : rx_) {
+      if (b.at > millis()) break;
+      n++;
+    }
+    return n;
+  }
+  int read() override {
+    if (!available()) return -1;
+    char c = rx_.front().c;
+    rx_.pop_front();
+    return (uint8_t)c;
+  }
+  int peek() override { return available() ? (uint8_t)rx_.front().c : -1; }
+
+  bool idle() const { return rx_.empty() && tx_.empty(); }
+
+private:
+  struct Byte {
+    char          c;
+    unsigned long at;
+  };
+  std::deque<Byte> rx_;
+  std::string      tx_;
+  unsigned long    lastAt_ = 0;
+
+  void command() {
+    received.push_back(tx_);
+    if (echo && tx_.back() == '\r') send(tx_);
+    if (script.empty() || script.front().expect != tx_) {
+      check(false, ("unexpected command " + tx_).c_str());
+    } else {
+      if (!script.front().reply.empty()) send(script.front().reply, script.front().delayMs);
+      script.pop_front();
+    }
+    tx_.clear();
+  }
+};
+
+static FakeModem s_modem;
+
+// -----------------------------------------------------------------------------
+// Hooks at_engine.cpp links against
+static int s_locks = 0;
+void power_acquire(PowerLock) { s_locks++; }
+void power_release(PowerLock) { s_locks--; }
+
+// -----------------------------------------------------------------------------
+// URC subscribers
+static std::vector<std::string> s_cmti, s_creg, s_cclk;
+
+static void onUrc(const char *line, void *ctx) {
+  static_cast<std::vector<std::string>*>(ctx)->push_back(line);
+}
+
+static void expectStep(const char *cmd, const std::string &reply, uint32_t delayMs = 20) {
+  s_modem.script.push_back({ std::string("AT") + cmd + "\r", reply, delayMs });
+}
+
+static void runFor(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; ++i) {
+    at_loop();
+    delay(1);
+  }
+}
+
+static void report(const char *label, AtResult r, unsigned long ms, const char *resp) {
+  int lines = 0;
+  for (const char *p = resp; *p; ++p) lines += *p == '\n';
+  printf("%-28s %-10s %7lu %6d\n", label, at_resultName(r), ms, resp[0] ? lines + 1 : 0);
+}
+
+// at_exec() with the simulated round trip
+static AtResult exec(const char *cmd, uint32_t timeoutMs, char *resp, size_t len, unsigned long &ms) {
+  unsigned long t0 = millis();
+  AtResult r = at_exec(cmd, timeoutMs, resp, len);
+  ms = millis() - t0;
+  return r;
+}
+
+// -----------------------------------------------------------------------------
+struct Queued {
+  std::vector<std::string> order;
+};
+
+static void onQueuedDone(const AtReply &r, void *ctx) {
+  Queued *q = static_cast<Queued*>(ctx);
+  q->order.push_back(std::string(at_resultName(r.result)) + ":" + r.text);
+  // blocking from a callback would deadlock the engine on the device
+  check(at_exec("+CSQ", 1000) == AT_REJECTED, "at_exec from a callback is rejected");
+}
+
+int main() {
+  Serial.quiet = true;
+  char resp[AT_RESP_LEN];
+  unsigned long ms;
+  AtResult r;
+
+  s_modem.send("\r\nRDY\r\n+CPIN: READY\r\n");   // bring-up leftovers
+  delay(10);
+  at_init(s_modem);
+  check(s_modem.available() == 0, "init drains the UART");
+  at_subscribe("+CMTI:", onUrc, &s_cmti);
+  at_subscribe("+CREG:", onUrc, &s_creg);
+  at_subscribe("+CCLK:", onUrc, &s_cclk);
+
+  printf("%-28s %-10s %7s %6s\n", "case", "result", "ms", "lines");
+
+  // completes on OK, not on the timeout
+  expectStep("+CSQ", "\r\n+CSQ: 21,99\r\n\r\nOK\r\n", 30);
+  r = exec("+CSQ", 3000, resp, sizeof(resp), ms);
+  report("OK after 30 ms, 3 s timeout", r, ms, resp);
+  check(r == AT_OK && strcmp(resp, "+CSQ: 21,99") == 0, "+CSQ reply");
+  check(ms < 50, "completes on the final result code");
+
+  // echo is dropped
+  s_modem.echo = true;
+  expectStep("+CCLK?", "\r\n+CCLK: \"26/05/01,12:00:00+12\"\r\n\r\nOK\r\n");
+  r = exec("+CCLK?", 1000, resp, sizeof(resp), ms);
+  report("echo on", r, ms, resp);
+  check(r == AT_OK && strcmp(resp, "+CCLK: \"26/05/01,12:00:00+12\"") == 0, "echo dropped");
+  check(s_cclk.empty(), "a command's own info line is not a URC");
+  s_modem.echo = false;
+
+  // URC in the middle of a reply goes to its subscriber, not into the reply
+  expectStep("+CCLK?", "\r\n+CMTI: \"SM\",3\r\n+CCLK: \"26/05/01,12:00:05+12\"\r\n+CREG: 1\r\n\r\nOK\r\n");
+  r = exec("+CCLK?", 1000, resp, sizeof(resp), ms);
+  report("URCs inside a reply", r, ms, resp);
+  check(r == AT_OK && strcmp(resp, "+CCLK: \"26/05/01,12:00:05+12\"") == 0, "URCs kept out of the reply");
+  check(s_cmti.size() == 1 && s_cmti[0] == "+CMTI: \"SM\",3", "+CMTI routed mid-reply");
+  check(s_creg.size() == 1, "+CREG routed mid-reply");
+
+  // URCs while idle, split across at_loop() calls; unknown ones are counted and dropped
+  size_t routed = s_cmti.size() + s_cclk.size();
+  s_modem.send("\r\n+CMTI: \"SM\",4\r\n+CPSI: LTE,Online\r\n\r\n+CCLK: \"26/05/01,12:00:09+12\"\r\n", 5);
+  runFor(20);
+  printf("%-28s %-10s %7s %6zu\n", "URCs while idle", "-", "-", s_cmti.size() + s_cclk.size() - routed);
+  check(s_cmti.size() == 2 && s_cmti[1] == "+CMTI: \"SM\",4", "+CMTI routed while idle");
+  check(s_cclk.size() == 1, "+CCLK routed while idle");
+  check(!at_busy() && s_locks == 0, "no lock held while idle");
+
+  // +CMGL: the line after each header is text, whatever it says
+  expectStep("+CMGL=\"REC UNREAD\"",
+             "\r\n+CMGL: 1,\"REC UNREAD\",\"+306900000001\",\"\",\"26/05/01,12:01:00+12\"\r\nOK\r\n"
+             "+CMGL: 2,\"REC UNREAD\",\"+306900000001\",\"\",\"26/05/01,12:01:10+12\"\r\n+CMTI: \"SM\",9\r\n"
+             "+CMGL: 3,\"REC UNREAD\",\"+306900000002\",\"\",\"26/05/01,12:01:20+12\"\r\n\r\n"
+             "+CMGL: 4,\"REC UNREAD\",\"+306900000002\",\"\",\"26/05/01,12:01:30+12\"\r\n AT+CFUN=0 \r\n"
+             "\r\nOK\r\n", 80);
+  r = exec("+CMGL=\"REC UNREAD\"", 5000, resp, sizeof(resp), ms);
+  report("+CMGL, text like codes", r, ms, resp);
+  const char *texts[] = { "\nOK\n", "\n+CMTI: \"SM\",9\n", "\n\n", "\n AT+CFUN=0 " };
+  for (const char *t : texts) check(strstr(resp, t) != nullptr, "message text kept verbatim");
+  check(r == AT_OK && s_cmti.size() == 2, "text lines do not end the command or reach subscribers");
+
+  // errors
+  expectStep("+CPMS?", "\r\n+CME ERROR: 10\r\n");
+  r = exec("+CPMS?", 1000, resp, sizeof(resp), ms);
+  report("+CME ERROR", r, ms, resp);
+  check(r == AT_CME_ERROR, "+CME ERROR result");
+  expectStep("+CMGD=1", "\r\n+CMS ERROR: 321\r\n");
+  r = exec("+CMGD=1", 1000, resp, sizeof(resp), ms);
+  report("+CMS ERROR", r, ms, resp);
+  check(r == AT_CME_ERROR, "+CMS ERROR result");
+  expectStep("+COPS=0", "\r\nERROR\r\n");
+  r = exec("+COPS=0", 1000, resp, sizeof(resp), ms);
+  report("ERROR", r, ms, resp);
+  check(r == AT_ERROR, "ERROR result");
+
+  // silence: times out after the command's own budget, and the next command still works
+  expectStep("+CGATT?", "");
+  r = exec("+CGATT?", 400, resp, sizeof(resp), ms);
+  report("no reply, 400 ms timeout", r, ms, resp);
+  check(r == AT_TIMEOUT && ms >= 400 && ms < 420, "timeout after timeoutMs");
+  expectStep("", "\r\nOK\r\n", 5);
+  r = exec("", 1000, resp, sizeof(resp), ms);
+  check(r == AT_OK, "engine recovers after a timeout");
+
+  // prompt: the payload and Ctrl-Z go out as soon as '>' arrives
+  expectStep("+CMGS=\"+306900000001\"", "\r\n> ", 15);
+  s_modem.script.push_back({ "OK weight=41.2kg\x1A", "\r\n+CMGS: 17\r\n\r\nOK\r\n", 900 });
+  unsigned long t0 = millis();
+  r = at_execPrompt("+CMGS=\"+306900000001\"", "OK weight=41.2kg", 10000);
+  report("prompt, SMS sent", r, millis() - t0, "");
+  check(r == AT_OK && s_modem.script.empty(), "payload sent after the prompt");
+
+  // prompt never comes: ESC cancels the pending input and the result says so
+  expectStep("+CMGS=\"+306900000002\"", "");
+  s_modem.script.push_back({ "\x1B", "", 0 });
+  t0 = millis();
+  r = at_execPrompt("+CMGS=\"+306900000002\"", "never sent", 300);
+  report("no prompt", r, millis() - t0, "");
+  check(r == AT_NO_PROMPT && s_modem.received.back() == "\x1B", "ESC after a missing prompt");
+
+  // queued commands run one at a time, in order, with their callbacks
+  Queued q;
+  expectStep("+CSQ", "\r\n+CSQ: 19,99\r\n\r\nOK\r\n");
+  expectStep("+CREG?", "\r\n+CREG: 0,1\r\n\r\nOK\r\n");
+  expectStep("+CBC", "\r\n+CBC: 4.012V\r\n\r\nOK\r\n");
+  check(at_submit("+CSQ", 1000, onQueuedDone, &q) && at_submit("+CREG?", 1000, onQueuedDone, &q) &&
+        at_submit("+CBC", 1000, onQueuedDone, &q), "queue accepts three commands");
+  size_t sentBefore = s_modem.received.size();
+  at_loop();
+  check(at_busy() && at_queued() == 2 && s_modem.received.size() == sentBefore + 1,
+        "one command in flight");
+  for (int i = 0; i < 1000 && (at_busy() || at_queued()); ++i) runFor(1);
+  printf("%-28s %-10s %7s %6zu\n", "three queued commands", "OK", "-", q.order.size());
+  check(q.order.size() == 3 && q.order[0] == "OK:+CSQ: 19,99" && q.order[1] == "OK:+CREG: 0,1" &&
+        q.order[2] == "OK:+CBC: 4.012V", "queued replies in order");
+  check(s_creg.size() == 1, "+CREG? reply is not a URC");
+
+  // a full queue rejects instead of blocking
+  for (int i = 0; i < AT_QUEUE_LEN; ++i) at_submit("+CSQ", 1000, nullptr, nullptr);
+  check(!at_submit("+CSQ", 1000, nullptr, nullptr), "full queue rejects");
+  for (int i = 0; i < AT_QUEUE_LEN; ++i) expectStep("+CSQ", "\r\nOK\r\n", 1);
+  for (int i = 0; i < 2000 && (at_busy() || at_queued()); ++i) runFor(1);
+
+  check(s_modem.script.empty(), "every scripted step was used");
+  check(s_locks == 0, "UART power lock released after every command");
+
+  if (s_failures) {
+    printf("%d checks failed\n", s_failures);
+    return 1;
+  }
+  printf("all at_engine checks passed\n");
+  return 0;
+}
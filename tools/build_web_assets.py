@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""Pack the files in web/ into web_assets.h as gzip-compressed byte arrays.
+
+Each asset gets an ETag derived from the SHA-256 of its uncompressed content, so the
+key server can answer repeat visits with 304 Not Modified. Output is deterministic
+(gzip mtime 0, sorted by path), so re-running without changes leaves the header as is.
+
+Run after editing anything under web/ and commit the regenerated header:
+  python3 tools/build_web_assets.py
+"""
+import gzip
+import hashlib
+import os
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SRC = os.path.join(ROOT, "web")
+OUT = os.path.join(ROOT, "web_assets.h")
+
+TYPES = {
+    ".html": "text/html; charset=UTF-8",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".json": "application/json",
+}
+
+
+def ident(path):
+    return "ASSET_" + "".join(c.upper() if c.isalnum() else "_" for c in path.strip("/"))
+
+
+def main():
+    assets = []
+    for dirpath, _, files in os.walk(SRC):
+        for name in files:
+            full = os.path.join(dirpath, name)
+            rel = "/" + os.path.relpath(full, SRC).replace(os.sep, "/")
+            ext = os.path.splitext(name)[1].lower()
+            if ext not in TYPES:
+                print(f"skipping {rel}: unknown type", file=sys.stderr)
+                continue
+            raw = open(full, "rb").read()
+            gz = gzip.compress(raw, compresslevel=9, mtime=0)
+            etag = hashlib.sha256(raw).hexdigest()[:16]
+            assets.append((rel, TYPES[ext], raw, gz, etag))
+    assets.sort()
+
+    lines = [
+        "// web_assets.h",
+        "// - GENERATED by tools/build_web_assets.py from web/ -- do not edit by hand.",
+        "// - gzip-compressed bodies in flash; ETag is the SHA-256 prefix of the raw file.",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "  const char    *path;",
+        "  const char    *contentType;",
+        "  const char    *etag;          // quoted, ready for the header",
+        "  const uint8_t *gz;",
+        "  uint32_t       gzLen;",
+        "  uint32_t       rawLen;",
+        "};",
+        "",
+    ]
+    for rel, ctype, raw, gz, etag in assets:
+        lines.append(f"// {rel}: {len(raw)} -> {len(gz)} bytes")
+        lines.append(f"static const uint8_t {ident(rel)}[] = {{")
+        for i in range(0, len(gz), 16):
+            lines.append("  " + ",".join(f"0x{b:02x}" for b in gz[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+    lines.append("static const WebAsset WEB_ASSETS[] = {")
+    for rel, ctype, raw, gz, etag in assets:
+        lines.append(f'  {{ "{rel}", "{ctype}", "\\"{etag}\\"", {ident(rel)}, {len(gz)}, {len(raw)} }},')
+    lines.append("};")
+    lines.append("static const int WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    lines.append("")
+    lines.append("#endif // WEB_ASSETS_H")
+    lines.append("")
+
+    text = "\n".join(lines)
+    old = open(OUT).read() if os.path.exists(OUT) else None
+    if old != text:
+        with open(OUT, "w") as f:
+            f.write(text)
+    total_raw = sum(len(a[2]) for a in assets)
+    total_gz = sum(len(a[3]) for a in assets)
+    for rel, _, raw, gz, etag in assets:
+        print(f"{rel:20s} {len(raw):6d} -> {len(gz):6d} bytes  etag {etag}")
+    print(f"{'total':20s} {total_raw:6d} -> {total_gz:6d} bytes" + ("" if old != text else "  (unchanged)"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,206 @@
+// tools/forecast_bench.cpp
+// - Host benchmark for the streaming Open-Meteo forecast parser (forecast_parser.cpp on
+//   json_stream.cpp): parse time and heap use per response, fed in TCP-sized chunks.
+// - Payloads: responses in Open-Meteo's format for 3 (what the device requests), 7 and
+//   16 forecast days, generated here, plus any captured bodies given on the command line
+//   (e.g. curl -o fc.json "https://api.open-meteo.com/v1/forecast?latitude=40.64&longitude=22.94&hourly=temperature_2m,weathercode,relativehumidity_2m,surface_pressure&forecast_days=3&timezone=auto&timeformat=unixtime").
+// - Heap: malloc/calloc/realloc are counted while the parser runs (glibc), so "0 / 0"
+//   means no allocation at all. "before" is what the old path held at its peak: the body
+//   as a String plus the 28 KB DynamicJsonDocument.
+// - Every chunk size must produce the same samples; for generated payloads they are also
+//   compared with the values that went in. The exit status is 1 on any mismatch.
+// - Build and run from the repository root:
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/forecast_bench.cpp forecast_parser.cpp json_stream.cpp -o forecast_bench
+//     ./forecast_bench [captured.json ...]
+#include "forecast_parser.h"
+#include "json_stream.h"
+#include <chrono>
+#include <malloc.h>
+#include <string>
+#include <vector>
+
+#define BENCH_OLD_DOC_B 28672   // DynamicJsonDocument of the replaced parser
+
+// -----------------------------------------------------------------------------
+// Allocation counting (glibc)
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void  __libc_free(void *);
+
+static bool   s_track = false;
+static size_t s_allocs = 0, s_live = 0, s_peak = 0;
+
+static void *tracked(void *p) {
+  if (s_track && p) {
+    s_allocs++;
+    s_live += malloc_usable_size(p);
+    if (s_live > s_peak) s_peak = s_live;
+  }
+  return p;
+}
+
+extern "C" void *malloc(size_t n) { return tracked(__libc_malloc(n)); }
+extern "C" void *calloc(size_t n, size_t m) { return tracked(__libc_calloc(n, m)); }
+extern "C" void *realloc(void *p, size_t n) {
+  if (s_track && p) s_live -= malloc_usable_size(p);
+  return tracked(__libc_realloc(p, n));
+}
+extern "C" void free(void *p) {
+  if (s_track && p) s_live -= malloc_usable_size(p);
+  __libc_free(p);
+}
+
+// -----------------------------------------------------------------------------
+// Generated responses
+static const int WMO_CODES[] = { 0, 1, 2, 3, 45, 51, 61, 63, 80, 95 };
+
+static float genTemp(int h)  { return 14.0f + 8.0f * sinf((h % 24 - 9) * (float)M_PI / 12.0f) + (h / 24) * 0.3f; }
+static int   genCode(int h)  { return WMO_CODES[(h * 7 / 5) % 10]; }
+static int   genHum(int h)   { return 55 + (h * 13) % 40; }
+static float genPress(int h) { return 1004.0f + (h % 48) * 0.25f; }
+
+static const uint32_t GEN_T0 = 1777593600UL;   // 2026-05-01 00:00 UTC
+
+static std::string generate(int days) {
+  int hours = days * 24;
+  char num[32];
+  std::string s = "{\"latitude\":40.64,\"longitude\":22.94,\"generationtime_ms\":0.0989437103271484,"
+                  "\"utc_offset_seconds\":10800,\"timezone\":\"Europe/Athens\","
+                  "\"timezone_abbreviation\":\"EEST\",\"elevation\":21.0,"
+                  "\"hourly_units\":{\"time\":\"unixtime\",\"temperature_2m\":\"\xC2\xB0" "C\","
+                  "\"weathercode\":\"wmo code\",\"relativehumidity_2m\":\"%\","
+                  "\"surface_pressure\":\"hPa\"},\"hourly\":{";
+  const char *fields[] = { "time", "temperature_2m", "weathercode", "relativehumidity_2m",
+                           "surface_pressure" };
+  for (int f = 0; f < 5; ++f) {
+    s += f ? ",\"" : "\"";
+    s += fields[f];
+    s += "\":[";
+    for (int h = 0; h < hours; ++h) {
+      switch (f) {
+        case 0: snprintf(num, sizeof(num), "%lu", (unsigned long)(GEN_T0 + h * 3600UL)); break;
+        case 1: snprintf(num, sizeof(num), "%.1f", genTemp(h)); break;
+        case 2: snprintf(num, sizeof(num), "%d", genCode(h)); break;
+        case 3: snprintf(num, sizeof(num), "%d", genHum(h)); break;
+        default: snprintf(num, sizeof(num), "%.1f", genPress(h)); break;
+      }
+      if (h) s += ",";
+      s += num;
+    }
+    s += "]";
+  }
+  s += "}}";
+  return s;
+}
+
+static int checkGenerated(const WeatherDay *d, int n) {
+  int bad = n == FORECAST_SAMPLES ? 0 : 1;
+  char t[16];
+  for (int i = 0; i < n; ++i) {
+    int h = i * FORECAST_STEP;
+    snprintf(t, sizeof(t), "%.1f", genTemp(h));
+    if (d[i].time != GEN_T0 + h * 3600UL || d[i].temp_c10 != (int16_t)lroundf(atof(t) * 10.0f) ||
+        d[i].humidity != genHum(h) || d[i].press_10 != (uint16_t)lroundf(genPress(h) * 10.0f))
+      bad++;
+  }
+  return bad;
+}
+
+// -----------------------------------------------------------------------------
+struct Parse {
+  int        samples;
+  int32_t    offset;
+  const char *err;
+  WeatherDay days[WEATHER_MAX_DAYS];
+};
+
+static Parse parse(const std::string &body, size_t chunk) {
+  Parse p;
+  memset(&p, 0, sizeof(p));
+  forecastParser_begin();
+  const uint8_t *b = (const uint8_t*)body.data();
+  for (size_t off = 0; off < body.size(); off += chunk) {
+    if (!forecastParser_feed(b + off, std::min(chunk, body.size() - off))) break;
+  }
+  p.samples = forecastParser_finish(p.days, WEATHER_MAX_DAYS, p.offset, p.err);
+  return p;
+}
+
+static int s_failures = 0;
+
+static void bench(const char *label, const std::string &body, bool generated) {
+  const size_t chunks[] = { body.size(), 1460, 536, 64, 1 };
+  Parse ref = parse(body, body.size());
+  if (ref.samples == 0) {
+    printf("%-10s parse failed: %s\n", label, ref.err);
+    s_failures++;
+    return;
+  }
+  if (generated && checkGenerated(ref.days, ref.samples)) {
+    printf("%-10s samples differ from the generated values\n", label);
+    s_failures++;
+  }
+
+  for (size_t chunk : chunks) {
+    int reps = (int)std::max<size_t>(1, 2000000 / body.size() / (chunk == 1 ? 8 : 1));
+    s_allocs = s_live = s_peak = 0;
+    s_track = true;
+    auto t0 = std::chrono::steady_clock::now();
+    Parse p;
+    for (int r = 0; r < reps; ++r) p = parse(body, chunk);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / reps;
+    s_track = false;
+
+    if (p.samples != ref.samples || memcmp(p.days, ref.days, sizeof(WeatherDay) * ref.samples)) {
+      printf("%-10s chunk %zu: samples differ from the whole-body parse\n", label, chunk);
+      s_failures++;
+    }
+    char c[16];
+    if (chunk == body.size()) snprintf(c, sizeof(c), "whole");
+    else snprintf(c, sizeof(c), "%zu", chunk);
+    printf("%-10s %7zu %6s %9.1f %8.1f %7d %4zu / %-5zu %8zu\n", label, body.size(), c, us,
+           body.size() / us, ref.samples, s_allocs / reps, s_peak, body.size() + BENCH_OLD_DOC_B);
+  }
+}
+
+static bool readFile(const char *path, std::string &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  printf("parser state: JsonStream %zu B + %d slots %zu B, static\n", sizeof(JsonStream),
+         FORECAST_SAMPLES, FORECAST_SAMPLES * (sizeof(WeatherDay) + 1));
+  printf("%-10s %7s %6s %9s %8s %7s %12s %8s\n", "payload", "bytes", "chunk", "us/parse", "MB/s",
+         "samples", "allocs/peak", "before");
+
+  const int days[] = { 3, 7, 16 };
+  for (int d : days) {
+    char label[16];
+    snprintf(label, sizeof(label), "gen %dd", d);
+    bench(label, generate(d), true);
+  }
+  for (int i = 1; i < argc; ++i) {
+    std::string body;
+    if (!readFile(argv[i], body)) {
+      printf("%s: cannot read\n", argv[i]);
+      s_failures++;
+      continue;
+    }
+    const char *base = strrchr(argv[i], '/');
+    bench(base ? base + 1 : argv[i], body, false);
+  }
+
+  if (s_failures) {
+    printf("%d checks failed\n", s_failures);
+    return 1;
+  }
+  printf("all chunk sizes produced identical samples\n");
+  return 0;
+}
@@ -0,0 +1,116 @@
+// tools/host/Arduino.h
+// - Minimal stand-in for the Arduino core so host tools can compile firmware modules
+//   unchanged (http_request.cpp, telemetry_codec.cpp, telemetry_queue.cpp, ...).
+// - millis()/micros() run on a simulated clock that only moves when a tool calls
+//   hostClock_advance() (or delay()), so simulations of hours of device time finish
+//   in milliseconds and repeat exactly.
+// - Serial writes to stderr, keeping the tools' result tables on stdout clean.
+// - Print/Stream carry only what the modules call on a port or client; tools derive their
+//   fakes (scripted modem, TLS server) from them.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define RTC_DATA_ATTR                       // RTC slow memory: ordinary statics on the host
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : (x) > (hi) ? (hi) : (x))
+
+// -----------------------------------------------------------------------------
+// Simulated clock
+inline uint64_t &hostClock_us() { static uint64_t us = 0; return us; }
+inline void hostClock_advance(uint32_t ms) { hostClock_us() += (uint64_t)ms * 1000ULL; }
+
+inline unsigned long millis() { return (unsigned long)(hostClock_us() / 1000ULL); }
+inline unsigned long micros() { return (unsigned long)hostClock_us(); }
+inline void delay(uint32_t ms) { hostClock_advance(ms); }
+inline void yield() {}
+
+// -----------------------------------------------------------------------------
+// String: the part of the Arduino API that module headers and logs use
+class String {
+public:
+  String(const char *s = "") : s_(s ? s : "") {}
+  String(const std::string &s) : s_(s) {}
+  explicit String(long v) : s_(std::to_string(v)) {}
+
+  const char *c_str() const { return s_.c_str(); }
+  unsigned int length() const { return (unsigned int)s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  bool reserve(unsigned int n) { s_.reserve(n); return true; }
+  String &operator+=(const String &o) { s_ += o.s_; return *this; }
+  String &operator+=(const char *o) { s_ += o; return *this; }
+  String &operator+=(char c) { s_ += c; return *this; }
+  bool operator==(const String &o) const { return s_ == o.s_; }
+  bool operator==(const char *o) const { return s_ == o; }
+  bool operator!=(const String &o) const { return s_ != o.s_; }
+  friend String operator+(String a, const String &b) { return a += b; }
+
+private:
+  std::string s_;
+};
+
+// -----------------------------------------------------------------------------
+// Print / Stream
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t len) {
+    size_t n = 0;
+    while (len-- && write(*buf++)) n++;
+    return n;
+  }
+  size_t print(const char *s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const String &s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long ms) { timeout_ = ms; }
+  unsigned long getTimeout() const { return timeout_; }
+
+protected:
+  unsigned long timeout_ = 1000;
+};
+
+// -----------------------------------------------------------------------------
+// Serial (log output only; quiet suppresses it)
+struct HostSerial {
+  bool quiet = false;
+
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    if (quiet) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    return n;
+  }
+  size_t print(const char *s) { return quiet ? 0 : fputs(s, stderr) >= 0 ? strlen(s) : 0; }
+  size_t print(const String &s) { return print(s.c_str()); }
+  size_t print(long v) { return (size_t)this->printf("%ld", v); }
+  size_t println(const char *s = "") { size_t n = print(s); return n + print("\n"); }
+  size_t println(const String &s) { return println(s.c_str()); }
+  size_t println(long v) { return (size_t)this->printf("%ld\n", v); }
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,24 @@
+// tools/host/Client.h
+// - Arduino network client interface. Modules pass clients around (net_transport.h) and
+//   http_async.cpp drives them; host tools implement it with scripted fakes.
+#ifndef HOST_CLIENT_H
+#define HOST_CLIENT_H
+
+#include <Arduino.h>
+
+class Client : public Stream {
+public:
+  virtual int     connect(const char *host, uint16_t port) = 0;
+  virtual size_t  write(uint8_t c) = 0;
+  virtual size_t  write(const uint8_t *buf, size_t len) = 0;
+  virtual int     available() = 0;
+  virtual int     read() = 0;
+  virtual int     read(uint8_t *buf, size_t len) = 0;
+  virtual int     peek() = 0;
+  virtual void    flush() = 0;
+  virtual void    stop() = 0;
+  virtual uint8_t connected() = 0;
+  virtual explicit operator bool() = 0;
+};
+
+#endif // HOST_CLIENT_H
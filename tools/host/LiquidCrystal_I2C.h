@@ -0,0 +1,13 @@
+// tools/host/LiquidCrystal_I2C.h
+// - Type only, for the extern lcd declaration in config.h.
+#ifndef HOST_LIQUIDCRYSTAL_I2C_H
+#define HOST_LIQUIDCRYSTAL_I2C_H
+
+#include <Arduino.h>
+
+class LiquidCrystal_I2C {
+public:
+  LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows) { (void)addr; (void)cols; (void)rows; }
+};
+
+#endif // HOST_LIQUIDCRYSTAL_I2C_H
@@ -0,0 +1,77 @@
+// tools/host/Preferences.h
+// - In-memory NVS for host tools: one key/value map per namespace, kept for the life
+//   of the process, so state written by one Preferences object is seen by the next.
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false) {
+    ns_ = &store()[name];
+    readOnly_ = readOnly;
+    return true;
+  }
+  void end() { ns_ = nullptr; }
+
+  bool isKey(const char *key) { return ns_ && ns_->count(key); }
+  bool remove(const char *key) { return writable() && ns_->erase(key) > 0; }
+  bool clear() { if (!writable()) return false; ns_->clear(); return true; }
+
+  size_t putBytes(const char *key, const void *v, size_t len) {
+    if (!writable()) return 0;
+    (*ns_)[key].assign((const char*)v, len);
+    return len;
+  }
+  size_t getBytes(const char *key, void *buf, size_t len) {
+    const std::string *v = find(key);
+    if (!v || v->size() > len) return 0;
+    memcpy(buf, v->data(), v->size());
+    return v->size();
+  }
+  size_t getBytesLength(const char *key) { const std::string *v = find(key); return v ? v->size() : 0; }
+
+  size_t putUChar(const char *k, uint8_t v)  { return put(k, v); }
+  size_t putInt(const char *k, int32_t v)    { return put(k, v); }
+  size_t putUInt(const char *k, uint32_t v)  { return put(k, v); }
+  size_t putLong(const char *k, int32_t v)   { return put(k, v); }
+  size_t putFloat(const char *k, float v)    { return put(k, v); }
+  size_t putBool(const char *k, bool v)      { return put(k, (uint8_t)v); }
+
+  uint8_t  getUChar(const char *k, uint8_t d = 0)  { return get(k, d); }
+  int32_t  getInt(const char *k, int32_t d = 0)    { return get(k, d); }
+  uint32_t getUInt(const char *k, uint32_t d = 0)  { return get(k, d); }
+  int32_t  getLong(const char *k, int32_t d = 0)   { return get(k, d); }
+  float    getFloat(const char *k, float d = NAN)  { return get(k, d); }
+  bool     getBool(const char *k, bool d = false)  { return get(k, (uint8_t)d) != 0; }
+
+private:
+  typedef std::map<std::string, std::string> Namespace;
+  static std::map<std::string, Namespace> &store() {
+    static std::map<std::string, Namespace> s;
+    return s;
+  }
+
+  bool writable() const { return ns_ && !readOnly_; }
+  const std::string *find(const char *key) const {
+    if (!ns_) return nullptr;
+    Namespace::const_iterator it = ns_->find(key);
+    return it == ns_->end() ? nullptr : &it->second;
+  }
+  template <typename T> size_t put(const char *key, T v) { return putBytes(key, &v, sizeof(v)); }
+  template <typename T> T get(const char *key, T def) {
+    const std::string *v = find(key);
+    if (!v || v->size() != sizeof(T)) return def;
+    T out;
+    memcpy(&out, v->data(), sizeof(T));
+    return out;
+  }
+
+  Namespace *ns_ = nullptr;
+  bool readOnly_ = false;
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,89 @@
+// tools/host/SD.h
+// - SD card for host tools, backed by files under a host directory (SD.setRoot(), the
+//   current directory by default). Modes are the ESP32 core's fopen strings.
+// - SD.failWritesAfter(n) lets the nth following write fail, to exercise the callers'
+//   error paths (e.g. the telemetry queue falling back to RAM).
+// - SD.io counts the read/write calls and bytes, the figures that matter on a card.
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+class File {
+public:
+  File() {}
+  explicit File(FILE *f) { if (f) f_.reset(f, fclose); }
+
+  explicit operator bool() const { return (bool)f_; }
+  void close() { f_.reset(); }
+
+  size_t read(uint8_t *buf, size_t len);
+  size_t write(const uint8_t *buf, size_t len);
+  bool   seek(uint32_t pos) { return f_ && fseek(f_.get(), (long)pos, SEEK_SET) == 0; }
+  void   flush() { if (f_) fflush(f_.get()); }
+  size_t size() {
+    if (!f_) return 0;
+    struct stat st;
+    return fstat(fileno(f_.get()), &st) == 0 ? (size_t)st.st_size : 0;
+  }
+
+private:
+  std::shared_ptr<FILE> f_;
+};
+
+class SDFS {
+public:
+  bool begin(int cs = -1) { (void)cs; return true; }
+  void setRoot(const char *dir) { root_ = dir; }
+
+  bool exists(const char *path) { struct stat st; return stat(full(path).c_str(), &st) == 0; }
+  bool remove(const char *path) { return ::remove(full(path).c_str()) == 0; }
+  File open(const char *path, const char *mode = FILE_READ) {
+    std::string m = std::string(mode) + "b";
+    return File(fopen(full(path).c_str(), m.c_str()));
+  }
+
+  // Fault injection: the nth write from now (1 = the next one) and all after it fail
+  void failWritesAfter(int n) { failIn_ = n; }
+  bool writeFails() {
+    if (failIn_ == 0) return false;
+    if (failIn_ > 0 && --failIn_ > 0) return false;
+    failIn_ = -1;
+    return true;
+  }
+  void clearFaults() { failIn_ = 0; }
+
+  struct { uint32_t reads, writes, bytesRead, bytesWritten; } io = { 0, 0, 0, 0 };
+
+private:
+  std::string full(const char *path) const { return root_ + path; }
+  std::string root_ = ".";
+  int failIn_ = 0;      // 0: no fault armed, -1: failing
+};
+
+inline SDFS SD;
+
+inline size_t File::read(uint8_t *buf, size_t len) {
+  if (!f_) return 0;
+  size_t n = fread(buf, 1, len, f_.get());
+  SD.io.reads++;
+  SD.io.bytesRead += n;
+  return n;
+}
+
+inline size_t File::write(const uint8_t *buf, size_t len) {
+  if (!f_ || SD.writeFails()) return 0;
+  size_t n = fwrite(buf, 1, len, f_.get());
+  SD.io.writes++;
+  SD.io.bytesWritten += n;
+  return n;
+}
+
+#endif // HOST_SD_H
@@ -0,0 +1,17 @@
+// tools/host/SPI.h
+// - Empty SPI bus for host tools (INIT_SD_CARD in config.h calls SPI.begin()).
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+class SPIClass {
+public:
+  void begin(int sck = -1, int miso = -1, int mosi = -1, int ss = -1) {
+    (void)sck; (void)miso; (void)mosi; (void)ss;
+  }
+};
+
+inline SPIClass SPI;
+
+#endif // HOST_SPI_H
@@ -0,0 +1,15 @@
+// tools/host/TinyGsmClient.h
+// - The modem type modem_manager.h names. Host tools talk to their fake modem through
+//   the AT engine, never through TinyGSM.
+#ifndef HOST_TINYGSMCLIENT_H
+#define HOST_TINYGSMCLIENT_H
+
+#include <Arduino.h>
+
+class TinyGsm {
+public:
+  explicit TinyGsm(Stream &s) : stream(s) {}
+  Stream &stream;
+};
+
+#endif // HOST_TINYGSMCLIENT_H
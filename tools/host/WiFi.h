@@ -0,0 +1,43 @@
+// tools/host/WiFi.h
+// - Station status constants and the resolver; host tools never bring up a network.
+// - WiFi.hostByName() answers every name with WiFi.dnsAddress unless dnsFails is set.
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS    = 0,
+  WL_NO_SSID_AVAIL  = 1,
+  WL_CONNECTED      = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED   = 6
+} wl_status_t;
+
+class IPAddress {
+public:
+  IPAddress(uint32_t a = 0) : addr_(a) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    : addr_((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+  operator uint32_t() const { return addr_; }
+
+private:
+  uint32_t addr_;
+};
+
+struct HostWiFi {
+  IPAddress dnsAddress = IPAddress(192, 0, 2, 1);
+  bool      dnsFails = false;
+  uint32_t  lookups = 0;
+
+  int hostByName(const char *host, IPAddress &out) {
+    lookups++;
+    if (dnsFails || !host || !*host) return 0;
+    out = dnsAddress;
+    return 1;
+  }
+};
+
+inline HostWiFi WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,24 @@
+// tools/host/WiFiClientSecure.h
+// - The TLS client type http_async.cpp casts WiFi pool clients to. Abstract on the host:
+//   tools derive a fake server from it. connect() by address defaults to connect(host).
+#ifndef HOST_WIFICLIENTSECURE_H
+#define HOST_WIFICLIENTSECURE_H
+
+#include <Client.h>
+#include <WiFi.h>
+
+class WiFiClientSecure : public Client {
+public:
+  using Client::connect;
+  virtual int connect(IPAddress ip, uint16_t port, const char *host, const char *caCert,
+                      const char *cert, const char *privateKey) {
+    (void)ip; (void)caCert; (void)cert; (void)privateKey;
+    return connect(host, port);
+  }
+  void setHandshakeTimeout(unsigned long seconds) { handshakeTimeout_ = seconds; }
+
+protected:
+  unsigned long handshakeTimeout_ = 120;
+};
+
+#endif // HOST_WIFICLIENTSECURE_H
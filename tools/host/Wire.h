@@ -0,0 +1,15 @@
+// tools/host/Wire.h
+// - Empty I2C bus for host tools (config.h includes it; nothing on the host talks I2C).
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t freq = 0) { (void)sda; (void)scl; (void)freq; return true; }
+};
+
+inline TwoWire Wire;
+
+#endif // HOST_WIRE_H
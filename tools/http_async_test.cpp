@@ -0,0 +1,316 @@
+// tools/http_async_test.cpp
+// - Host test for the HTTPS engine (http_async.cpp): response framing and the keep-alive
+//   pool, run against an in-process stand-in for the TLS server.
+// - FakeTls is the client net_transport would hand out for a pool slot. "Connecting" counts
+//   a handshake; each request written to it is answered with the next scripted reply, and
+//   reads return at most readChunk bytes so split records (down to 1 byte) are exercised.
+// - Cases: chunked bodies with chunk extensions and trailers, Content-Length, read-to-close,
+//   keep-alive reuse across hosts and transports, server "Connection: close", a reused
+//   socket the server already dropped (retried once on a fresh one), error bodies drained
+//   but not delivered, Range/206, and idle expiry after HTTP_KEEPALIVE_MS.
+// - Reports per case the status, body bytes and the handshake/reuse counters; the exit
+//   status is 1 if any check fails.
+// - Build and run from the repository root:
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/http_async_test.cpp http_async.cpp -o http_async_test
+//     ./http_async_test
+#include "http_async.h"
+#include "net_transport.h"
+#include "power_manager.h"
+#include "config.h"
+#include <WiFiClientSecure.h>
+#include <deque>
+#include <string>
+
+#define TEST_POLL_LIMIT 100000
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (ok) return;
+  if (s_failures++ < 10) printf("FAILED: %s\n", what);
+}
+
+// -----------------------------------------------------------------------------
+// Scripted server: one reply per request, in order, whichever slot asks
+struct Reply {
+  std::string bytes;
+  bool        closeAfter;   // server closes the socket once the reply is sent
+};
+
+static std::deque<Reply> s_replies;
+static std::string       s_lastRequest;
+
+static void script(const std::string &bytes, bool closeAfter = false) {
+  s_replies.push_back({ bytes, closeAfter });
+}
+
+class FakeTls : public WiFiClientSecure {
+public:
+  size_t   readChunk = 1460;
+  bool     dropOnWrite = false;     // peer already closed: the next request goes nowhere
+  bool     refuseWrite = false;     // peer already closed: the next write fails
+  uint32_t connects = 0;
+
+  int connect(const char *host, uint16_t port) override {
+    (void)host; (void)port;
+    connects++;
+    open_ = true;
+    rx_.clear();
+    pos_ = 0;
+    return 1;
+  }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buf, size_t len) override {
+    if (!open_ || refuseWrite) { refuseWrite = false; return 0; }
+    s_lastRequest.assign((const char*)buf, len);
+    if (dropOnWrite) { dropOnWrite = false; open_ = false; return len; }
+    if (s_replies.empty()) return len;
+    rx_.append(s_replies.front().bytes);
+    if (s_replies.front().closeAfter) open_ = false;
+    s_replies.pop_front();
+    return len;
+  }
+  int available() override { return (int)(rx_.size() - pos_); }
+  int read() override { return pos_ < rx_.size() ? (uint8_t)rx_[pos_++] : -1; }
+  int read(uint8_t *buf, size_t len) override {
+    size_t n = std::min(std::min(len, readChunk), rx_.size() - pos_);
+    memcpy(buf, rx_.data() + pos_, n);
+    pos_ += n;
+    return (int)n;
+  }
+  int peek() override { return pos_ < rx_.size() ? (uint8_t)rx_[pos_] : -1; }
+  void flush() override {}
+  void stop() override { open_ = false; rx_.clear(); pos_ = 0; }
+  uint8_t connected() override { return open_; }
+  explicit operator bool() override { return open_; }
+
+  size_t unread() const { return rx_.size() - pos_; }
+  void serverClose() { open_ = false; }
+
+private:
+  bool        open_ = false;
+  std::string rx_;
+  size_t      pos_ = 0;
+};
+
+// -----------------------------------------------------------------------------
+// Hooks http_async.cpp links against
+static FakeTls      s_fakes[NET_TRANSPORT_COUNT][HTTP_POOL_SLOTS];
+static NetTransport s_net = NET_WIFI;
+static int          s_locks = 0;
+
+NetTransport netTransport_select() { return s_net; }
+bool netTransport_isUp(NetTransport t) { return t != NET_NONE; }
+Client *netTransport_tlsClient(NetTransport t, uint8_t slot) { return &s_fakes[t][slot]; }
+void netTransport_recordConnect(NetTransport, uint32_t, bool) {}
+void netTransport_addBytes(NetTransport, uint32_t, uint32_t) {}
+void power_acquire(PowerLock) { s_locks++; }
+void power_release(PowerLock) { s_locks--; }
+
+static void setReadChunk(size_t n) {
+  for (auto &row : s_fakes)
+    for (FakeTls &f : row) f.readChunk = n;
+}
+
+static uint32_t connects() {
+  uint32_t n = 0;
+  for (auto &row : s_fakes)
+    for (FakeTls &f : row) n += f.connects;
+  return n;
+}
+
+// -----------------------------------------------------------------------------
+struct Result {
+  HttpPhase   phase;
+  int         status;
+  std::string body;
+  std::string err;
+};
+
+static bool sink(const uint8_t *data, size_t len, void *ctx) {
+  static_cast<std::string*>(ctx)->append((const char*)data, len);
+  return true;
+}
+
+static Result get(const char *host, const char *path) {
+  Result r;
+  r.phase = HTTP_FAILED;
+  r.status = 0;
+  if (!httpAsync_start(host, path, sink, nullptr, &r.body)) {
+    r.err = httpAsync_lastError();
+    return r;
+  }
+  for (int i = 0; i < TEST_POLL_LIMIT && httpAsync_busy(); ++i) {
+    httpAsync_poll();
+    hostClock_advance(1);
+  }
+  check(!httpAsync_busy(), "request ends");
+  r.phase = httpAsync_phase();
+  r.status = httpAsync_statusCode();
+  r.err = httpAsync_lastError();
+  return r;
+}
+
+static void report(const char *label, const Result &r) {
+  printf("%-26s %4d %-6s %6zu %10lu %7lu\n", label, r.status,
+         r.phase == HTTP_DONE ? "done" : httpAsync_phaseName(r.phase), r.body.size(),
+         (unsigned long)httpAsync_handshakes(), (unsigned long)httpAsync_reuses());
+}
+
+static std::string bodyOf(size_t n) {
+  std::string s;
+  for (size_t i = 0; i < n; ++i) s += (char)('a' + i * 7 % 26);
+  return s;
+}
+
+static std::string lengthReply(int status, const std::string &body, const char *extra = "") {
+  char head[160];
+  snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+           "Content-Length: %zu\r\n%s\r\n", status, status < 300 ? "OK" : "Error", body.size(), extra);
+  return head + body;
+}
+
+// Chunks of the given sizes with an extension on the first and a trailer field at the end
+static std::string chunkedReply(const std::string &body, const size_t *sizes, int count) {
+  std::string s = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n";
+  size_t off = 0;
+  char line[32];
+  for (int i = 0; i < count; ++i) {
+    snprintf(line, sizeof(line), i == 0 ? "%zx;ext=\"a b\"\r\n" : "%zX\r\n", sizes[i]);
+    s += line;
+    s += body.substr(off, sizes[i]);
+    s += "\r\n";
+    off += sizes[i];
+  }
+  return s + "0\r\nX-Checksum: 5f3a\r\nServer-Timing: db;dur=53\r\n\r\n";
+}
+
+// -----------------------------------------------------------------------------
+int main() {
+  Serial.quiet = true;
+  printf("%-26s %4s %-6s %6s %10s %7s\n", "case", "code", "phase", "body", "handshakes", "reuses");
+
+  // chunked, one byte per read: extensions, upper/lower case sizes, trailer
+  std::string body = bodyOf(3000);
+  const size_t sizes[] = { 1, 255, 1024, 1720 };
+  script(chunkedReply(body, sizes, 4));
+  setReadChunk(1);
+  Result r = get("api.open-meteo.com", "/v1/forecast?latitude=40.64");
+  report("chunked, 1-byte reads", r);
+  check(r.phase == HTTP_DONE && r.body == body, "chunked body decoded");
+  check(s_fakes[NET_WIFI][0].unread() == 0, "trailer consumed before the socket goes idle");
+  check(s_lastRequest.find("Connection: keep-alive\r\n") != std::string::npos, "request asks for keep-alive");
+  check(httpAsync_handshakes() == 1 && httpAsync_reuses() == 0, "first request handshakes");
+
+  // same host again: the kept-alive socket is reused, no DNS or handshake
+  script(lengthReply(200, "{\"ok\":1}"));
+  setReadChunk(7);
+  uint32_t lookups = WiFi.lookups;
+  r = get("api.open-meteo.com", "/v1/forecast?latitude=40.65");
+  report("content-length, reused", r);
+  check(r.phase == HTTP_DONE && r.body == "{\"ok\":1}", "content-length body");
+  check(httpAsync_handshakes() == 1 && httpAsync_reuses() == 1, "second request reuses");
+  check(WiFi.lookups == lookups, "reuse skips DNS");
+
+  // a second host fills the other slot; alternating keeps both alive
+  setReadChunk(1460);
+  for (int i = 0; i < 4; ++i) {
+    script(lengthReply(200, bodyOf(100)));
+    r = get(i % 2 ? "api.open-meteo.com" : "geocoding-api.open-meteo.com", "/v1/search?name=x");
+    check(r.phase == HTTP_DONE && r.body.size() == 100, "two-host body");
+  }
+  report("two hosts, alternating", r);
+  check(httpAsync_handshakes() == 2 && httpAsync_reuses() == 4, "one handshake per host");
+
+  // a third host evicts the least recently used slot (open-meteo's geocoder)
+  script(lengthReply(200, bodyOf(10)));
+  r = get("api.openweathermap.org", "/data/2.5/weather");
+  script(lengthReply(200, bodyOf(10)));
+  r = get("api.open-meteo.com", "/v1/forecast");
+  report("third host evicts oldest", r);
+  check(httpAsync_handshakes() == 3 && httpAsync_reuses() == 5, "eviction keeps the recent host");
+
+  // the same host over LTE is a different connection
+  s_net = NET_LTE;
+  script(lengthReply(200, bodyOf(10)));
+  r = get("api.open-meteo.com", "/v1/forecast");
+  report("same host over LTE", r);
+  check(r.phase == HTTP_DONE && httpAsync_handshakes() == 4, "pool is per transport");
+  s_net = NET_WIFI;
+
+  // server asks to close: the socket is not kept
+  script(lengthReply(200, bodyOf(50), "Connection: close\r\n"), true);
+  r = get("api.open-meteo.com", "/v1/forecast");
+  script(lengthReply(200, bodyOf(50)));
+  r = get("api.open-meteo.com", "/v1/forecast");
+  report("connection: close", r);
+  check(r.phase == HTTP_DONE && httpAsync_handshakes() == 5 && httpAsync_reuses() == 6,
+        "closed connection is not reused");
+
+  // server dropped the idle socket while the client still thought it open: the request
+  // goes out, nothing comes back, and it is retried once on a fresh connection
+  for (auto &row : s_fakes)
+    for (FakeTls &f : row) if (f.connected()) f.dropOnWrite = true;
+  script(lengthReply(200, bodyOf(40)));
+  r = get("api.open-meteo.com", "/v1/forecast");
+  report("reused socket was closed", r);
+  check(r.phase == HTTP_DONE && r.body.size() == 40, "retried on a fresh socket");
+  check(httpAsync_handshakes() == 6 && httpAsync_reuses() == 7, "retry handshakes once");
+
+  // ... or the write itself fails
+  for (auto &row : s_fakes)
+    for (FakeTls &f : row) if (f.connected()) f.refuseWrite = true;
+  script(lengthReply(200, bodyOf(40)));
+  r = get("api.open-meteo.com", "/v1/forecast");
+  report("reused socket refused", r);
+  check(r.phase == HTTP_DONE && r.body.size() == 40, "write failure retried");
+  check(httpAsync_handshakes() == 7 && httpAsync_reuses() == 8, "write retry handshakes once");
+
+  // error statuses: the body is drained, not delivered, and the request fails
+  script(lengthReply(404, "{\"error\":true,\"reason\":\"not found\"}"));
+  r = get("api.open-meteo.com", "/v1/missing");
+  report("404 with a body", r);
+  check(r.phase == HTTP_FAILED && r.status == 404 && r.body.empty() && r.err == "HTTP_404",
+        "error body not delivered");
+  check(httpAsync_bytesReceived() == 35, "error body drained");
+
+  // Range: 206 counts as success when a range was asked for
+  httpAsync_setRangeStart(100);
+  script("HTTP/1.1 206 Partial Content\r\nContent-Range: bytes 100-149/150\r\n"
+         "Content-Length: 50\r\n\r\n" + bodyOf(50));
+  r = get("api.open-meteo.com", "/v1/forecast");
+  report("range, 206", r);
+  check(r.phase == HTTP_DONE && r.body.size() == 50, "206 delivered");
+  check(s_lastRequest.find("Range: bytes=100-\r\n") != std::string::npos, "range header sent");
+
+  // no length, not chunked: the body runs until the server closes
+  script("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\n" + bodyOf(777), true);
+  r = get("api.open-meteo.com", "/v1/forecast");
+  report("read until close", r);
+  check(r.phase == HTTP_DONE && r.body.size() == 777, "read-to-close body");
+
+  // idle sockets are closed after HTTP_KEEPALIVE_MS, then the next request handshakes
+  script(lengthReply(200, bodyOf(10)));
+  r = get("api.open-meteo.com", "/v1/forecast");
+  uint32_t hs = httpAsync_handshakes();
+  httpAsync_closeIdle(false);
+  check(s_fakes[NET_WIFI][0].connected() || s_fakes[NET_WIFI][1].connected(), "fresh idle socket kept");
+  hostClock_advance(HTTP_KEEPALIVE_MS + 1);
+  httpAsync_closeIdle(false);
+  for (FakeTls &f : s_fakes[NET_WIFI]) check(!f.connected(), "expired idle socket closed");
+  script(lengthReply(200, bodyOf(10)));
+  r = get("api.open-meteo.com", "/v1/forecast");
+  report("after keep-alive expiry", r);
+  check(httpAsync_handshakes() == hs + 1, "expired socket not reused");
+
+  check(s_replies.empty(), "every scripted reply was read");
+  check(s_locks == 0, "power lock released after every request");
+  check(connects() == httpAsync_handshakes(), "handshake counter matches server connects");
+
+  if (s_failures) {
+    printf("%d checks failed\n", s_failures);
+    return 1;
+  }
+  printf("all http_async checks passed\n");
+  return 0;
+}
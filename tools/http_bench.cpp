@@ -0,0 +1,350 @@
+// tools/http_bench.cpp
+// - Host load test for the key server's request path: the incremental parser
+//   (http_request.cpp), route/asset dispatch (httpTable_find over the same sorted tables)
+//   and response head formatting, driven by a browser-like mix of keep-alive requests.
+// - Each request is fed to the parser in segments of a given size, as TCP reads would
+//   deliver it, so the 1-byte run shows the cost of resuming a split request.
+// - Reports requests/s and p50/p99/max latency per segment size.
+// - Dispatch alone: ns and allocations per lookup of a path in the route and asset tables,
+//   against the String == chain the table replaced (the path copied into a String and
+//   compared with each route, then each asset, in turn). The host String keeps short
+//   paths inline, so the chain's allocation count here is a lower bound.
+// - GET /: bytes sent and host time to produce the response for the dashboard from flash
+//   (first visit: index.html and app.js gzip; revisit: two 304s) against the dynamic form
+//   page (key_pages.h, still sent to clients without gzip) and the String-built page it
+//   replaced (makeFormPage() as it was, reproduced here since it is gone from the tree).
+//   Heap allocations per response are counted through the glibc malloc entry points.
+// - Build and run from the repository root:
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/http_bench.cpp http_request.cpp -o http_bench
+//     ./http_bench [requests]
+#include "http_request.h"
+#include "key_routes.h"
+#include "key_pages.h"
+#include "web_assets.h"
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+#include <malloc.h>
+#include <string>
+#include <vector>
+
+// Request buffers are compacted the way key_server.cpp does
+#define BENCH_REQ_BUF KS_REQ_BUF
+#define BENCH_HDR_MAX 256
+
+// The firmware's route table (key_routes.h) without the handlers
+struct BenchRoute {
+  const char *path;
+  uint8_t     methods;
+};
+
+#define BENCH_ROUTE(path, methods, handler) { path, methods },
+static const BenchRoute ROUTES[] = { KS_ROUTES(BENCH_ROUTE) };
+#undef BENCH_ROUTE
+static const int ROUTE_COUNT = sizeof(ROUTES) / sizeof(ROUTES[0]);
+
+// -----------------------------------------------------------------------------
+// Allocation counting (glibc)
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+
+static size_t s_allocs = 0;
+
+extern "C" void *malloc(size_t n) { s_allocs++; return __libc_malloc(n); }
+extern "C" void *calloc(size_t n, size_t m) { s_allocs++; return __libc_calloc(n, m); }
+extern "C" void *realloc(void *p, size_t n) { s_allocs++; return __libc_realloc(p, n); }
+
+// -----------------------------------------------------------------------------
+// Request mix: what a dashboard tab sends on a revisit, plus a form post and a miss
+static const char *HDRS =
+  "Host: beehive.local\r\n"
+  "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+  "Accept: */*\r\n"
+  "Accept-Language: en-US,en;q=0.5\r\n"
+  "Accept-Encoding: gzip, deflate\r\n"
+  "Connection: keep-alive\r\n";
+
+static std::vector<std::string> buildMix() {
+  std::vector<std::string> mix;
+  mix.push_back(std::string("GET /index.html HTTP/1.1\r\n") + HDRS + "\r\n");
+  mix.push_back(std::string("GET /app.js HTTP/1.1\r\n") + HDRS +
+                "If-None-Match: " + WEB_ASSETS[0].etag + "\r\n\r\n");
+  mix.push_back(std::string("GET /api/status HTTP/1.1\r\n") + HDRS + "\r\n");
+  mix.push_back(std::string("GET /api/measurements?since=0 HTTP/1.1\r\n") + HDRS + "\r\n");
+  const char *form = "city=Thessaloniki&country=GR";
+  mix.push_back(std::string("POST /set HTTP/1.1\r\n") + HDRS +
+                "Content-Type: application/x-www-form-urlencoded\r\n"
+                "Content-Length: " + std::to_string(strlen(form)) + "\r\n\r\n" + form);
+  mix.push_back(std::string("GET /favicon.ico HTTP/1.1\r\n") + HDRS + "\r\n");
+  return mix;
+}
+
+// -----------------------------------------------------------------------------
+struct Conn {
+  char        in[BENCH_REQ_BUF];
+  uint16_t    used;
+  HttpRequest req;
+  char        hdr[BENCH_HDR_MAX];
+  char        out[KS_RESP_BUF];
+};
+
+static size_t writeHead(Conn &c, int code, const char *type, uint32_t contentLength,
+                        const char *extra) {
+  int n = snprintf(c.hdr, sizeof(c.hdr),
+                   "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %lu\r\n"
+                   "Connection: %s\r\n%s\r\n",
+                   code, code == 200 ? "OK" : code == 304 ? "Not Modified" : "Not Found", type,
+                   (unsigned long)contentLength, c.req.keepAlive ? "keep-alive" : "close", extra);
+  return n > 0 ? (size_t)n : 0;
+}
+
+static size_t sendAsset(Conn &c, const WebAsset *a) {
+  const HttpRequest &r = c.req;
+  char extra[112];
+  int n = snprintf(extra, sizeof(extra), "ETag: %s\r\nCache-Control: no-cache\r\n%s",
+                   a->etag, "Vary: Accept-Encoding\r\n");
+  if (r.ifNoneMatch.len && httpSpan_contains(c.in, r.ifNoneMatch, a->etag))
+    return writeHead(c, 304, a->contentType, 0, extra);
+  snprintf(extra + n, sizeof(extra) - n, "Content-Encoding: gzip\r\n");
+  return writeHead(c, 200, a->contentType, a->gzLen, extra) + a->gzLen;
+}
+
+static size_t sendFormPage(Conn &c, const char *status) {
+  HttpBody b;
+  httpBody_init(b, c.out, sizeof(c.out));
+  keyPages_form(b, status);
+  return writeHead(c, 200, "text/html; charset=UTF-8", b.len, "") + b.len;
+}
+
+// Dispatch a parsed request the way key_server.cpp does; returns the bytes that would be sent
+static size_t dispatch(Conn &c) {
+  const HttpRequest &r = c.req;
+  const char *path = c.in + r.path.off;
+  uint8_t method = httpSpan_equals(c.in, r.method, "GET") ? M_GET
+                 : httpSpan_equals(c.in, r.method, "POST") ? M_POST : 0;
+
+  const BenchRoute *route = httpTable_find(ROUTES, ROUTE_COUNT, path, r.path.len);
+  if (route && (route->methods & method)) {
+    if (route->path[1] == 0) {   // handleRoot
+      const WebAsset *index = httpTable_find(WEB_ASSETS, WEB_ASSET_COUNT, "/index.html", 11);
+      if (index && method == M_GET && httpSpan_contains(c.in, r.acceptEncoding, "gzip"))
+        return sendAsset(c, index);
+      return sendFormPage(c, "");
+    }
+    if (strcmp(route->path, "/set") == 0) {
+      char city[48], country[8], status[128];
+      HttpSpan form = method == M_POST ? r.body : r.query;
+      httpRequest_formValue(c.in, form, "city", city, sizeof(city));
+      httpRequest_formValue(c.in, form, "country", country, sizeof(country));
+      snprintf(status, sizeof(status), "Geocode queued for %s. Reload this page for the result.", city);
+      return sendFormPage(c, status);
+    }
+    // the other handler bodies (JSON) depend on device state and are not measured
+    return writeHead(c, 200, "application/json", 0, "Cache-Control: no-store\r\n");
+  }
+
+  const WebAsset *a = httpTable_find(WEB_ASSETS, WEB_ASSET_COUNT, path, r.path.len);
+  if (!a) return writeHead(c, 404, "text/plain", 0, "");
+  return sendAsset(c, a);
+}
+
+// Feed one request in segments of seg bytes; returns bytes sent or 0 on a parse failure
+static size_t serve(Conn &c, const std::string &req, size_t seg) {
+  size_t fed = 0;
+  while (fed < req.size()) {
+    size_t n = std::min(seg, req.size() - fed);
+    memcpy(c.in + c.used, req.data() + fed, n);
+    c.used += n;
+    fed += n;
+    HttpParseResult res = httpRequest_parse(c.req, c.in, c.used, sizeof(c.in));
+    if (res == HTTP_REQ_MORE) continue;
+    if (res != HTTP_REQ_DONE) return 0;
+    size_t sent = dispatch(c);
+    memmove(c.in, c.in + c.req.total, c.used - c.req.total);
+    c.used -= c.req.total;
+    httpRequest_reset(c.req);
+    return sent;
+  }
+  return 0;
+}
+
+static void run(const std::vector<std::string> &mix, size_t seg, int requests) {
+  static Conn c;
+  c.used = 0;
+  httpRequest_reset(c.req);
+
+  std::vector<double> lat;
+  lat.reserve(requests);
+  size_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < requests; ++i) {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t sent = serve(c, mix[i % mix.size()], seg);
+    auto t1 = std::chrono::steady_clock::now();
+    if (sent == 0) {
+      fprintf(stderr, "request %d failed to parse\n", i);
+      return;
+    }
+    bytes += sent;
+    lat.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::sort(lat.begin(), lat.end());
+  auto pct = [&](double p) { return lat[(size_t)(p * (lat.size() - 1))]; };
+  char label[16];
+  if (seg >= BENCH_REQ_BUF) snprintf(label, sizeof(label), "whole");
+  else snprintf(label, sizeof(label), "%zu B", seg);
+  printf("%-8s %12.0f %9.0f %9.0f %9.0f %10.1f\n", label, requests / secs, pct(0.50),
+         pct(0.99), lat.back(), (double)bytes / requests);
+}
+
+// -----------------------------------------------------------------------------
+// The page GET / sent before the gzip dashboard: makeFormPage() and sendHttpResponse() of
+// the original key_server.cpp, built with String +=. Returns the bytes it sent.
+static size_t makeFormPageBefore(const String &status) {
+  String page;
+  page.reserve(1024);
+  page += "<!doctype html><html><head><meta charset='utf-8'><title>Beehive: Provision</title></head><body>";
+  page += "<h3>Beehive Provisioning</h3>";
+  if (status.length()) {
+    page += "<p><b>Status:</b> ";
+    page += status;
+    page += "</p>";
+  }
+
+  page += "<p><i>Enter City and (optional) 2-letter Country code. Location will be used with Open‑Meteo (no API key required).</i></p>";
+
+  page += "<form method='POST' action='/set'>";
+  page += "City: <input name='city' style='width:200px' placeholder='e.g. Elefsina'> Country (2-letter ISO): <input name='country' style='width:60px' placeholder='GR'><br><br>";
+  page += "<input type='submit' value='Save'>";
+  page += "</form>";
+  page += "<p>Or use GET: /set?city=Athens&country=GR</p>";
+  page += "</body></html>";
+
+  char len[48];
+  snprintf(len, sizeof(len), "Content-Length: %u\r\n\r\n", (unsigned)page.length());
+  String head = "HTTP/1.1 200 OK\r\n";
+  head += "Content-Type: text/html; charset=UTF-8\r\n";
+  head += "Connection: close\r\n";
+  head += len;
+  return head.length() + page.length();
+}
+
+struct Cost {
+  double ns;
+  double allocs;
+};
+
+template <typename F> static Cost timeNs(int reps, F fn) {
+  size_t allocs = s_allocs;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r) fn();
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+  return { ns / reps, (double)(s_allocs - allocs) / reps };
+}
+
+// Parse req once, then time producing its response (dispatch and head formatting)
+static Cost responseNs(const std::string &req, int reps, size_t &bytes) {
+  static Conn c;
+  c.used = (uint16_t)req.size();
+  memcpy(c.in, req.data(), req.size());
+  httpRequest_reset(c.req);
+  if (httpRequest_parse(c.req, c.in, c.used, sizeof(c.in)) != HTTP_REQ_DONE) {
+    fprintf(stderr, "request did not parse\n");
+    exit(1);
+  }
+  return timeNs(reps, [&] { bytes = dispatch(c); });
+}
+
+// -----------------------------------------------------------------------------
+// Dispatch: index into ROUTES, ROUTE_COUNT + index into WEB_ASSETS, or -1
+static int lookupTable(const char *p, size_t len) {
+  if (const BenchRoute *r = httpTable_find(ROUTES, ROUTE_COUNT, p, len)) return (int)(r - ROUTES);
+  if (const WebAsset *a = httpTable_find(WEB_ASSETS, WEB_ASSET_COUNT, p, len))
+    return ROUTE_COUNT + (int)(a - WEB_ASSETS);
+  return -1;
+}
+
+static int lookupStringChain(const char *p, size_t len) {
+  String path(std::string(p, len));   // path.substring(0, qIdx) in the old loop
+  for (int i = 0; i < ROUTE_COUNT; ++i)
+    if (path == ROUTES[i].path) return i;
+  for (int i = 0; i < WEB_ASSET_COUNT; ++i)
+    if (path == WEB_ASSETS[i].path) return ROUTE_COUNT + i;
+  return -1;
+}
+
+static volatile int s_sink;
+
+// false if the two lookups disagree
+static bool dispatchRow(const char *path, int reps) {
+  const char *volatile p = path;   // keeps the lookup inside the timed loop
+  size_t len = strlen(path);
+  int want = lookupStringChain(path, len);
+  bool same = lookupTable(path, len) == want;
+  Cost t = timeNs(reps, [&] { s_sink = lookupTable(p, len); });
+  Cost chain = timeNs(reps, [&] { s_sink = lookupStringChain(p, len); });
+  printf("%-22s %-6s %9.1f %7.1f %9.1f %7.1f%s\n", path,
+         want < 0 ? "miss" : want < ROUTE_COUNT ? "route" : "asset", t.ns, t.allocs, chain.ns,
+         chain.allocs, same ? "" : "   MISMATCH");
+  return same;
+}
+
+int main(int argc, char **argv) {
+  int requests = argc > 1 ? atoi(argv[1]) : 200000;
+  if (requests <= 0) requests = 200000;
+  std::vector<std::string> mix = buildMix();
+
+  printf("%d requests, %zu-request keep-alive mix, latency in ns\n", requests, mix.size());
+  printf("%-8s %12s %9s %9s %9s %10s\n", "segment", "req/s", "p50", "p99", "max", "bytes/req");
+  const size_t segs[] = { BENCH_REQ_BUF, 536, 64, 1 };
+  for (size_t seg : segs) run(mix, seg, requests);
+  int reps = requests / 4 + 1;
+
+  // Dispatch alone: first, middle and last route, an asset, a miss
+  printf("\ndispatch, ns and allocations per lookup (%d routes, %d assets)\n", ROUTE_COUNT,
+         WEB_ASSET_COUNT);
+  printf("%-22s %-6s %9s %7s %9s %7s\n", "path", "kind", "table", "allocs", "chain", "allocs");
+  const char *paths[] = { ROUTES[0].path, "/api/status", ROUTES[ROUTE_COUNT - 1].path,
+                          WEB_ASSETS[WEB_ASSET_COUNT - 1].path, "/does/not/exist" };
+  int mismatches = 0;
+  for (const char *p : paths) mismatches += !dispatchRow(p, reps * 4);
+
+  // GET /: the dashboard from flash against the dynamic pages
+  printf("\nGET /, host ns to produce the response and bytes sent\n");
+  printf("%-26s %9s %7s %9s\n", "response", "ns", "allocs", "bytes");
+  std::string page = std::string("GET / HTTP/1.1\r\n") + HDRS + "\r\n";
+  std::string plain = page;
+  plain.replace(plain.find("Accept-Encoding: gzip, deflate"), 30, "Accept-Encoding: identity");
+  std::string app = std::string("GET /app.js HTTP/1.1\r\n") + HDRS + "\r\n";
+  const WebAsset *index = httpTable_find(WEB_ASSETS, WEB_ASSET_COUNT, "/index.html", 11);
+  const WebAsset *js = httpTable_find(WEB_ASSETS, WEB_ASSET_COUNT, "/app.js", 7);
+  auto revalidate = [](std::string req, const WebAsset *a) {
+    return req.insert(req.size() - 2, std::string("If-None-Match: ") + a->etag + "\r\n");
+  };
+  auto row = [](const char *label, Cost a, Cost b, size_t bytes) {
+    printf("%-26s %9.0f %7.1f %9zu\n", label, a.ns + b.ns, a.allocs + b.allocs, bytes);
+  };
+
+  size_t bytes = 0, b2 = 0;
+  Cost none = { 0, 0 };
+  Cost c = timeNs(reps, [&] { bytes = makeFormPageBefore(""); });
+  row("String page (before)", c, none, bytes);
+  c = responseNs(plain, reps, bytes);
+  row("form page, no gzip", c, none, bytes);
+  c = responseNs(page, reps, bytes);
+  Cost c2 = responseNs(app, reps, b2);
+  row("dashboard, first visit", c, c2, bytes + b2);
+  c = responseNs(revalidate(page, index), reps, bytes);
+  c2 = responseNs(revalidate(app, js), reps, b2);
+  row("dashboard, revisit (304)", c, c2, bytes + b2);
+  printf("dashboard: %u bytes raw, sent gzip from flash without a copy\n",
+         (unsigned)(index->rawLen + js->rawLen));
+  if (mismatches) {
+    printf("%d paths dispatched differently by the table and the chain\n", mismatches);
+    return 1;
+  }
+  return 0;
+}
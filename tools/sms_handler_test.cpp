@@ -0,0 +1,357 @@
+// tools/sms_handler_test.cpp
+// - Host test for the URC-driven SMS intake (sms_handler.cpp on at_engine.cpp): a recorded
+//   AT transcript is replayed by a fake modem and the device side must send exactly the
+//   commands it shows, in order, and nothing else.
+// - Transcript lines: ">> text" is what the device sends ("^Z" stands for Ctrl-Z; other
+//   lines end in '\r'), "<< text" what the modem answers ("<< >" is the CMGS prompt),
+//   "-- wait N" N seconds in which the device must stay silent, "#" a comment. Modem lines
+//   that follow a device line are its reply; any others are unsolicited (+CMTI, SMS DONE).
+// - The built-in transcript covers the listing at start-up, +CMTI intake, message text
+//   that reads "OK", STATUS? replies, SET/GEO refused with an empty SMS_ALLOW_LIST,
+//   unknown text, the reply token bucket running dry and refilling, the slow fallback
+//   poll, deletion of only the received messages, and "SMS DONE" after a modem restart.
+//   A captured transcript in the same format can be given on the command line.
+// - The exit status is 1 if the device strays from the transcript, or leaves a modem
+//   lease or power lock held at the end.
+// - Build and run from the repository root:
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/sms_handler_test.cpp sms_handler.cpp at_engine.cpp -o sms_handler_test
+//     ./sms_handler_test [transcript.txt]
+#include "sms_handler.h"
+#include "at_engine.h"
+#include "modem_manager.h"
+#include "weather_manager.h"
+#include "power_manager.h"
+#include "measurement.h"
+#include "sampling_scheduler.h"
+#include "settings.h"
+#include "telemetry.h"
+#include "config.h"
+#include <string>
+#include <vector>
+
+#define TEST_STALL_MS 30000   // the device has this long to send the next expected line
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (ok) return;
+  if (s_failures++ < 10) printf("FAILED: %s\n", what);
+}
+
+static const char *TRANSCRIPT = R"(# A7670E, SIM storage "SM". Times are simulated.
+# sms_init()
+>> AT+CMGF=1
+<< OK
+>> AT+CNMI=2,1,0,0,0
+<< OK
+# first sms_loop(): list what arrived while the device was off
+>> AT+CMGF=1
+<< OK
+>> AT+CMGL="ALL"
+<< +CMGL: 1,"REC READ","+306900000001","","26/05/01,09:00:00+12"
+<< STATUS?
+<< +CMGL: 2,"STO SENT","+306900000001","",""
+<< OK
+<<
+<< OK
+>> AT+CMGS="+306900000001"
+<< >
+>> 12:00 W41.20kg Ti34.5C Hi58% Te17.0C He70% P1013 B4.05V 83% RSSI-71 iv900s q12^Z
+<< +CMGS: 21
+<<
+<< OK
+>> AT+CMGD=1
+<< OK
+-- wait 5
+# new messages: one +CMTI for the lot, one listing
+<< +CMTI: "SM",3
+>> AT+CMGF=1
+<< OK
+>> AT+CMGL="ALL"
+<< +CMGL: 2,"STO SENT","+306900000001","",""
+<< OK
+<< +CMGL: 3,"REC UNREAD","+306900000002","","26/05/01,12:00:10+12"
+<< SET iv=300
+<< +CMGL: 4,"REC UNREAD","+306900000002","","26/05/01,12:00:20+12"
+<< GEO: Athens, GR
+<< +CMGL: 5,"REC UNREAD","+306900000003","","26/05/01,12:00:30+12"
+<< status?
+<< +CMGL: 6,"REC UNREAD","+306900000004","","26/05/01,12:00:40+12"
+<< STATUS?
+<< +CMGL: 7,"REC UNREAD","+306900000005","","26/05/01,12:00:50+12"
+<< STATUS?
+<< +CMGL: 8,"REC UNREAD","+306900000006","","26/05/01,12:01:00+12"
+<< Hi, is this the bee guy?
+<< Call me
+<<
+<< OK
+# SET and GEO refused (empty allow-list), two tokens left, the third STATUS? is dropped
+>> AT+CMGS="+306900000003"
+<< >
+>> 12:00 W41.20kg Ti34.5C Hi58% Te17.0C He70% P1013 B4.05V 83% RSSI-71 iv900s q12^Z
+<< +CMGS: 22
+<<
+<< OK
+>> AT+CMGS="+306900000004"
+<< >
+>> 12:00 W41.20kg Ti34.5C Hi58% Te17.0C He70% P1013 B4.05V 83% RSSI-71 iv900s q12^Z
+<< +CMGS: 23
+<<
+<< OK
+>> AT+CMGD=3
+<< OK
+>> AT+CMGD=4
+<< OK
+>> AT+CMGD=5
+<< OK
+>> AT+CMGD=6
+<< OK
+>> AT+CMGD=7
+<< OK
+>> AT+CMGD=8
+<< OK
+# a message whose +CMTI went to TinyGSM: found by the fallback poll, token refilled
+-- wait 590
+>> AT+CMGF=1
+<< OK
+>> AT+CMGL="ALL"
+<< +CMGL: 2,"STO SENT","+306900000001","",""
+<< OK
+<< +CMGL: 9,"REC UNREAD","+306900000005","","26/05/01,12:10:00+12"
+<< STATUS?
+<<
+<< OK
+>> AT+CMGS="+306900000005"
+<< >
+>> 12:00 W41.20kg Ti34.5C Hi58% Te17.0C He70% P1013 B4.05V 83% RSSI-71 iv900s q12^Z
+<< +CMGS: 24
+<<
+<< OK
+>> AT+CMGD=9
+<< OK
+# modem restarted: text mode and URC routing are restored, then one listing
+-- wait 60
+<< SMS DONE
+>> AT+CMGF=1
+<< OK
+>> AT+CNMI=2,1,0,0,0
+<< OK
+>> AT+CMGF=1
+<< OK
+>> AT+CMGL="ALL"
+<< +CMGL: 2,"STO SENT","+306900000001","",""
+<< OK
+<<
+<< OK
+-- wait 30
+)";
+
+// -----------------------------------------------------------------------------
+// Transcript replay
+struct Entry {
+  char        kind;   // '>' device, '<' modem, 'w' wait
+  std::string text;
+  uint32_t    ms;
+  int         line;
+};
+
+static std::vector<Entry> s_script;
+static size_t s_pos = 0;
+static bool   s_silent = false;   // inside a wait: the device must not send
+
+static void parseTranscript(const std::string &t) {
+  size_t start = 0;
+  int line = 0;
+  while (start < t.size()) {
+    size_t end = t.find('\n', start);
+    if (end == std::string::npos) end = t.size();
+    std::string l = t.substr(start, end - start);
+    start = end + 1;
+    line++;
+    if (!l.empty() && l.back() == '\r') l.pop_back();
+    if (l.empty() || l[0] == '#') continue;
+
+    Entry e = { 0, "", 0, line };
+    if (l.compare(0, 2, ">>") == 0) {
+      e.kind = '>';
+      e.text = l.size() > 3 ? l.substr(3) : "";
+      size_t z = e.text.find("^Z");
+      if (z != std::string::npos) e.text.replace(z, 2, "\x1A");
+      else e.text += '\r';
+    } else if (l.compare(0, 2, "<<") == 0) {
+      e.kind = '<';
+      e.text = l.size() > 3 ? l.substr(3) : "";
+    } else if (l.compare(0, 8, "-- wait ") == 0) {
+      e.kind = 'w';
+      e.ms = (uint32_t)atol(l.c_str() + 8) * 1000UL;
+    } else {
+      fprintf(stderr, "transcript line %d not understood: %s\n", line, l.c_str());
+      exit(1);
+    }
+    s_script.push_back(e);
+  }
+}
+
+static std::string printable(const std::string &s) {
+  std::string o;
+  for (char c : s) o += c == '\r' ? std::string("\\r") : c == 0x1A ? std::string("^Z") : std::string(1, c);
+  return o;
+}
+
+class FakeModem : public Stream {
+public:
+  std::vector<std::string> sent;
+
+  size_t write(uint8_t c) override {
+    tx_ += (char)c;
+    if (c == '\r' || c == 0x1A || c == 0x1B) command();
+    return 1;
+  }
+  int available() override { return (int)(rx_.size() - rxPos_); }
+  int read() override { return rxPos_ < rx_.size() ? (uint8_t)rx_[rxPos_++] : -1; }
+  int peek() override { return rxPos_ < rx_.size() ? (uint8_t)rx_[rxPos_] : -1; }
+
+  // Modem lines at the cursor, up to the next device line or wait
+  void emit() {
+    while (s_pos < s_script.size() && s_script[s_pos].kind == '<') {
+      const std::string &t = s_script[s_pos++].text;
+      rx_ += t == ">" ? "\r\n> " : t + "\r\n";
+    }
+  }
+
+private:
+  std::string tx_;
+  std::string rx_;
+  size_t      rxPos_ = 0;
+
+  void command() {
+    sent.push_back(tx_);
+    char msg[240];
+    if (s_silent || s_pos >= s_script.size() || s_script[s_pos].kind != '>') {
+      snprintf(msg, sizeof(msg), "device sent %s where the transcript has none (line %d)",
+               printable(tx_).c_str(), s_pos < s_script.size() ? s_script[s_pos].line : -1);
+      check(false, msg);
+    } else if (s_script[s_pos].text != tx_) {
+      snprintf(msg, sizeof(msg), "line %d: expected %s, device sent %s", s_script[s_pos].line,
+               printable(s_script[s_pos].text).c_str(), printable(tx_).c_str());
+      check(false, msg);
+    } else {
+      s_pos++;
+      emit();
+    }
+    tx_.clear();
+  }
+};
+
+static FakeModem s_modem;
+
+// -----------------------------------------------------------------------------
+// Hooks sms_handler.cpp links against
+static uint32_t s_leases = 0;
+static int      s_locks = 0;
+
+bool modem_acquire(ModemLease who, uint32_t) { s_leases |= 1UL << who; return true; }
+void modem_release(ModemLease who) { s_leases &= ~(1UL << who); }
+bool modem_waitOn(uint32_t) { return true; }
+bool modem_isOn() { return true; }
+void power_acquire(PowerLock) { s_locks++; }
+void power_release(PowerLock) { s_locks--; }
+
+static uint32_t s_geocodes = 0, s_settingsApplied = 0;
+bool weather_geocodeLocation(const char *, const char *) { s_geocodes++; return true; }
+String weather_getLastError() { return ""; }
+bool settings_apply(const char *, char *, size_t) { s_settingsApplied++; return true; }
+int settings_format(char *out, size_t len) { return snprintf(out, len, "iv=300"); }
+void sampler_settingsChanged() {}
+uint32_t sampler_getIntervalSec() { return 900; }
+uint32_t telemetry_pending() { return 12; }
+
+bool measurement_getLatest(Measurement &m) {
+  memset(&m, 0, sizeof(m));
+  m.timestamp    = 1777636800UL;   // 2026-05-01 12:00 UTC
+  m.weight       = 41.2f;
+  m.temp_int     = 34.5f;
+  m.hum_int      = 58.0f;
+  m.temp_ext     = 17.0f;
+  m.hum_ext      = 70.0f;
+  m.pressure     = 1013.2f;
+  m.batt_voltage = 4.05f;
+  m.batt_percent = 83;
+  m.rssi         = -71;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static void step() {
+  sms_loop();
+  at_loop();
+  delay(1);
+}
+
+static bool readFile(const char *path, std::string &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  Serial.quiet = true;
+  setenv("TZ", "UTC0", 1);
+  tzset();
+
+  std::string t = TRANSCRIPT;
+  if (argc > 1 && !(t.clear(), readFile(argv[1], t))) {
+    printf("%s: cannot read\n", argv[1]);
+    return 1;
+  }
+  parseTranscript(t);
+
+  at_init(s_modem);
+  s_modem.emit();   // anything the modem said before sms_init()
+  sms_init();
+
+  while (s_pos < s_script.size() && s_failures == 0) {
+    const Entry &e = s_script[s_pos];
+    if (e.kind == '<') {
+      s_modem.emit();
+    } else if (e.kind == 'w') {
+      s_pos++;
+      s_silent = true;
+      for (uint32_t i = 0; i < e.ms; ++i) step();
+      s_silent = false;
+    } else {
+      size_t at = s_pos;
+      for (uint32_t i = 0; i < TEST_STALL_MS && s_pos == at && s_failures == 0; ++i) step();
+      if (s_pos == at && s_failures == 0) {
+        char msg[200];
+        snprintf(msg, sizeof(msg), "line %d: device never sent %s", e.line, printable(e.text).c_str());
+        check(false, msg);
+      }
+    }
+  }
+
+  int lists = 0, replies = 0, deletes = 0;
+  for (const std::string &c : s_modem.sent) {
+    lists += c.compare(0, 7, "AT+CMGL") == 0;
+    replies += c.compare(0, 7, "AT+CMGS") == 0;
+    deletes += c.compare(0, 7, "AT+CMGD") == 0;
+  }
+  printf("%zu transcript lines, %zu commands sent in %.0f s: %d listings, %d replies, %d deletes\n",
+         s_script.size(), s_modem.sent.size(), millis() / 1000.0, lists, replies, deletes);
+
+  check(s_geocodes == 0 && s_settingsApplied == 0, "SET/GEO refused with an empty allow-list");
+  check(!at_busy() && at_queued() == 0, "AT engine idle at the end");
+  check(s_leases == 0, "modem leases released");
+  check(s_locks == 0, "UART power lock released");
+
+  if (s_failures) {
+    printf("%d checks failed\n", s_failures);
+    return 1;
+  }
+  printf("device followed the transcript\n");
+  return 0;
+}
@@ -0,0 +1,175 @@
+// tools/telemetry_codec_bench.cpp
+// - Host benchmark for the telemetry payload encodings (telemetry_codec.cpp): bytes and
+//   encode time of the binary batches against the JSON the same records would need.
+// - Feeds a few days of synthetic hive readings through the keyframe/delta policy of
+//   telemetry.cpp (keyframe first and every TELEMETRY_KEYFRAME_EVERY batches, deltas
+//   against the last acknowledged record otherwise) for several batch sizes.
+// - Every binary batch is decoded again and compared with the quantized input, so the
+//   run also checks the round trip; the exit status is 1 on any mismatch.
+// - "wire" adds what MQTT puts around each payload (PUBLISH header with the topic and
+//   packet id, and the PUBACK), which batching amortizes; TCP/IP headers are not counted.
+// - Build and run from the repository root:
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/telemetry_codec_bench.cpp telemetry_codec.cpp -o telemetry_codec_bench
+//     ./telemetry_codec_bench [days]
+#include "telemetry_codec.h"
+#include "config.h"
+#include <chrono>
+#include <vector>
+
+#define BENCH_BUF       4096
+#define BENCH_STEP_S    SAMPLE_INTERVAL_FORAGE_S
+#define BENCH_DEV_ID    "a1b2c3d4e5f6"
+#define BENCH_TOPIC_LEN (sizeof(MQTT_TOPIC_PREFIX "/" BENCH_DEV_ID "/telemetry") - 1)
+
+// -----------------------------------------------------------------------------
+// Synthetic readings
+static uint32_t s_rng = 0x2545F491;
+
+static float noise(float amp) {
+  s_rng ^= s_rng << 13;
+  s_rng ^= s_rng >> 17;
+  s_rng ^= s_rng << 5;
+  return amp * ((float)(s_rng % 2001) / 1000.0f - 1.0f);
+}
+
+enum Scenario { SC_FLAT, SC_HIVE, SC_NOISY, SC_COUNT };
+static const char *SCENARIO_NAMES[SC_COUNT] = { "flat", "hive", "noisy" };
+
+// flat: a hive at rest in winter, readings repeat. hive: daily temperature and foraging
+// weight cycles with sensor noise. noisy: the same with ten times the noise.
+static std::vector<Measurement> buildSeries(Scenario sc, int days) {
+  std::vector<Measurement> v;
+  int steps = days * 86400 / BENCH_STEP_S;
+  float k = sc == SC_NOISY ? 10.0f : sc == SC_HIVE ? 1.0f : 0.0f;
+  uint32_t t0 = 1777593600UL;   // 2026-05-01 00:00 UTC
+  for (int i = 0; i < steps; ++i) {
+    uint32_t ts = t0 + (uint32_t)i * BENCH_STEP_S;
+    float day = (float)((ts - t0) % 86400) / 86400.0f;
+    float sun = sc == SC_FLAT ? 0.0f : sinf(2.0f * (float)M_PI * (day - 0.25f));
+    Measurement m;
+    memset(&m, 0, sizeof(m));
+    m.timestamp    = ts;
+    m.weight       = 42.0f + 0.02f * i / 96.0f * k - (sun > 0 ? 0.8f * sun : 0) + noise(0.01f * k);
+    m.temp_int     = 34.5f + 0.3f * sun + noise(0.05f * k);
+    m.hum_int      = 58.0f - 4.0f * sun + noise(0.3f * k);
+    m.temp_ext     = 17.0f + 7.0f * sun + noise(0.1f * k);
+    m.hum_ext      = 70.0f - 20.0f * sun + noise(0.5f * k);
+    m.pressure     = 1013.0f + noise(0.2f * k);
+    m.acc_x        = noise(0.002f * k);
+    m.acc_y        = noise(0.002f * k);
+    m.acc_z        = 1.0f + noise(0.002f * k);
+    m.batt_voltage = 4.10f - 0.0004f * i * (k > 0) + noise(0.005f * k);
+    m.batt_percent = (int)lroundf((m.batt_voltage - 3.3f) / 0.9f * 100.0f);
+    m.rssi         = -71 + (int)lroundf(noise(3.0f * k));
+    v.push_back(m);
+  }
+  return v;
+}
+
+// -----------------------------------------------------------------------------
+struct Result {
+  size_t   batches, records, json, bin, keyBytes, keyframes;
+  double   jsonNs, binNs;
+  int      mismatches;
+};
+
+// MQTT PUBLISH (QoS1) around a payload of len bytes, plus the 4-byte PUBACK
+static size_t mqttOverhead(size_t len) {
+  size_t remaining = 2 + BENCH_TOPIC_LEN + 2 + len;
+  size_t lenBytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+  return 1 + lenBytes + 2 + BENCH_TOPIC_LEN + 2 + 4;
+}
+
+static bool sameQuantized(const Measurement &a, const Measurement &b) {
+  if (a.timestamp != b.timestamp) return false;
+  for (int f = 0; f < TF_COUNT; ++f)
+    if (telemetryCodec_quantize(a, f) != telemetryCodec_quantize(b, f)) return false;
+  return true;
+}
+
+template <typename F> static double timeNs(int reps, F fn) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r) fn();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / reps;
+}
+
+static Result run(const std::vector<Measurement> &series, int batch, size_t &wireJson,
+                  size_t &wireBin) {
+  static uint8_t bin[BENCH_BUF];
+  static char json[BENCH_BUF];
+  Result r;
+  memset(&r, 0, sizeof(r));
+  wireJson = wireBin = 0;
+
+  TelemetrySnapshot acked, rx;
+  memset(&acked, 0, sizeof(acked));
+  memset(&rx, 0, sizeof(rx));
+  uint32_t seq = 1;
+  int sinceKey = 0;
+  const int reps = 20;
+
+  for (size_t i = 0; i < series.size(); i += batch, ++seq) {
+    int n = (int)std::min(series.size() - i, (size_t)batch);
+    const Measurement *recs = &series[i];
+
+    size_t jl = 0;
+    r.jsonNs += timeNs(reps, [&] { jl = telemetryCodec_encodeJson(recs, n, BENCH_DEV_ID, json, sizeof(json)); });
+    bool key = !acked.valid || sinceKey >= TELEMETRY_KEYFRAME_EVERY;
+    size_t bl = 0;
+    r.binNs += timeNs(reps, [&] { bl = telemetryCodec_encode(recs, n, seq, key ? nullptr : &acked, bin, sizeof(bin)); });
+    if (!jl || !bl) {
+      fprintf(stderr, "batch %lu of %d records does not fit %d bytes\n", (unsigned long)seq, n, BENCH_BUF);
+      r.mismatches++;
+      return r;
+    }
+
+    // the receiver's view: decode against its own reference and compare
+    Measurement out[64];
+    int got = telemetryCodec_decode(bin, bl, out, 64, &rx);
+    if (got != n) r.mismatches++;
+    for (int k = 0; k < got && k < n; ++k) if (!sameQuantized(out[k], recs[k])) r.mismatches++;
+
+    telemetryCodec_snapshot(recs[n - 1], seq, acked);   // PUBACK
+    if (key) { r.keyframes++; r.keyBytes += bl; sinceKey = 0; }
+    else sinceKey++;
+    r.batches++;
+    r.records += n;
+    r.json += jl;
+    r.bin += bl;
+    wireJson += jl + mqttOverhead(jl);
+    wireBin += bl + mqttOverhead(bl);
+  }
+  return r;
+}
+
+int main(int argc, char **argv) {
+  int days = argc > 1 ? atoi(argv[1]) : 7;
+  if (days <= 0) days = 7;
+
+  printf("%d days at %lu s per record, keyframe every %d batches; bytes and ns per record\n",
+         days, (unsigned long)BENCH_STEP_S, TELEMETRY_KEYFRAME_EVERY);
+  printf("%-6s %5s %8s %8s %8s %7s %9s %9s %9s %9s\n", "data", "batch", "json B", "bin B",
+         "key B", "bin %", "wire json", "wire bin", "json ns", "bin ns");
+
+  const int batches[] = { 1, 4, TELEMETRY_BATCH_MAX };
+  int mismatches = 0;
+  for (int sc = 0; sc < SC_COUNT; ++sc) {
+    std::vector<Measurement> series = buildSeries((Scenario)sc, days);
+    for (int b : batches) {
+      size_t wireJson, wireBin;
+      Result r = run(series, b, wireJson, wireBin);
+      mismatches += r.mismatches;
+      double n = (double)r.records;
+      printf("%-6s %5d %8.1f %8.1f %8.1f %6.1f%% %9.1f %9.1f %9.0f %9.0f\n", SCENARIO_NAMES[sc], b,
+             r.json / n, r.bin / n, r.keyframes ? (double)r.keyBytes / r.keyframes / b : 0.0,
+             100.0 * r.bin / r.json, wireJson / n, wireBin / n, r.jsonNs / n, r.binNs / n);
+    }
+  }
+
+  if (mismatches) {
+    printf("round trip: %d mismatched records\n", mismatches);
+    return 1;
+  }
+  printf("round trip: every batch decoded to its quantized input\n");
+  return 0;
+}
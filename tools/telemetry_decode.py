@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Decode Beehive Monitor binary telemetry batches (telemetry_codec.h, versions 1-2).
+
+Delta batches are resolved against the last record of the previous batch, so feed the
+payloads of one device in order (a keyframe resets the reference). Batch seqs only ever
+increase, even across reboots, so a batch with seq <= the last one decoded is a QoS1
+redelivery and is skipped.
+
+Usage:
+  telemetry_decode.py FILE            # one raw MQTT payload per file
+  mosquitto_sub -t 'beehive/+/telemetry' -F %x | telemetry_decode.py --hex -
+"""
+import json
+import sys
+
+VERSION = 2
+FLAG_KEYFRAME = 0x01
+Q_NAN = -(1 << 31)      # quantized NaN (missing sensor), decoded as null
+# (name, scale) in wire order -- keep in sync with enum TelemetryField
+FIELDS = [
+    ("weight", 100), ("temp_int", 100), ("hum_int", 10), ("temp_ext", 100),
+    ("hum_ext", 10), ("pressure", 10), ("acc_x", 1000), ("acc_y", 1000),
+    ("acc_z", 1000), ("batt_voltage", 1000), ("batt_percent", 1), ("rssi", 1),
+]
+
+
+def varint(buf, pos):
+    v = shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return v, pos
+
+
+def svarint(buf, pos):
+    v, pos = varint(buf, pos)
+    return (v >> 1) ^ -(v & 1), pos
+
+
+def wrap32(v):
+    """Deltas are taken modulo 2^32 on the device."""
+    return (v + (1 << 31)) % (1 << 32) - (1 << 31)
+
+
+class Decoder:
+    """Keeps the reference snapshot (last record of the last batch) between payloads."""
+
+    def __init__(self):
+        self.base_seq = None
+        self.duplicates = 0
+        self.base_ts = 0
+        self.base_q = None
+
+    def decode(self, buf):
+        """Records of one payload, or None for a redelivered batch."""
+        if buf[:1] == b"{":
+            return json.loads(buf)      # JSON payload (TELEMETRY_FORMAT_JSON)
+        version, flags = buf[0], buf[1]
+        if version == 1:
+            return self._records(buf, 2, keyframe=True)
+        if version != VERSION:
+            raise ValueError("unknown codec version %d" % version)
+        keyframe = bool(flags & FLAG_KEYFRAME)
+        seq, pos = varint(buf, 2)
+        if self.base_seq is not None and seq <= self.base_seq:
+            self.duplicates += 1
+            return None
+        if not keyframe:
+            base_seq, pos = varint(buf, pos)
+            if base_seq != self.base_seq:
+                raise ValueError("delta against seq %d, have %s" % (base_seq, self.base_seq))
+        records = self._records(buf, pos, keyframe)
+        self.base_seq = seq
+        return records
+
+    def _records(self, buf, pos, keyframe):
+        count, pos = varint(buf, pos)
+        ts = 0
+        if keyframe:
+            ts, pos = varint(buf, pos)
+        records = []
+        for _ in range(count):
+            dt, pos = svarint(buf, pos)
+            if keyframe:
+                ts += dt
+                q = []
+                for _f in FIELDS:
+                    v, pos = svarint(buf, pos)
+                    q.append(v)
+            else:
+                ts = self.base_ts + dt
+                mask, pos = varint(buf, pos)
+                q = list(self.base_q)
+                for f in range(len(FIELDS)):
+                    if mask & (1 << f):
+                        v, pos = svarint(buf, pos)
+                        q[f] = wrap32(q[f] + v)
+            rec = {"timestamp": ts}
+            for (name, scale), v in zip(FIELDS, q):
+                if v == Q_NAN:
+                    rec[name] = None
+                else:
+                    rec[name] = v / scale if scale != 1 else v
+            records.append(rec)
+            last_ts, last_q = ts, q
+        if count:
+            self.base_ts, self.base_q = last_ts, last_q
+        return records
+
+
+def main(argv):
+    hexmode = "--hex" in argv
+    paths = [a for a in argv[1:] if a != "--hex"] or ["-"]
+    decoder = Decoder()
+    for path in paths:
+        if path == "-":
+            chunks = sys.stdin.read().split() if hexmode else [sys.stdin.buffer.read()]
+        else:
+            with open(path, "rb") as f:
+                data = f.read()
+            chunks = data.decode().split() if hexmode else [data]
+        for chunk in chunks:
+            buf = bytes.fromhex(chunk) if hexmode else chunk
+            records = decoder.decode(buf)
+            if records is not None:
+                print(json.dumps(records))
+    if decoder.duplicates:
+        print("skipped %d duplicate batch(es)" % decoder.duplicates, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,218 @@
+// tools/telemetry_queue_bench.cpp
+// - Host benchmark for the store-and-forward telemetry queue (telemetry_queue.cpp) on a
+//   file-backed SD card (tools/host/SD.h) and in its RAM fallback.
+// - Throughput: host time and card I/O per record for push and for peek+pop in batches.
+// - Drain: an uplink outage fills the queue at the sampling interval; on reconnect the
+//   queue is drained the way telemetry.cpp does it: one batch of TELEMETRY_BATCH_MAX in
+//   flight, popped on PUBACK, while sampling goes on. The link is modelled by its PUBACK
+//   round trip and bit rate (assumed figures, see LINKS). The clock is simulated.
+// - Checks on the way: the queue survives a re-init (reboot) mid-outage, an SD write
+//   fault moves the newest records to RAM, records leave in order, and pushed = sent +
+//   dropped. The exit status is 1 if any check fails.
+// - Build and run from the repository root:
+//     g++ -O2 -std=c++17 -Itools/host -I. tools/telemetry_queue_bench.cpp telemetry_queue.cpp telemetry_codec.cpp -o telemetry_queue_bench
+//     ./telemetry_queue_bench
+#include "telemetry_queue.h"
+#include "telemetry_codec.h"
+#include "config.h"
+#include <chrono>
+#include <string>
+#include <unistd.h>
+
+#define BENCH_STEP_S  SAMPLE_INTERVAL_FORAGE_S
+#define BENCH_MQTT_B  40      // PUBLISH header with topic and packet id, plus PUBACK
+
+struct Link {
+  const char *name;
+  uint32_t    rttMs;      // publish to PUBACK
+  uint32_t    kbps;
+};
+
+static const Link LINKS[] = {
+  { "wifi", 40,  1000 },
+  { "lte",  350, 40 },    // A7670 over AT+CIPSEND, Cat-1 uplink in a weak cell
+};
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (ok) return;
+  if (s_failures++ < 10) printf("FAILED: %s\n", what);
+}
+
+// -----------------------------------------------------------------------------
+static uint32_t s_t0 = 1777593600UL;   // 2026-05-01 00:00 UTC
+
+static Measurement sample(uint32_t i) {
+  Measurement m;
+  memset(&m, 0, sizeof(m));
+  m.timestamp    = s_t0 + i * BENCH_STEP_S;
+  m.weight       = 42.0f + (float)(i % 96) * 0.01f;
+  m.temp_int     = 34.5f + (float)(i % 7) * 0.01f;
+  m.hum_int      = 58.0f;
+  m.temp_ext     = 12.0f + (float)(i % 96) * 0.1f;
+  m.hum_ext      = 70.0f;
+  m.pressure     = 1013.2f;
+  m.acc_z        = 1.0f;
+  m.batt_voltage = 4.05f;
+  m.batt_percent = 83;
+  m.rssi         = -71;
+  return m;
+}
+
+static std::string s_root;
+
+// Start from an empty card (or none: RAM ring)
+static void freshQueue(bool sd) {
+  SD.clearFaults();
+  SD.setRoot(sd ? s_root.c_str() : "/nonexistent-sd-card");
+  SD.remove(TELEMETRY_QUEUE_FILE);
+  telemetryQueue_init();
+  check(telemetryQueue_isPersistent() == sd, "queue backing");
+}
+
+static double nsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// -----------------------------------------------------------------------------
+static void throughput(bool sd, uint32_t n) {
+  freshQueue(sd);
+  SD.io = { 0, 0, 0, 0 };
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < n; ++i) telemetryQueue_push(sample(i));
+  double pushNs = nsSince(t0) / n;
+  uint32_t pushWrites = SD.io.writes, pushBytes = SD.io.bytesWritten;
+
+  SD.io = { 0, 0, 0, 0 };
+  Measurement batch[TELEMETRY_BATCH_MAX];
+  uint32_t drained = 0;
+  t0 = std::chrono::steady_clock::now();
+  while (int got = telemetryQueue_peek(batch, TELEMETRY_BATCH_MAX)) {
+    check(batch[0].timestamp == sample(drained + telemetryQueue_dropped()).timestamp, "drain order");
+    telemetryQueue_pop(got);
+    drained += got;
+  }
+  double drainNs = nsSince(t0) / (drained ? drained : 1);
+  check(drained + telemetryQueue_dropped() == n, "pushed = drained + dropped");
+
+  printf("%-4s %6lu %9.0f %9.0f %8.2f %8.1f %8.2f %8.1f %8.2f %8.1f\n", sd ? "SD" : "RAM",
+         (unsigned long)n, pushNs, drainNs, (double)pushWrites / n, (double)pushBytes / n,
+         (double)SD.io.reads / n, (double)SD.io.bytesRead / n, (double)SD.io.writes / n,
+         (double)SD.io.bytesWritten / n);
+}
+
+// -----------------------------------------------------------------------------
+struct Drain {
+  uint32_t queued, batches, records, bytes, dropped;
+  double   seconds;
+};
+
+// Publish batches until the queue is empty, sampling every BENCH_STEP_S meanwhile.
+// next is the index of the next sample to take.
+static Drain drain(const Link &link, uint32_t &next, unsigned long &nextSampleMs) {
+  Drain d;
+  memset(&d, 0, sizeof(d));
+  d.queued = telemetryQueue_count();
+  unsigned long start = millis();
+  TelemetrySnapshot acked;
+  memset(&acked, 0, sizeof(acked));
+  uint32_t seq = 1, sinceKey = 0, expect = 0;
+  bool first = true;
+  uint8_t buf[1024];
+  Measurement batch[TELEMETRY_BATCH_MAX];
+
+  while (telemetryQueue_count()) {
+    int n = telemetryQueue_peek(batch, TELEMETRY_BATCH_MAX);
+    if (!first) check(batch[0].timestamp >= expect, "drain order");
+    first = false;
+    expect = batch[n - 1].timestamp + BENCH_STEP_S;
+
+    bool key = !acked.valid || sinceKey >= TELEMETRY_KEYFRAME_EVERY;
+    size_t len = telemetryCodec_encode(batch, n, seq, key ? nullptr : &acked, buf, sizeof(buf));
+    check(len > 0, "batch fits the payload buffer");
+    uint32_t ms = link.rttMs + (uint32_t)((len + BENCH_MQTT_B) * 8UL / link.kbps);
+
+    // sampling does not stop while a batch is in flight
+    unsigned long done = millis() + ms;
+    while (nextSampleMs <= done) {
+      hostClock_advance(nextSampleMs - millis());
+      telemetryQueue_push(sample(next++));
+      nextSampleMs += BENCH_STEP_S * 1000UL;
+    }
+    hostClock_advance(done - millis());
+
+    telemetryQueue_pop(n);
+    telemetryCodec_snapshot(batch[n - 1], seq++, acked);
+    sinceKey = key ? 0 : sinceKey + 1;
+    d.batches++;
+    d.records += n;
+    d.bytes += len + BENCH_MQTT_B;
+  }
+  d.seconds = (millis() - start) / 1000.0;
+  return d;
+}
+
+// Fill the queue during an outage of the given length, then drain it over each link.
+// faultAt > 0 arms an SD write fault that many samples into the outage.
+static void outage(const char *label, uint32_t hours, uint32_t faultAt) {
+  for (const Link &link : LINKS) {
+    freshQueue(true);
+    uint32_t samples = hours * 3600UL / BENCH_STEP_S;
+    uint32_t next = 0;
+    for (; next < samples; ++next) {
+      if (faultAt && next == faultAt) SD.failWritesAfter(1);
+      telemetryQueue_push(sample(next));
+      if (next == samples / 2 && telemetryQueue_isPersistent()) {
+        uint32_t before = telemetryQueue_count();
+        telemetryQueue_init();   // reboot mid-outage
+        check(telemetryQueue_count() == before, "queue survives a reboot");
+      }
+    }
+    check(telemetryQueue_isPersistent() == (faultAt == 0), "SD fault falls back to RAM");
+
+    unsigned long nextSampleMs = millis() + BENCH_STEP_S * 1000UL;
+    Drain d = drain(link, next, nextSampleMs);
+    d.dropped = telemetryQueue_dropped();
+    check(d.records + d.dropped == next, "pushed = sent + dropped");
+
+    printf("%-9s %-4s %-4s %6lu %7lu %7lu %8.1f %7.2f %8.1f %8lu\n", label, link.name,
+           telemetryQueue_isPersistent() ? "SD" : "RAM", (unsigned long)d.queued,
+           (unsigned long)d.batches, (unsigned long)d.records, d.seconds,
+           d.seconds > 0 ? d.records / d.seconds : 0.0, d.bytes / 1024.0,
+           (unsigned long)d.dropped);
+  }
+}
+
+int main() {
+  char dir[] = "/tmp/tqbenchXXXXXX";
+  if (!mkdtemp(dir)) { perror("mkdtemp"); return 1; }
+  s_root = dir;
+  Serial.quiet = true;
+
+  printf("queue ops, host ns per record; card I/O calls and bytes per record\n");
+  printf("%-4s %6s %9s %9s %8s %8s %8s %8s %8s %8s\n", "ring", "recs", "push ns", "drain ns",
+         "push wr", "push B", "drain rd", "rd B", "drain wr", "wr B");
+  throughput(true, TELEMETRY_QUEUE_CAP);
+  throughput(true, TELEMETRY_QUEUE_CAP + TELEMETRY_QUEUE_CAP / 4);   // overflow drops the oldest
+  throughput(false, TELEMETRY_RAM_CAP * 4);
+
+  printf("\ndrain after an outage: %d records per batch, one in flight, a sample every %lu s\n",
+         TELEMETRY_BATCH_MAX, (unsigned long)BENCH_STEP_S);
+  printf("%-9s %-4s %-4s %6s %7s %7s %8s %7s %8s %8s\n", "outage", "link", "ring", "queued",
+         "batches", "sent", "drain s", "rec/s", "KB sent", "dropped");
+  outage("6 h", 6, 0);
+  outage("2 d", 48, 0);
+  outage("7 d", 24 * 7, 0);
+  outage("60 d", 24 * 60, 0);
+  outage("2 d+fault", 48, 100);
+
+  SD.remove(TELEMETRY_QUEUE_FILE);
+  rmdir(dir);
+  if (s_failures) {
+    printf("%d checks failed\n", s_failures);
+    return 1;
+  }
+  printf("all queue checks passed\n");
+  return 0;
+}
@@ -4,20 +4,31 @@
   Self-contained implementation that:
   - Uses Preferences namespace "beehive" to store lat/lon and place name/country.
   - Fetches hourly arrays from Open‑Meteo and samples every 6 hours for 72 hours.
-  - Parses JSON using ArduinoJson v7 API (DeserializationError / deserializeJson).
+  - Parses the forecast while it downloads (forecast_parser, a streaming tokenizer);
+    geocoding results are parsed with ArduinoJson v7 (DeserializationError / deserializeJson).
   - Exposes weather_init(), weather_fetch(), weather_hasData(), weather_daysCount(),
     weather_getDay(), weather_setCoords(), weather_geocodeLocation(), weather_getLastError(),
     and weather_debug_dumpAndFetch() as in weather_manager.h.
+  - Network I/O runs on the non-blocking http_async engine: *Start() + weather_poll()
+    for UI code that must stay responsive, blocking wrappers for everything else.
+  - Geocoding results go through a small persistent LRU (geocode_cache), so repeat
+    lookups of a known site complete immediately and offline.
+  - Keeps the last forecast as a compact blob in NVS (key "wx_cache") with its fetch time,
+    so a cold boot shows it immediately; weather_loop() refreshes it once older than
+    WEATHER_CACHE_TTL_S.
 
   Make sure ArduinoJson 7.x is installed in the IDE.
 */
 
 #include "config.h"
 #include "weather_manager.h"
+#include "http_async.h"
+#include "forecast_parser.h"
+#include "geocode_cache.h"
+#include "net_transport.h"
+#include "time_manager.h"
 #include <Arduino.h>
 #include <Preferences.h>
-#include <WiFi.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include <time.h>
 
@@ -28,14 +39,36 @@ static const char *PREF_KEY_LAT = "owm_lat";
 static const char *PREF_KEY_LON = "owm_lon";
 static const char *PREF_KEY_LOC_NAME = "loc_name";
 static const char *PREF_KEY_LOC_COUNTRY = "loc_country";
+static const char *PREF_KEY_CACHE = "wx_cache";
 
 static double s_lat = DEFAULT_LAT;
 static double s_lon = DEFAULT_LON;
 static bool   s_hasData = false;
 static String s_lastError = "";
 
-static WeatherDay *s_days = nullptr;
+static WeatherDay s_days[WEATHER_MAX_DAYS];
 static int s_daysCount = 0;
+static int32_t s_utcOffset = 0;   // forecast location's UTC offset (seconds)
+
+// Cache freshness: epoch of the fetch when the clock was valid, else millis() of this boot
+static uint32_t s_fetchedEpoch = 0;
+static unsigned long s_fetchedMs = 0;
+static bool s_fetchedThisBoot = false;
+static unsigned long s_lastAttemptMs = 0;
+static bool s_attempted = false;
+
+// Persisted cache layout (bump CACHE_VERSION when changing it)
+static const uint8_t CACHE_VERSION = 2;
+
+struct CacheBlob {
+  uint8_t    version;
+  uint8_t    count;
+  uint32_t   fetchedEpoch;
+  int32_t    utcOffset;
+  float      lat;
+  float      lon;
+  WeatherDay days[WEATHER_MAX_DAYS];
+};
 
 // URL-encode helper (RFC3986-ish). Returns encoded string.
 static String urlEncode(const String &str) {
@@ -60,6 +93,44 @@ static String urlEncode(const String &str) {
   return encoded;
 }
 
+// Write the current forecast to NVS as one blob (WeatherDay is plain data)
+static void saveCache() {
+  static CacheBlob blob;
+  memset(&blob, 0, sizeof(blob));
+  blob.version = CACHE_VERSION;
+  blob.count = (uint8_t)s_daysCount;
+  blob.fetchedEpoch = s_fetchedEpoch;
+  blob.utcOffset = s_utcOffset;
+  blob.lat = (float)s_lat;
+  blob.lon = (float)s_lon;
+  memcpy(blob.days, s_days, sizeof(WeatherDay) * s_daysCount);
+  Preferences cp;
+  cp.begin(PREF_NS, false);
+  cp.putBytes(PREF_KEY_CACHE, &blob, sizeof(blob));
+  cp.end();
+}
+
+// Restore the forecast saved by saveCache(); ignored if it belongs to other coordinates
+static void loadCache() {
+  static CacheBlob blob;
+  Preferences cp;
+  cp.begin(PREF_NS, true);
+  size_t n = cp.getBytes(PREF_KEY_CACHE, &blob, sizeof(blob));
+  cp.end();
+  if (n != sizeof(blob) || blob.version != CACHE_VERSION || blob.count == 0 ||
+      blob.count > WEATHER_MAX_DAYS) return;
+  if (fabs(blob.lat - s_lat) > 0.001 || fabs(blob.lon - s_lon) > 0.001) return;
+
+  memcpy(s_days, blob.days, sizeof(WeatherDay) * blob.count);
+  s_daysCount = blob.count;
+  s_utcOffset = blob.utcOffset;
+  s_hasData = true;
+  s_fetchedEpoch = blob.fetchedEpoch;
+  s_fetchedThisBoot = false;
+  Serial.printf("[Weather] cache loaded: %d samples, fetched at %lu\n",
+                s_daysCount, (unsigned long)s_fetchedEpoch);
+}
+
 void weather_init() {
   prefs.begin(PREF_NS, false);
   String latS = prefs.getString(PREF_KEY_LAT, "");
@@ -73,7 +144,8 @@ void weather_init() {
   }
   s_hasData = false;
   s_lastError = "";
-  if (s_days) { delete[] s_days; s_days = nullptr; s_daysCount = 0; }
+  s_daysCount = 0;
+  loadCache();
 }
 
 // Store coords as strings (persist)
@@ -84,6 +156,10 @@ void weather_setCoords(double lat, double lon) {
   prefs.end();
   s_lat = lat;
   s_lon = lon;
+  // the cached forecast belongs to the old location
+  s_daysCount = 0;
+  s_hasData = false;
+  s_attempted = false;
   Serial.print("[Weather] coords saved: lat=");
   Serial.print(lat, 6);
   Serial.print(" lon=");
@@ -94,65 +170,123 @@ String weather_getLastError() {
   return s_lastError;
 }
 
-// Map Open-Meteo weathercode to short description
-static String mapWeatherCodeOpenMeteo(int code) {
-  switch(code) {
-    case 0: return "Clear";
-    case 1: case 2: case 3: return "Partly cloudy";
-    case 45: case 48: return "Fog";
-    case 51: case 53: case 55: return "Drizzle";
-    case 61: case 63: case 65: return "Rain";
-    case 71: case 73: case 75: return "Snow";
-    case 80: case 81: case 82: return "Showers";
-    case 95: case 96: case 99: return "Thunder";
-    default: return "N/A";
-  }
+// Short descriptions, indexed by WeatherCode (kept in flash)
+static const char *const WX_DESC[WX_CODE_COUNT] = {
+  "Clear", "Partly cloudy", "Fog", "Drizzle", "Rain", "Snow", "Showers", "Thunder", "N/A"
+};
+
+const char *weather_codeDesc(uint8_t code) {
+  return WX_DESC[code < WX_CODE_COUNT ? code : WX_UNKNOWN];
 }
 
-// Geocode via Open-Meteo geocoding API, store coords and place name/country in prefs on success
-bool weather_geocodeLocation(const char* city, const char* countryCode) {
-  if (!city) return false;
-  String q = String(city);
+void weather_formatTime(const WeatherDay &d, char *buf, size_t len) {
+  if (d.time == 0) { snprintf(buf, len, "--"); return; }
+  time_t t = (time_t)d.time + s_utcOffset;
+  struct tm tmv;
+  gmtime_r(&t, &tmv);
+  snprintf(buf, len, "%02d-%02d %02d:%02d", tmv.tm_mday, tmv.tm_mon + 1, tmv.tm_hour, tmv.tm_min);
+}
 
-  // Build base URL using name parameter (city only).
-  String url = String("https://geocoding-api.open-meteo.com/v1/search?name=") + urlEncode(q)
-               + "&count=1&language=en&format=json";
+// ---------------------------------------------------------------------------
+// Async job plumbing: forecast bodies are tokenized as they arrive, geocode bodies
+// are collected and parsed in the engine's PARSE phase. One job runs at a time.
+// ---------------------------------------------------------------------------
+enum WeatherJob { JOB_NONE, JOB_FORECAST, JOB_GEOCODE };
+static WeatherJob s_job = JOB_NONE;
+static bool s_jobOk = false;
+static String s_body;
+
+static const char *HOST_GEOCODE  = "geocoding-api.open-meteo.com";
+static const char *HOST_FORECAST = "api.open-meteo.com";
+
+static bool collectBody(const uint8_t *data, size_t len, void *ctx) {
+  (void)ctx;
+  if (s_body.length() == 0) s_body.reserve(2048);
+  return s_body.concat((const char*)data, len);
+}
 
-  // If a country code was provided, append the dedicated countryCode parameter.
-  // Ensure we use the ISO-3166-1 alpha2 form (uppercase).
-  if (countryCode && strlen(countryCode) > 0) {
-    String cc = String(countryCode);
-    cc.toUpperCase();
-    url += String("&countryCode=") + urlEncode(cc);
+static bool startJob(WeatherJob job, const char *host, const String &path,
+                     HttpBodySink sink, HttpParseFn parse) {
+  if (s_job != JOB_NONE || httpAsync_busy()) {
+    s_lastError = "Busy";
+    return false;
   }
-
-  Serial.print("[Weather] Geocode (OpenMeteo) -> ");
-  Serial.println(url);
-
-  if (WiFi.status() != WL_CONNECTED) {
-    s_lastError = "WiFi not connected";
-    Serial.println("[Weather] Geocode failed: WiFi not connected");
+  s_body = String();
+  s_lastError = "";
+  s_jobOk = false;
+  if (!httpAsync_start(host, path.c_str(), sink, parse, nullptr)) {
+    s_lastError = httpAsync_lastError();
     return false;
   }
+  s_job = job;
+  return true;
+}
 
-  HTTPClient http;
-  http.begin(url);
-  int code = http.GET();
-  String body;
-  if (code > 0) body = http.getString();
-  http.end();
+bool weather_poll() {
+  if (s_job == JOB_NONE) return false;
+  HttpPhase p = httpAsync_poll();
+  if (httpAsync_busy()) return true;
 
-  if (code != 200) {
-    s_lastError = String("HTTP_") + String(code) + ": " + body;
-    Serial.print("[Weather] Geocode failed: ");
+  s_jobOk = (p == HTTP_DONE);
+  if (!s_jobOk && s_lastError.length() == 0) s_lastError = httpAsync_lastError();
+  if (!s_jobOk) {
+    Serial.print("[Weather] request failed: ");
     Serial.println(s_lastError);
-    return false;
   }
+  s_body = String();   // release the response buffer
+  s_job = JOB_NONE;
+  return false;
+}
+
+bool weather_busy() { return s_job != JOB_NONE; }
+
+void weather_cancel() {
+  if (s_job == JOB_NONE) return;
+  httpAsync_cancel();
+  s_lastError = "Cancelled";
+  weather_poll();
+}
+
+int weather_progress() { return httpAsync_progress(); }
+
+const char *weather_phaseName() { return httpAsync_phaseName(httpAsync_phase()); }
+
+// Run the current job to completion (blocking wrappers below)
+static bool waitJob() {
+  while (weather_poll()) delay(1);
+  return s_jobOk;
+}
+
+// Query of the running geocode job, the key for geocache_store()
+static char s_geoCity[64];
+static char s_geoCountry[4];
+
+// Persist a geocoding result: coords, plus place name & country for UI display
+static void applyGeocode(const GeoResult &res) {
+  weather_setCoords(res.lat, res.lon);
+
+  prefs.begin(PREF_NS, false);
+  if (res.name[0])    prefs.putString(PREF_KEY_LOC_NAME, res.name);
+  if (res.country[0]) prefs.putString(PREF_KEY_LOC_COUNTRY, res.country);
+  prefs.end();
+
+  s_lastError = "";
+  Serial.printf("[Weather] Geocode OK: lat=%.6f lon=%.6f", res.lat, res.lon);
+  if (res.name[0]) {
+    Serial.print(" place=");
+    Serial.print(res.name);
+    if (res.country[0]) { Serial.print(", country="); Serial.print(res.country); }
+  }
+  Serial.println();
+}
 
+// Geocode result parser (runs in the engine's PARSE phase)
+static bool parseGeocode(void *ctx) {
+  (void)ctx;
   // Parse JSON with ArduinoJson v7 API
   const size_t CAP = 10 * 1024;
   DynamicJsonDocument doc(CAP);
-  DeserializationError derr = deserializeJson(doc, body);
+  DeserializationError derr = deserializeJson(doc, s_body);
   if (derr) {
     s_lastError = "JSON parse error";
     Serial.print("[Weather] Geocode JSON parse failed: ");
@@ -175,167 +309,123 @@ bool weather_geocodeLocation(const char* city, const char* countryCode) {
     return false;
   }
 
-  // Persist coords
-  weather_setCoords(lat, lon);
-
-  // Persist place name & country for UI display
-  String placeName = "";
-  String country = "";
-  if (r.containsKey("name"))    placeName = String((const char*)r["name"].as<const char*>());
-  if (r.containsKey("country")) country   = String((const char*)r["country"].as<const char*>());
-
-  prefs.begin(PREF_NS, false);
-  if (placeName.length()) prefs.putString(PREF_KEY_LOC_NAME, placeName);
-  if (country.length())   prefs.putString(PREF_KEY_LOC_COUNTRY, country);
-  prefs.end();
-
-  s_lastError = "";
-  Serial.printf("[Weather] Geocode OK: lat=%.6f lon=%.6f", lat, lon);
-  if (placeName.length()) {
-    Serial.print(" place=");
-    Serial.print(placeName);
-    if (country.length()) { Serial.print(", country="); Serial.print(country); }
-  }
-  Serial.println();
+  GeoResult res;
+  memset(&res, 0, sizeof(res));
+  res.lat = lat;
+  res.lon = lon;
+  const char *name = r["name"] | "";
+  const char *country = r["country"] | "";
+  strncpy(res.name, name, sizeof(res.name) - 1);
+  strncpy(res.country, country, sizeof(res.country) - 1);
+
+  geocache_store(s_geoCity, s_geoCountry, res);
+  applyGeocode(res);
   return true;
 }
 
-// Fetch Open-Meteo forecast: hourly arrays, sample every 6 hours for next 72h
-static bool weather_fetch_open_meteo() {
-  // include humidity and surface_pressure in hourly arrays
-  String url = String("https://api.open-meteo.com/v1/forecast?latitude=")
-    + String(s_lat, 6) + "&longitude=" + String(s_lon, 6)
-    + "&hourly=temperature_2m,weathercode,relativehumidity_2m,surface_pressure&forecast_days=3&timezone=auto";
-
-  Serial.print("[Weather] OpenMeteo Request URL: ");
-  Serial.println(url);
-
-  if (WiFi.status() != WL_CONNECTED) {
-    s_lastError = "WiFi not connected";
-    Serial.println("[Weather] OpenMeteo fetch failed: WiFi not connected");
+// Start geocoding via Open-Meteo geocoding API; coords and place name/country are stored on success.
+// A cached result completes immediately without touching the network.
+bool weather_geocodeStart(const char* city, const char* countryCode) {
+  if (!city) return false;
+  if (s_job != JOB_NONE || httpAsync_busy()) {
+    s_lastError = "Busy";
     return false;
   }
 
-  HTTPClient http;
-  http.begin(url);
-  int code = http.GET();
-  String body;
-  if (code > 0) body = http.getString();
-  http.end();
-
-  if (code != 200) {
-    s_lastError = String("HTTP_") + String(code) + ": " + body;
-    Serial.print("[Weather] OpenMeteo HTTP fail: ");
-    Serial.println(s_lastError);
-    Serial.println(body.substring(0, min((int)body.length(), 512)));
-    return false;
+  GeoResult cached;
+  if (geocache_lookup(city, countryCode, cached)) {
+    applyGeocode(cached);
+    s_jobOk = true;
+    return true;
   }
 
-  // Parse JSON
-  const size_t CAP = 28 * 1024; // adjust if memory issues appear
-  DynamicJsonDocument doc(CAP);
-  DeserializationError derr = deserializeJson(doc, body);
-  if (derr) {
-    s_lastError = "JSON parse failed";
-    Serial.print("[Weather] OpenMeteo JSON parse failed: ");
-    Serial.println(derr.c_str());
-    return false;
-  }
+  strncpy(s_geoCity, city, sizeof(s_geoCity) - 1);
+  s_geoCity[sizeof(s_geoCity) - 1] = 0;
+  strncpy(s_geoCountry, countryCode ? countryCode : "", sizeof(s_geoCountry) - 1);
+  s_geoCountry[sizeof(s_geoCountry) - 1] = 0;
 
-  if (!doc.containsKey("hourly")) {
-    s_lastError = "No hourly data";
-    Serial.println("[Weather] No hourly data in OpenMeteo response");
-    return false;
-  }
+  String q = String(city);
 
-  JsonObject hourly = doc["hourly"].as<JsonObject>();
-  if (!hourly.containsKey("time") || !hourly.containsKey("temperature_2m")) {
-    s_lastError = "Incomplete hourly data";
-    Serial.println("[Weather] Hourly data incomplete");
-    return false;
+  // Build base path using name parameter (city only).
+  String path = String("/v1/search?name=") + urlEncode(q) + "&count=1&language=en&format=json";
+
+  // If a country code was provided, append the dedicated countryCode parameter.
+  // Ensure we use the ISO-3166-1 alpha2 form (uppercase).
+  if (countryCode && strlen(countryCode) > 0) {
+    String cc = String(countryCode);
+    cc.toUpperCase();
+    path += String("&countryCode=") + urlEncode(cc);
   }
 
-  JsonArray times = hourly["time"].as<JsonArray>();
-  JsonArray temps = hourly["temperature_2m"].as<JsonArray>();
-  JsonArray codes = hourly["weathercode"].as<JsonArray>();
-  JsonArray hums  = hourly.containsKey("relativehumidity_2m") ? hourly["relativehumidity_2m"].as<JsonArray>() : JsonArray();
-  JsonArray press = hourly.containsKey("surface_pressure") ? hourly["surface_pressure"].as<JsonArray>() : JsonArray();
+  Serial.print("[Weather] Geocode (OpenMeteo) -> https://");
+  Serial.print(HOST_GEOCODE);
+  Serial.println(path);
 
-  int totalHours = times.size();
-  if (totalHours <= 0) {
-    s_lastError = "No hourly entries";
-    Serial.println("[Weather] No hourly entries");
-    return false;
-  }
+  return startJob(JOB_GEOCODE, HOST_GEOCODE, path, collectBody, parseGeocode);
+}
 
-  // We'll sample every 6 hours starting from index 0, up to next 72 hours (3 days)
-  const int HOURS_TO_COVER = 72;
-  const int STEP = 6;
-  int maxSamples = (HOURS_TO_COVER / STEP);
-  // free previous cache
-  if (s_days) { delete[] s_days; s_days = nullptr; s_daysCount = 0; }
-  s_days = new WeatherDay[maxSamples];
-  int samples = 0;
-  for (int offset = 0; offset < HOURS_TO_COVER && (offset < totalHours); offset += STEP) {
-    int idx = offset; // index into hourly arrays
-    if (idx >= totalHours) break;
-    String tISO = String(times[idx].as<const char*>());
-    double temp = temps[idx].as<double>();
-    int wc = 0;
-    if (idx < (int)codes.size()) wc = codes[idx].as<int>();
-    double hum = NAN;
-    if (!hums.isNull() && idx < (int)hums.size()) hum = hums[idx].as<double>();
-    double pr = NAN;
-    if (!press.isNull() && idx < (int)press.size()) pr = press[idx].as<double>();
-
-    // convert pressure to hPa if necessary:
-    // - Open-Meteo surface_pressure typically returns hPa. But if a value looks like Pa (>2000),
-    //   convert by dividing by 100.
-    if (!isnan(pr)) {
-      if (pr > 2000.0) pr = pr / 100.0;
-    }
+bool weather_geocodeLocation(const char* city, const char* countryCode) {
+  if (!weather_geocodeStart(city, countryCode)) return false;
+  return waitJob();
+}
+
+static String forecastPath(double lat, double lon) {
+  // include humidity and surface_pressure in hourly arrays
+  return String("/v1/forecast?latitude=") + String(lat, 6) + "&longitude=" + String(lon, 6)
+    + "&hourly=temperature_2m,weathercode,relativehumidity_2m,surface_pressure&forecast_days=3"
+    + "&timezone=auto&timeformat=unixtime";
+}
 
-    // convert ISO "YYYY-MM-DDThh:mm" or "YYYY-MM-DD hh:mm" to "DD-MM HH:MM"
-    String hhmm = "00:00";
-    int posT = tISO.indexOf('T');
-    if (posT < 0) posT = tISO.indexOf(' ');
-    if (posT >= 0) hhmm = tISO.substring(posT+1, posT+6);
-    int y = tISO.substring(0,4).toInt();
-    int m = tISO.substring(5,7).toInt();
-    int d = tISO.substring(8,10).toInt();
-
-    char dbuf[20];
-    snprintf(dbuf, sizeof(dbuf), "%02d-%02d %s", d, m, hhmm.c_str());
-    s_days[samples].date = String(dbuf);
-    s_days[samples].temp_min = (float)temp;
-    s_days[samples].temp_max = (float)temp;
-    s_days[samples].humidity = isnan(hum) ? 0.0f : (float)hum; // percent
-    s_days[samples].pressure = isnan(pr) ? 0.0f : (float)pr;   // hPa
-    s_days[samples].desc = mapWeatherCodeOpenMeteo(wc);
-    samples++;
-    if (samples >= maxSamples) break;
+// ---------------------------------------------------------------------------
+// Forecast: the body goes through forecast_parser as it downloads
+// ---------------------------------------------------------------------------
+static bool streamForecast(const uint8_t *data, size_t len, void *ctx) {
+  (void)ctx;
+  if (!forecastParser_feed(data, len)) {
+    s_lastError = "JSON parse failed";
+    return false;
   }
+  return true;
+}
 
+// Runs in the engine's PARSE phase: convert the collected slots into the forecast cache
+static bool parseForecast(void *ctx) {
+  (void)ctx;
+  int32_t offset;
+  const char *err;
+  int samples = forecastParser_finish(s_days, WEATHER_MAX_DAYS, offset, err);
   if (samples == 0) {
-    s_lastError = "No samples parsed";
-    Serial.println("[Weather] No samples parsed from OpenMeteo");
-    // free memory
-    delete[] s_days;
-    s_days = nullptr;
-    s_daysCount = 0;
-    s_hasData = false;
+    s_lastError = err;
+    Serial.print("[Weather] OpenMeteo: ");
+    Serial.println(s_lastError);
     return false;
   }
 
   s_daysCount = samples;
+  s_utcOffset = offset;
   s_hasData = true;
   s_lastError = "";
+  s_fetchedEpoch = timeManager_isTimeValid() ? (uint32_t)time(nullptr) : 0;
+  s_fetchedMs = millis();
+  s_fetchedThisBoot = true;
+  saveCache();
   Serial.print("[Weather] OpenMeteo fetch OK, samples=");
   Serial.println(s_daysCount);
   return true;
 }
 
-bool weather_fetch() {
+static bool weather_fetch_open_meteo() {
+  String path = forecastPath(s_lat, s_lon);
+  Serial.print("[Weather] OpenMeteo Request URL: https://");
+  Serial.print(HOST_FORECAST);
+  Serial.println(path);
+  forecastParser_begin();
+  return startJob(JOB_FORECAST, HOST_FORECAST, path, streamForecast, parseForecast);
+}
+
+bool weather_fetchStart() {
+  s_lastAttemptMs = millis();
+  s_attempted = true;
 #if USE_OPENMETEO
   return weather_fetch_open_meteo();
 #else
@@ -345,17 +435,51 @@ bool weather_fetch() {
 #endif
 }
 
+bool weather_fetch() {
+  if (!weather_fetchStart()) return false;
+  return waitJob();
+}
+
+uint32_t weather_getAgeSec() {
+  if (!s_hasData) return UINT32_MAX;
+  if (s_fetchedEpoch && timeManager_isTimeValid()) {
+    uint32_t now = (uint32_t)time(nullptr);
+    return now > s_fetchedEpoch ? now - s_fetchedEpoch : 0;
+  }
+  if (s_fetchedThisBoot) return (millis() - s_fetchedMs) / 1000UL;
+  return UINT32_MAX;   // loaded from NVS and the clock is not set yet
+}
+
+bool weather_isStale() {
+  uint32_t age = weather_getAgeSec();
+  // cached forecast, clock not set yet: wait for the sync rather than refetch every boot
+  if (age == UINT32_MAX && s_hasData && millis() < WEATHER_CLOCK_WAIT_S * 1000UL) return false;
+  return age > WEATHER_CACHE_TTL_S;
+}
+
+// Background refresh: drive a running request, or start one when the cache is stale
+void weather_loop() {
+  if (s_job != JOB_NONE) { weather_poll(); return; }
+  httpAsync_closeIdle(false);
+  if (s_fetchedThisBoot && !s_fetchedEpoch && timeManager_isTimeValid()) {
+    // fetched before the clock was set: stamp it now so the next boot knows its age
+    s_fetchedEpoch = (uint32_t)time(nullptr) - (millis() - s_fetchedMs) / 1000UL;
+    saveCache();
+  }
+  if (!weather_isStale()) return;
+  if (s_attempted && millis() - s_lastAttemptMs < WEATHER_RETRY_S * 1000UL) return;
+  if (!netTransport_available()) return;
+  Serial.println("[Weather] cache stale, refreshing in background");
+  weather_fetchStart();
+}
+
 bool weather_hasData() { return s_hasData; }
 int weather_daysCount() { return s_daysCount; }
 
 void weather_getDay(int idx, WeatherDay &out) {
   if (!s_hasData || idx < 0 || idx >= s_daysCount) {
-    out.date = String("--");
-    out.temp_min = 0.0f;
-    out.temp_max = 0.0f;
-    out.humidity = 0.0f;
-    out.pressure = 0.0f;
-    out.desc = String("N/A");
+    memset(&out, 0, sizeof(out));
+    out.code = WX_UNKNOWN;
     return;
   }
   out = s_days[idx];
@@ -370,11 +494,14 @@ bool weather_debug_dumpAndFetch() {
   cp.end();
   double lat = s_lat, lon = s_lon;
   if (latS.length() && lonS.length()) { lat = latS.toDouble(); lon = lonS.toDouble(); }
-  String fullUrl = String("https://api.open-meteo.com/v1/forecast?latitude=")
-    + String(lat, 6) + "&longitude=" + String(lon, 6)
-    + "&hourly=temperature_2m,weathercode,relativehumidity_2m,surface_pressure&forecast_days=3&timezone=auto";
+  String fullUrl = String("https://") + HOST_FORECAST + forecastPath(lat, lon);
   Serial.print("[Debug] Request URL: ");
   Serial.println(fullUrl);
-  bool res = weather_fetch();
-  return res;
+  if (!weather_isStale()) {
+    uint32_t age = weather_getAgeSec();
+    if (age == UINT32_MAX) Serial.println("[Debug] cache age unknown until the clock is set, fetch deferred");
+    else Serial.printf("[Debug] cache fresh (age %lus), skipping fetch\n", (unsigned long)age);
+    return true;
+  }
+  return weather_fetch();
 }
\ No newline at end of file
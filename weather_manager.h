@@ -3,15 +3,42 @@
 
 #include <Arduino.h>
 
+// Condensed weather condition (Open-Meteo WMO codes are mapped onto these)
+enum WeatherCode : uint8_t {
+  WX_CLEAR = 0,
+  WX_PARTLY_CLOUDY,
+  WX_FOG,
+  WX_DRIZZLE,
+  WX_RAIN,
+  WX_SNOW,
+  WX_SHOWERS,
+  WX_THUNDER,
+  WX_UNKNOWN,
+  WX_CODE_COUNT
+};
+
+// One 6-hour forecast sample. Plain data (12 bytes): no heap, safe to copy and to
+// persist as raw bytes.
 struct WeatherDay {
-  String date;        // used as "DD-MM HH:MM" for 6-hour samples
-  float temp_min;     // for 6h sample: temperature at sample time
-  float temp_max;
-  float humidity;     // relative humidity (%) for the sample
-  float pressure;     // surface pressure in hPa for the sample
-  String desc;        // short description (e.g. "Light rain" or "Clear")
+  uint32_t time;      // sample time, epoch seconds (UTC)
+  int16_t  temp_c10;  // temperature at sample time, 0.1 C
+  uint16_t press_10;  // surface pressure, 0.1 hPa (0 = unknown)
+  uint8_t  humidity;  // relative humidity (%)
+  uint8_t  code;      // WeatherCode
+  uint8_t  reserved[2];
 };
 
+#define WEATHER_MAX_DAYS 12
+
+inline float weatherDay_tempC(const WeatherDay &d)       { return d.temp_c10 / 10.0f; }
+inline float weatherDay_pressureHpa(const WeatherDay &d) { return d.press_10 / 10.0f; }
+
+// Short description of a WeatherCode (e.g. "Rain"), from a constant table
+const char *weather_codeDesc(uint8_t code);
+
+// Format the sample time as local "DD-MM HH:MM" (forecast location's UTC offset)
+void weather_formatTime(const WeatherDay &d, char *buf, size_t len);
+
 // Init the module (call from setup)
 void weather_init();
 
@@ -19,10 +46,28 @@ void weather_init();
 // When USE_OPENMETEO is enabled, this fetches 6-hourly samples for the next 3 days.
 bool weather_fetch();
 
+// Non-blocking variants: start a forecast fetch or geocode, then call weather_poll()
+// until it returns false. Only one request runs at a time.
+bool weather_fetchStart();
+bool weather_geocodeStart(const char* city, const char* countryCode); // cache hit: done on return
+bool weather_poll();                    // true while the request is still running
+bool weather_busy();
+void weather_cancel();                  // abort the running request
+int  weather_progress();                // body download percent, -1 if unknown
+const char *weather_phaseName();        // current http_async phase (for UI)
+
+// Cache: forecast age in seconds (UINT32_MAX if unknown) and TTL check. A cache of unknown
+// age (clock not set yet) only counts as stale after WEATHER_CLOCK_WAIT_S of uptime.
+uint32_t weather_getAgeSec();
+bool weather_isStale();
+
+// Call from loop(): drives a running request and refreshes a stale cache in the background
+void weather_loop();
+
 // Accessors
 bool weather_hasData();
 int  weather_daysCount();               // number of samples currently cached (e.g. 12)
-void weather_getDay(int idx, WeatherDay &out); // idx: 0..weather_daysCount()-1
+void weather_getDay(int idx, WeatherDay &out); // idx: 0..weather_daysCount()-1, 12-byte copy
 
 // Runtime helpers (no API key functions anymore)
 void weather_setCoords(double lat, double lon);          // store coordinates in Preferences
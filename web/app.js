@@ -0,0 +1,40 @@
+// Dashboard for the key server: live values from /events, state from /api/status.
+(function () {
+  function $(id) { return document.getElementById(id); }
+  function fmt(v, d) { return v === null || v === undefined ? '--' : v.toFixed(d); }
+
+  function show(m) {
+    $('weight').textContent = fmt(m.weight, 2);
+    $('temp').textContent = fmt(m.temp_int, 1) + ' / ' + fmt(m.temp_ext, 1);
+    $('hum').textContent = fmt(m.hum_int, 0) + ' / ' + fmt(m.hum_ext, 0);
+    $('pressure').textContent = fmt(m.pressure, 1);
+    $('batt').textContent = fmt(m.batt_voltage, 2) + ' V ' + m.batt_percent + '%';
+    $('live').textContent = m.timestamp ? new Date(m.timestamp * 1000).toLocaleTimeString() : '';
+  }
+
+  function status() {
+    fetch('/api/status').then(function (r) { return r.json(); }).then(function (s) {
+      $('status').textContent = s.geocode || '--';
+      $('sys').textContent = 'Up ' + Math.round(s.uptime_s / 60) + ' min, heap ' + s.heap_free +
+        ', RSSI ' + (s.rssi === null ? '--' : s.rssi) + ', queue ' + s.telemetry_pending +
+        (s.modem ? ', modem ' + s.modem.state + ' (idle ' + Math.round(s.modem.idle_s / 60) + ' min)' : '');
+    }).catch(function () {});
+  }
+
+  if (window.EventSource) {
+    var es = new EventSource('/events');
+    es.onmessage = function (e) { show(JSON.parse(e.data)); };
+    es.onerror = function () { $('live').textContent = 'reconnecting...'; };
+  } else {
+    fetch('/api/measurements').then(function (r) { return r.json(); }).then(show).catch(function () {});
+  }
+
+  $('loc').onsubmit = function (e) {
+    e.preventDefault();
+    fetch('/set', { method: 'POST', body: new URLSearchParams(new FormData(e.target)) })
+      .then(function () { $('status').textContent = 'queued...'; setTimeout(status, 3000); });
+  };
+
+  status();
+  setInterval(status, 30000);
+})();
@@ -0,0 +1,145 @@
+// web_api.cpp
+// - JSON documents for the key server's /api/ routes (see web_api.h).
+// - Written with HttpBody into the connection's response buffer; floats that are NaN
+//   (sensor missing) become null.
+#include "web_api.h"
+#include "weather_manager.h"
+#include "calibration.h"
+#include "connectivity_manager.h"
+#include "net_status.h"
+#include "telemetry.h"
+#include "time_manager.h"
+#include "key_server.h"
+#include "ota_manager.h"
+#include "modem_manager.h"
+#include "config.h"
+#include <WiFi.h>
+
+static void keyFloat(HttpBody &b, const char *key, float v, uint8_t decimals, bool comma = true) {
+  httpBody_printf(b, "\"%s\":", key);
+  httpBody_jsonFloat(b, v, decimals);
+  if (comma) httpBody_puts(b, ",");
+}
+
+void webApi_writeMeasurement(HttpBody &b, const Measurement &m) {
+  httpBody_printf(b, "{\"timestamp\":%lu,", (unsigned long)m.timestamp);
+  keyFloat(b, "weight", m.weight, 3);
+  keyFloat(b, "temp_int", m.temp_int, 2);
+  keyFloat(b, "hum_int", m.hum_int, 1);
+  keyFloat(b, "temp_ext", m.temp_ext, 2);
+  keyFloat(b, "hum_ext", m.hum_ext, 1);
+  keyFloat(b, "pressure", m.pressure, 1);
+  keyFloat(b, "acc_x", m.acc_x, 3);
+  keyFloat(b, "acc_y", m.acc_y, 3);
+  keyFloat(b, "acc_z", m.acc_z, 3);
+  keyFloat(b, "batt_voltage", m.batt_voltage, 3);
+  httpBody_printf(b, "\"batt_percent\":%d,\"rssi\":%d}", m.batt_percent, m.rssi);
+}
+
+int webApi_measurements(HttpBody &b) {
+  Measurement m;
+  if (!measurement_getLatest(m)) {
+    httpBody_puts(b, "{\"error\":\"no measurement yet\"}");
+    return 503;
+  }
+  webApi_writeMeasurement(b, m);
+  return 200;
+}
+
+int webApi_forecast(HttpBody &b) {
+  int n = weather_daysCount();
+  httpBody_printf(b, "{\"age_s\":%lu,\"stale\":%s,\"days\":[",
+                  (unsigned long)weather_getAgeSec(), weather_isStale() ? "true" : "false");
+  char local[24];
+  for (int i = 0; i < n; ++i) {
+    WeatherDay d;
+    weather_getDay(i, d);
+    weather_formatTime(d, local, sizeof(local));
+    httpBody_printf(b, "%s{\"time\":%lu,\"local\":\"%s\",", i ? "," : "", (unsigned long)d.time, local);
+    keyFloat(b, "temp", weatherDay_tempC(d), 1);
+    keyFloat(b, "pressure", weatherDay_pressureHpa(d), 1);
+    httpBody_printf(b, "\"humidity\":%u,\"code\":%u,\"desc\":", d.humidity, d.code);
+    httpBody_jsonString(b, weather_codeDesc(d.code));
+    httpBody_puts(b, "}");
+  }
+  httpBody_puts(b, "]}");
+  return 200;
+}
+
+int webApi_calibration(HttpBody &b) {
+  CalibrationSummary c;
+  calibration_readSummary(c);
+  httpBody_printf(b, "{\"zero_raw\":%ld,", c.zeroRaw);
+  keyFloat(b, "scale_factor", c.scaleFactor, 6);
+  keyFloat(b, "batt_factor", c.battFactor, 4);
+  keyFloat(b, "temp_offset", c.tempOffset, 2);
+  keyFloat(b, "hum_offset", c.humOffset, 2);
+  httpBody_puts(b, "\"accel_bias\":[");
+  for (int i = 0; i < 3; ++i) {
+    if (i) httpBody_puts(b, ",");
+    httpBody_jsonFloat(b, c.accelBias[i], 4);
+  }
+  httpBody_puts(b, "]}");
+  return 200;
+}
+
+// ,"<key>":<seconds since stamp> or null when never refreshed
+static void writeAge(HttpBody &b, const char *key, uint32_t stampMs) {
+  uint32_t age = netStatus_age(stampMs);
+  if (age == NETSTAT_AGE_NEVER) httpBody_printf(b, ",\"%s\":null", key);
+  else httpBody_printf(b, ",\"%s\":%lu", key, (unsigned long)(age / 1000UL));
+}
+
+int webApi_status(HttpBody &b) {
+  const NetStatus &ns = netStatus_get();
+  httpBody_printf(b, "{\"uptime_s\":%lu,\"heap_free\":%lu,\"heap_min\":%lu,\"heap_max_block\":%lu,",
+                  millis() / 1000UL, (unsigned long)ESP.getFreeHeap(),
+                  (unsigned long)ESP.getMinFreeHeap(), (unsigned long)ESP.getMaxAllocHeap());
+  if (ns.wifiConnected) httpBody_printf(b, "\"rssi\":%d", (int)ns.wifiRssi);
+  else httpBody_puts(b, "\"rssi\":null");
+  writeAge(b, "rssi_age_s", ns.wifiMs);
+  if (ns.lteRssi) httpBody_printf(b, ",\"lte_rssi\":%d", (int)ns.lteRssi);
+  else httpBody_puts(b, ",\"lte_rssi\":null");
+  writeAge(b, "lte_rssi_age_s", ns.rssiMs);
+  httpBody_printf(b, ",\"lte_reg_stat\":%d", (int)ns.regStat);
+  writeAge(b, "lte_reg_age_s", ns.regMs);
+  httpBody_puts(b, ",\"lte_operator\":");
+  httpBody_jsonString(b, ns.op);
+  writeAge(b, "lte_operator_age_s", ns.opMs);
+  httpBody_puts(b, ",");
+  httpBody_puts(b, "\"wifi\":");
+  httpBody_jsonString(b, connectivity_stateName());
+  httpBody_puts(b, ",\"geocode\":");
+  httpBody_jsonString(b, keyServer_jobMessage());
+  // seconds per modem power state since boot (MODEM_POWER_POLICY)
+  httpBody_printf(b, ",\"modem\":{\"state\":\"%s\",\"power_ups\":%lu",
+                  modem_powerStateName(modem_powerState()), (unsigned long)modem_powerUps());
+  for (int i = 0; i < MPS_COUNT; ++i) {
+    httpBody_printf(b, ",\"%s_s\":%lu", modem_powerStateName((ModemPowerState)i),
+                    (unsigned long)modem_powerStateSec((ModemPowerState)i));
+  }
+  httpBody_puts(b, "}");
+  httpBody_printf(b, ",\"lte_registered\":%s,\"time_valid\":%s,\"weather_age_s\":%lu,"
+                     "\"telemetry_pending\":%lu,\"telemetry_connected\":%s}",
+                  connectivity_lteRegistered() ? "true" : "false",
+                  timeManager_isTimeValid() ? "true" : "false",
+                  (unsigned long)weather_getAgeSec(),
+                  (unsigned long)telemetry_pending(),
+                  telemetry_isConnected() ? "true" : "false");
+  return 200;
+}
+
+int webApi_ota(HttpBody &b) {
+  OtaStatus st;
+  ota_getStatus(st);
+  httpBody_printf(b, "{\"state\":\"%s\",\"size\":%lu,\"written\":%lu,\"committed\":%lu,"
+                     "\"bytes_per_sec\":%lu,\"pull\":%s,\"trial\":%s,\"sha256\":",
+                  ota_stateName(st.state), (unsigned long)st.size, (unsigned long)st.written,
+                  (unsigned long)st.committed, (unsigned long)st.bytesPerSec,
+                  st.pull ? "true" : "false", st.trial ? "true" : "false");
+  httpBody_jsonString(b, st.sha256);
+  httpBody_puts(b, ",\"error\":");
+  httpBody_jsonString(b, st.error);
+  httpBody_puts(b, "}");
+  return 200;
+}
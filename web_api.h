@@ -0,0 +1,23 @@
+#ifndef WEB_API_H
+#define WEB_API_H
+
+#include <Arduino.h>
+#include "http_request.h"
+#include "measurement.h"
+
+// Read-only JSON endpoints served by the key server:
+//   /api/measurements  latest Measurement
+//   /api/forecast      cached WeatherDay samples
+//   /api/calibration   calibration_readSummary()
+//   /api/status        uptime, heap, link and queue state, modem power-state times
+// Each writes its document into body and returns the HTTP status code.
+// Nothing is allocated; values are formatted straight into the caller's buffer.
+
+int webApi_measurements(HttpBody &body);
+void webApi_writeMeasurement(HttpBody &body, const Measurement &m);   // one object, also used for /events
+int webApi_forecast(HttpBody &body);
+int webApi_calibration(HttpBody &body);
+int webApi_status(HttpBody &body);
+int webApi_ota(HttpBody &body);           // ota_getStatus() for /ota
+
+#endif // WEB_API_H
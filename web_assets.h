@@ -0,0 +1,128 @@
+// web_assets.h
+// - GENERATED by tools/build_web_assets.py from web/ -- do not edit by hand.
+// - gzip-compressed bodies in flash; ETag is the SHA-256 prefix of the raw file.
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+struct WebAsset {
+  const char    *path;
+  const char    *contentType;
+  const char    *etag;          // quoted, ready for the header
+  const uint8_t *gz;
+  uint32_t       gzLen;
+  uint32_t       rawLen;
+};
+
+// /app.js: 1818 -> 799 bytes
+static const uint8_t ASSET_APP_JS[] = {
+  0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x95,0x55,0x4d,0x6f,0xdb,0x30,
+  0x0c,0xbd,0xf7,0x57,0xf0,0xb0,0xc1,0xf6,0x9a,0x2a,0xe9,0x06,0xec,0x90,0x20,0x18,
+  0xb0,0xb5,0x05,0x3a,0x74,0x6b,0xd1,0xb4,0xbb,0x06,0x8a,0x4d,0xc7,0xde,0x2c,0xc9,
+  0x93,0x64,0xa7,0x41,0xdb,0xff,0x3e,0xd2,0x76,0x52,0xa7,0x59,0x30,0xec,0x10,0x40,
+  0xd6,0x23,0x9f,0xf8,0xf1,0xc8,0x0c,0x87,0x70,0x26,0x5d,0xb6,0x30,0xd2,0x26,0x90,
+  0x1a,0x0b,0x3e,0x43,0xf8,0x85,0x6b,0x70,0x68,0x6b,0xb4,0x63,0x28,0xf2,0x1a,0xa1,
+  0x96,0x45,0x85,0x0e,0x52,0x6b,0x14,0x0c,0xb1,0x46,0xed,0xdd,0x00,0x9c,0x97,0x1e,
+  0xbb,0x3b,0x59,0xe6,0x43,0xfe,0xae,0x9c,0x38,0x0a,0xd3,0x4a,0xc7,0x3e,0x37,0x1a,
+  0xc2,0x08,0x1e,0x8f,0x00,0xb6,0xdf,0x6f,0xc2,0x3c,0xa1,0x2b,0xb0,0xe8,0x2b,0xab,
+  0x21,0x31,0x71,0xa5,0x88,0x4b,0x2c,0xd1,0x9f,0x17,0xc8,0xc7,0xcf,0xeb,0xcb,0x84,
+  0x8d,0x26,0xf0,0xdc,0x77,0x4c,0x95,0x0f,0xeb,0x01,0xf4,0x9d,0x6b,0x98,0x4e,0xa7,
+  0xa0,0xab,0xa2,0x80,0xa7,0xa7,0xee,0xab,0xd2,0x09,0xa6,0xb9,0xc6,0x04,0x3e,0x41,
+  0x70,0x72,0x12,0xc0,0x18,0x6a,0xe1,0xcd,0x45,0xfe,0x80,0x49,0xd8,0x92,0xf6,0x59,
+  0x5d,0x66,0x56,0xa1,0x6a,0x63,0x04,0x0a,0x2e,0x58,0x61,0xbe,0xcc,0x7c,0x10,0x09,
+  0x8f,0x0f,0xfe,0x8b,0xd1,0x9e,0x22,0x82,0x69,0xf3,0xba,0x12,0x2d,0x38,0x80,0xf7,
+  0xd1,0x64,0x63,0xef,0x51,0x95,0x07,0xac,0x19,0x9a,0xe7,0x9a,0xec,0x4f,0x23,0x38,
+  0x86,0x00,0x86,0xf4,0x3b,0xee,0x83,0xe4,0xc4,0xe0,0x96,0x2c,0xab,0xd4,0x01,0x2e,
+  0x42,0x5a,0xaa,0xd1,0x3e,0x15,0x63,0x0d,0xd3,0xe8,0x85,0xa9,0xb4,0xe8,0x5c,0x65,
+  0xf1,0x00,0xdd,0x06,0xde,0x79,0x7d,0x21,0xfd,0xa1,0xc4,0x19,0x9a,0xd7,0xa6,0xf0,
+  0x72,0x89,0x9c,0x7e,0x13,0xc3,0x8f,0x26,0x86,0x0e,0x2c,0xd1,0xc6,0xec,0x41,0xc0,
+  0xdb,0x60,0x4b,0xc9,0xca,0xd9,0xa3,0xa4,0xe4,0x73,0x85,0x24,0x15,0x55,0x52,0x93,
+  0x34,0xae,0x48,0x7e,0x1e,0xc3,0xfe,0xf5,0x3b,0x38,0x1d,0x8d,0x46,0xe4,0x68,0xae,
+  0x4c,0x2c,0x0b,0xbc,0x23,0x64,0xe6,0x6d,0xae,0x97,0xa4,0xa7,0x31,0x04,0xcd,0x0b,
+  0xaf,0x3a,0xd9,0x48,0x2f,0xdc,0xb4,0x32,0x45,0x1f,0x67,0x61,0xd0,0x53,0x25,0xc7,
+  0x91,0xa1,0xee,0x49,0xd3,0xf6,0xb4,0x64,0xc5,0x4f,0x67,0x74,0xc8,0x02,0xd9,0xb3,
+  0x73,0x1b,0xd2,0x26,0xa7,0x17,0xb6,0x9d,0xac,0x1c,0x49,0xd8,0xc4,0x26,0x41,0xd6,
+  0x22,0x2b,0x6f,0xd2,0x73,0x59,0xef,0xdb,0x07,0xf7,0x65,0x53,0xbf,0x6f,0xd2,0x67,
+  0xc2,0x1a,0xd2,0x6d,0xe8,0x44,0x55,0x72,0x0d,0xe6,0x8e,0xfa,0xfb,0xb1,0xeb,0xb4,
+  0xca,0xf5,0x00,0x32,0x94,0xad,0xb5,0x13,0x7c,0x9c,0xa7,0x16,0x11,0x8e,0xbb,0x07,
+  0x00,0x82,0x01,0xdc,0xce,0x66,0x97,0x8d,0x05,0xb1,0x58,0xe7,0xf2,0x97,0xd1,0xd8,
+  0xce,0x41,0x0b,0x34,0xac,0x03,0xf8,0x5d,0x61,0x85,0x1d,0xa5,0x47,0x9e,0x3c,0x6f,
+  0xd7,0xd4,0x45,0x9d,0x50,0x91,0x7b,0xd4,0x44,0xa7,0x28,0x29,0xc5,0x34,0x03,0x68,
+  0x8f,0xad,0x57,0x73,0x16,0xed,0x06,0xe0,0x40,0x69,0x66,0x0b,0xdc,0x4f,0xa9,0x35,
+  0x63,0xec,0x75,0x5a,0x51,0xd0,0xb4,0xb2,0x13,0x20,0x95,0x3d,0x96,0xdc,0xb3,0x9d,
+  0xd5,0xf1,0x1c,0x6d,0x3b,0x9d,0xa7,0x10,0xae,0x72,0x9d,0x98,0x95,0x38,0xe7,0xf5,
+  0x33,0x33,0x15,0x49,0x6e,0xd3,0x9a,0x5a,0x5a,0xa0,0xf5,0x34,0x6d,0xf4,0xd4,0xc3,
+  0x49,0x02,0xed,0xb2,0xda,0xbc,0x83,0x4e,0x18,0x4d,0x3a,0x73,0x24,0x65,0xd6,0xf7,
+  0xf6,0x35,0xa6,0x6a,0xf7,0xc1,0xd7,0xd9,0xf5,0x77,0x51,0x4a,0xeb,0x30,0x44,0x91,
+  0x48,0x2f,0x23,0x96,0x45,0xcf,0x1d,0xad,0xa5,0x35,0xd9,0x77,0x66,0xdf,0x43,0x7a,
+  0x0f,0x2c,0xc6,0x46,0x6b,0x24,0x53,0xbd,0x14,0x42,0x04,0x1d,0xd9,0x33,0x60,0xe1,
+  0xf0,0x2f,0x7a,0x55,0x28,0x79,0x38,0x55,0x1b,0xf6,0xff,0xa9,0x96,0x13,0xf8,0x57,
+  0x25,0x39,0x50,0x13,0x13,0xb3,0xd1,0xae,0x5a,0xa8,0xdc,0xef,0xd5,0xa1,0x4d,0x95,
+  0xd7,0x04,0xd7,0xee,0x0c,0x53,0x59,0x15,0x3e,0xec,0x2a,0xb8,0x09,0xd5,0xa1,0x27,
+  0x49,0x3c,0x02,0x49,0x27,0x33,0x09,0xb5,0xf2,0xe6,0x7a,0x76,0x47,0x37,0x0b,0x93,
+  0xac,0xc7,0x4d,0x1f,0xee,0x6f,0xaf,0x66,0x28,0x6d,0x9c,0xdd,0x48,0x2b,0x95,0x0b,
+  0xf9,0xee,0xc2,0x58,0x45,0xf3,0x2e,0xa9,0xb4,0x5e,0x5a,0x5a,0xfb,0x51,0x44,0xc1,
+  0x77,0x7a,0x7b,0x9d,0x6b,0x57,0xd6,0x03,0x23,0x17,0x34,0x22,0x4e,0xda,0x92,0x52,
+  0x34,0xbc,0x25,0x4c,0xe5,0xc3,0xd6,0x7c,0x00,0x1f,0x78,0x87,0x70,0x69,0x9a,0xcc,
+  0x27,0x9c,0xfa,0x66,0x4b,0xf0,0x0d,0x79,0x5c,0x12,0x95,0xa5,0x7f,0xb6,0x1d,0x17,
+  0x5e,0xa3,0xcf,0x11,0xdb,0xfc,0x01,0x30,0x39,0x27,0x1c,0x1a,0x07,0x00,0x00,
+};
+
+// /index.html: 1440 -> 730 bytes
+static const uint8_t ASSET_INDEX_HTML[] = {
+  0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x85,0x94,0x6d,0x4f,0xdb,0x30,
+  0x10,0x80,0xbf,0xe7,0x57,0x78,0x41,0x9b,0x40,0x5a,0x92,0xf2,0xa2,0xa9,0x0a,0x69,
+  0xa4,0x81,0xd0,0x86,0x34,0x44,0xb5,0x22,0xed,0xb3,0x13,0x5f,0x13,0x0f,0xc7,0xf6,
+  0x6c,0xa7,0x25,0xab,0xf8,0xef,0x3b,0x27,0x29,0x50,0x28,0xda,0x87,0xc4,0xf6,0xdd,
+  0xf9,0xf1,0xbd,0xf8,0x9c,0x7d,0x60,0xaa,0x74,0x9d,0x06,0x52,0xbb,0x46,0xe4,0x41,
+  0xb6,0x1d,0x80,0x32,0x1c,0x1a,0x70,0x94,0x94,0x35,0x35,0x16,0xdc,0x2c,0x6c,0xdd,
+  0x32,0x9a,0x86,0x5b,0xb1,0xa4,0x0d,0xcc,0xc2,0x15,0x87,0xb5,0x56,0xc6,0x85,0xa4,
+  0x54,0xd2,0x81,0x44,0xb3,0x35,0x67,0xae,0x9e,0x31,0x58,0xf1,0x12,0xa2,0x7e,0xf1,
+  0x99,0x4b,0xee,0x38,0x15,0x91,0x2d,0xa9,0x80,0xd9,0xb1,0x67,0x38,0xee,0x04,0xe4,
+  0x17,0x00,0x35,0x5f,0x01,0xb9,0x51,0x68,0xa1,0x4c,0x96,0x0c,0xe2,0x20,0xb3,0xae,
+  0xf3,0x63,0xa1,0x58,0xb7,0x59,0x22,0x39,0x5a,0xd2,0x86,0x8b,0x2e,0xb5,0x54,0xda,
+  0xc8,0x82,0xe1,0xcb,0xf3,0x86,0x9a,0x8a,0xcb,0xf4,0x18,0x1a,0x9c,0x3e,0x0c,0x27,
+  0xa5,0x67,0x13,0x68,0x1e,0x83,0xfa,0x74,0x33,0x6a,0xe3,0x33,0x68,0xc8,0xe4,0x31,
+  0x70,0xb4,0x10,0xb0,0x29,0x94,0x61,0x60,0xa2,0x52,0x09,0x41,0xb5,0x85,0x74,0x3b,
+  0x41,0x3d,0xdb,0x68,0xca,0x18,0x97,0x55,0x7a,0xa2,0x1f,0xc8,0xf1,0x04,0x7f,0x7e,
+  0x82,0x5b,0xe3,0xd5,0xe0,0xc1,0x1a,0x78,0x55,0xbb,0xb4,0x50,0x82,0x9d,0x3b,0x78,
+  0x70,0x11,0x15,0xbc,0x92,0xa9,0xf1,0xd2,0xc7,0xe0,0x40,0x60,0x1c,0x83,0xa1,0xe5,
+  0x7f,0x21,0x8d,0xa7,0xe8,0x17,0xf2,0x95,0x49,0x0f,0xa6,0xd3,0xe9,0x63,0xb0,0xe4,
+  0x20,0x18,0xe6,0x71,0xf3,0xec,0xb7,0xa7,0x67,0xc9,0x18,0x6a,0x96,0x8c,0x49,0xf7,
+  0x31,0xfb,0x12,0x9c,0xbe,0xcd,0x0e,0xca,0x82,0x20,0xdb,0x92,0xd0,0x48,0x40,0x05,
+  0x92,0xe5,0x3f,0xbc,0x55,0x66,0x35,0x95,0x84,0xb3,0x59,0xe8,0x5d,0x09,0x73,0x2c,
+  0x88,0x84,0xd2,0x61,0x48,0x71,0x1c,0xe3,0x31,0xa8,0xcd,0xb3,0x64,0xdc,0x81,0x05,
+  0xf0,0x19,0xf1,0xa3,0xc9,0x33,0xc7,0xf2,0x5f,0x7d,0x74,0x58,0x00,0xe6,0x97,0xa4,
+  0x14,0xd4,0x5a,0x2c,0x6f,0xd8,0x03,0x87,0xd0,0xc3,0x3c,0x8a,0xb6,0x06,0xf9,0x7d,
+  0x35,0x4c,0x13,0xdc,0xff,0x04,0xb9,0x83,0x46,0x13,0x2e,0x49,0x42,0x54,0xfb,0x1e,
+  0xcb,0xa1,0xcd,0x0e,0xe9,0x13,0x83,0xea,0xfc,0x72,0x0f,0xed,0x7b,0xdb,0x70,0xc6,
+  0x5d,0xf7,0x3f,0x62,0xdd,0x36,0x3b,0xc0,0x8f,0x7b,0x58,0x73,0x03,0xd6,0xb6,0x06,
+  0xde,0x41,0xe8,0x51,0xbd,0xc3,0xa9,0xe7,0x74,0x0f,0xe9,0x82,0x3a,0x07,0xa6,0x7b,
+  0x07,0x54,0xa0,0x76,0x07,0xf2,0x92,0x90,0x6c,0x73,0x9e,0x3c,0x97,0x70,0x6f,0x39,
+  0x55,0x49,0x1d,0x57,0xf2,0x45,0xb5,0x74,0x9e,0xf1,0xfc,0x0a,0x3b,0xcc,0x90,0x4b,
+  0x9f,0x12,0x2a,0x19,0x39,0x54,0xda,0x5b,0x51,0x71,0x44,0x4e,0x22,0x01,0xae,0x57,
+  0xaa,0x56,0x3a,0xd3,0x61,0x37,0x32,0x88,0xc9,0x16,0x44,0xd6,0x5c,0x08,0x52,0x00,
+  0x69,0x2d,0x30,0x5c,0xb8,0x9a,0xdc,0x6a,0x90,0xd1,0x0d,0x38,0x50,0xe4,0x50,0x2a,
+  0xf2,0x75,0x7e,0x4d,0xee,0xa1,0x23,0x06,0xfe,0xb4,0xdc,0x00,0x3b,0xc2,0x1b,0xc3,
+  0xd1,0x6f,0x8d,0x67,0x2f,0x95,0x69,0x86,0x7b,0xa5,0xca,0x90,0x60,0xf3,0xd7,0x0a,
+  0x17,0xf3,0xdb,0xc5,0x5d,0x48,0x68,0xe9,0xf9,0xb3,0x30,0xc1,0x00,0xb0,0xad,0xbd,
+  0x6f,0x29,0xc9,0xb8,0xd4,0xad,0x1b,0x5f,0x88,0x12,0x45,0x21,0xe9,0x2f,0xf9,0xf8,
+  0x36,0xa4,0x27,0x13,0x6c,0xaf,0x90,0x68,0x41,0x4b,0xa8,0xb1,0x9d,0xc0,0xcc,0x42,
+  0x88,0xab,0x98,0x5c,0x09,0x58,0x5a,0x2e,0xa9,0x27,0x8d,0x81,0x1c,0x3e,0x85,0x76,
+  0xbd,0xb8,0x3d,0x7a,0xcd,0x1e,0x8c,0x5e,0xe1,0xbf,0xbc,0xa5,0x7f,0xfb,0x19,0xe6,
+  0x59,0x61,0xfa,0x2f,0x18,0x11,0xfe,0xd9,0x9b,0x85,0xb6,0x2d,0x1a,0x8e,0xcf,0xd7,
+  0x8a,0x8a,0x16,0x97,0x0b,0xea,0x5b,0xc7,0x57,0x08,0x83,0x1e,0xf2,0x5e,0xe4,0x0b,
+  0x47,0x5d,0x6b,0xd3,0x2c,0x29,0xf2,0x17,0x5d,0x66,0x7b,0xe9,0x50,0xec,0xb1,0xb9,
+  0xf4,0xeb,0xda,0xea,0xc1,0xb2,0x43,0xb3,0x41,0x6b,0x4b,0xc3,0xb5,0x23,0xd6,0x94,
+  0x98,0x33,0xaa,0x75,0xfc,0xbb,0x57,0x0d,0x62,0xbf,0x7b,0xec,0xfe,0x64,0x78,0x88,
+  0xff,0x01,0x67,0xea,0x70,0x6f,0xa0,0x05,0x00,0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+  { "/app.js", "application/javascript", "\"e914657c0129310a\"", ASSET_APP_JS, 799, 1818 },
+  { "/index.html", "text/html; charset=UTF-8", "\"8981a344e846acc0\"", ASSET_INDEX_HTML, 730, 1440 },
+};
+static const int WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
+
+#endif // WEB_ASSETS_H